@@ -0,0 +1,177 @@
+//==========================================================================
+// Airtime budget checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "airtime-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "RegionCommon.h"
+#include "RegionNvm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "radio.h"
+#include "timer.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Airtime"
+// DUTY_CYCLE_TIME_PERIOD of RegionCommon.c
+#define AIRTIME_WINDOW_MS 3600000
+#define AIRTIME_DATARATE DR_5
+
+//==========================================================================
+// Variables
+//==========================================================================
+static RegionNvmDataGroup1_t gNvmGroup1;
+static RegionNvmDataGroup2_t gNvmGroup2;
+static Band_t gRegionBands[REGION_NVM_MAX_NB_BANDS];
+
+//==========================================================================
+//==========================================================================
+static BandBudget_t *FindBudget(BandBudget_t *aBudgets, uint8_t aNbBudgets, uint8_t aBand) {
+  for (uint8_t i = 0; i < aNbBudgets; i++) {
+    if (aBudgets[i].Band == aBand) {
+      return &aBudgets[i];
+    }
+  }
+  return NULL;
+}
+
+static void InitEu868(uint32_t aExtraFrequency, uint16_t aChannelsMask) {
+  InitDefaultsParams_t init;
+  ChannelAddParams_t add;
+  ChannelParams_t channel;
+
+  RadioSelectChip(RADIO_CHIP_SX126X);
+  memset(&gNvmGroup1, 0, sizeof(gNvmGroup1));
+  memset(&gNvmGroup2, 0, sizeof(gNvmGroup2));
+  init.NvmGroup1 = &gNvmGroup1;
+  init.NvmGroup2 = &gNvmGroup2;
+  init.Bands = gRegionBands;
+  init.Type = INIT_TYPE_DEFAULTS;
+  RegionInitDefaults(LORAMAC_REGION_EU868, &init);
+
+  if (aExtraFrequency != 0) {
+    channel.Frequency = aExtraFrequency;
+    channel.Rx1Frequency = 0;
+    channel.DrRange.Value = (DR_5 << 4) | DR_0;
+    channel.Band = 0;
+    add.NewChannel = &channel;
+    add.ChannelId = 3;
+    RegionChannelAdd(LORAMAC_REGION_EU868, &add);
+  }
+  gNvmGroup2.ChannelsMask[0] = aChannelsMask;
+}
+
+//==========================================================================
+// Uplinks until the band has no credits left, then wait for the next window
+//==========================================================================
+static int CheckBand(const char *aName, uint8_t aBand, uint32_t aExtraFrequency, uint16_t aChannelsMask) {
+  GetPhyParams_t get_phy;
+  NextChanParams_t next;
+  SetBandTxDoneParams_t tx_done;
+  BandBudget_t budgets[REGION_NVM_MAX_NB_BANDS];
+  BandBudget_t *budget;
+  uint8_t nb_budgets;
+  uint8_t channel;
+  TimerTime_t time;
+  TimerTime_t aggregated;
+  TimerTime_t delay;
+  TimerTime_t start = 0;
+  uint32_t frames = 0;
+  bool ok = true;
+
+  InitEu868(aExtraFrequency, aChannelsMask);
+
+  memset(&next, 0, sizeof(next));
+  next.Datarate = AIRTIME_DATARATE;
+  next.Joined = true;
+  next.DutyCycleEnabled = true;
+  next.PktLen = AIRTIME_CHECK_PKT_LEN;
+
+  get_phy.Attribute = PHY_TIME_ON_AIR;
+  get_phy.Datarate = next.Datarate;
+  get_phy.PktLen = next.PktLen;
+  TimerTime_t toa = RegionGetPhyParam(LORAMAC_REGION_EU868, &get_phy).Value;
+  TimerTime_t cost = toa * gRegionBands[aBand].DCycle;
+  uint32_t expected_frames = (AIRTIME_WINDOW_MS - 1) / cost;
+
+  // Same answer as the channel selection before every uplink
+  for (;;) {
+    delay = RegionGetTxOpportunity(LORAMAC_REGION_EU868, &next, budgets, &nb_budgets);
+    budget = FindBudget(budgets, nb_budgets, aBand);
+    LoRaMacStatus_t status = RegionNextChannel(LORAMAC_REGION_EU868, &next, &channel, &time, &aggregated);
+    if (frames == 0) {
+      start = TimerGetCurrentTime();
+    }
+    TimerTime_t window_left = AIRTIME_WINDOW_MS - TimerGetElapsedTime(start);
+
+    ok = ok && (budget != NULL) && budget->Usable && (budget->MaxTimeCredits == AIRTIME_WINDOW_MS);
+    ok = ok && (budget->TimeCredits == AIRTIME_WINDOW_MS - frames * cost);
+    ok = ok && (budget->ObservationLeft == window_left);
+    if (status != LORAMAC_STATUS_OK) {
+      ok = ok && (status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED) && (delay == window_left) && (time == delay);
+      break;
+    }
+    ok = ok && (delay == 0) && (gNvmGroup2.Channels[channel].Band == aBand);
+    if (!ok || (frames > expected_frames)) {
+      break;
+    }
+
+    tx_done.Channel = channel;
+    tx_done.Joined = true;
+    tx_done.LastTxDoneTime = TimerGetCurrentTime();
+    tx_done.LastTxAirTime = toa;
+    tx_done.ElapsedTimeSinceStartUp.Seconds = 0;
+    tx_done.ElapsedTimeSinceStartUp.SubSeconds = 0;
+    RegionSetBandTxDone(LORAMAC_REGION_EU868, &tx_done);
+    frames++;
+    vTaskDelay(pdMS_TO_TICKS(toa));
+  }
+  ok = ok && (frames == expected_frames);
+  printf("Airtime %s: DR%u %u bytes %u ms on air, %u uplinks, next in %.1f s\n", aName, next.Datarate,
+         next.PktLen, toa, frames, delay / 1000.0);
+
+  // The other bands with a channel are reported, but not usable
+  for (uint8_t i = 0; i < nb_budgets; i++) {
+    ok = ok && ((budgets[i].Band == aBand) || !budgets[i].Usable);
+  }
+
+  // A new window brings back the whole budget
+  vTaskDelay(pdMS_TO_TICKS(delay));
+  delay = RegionGetTxOpportunity(LORAMAC_REGION_EU868, &next, budgets, &nb_budgets);
+  budget = FindBudget(budgets, nb_budgets, aBand);
+  ok = ok && (delay == 0) && (budget != NULL) && (budget->TimeCredits == AIRTIME_WINDOW_MS) &&
+       (budget->ObservationLeft == AIRTIME_WINDOW_MS);
+  ok = ok && (RegionNextChannel(LORAMAC_REGION_EU868, &next, &channel, &time, &aggregated) == LORAMAC_STATUS_OK);
+  return HostOsCheck(CHECK_GROUP, ok, aName);
+}
+
+//==========================================================================
+//==========================================================================
+int AirtimeCheckRunChecks(void) {
+  int failed = 0;
+
+  // A band update at time 0 reads as never updated
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  failed += CheckBand("1%", 1, 0, LC(1) + LC(2) + LC(3));
+  failed += CheckBand("10%", 3, 869525000, LC(4));
+  printf("Airtime check: %d failed.\n", failed);
+  return failed;
+}
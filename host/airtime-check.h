@@ -0,0 +1,28 @@
+//==========================================================================
+// Airtime budget checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Sends EU868 uplinks back to back in virtual time on the 1% sub-band of
+// the default channels, then on the 10% sub-band of 869.525 MHz. Before
+// every uplink, RegionGetTxOpportunity() must agree with the channel
+// selection of RegionNextChannel(), and its band budget with the credits
+// the uplinks used. When the band runs out of credits, the delay must be
+// the rest of the observation window, and after waiting it the full
+// budget must be back.
+//==========================================================================
+#ifndef INC_AIRTIME_CHECK_H
+#define INC_AIRTIME_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define AIRTIME_CHECK_PKT_LEN 51
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int AirtimeCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_AIRTIME_CHECK_H
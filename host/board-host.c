@@ -0,0 +1,156 @@
+//==========================================================================
+// Board functions for LoRa MAC, host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radio.h"
+#include "radio_dio.h"
+#include "timer.h"
+#include "virtual-radio.h"
+
+//==========================================================================
+//==========================================================================
+#define TASK_PRIO_IRQ 16
+
+//==========================================================================
+// Timer interrupt
+//==========================================================================
+static esp_timer_handle_t gBoardTimer = NULL;
+static TaskHandle_t gDioTaskHandle = NULL;
+static uint32_t gDioLatencyMs = 0;
+
+static void BoardTimerFunc(void *arg) { TimerIrqHandler(); }
+
+//==========================================================================
+// DIO interrupt of the virtual radios, one notification bit per chip
+//==========================================================================
+void HostBoardRaiseDioIrq(RadioChip_t aChip) {
+  RadioDioEdgeFromIsr(aChip);
+  if (gDioTaskHandle != NULL) {
+    xTaskNotifyFromISR(gDioTaskHandle, 1 << aChip, eSetBits, NULL);
+  }
+}
+
+void HostBoardSetDioLatencyMs(uint32_t aLatencyMs) {
+  __atomic_store_n(&gDioLatencyMs, aLatencyMs, __ATOMIC_RELAXED);
+}
+
+static void LoRaDioDispatch(RadioChip_t aChip) {
+  RadioDioDispatchBegin(aChip);
+  RadioDioDispatchPass(aChip);
+  if (aChip == RADIO_CHIP_SX126X) {
+    RadioSx126x.IrqProcess();
+  } else {
+    RadioSx1280.IrqProcess();
+  }
+  RadioDioDispatchEnd(aChip, false);
+}
+
+static void LoRaDioIrqTask(void *arg) {
+  uint32_t bits;
+  for (;;) {
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY) == pdTRUE) {
+      uint32_t latency_ms = __atomic_load_n(&gDioLatencyMs, __ATOMIC_RELAXED);
+      if (latency_ms > 0) {
+        vTaskDelay(pdMS_TO_TICKS(latency_ms));
+      }
+      if (bits & (1 << RADIO_CHIP_SX126X)) {
+        LoRaDioDispatch(RADIO_CHIP_SX126X);
+      }
+      if (bits & (1 << RADIO_CHIP_SX1280)) {
+        LoRaDioDispatch(RADIO_CHIP_SX1280);
+      }
+    }
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaBoardGetUniqueId(uint8_t *id) {
+  memset(id, 0, 8);
+  esp_efuse_mac_get_default(id);
+}
+
+//==========================================================================
+// One-shot alarm for the earliest timer deadline
+//==========================================================================
+static void CreateBoardTimer(void) {
+  if (gBoardTimer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = &BoardTimerFunc,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "lora_timer",
+    };
+    if (esp_timer_create(&timer_args, &gBoardTimer) != ESP_OK) {
+      printf("ERROR. Failed to create board timer.\n");
+      gBoardTimer = NULL;
+    }
+  }
+}
+
+static void RemoveBoardTimer(void) {
+  if (gBoardTimer != NULL) {
+    esp_timer_stop(gBoardTimer);
+    esp_timer_delete(gBoardTimer);
+    gBoardTimer = NULL;
+  }
+}
+
+bool LoRaBoardStartTimerAlarm(uint64_t aTimeoutUs) {
+  if (gBoardTimer != NULL) {
+    esp_timer_stop(gBoardTimer);
+    if (esp_timer_start_once(gBoardTimer, aTimeoutUs) != ESP_OK) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LoRaBoardStopTimerAlarm(void) {
+  if (gBoardTimer != NULL) {
+    esp_timer_stop(gBoardTimer);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaBoardInitMcu(void) {
+  TimerPowerUpInit();
+  CreateBoardTimer();
+
+  if (gDioTaskHandle == NULL) {
+    if (xTaskCreate(LoRaDioIrqTask, "LoRaDioIrqTask", 2048, NULL, TASK_PRIO_IRQ, &gDioTaskHandle) != pdPASS) {
+      printf("ERROR. Failed to create LoRa DIO IRQ task.\n");
+    }
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaBoardPrepareForSleep(void) { RemoveBoardTimer(); }
+
+void LoRaBoardResumeFromSleep(void) {
+  CreateBoardTimer();
+  // Process timers pending during sleep
+  if (!LoRaBoardStartTimerAlarm(0)) {
+    printf("ERROR. Failed to start board timer.\n");
+  }
+}
@@ -0,0 +1,288 @@
+//==========================================================================
+// Channel selection checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "channel-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "RegionCommon.h"
+#include "RegionNvm.h"
+#include "host_os.h"
+#include "radio.h"
+#include "utilities.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Channel"
+#define TABLE_CHANNELS 96
+#define TABLE_MASK_SIZE (TABLE_CHANNELS / 16)
+#define TABLE_BANDS 6
+
+//==========================================================================
+// Variables
+//==========================================================================
+static ChannelParams_t gChannels[TABLE_CHANNELS];
+static uint16_t gMask[TABLE_MASK_SIZE];
+static uint16_t gJoinMask[TABLE_MASK_SIZE];
+static Band_t gBands[TABLE_BANDS];
+
+static RegionNvmDataGroup1_t gNvmGroup1;
+static RegionNvmDataGroup2_t gNvmGroup2;
+static Band_t gRegionBands[REGION_NVM_MAX_NB_BANDS];
+
+static uint32_t gRandom = 0x2545F491;
+
+//==========================================================================
+//==========================================================================
+static uint32_t NextRandom(void) {
+  gRandom ^= gRandom << 13;
+  gRandom ^= gRandom >> 17;
+  gRandom ^= gRandom << 5;
+  return gRandom;
+}
+
+// The channel loop of RegionCommonCountNbOfEnabledChannels() before
+static void RefCountEnabled(RegionCommonCountNbOfEnabledChannelsParams_t *aParams, uint8_t *aEnabled,
+                            uint8_t *aNbEnabled, uint8_t *aNbRestricted) {
+  uint8_t nb_enabled = 0;
+  uint8_t nb_restricted = 0;
+
+  for (uint8_t i = 0, k = 0; i < aParams->MaxNbChannels; i += 16, k++) {
+    for (uint8_t j = 0; j < 16; j++) {
+      if ((aParams->ChannelsMask[k] & (1 << j)) == 0) {
+        continue;
+      }
+      if (aParams->Channels[i + j].Frequency == 0) {
+        continue;
+      }
+      if ((aParams->Joined == false) && (aParams->JoinChannels != NULL) &&
+          ((aParams->JoinChannels[k] & (1 << j)) == 0)) {
+        continue;
+      }
+      if (RegionCommonValueInRange(aParams->Datarate, aParams->Channels[i + j].DrRange.Fields.Min,
+                                   aParams->Channels[i + j].DrRange.Fields.Max) == false) {
+        continue;
+      }
+      if (aParams->Bands[aParams->Channels[i + j].Band].ReadyForTransmission == false) {
+        nb_restricted++;
+        continue;
+      }
+      aEnabled[nb_enabled++] = i + j;
+    }
+  }
+  *aNbEnabled = nb_enabled;
+  *aNbRestricted = nb_restricted;
+}
+
+static void RandomTable(void) {
+  for (uint8_t i = 0; i < TABLE_CHANNELS; i++) {
+    uint32_t r = NextRandom();
+    uint8_t min = r & 0x07;
+    uint8_t max = min + ((r >> 3) & 0x07);
+    gChannels[i].Frequency = ((r >> 6) & 0x07) ? 868100000 + i * 200000 : 0;
+    gChannels[i].DrRange.Fields.Min = min;
+    gChannels[i].DrRange.Fields.Max = (max > 15) ? 15 : max;
+    gChannels[i].Band = (r >> 9) % TABLE_BANDS;
+  }
+  for (uint8_t k = 0; k < TABLE_MASK_SIZE; k++) {
+    uint32_t r = NextRandom();
+    // Sparse, dense and random masks
+    gMask[k] = ((r >> 16) & 1) ? (uint16_t)r : (((r >> 17) & 1) ? (uint16_t)(r & (r >> 5)) : 0xFFFF);
+    gJoinMask[k] = (uint16_t)NextRandom();
+  }
+  for (uint8_t b = 0; b < TABLE_BANDS; b++) {
+    gBands[b].ReadyForTransmission = (NextRandom() & 3) != 0;
+  }
+}
+
+// A 96 channel table: 64 channels DR0 to DR3 and 32 channels DR4, a band
+static void DenseTable(uint8_t aEnabled) {
+  memset(gChannels, 0, sizeof(gChannels));
+  memset(gMask, 0, sizeof(gMask));
+  for (uint8_t i = 0; i < TABLE_CHANNELS; i++) {
+    gChannels[i].Frequency = 902300000 + i * 200000;
+    gChannels[i].DrRange.Value = (i < 64) ? ((DR_3 << 4) | DR_0) : ((DR_4 << 4) | DR_4);
+    gChannels[i].Band = 0;
+  }
+  for (uint8_t i = 0; i < aEnabled; i++) {
+    gMask[i / 16] |= 1 << (i % 16);
+  }
+  memset(gBands, 0, sizeof(gBands));
+  gBands[0].DCycle = 1;
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckEnumeration(void) {
+  RegionCommonCountNbOfEnabledChannelsParams_t params;
+  uint8_t enabled[TABLE_CHANNELS];
+  uint8_t ref_enabled[TABLE_CHANNELS];
+  uint8_t nb_enabled;
+  uint8_t nb_restricted;
+  uint8_t ref_nb_enabled;
+  uint8_t ref_nb_restricted;
+  uint32_t mismatches = 0;
+
+  for (uint32_t t = 0; t < CHANNEL_CHECK_TABLES; t++) {
+    RandomTable();
+    params.Joined = (t & 1) != 0;
+    params.Datarate = NextRandom() & 0x0F;
+    params.ChannelsMask = gMask;
+    params.Channels = gChannels;
+    params.Bands = gBands;
+    params.MaxNbChannels = 16 * (1 + (t % TABLE_MASK_SIZE));
+    params.JoinChannels = (t & 2) ? gJoinMask : NULL;
+
+    RegionCommonCountNbOfEnabledChannels(&params, enabled, &nb_enabled, &nb_restricted);
+    RefCountEnabled(&params, ref_enabled, &ref_nb_enabled, &ref_nb_restricted);
+    bool same = (nb_enabled == ref_nb_enabled) && (nb_restricted == ref_nb_restricted) &&
+                (memcmp(enabled, ref_enabled, nb_enabled) == 0);
+
+    // Any enabled channel supporting the datarate
+    bool ref_dr = false;
+    for (uint8_t i = 0; i < params.MaxNbChannels; i++) {
+      if ((gMask[i / 16] & (1 << (i % 16))) &&
+          RegionCommonValueInRange(params.Datarate, gChannels[i].DrRange.Fields.Min & 0x0F,
+                                   gChannels[i].DrRange.Fields.Max & 0x0F)) {
+        ref_dr = true;
+        break;
+      }
+    }
+    same = same && (RegionCommonChanVerifyDr(params.MaxNbChannels, gMask, params.Datarate, DR_0, DR_15,
+                                             gChannels) == ref_dr);
+
+    uint8_t ref_count = 0;
+    for (uint8_t i = 0; i < TABLE_CHANNELS; i++) {
+      ref_count += (gMask[i / 16] >> (i % 16)) & 1;
+    }
+    same = same && (RegionCommonCountChannels(gMask, 0, TABLE_MASK_SIZE) == ref_count);
+
+    if (!same && (mismatches++ == 0)) {
+      printf("Channel table %u: enabled %u/%u restricted %u/%u\n", t, nb_enabled, ref_nb_enabled, nb_restricted,
+             ref_nb_restricted);
+    }
+  }
+  printf("Channel: %u random tables, %u differ\n", CHANNEL_CHECK_TABLES, mismatches);
+  return HostOsCheck(CHECK_GROUP, mismatches == 0, "enumeration");
+}
+
+//==========================================================================
+// Time per call
+//==========================================================================
+static void BenchRegion(const char *aName, LoRaMacRegion_t aRegion, RadioChip_t aChip, uint8_t aChannels,
+                        uint32_t aFirstFrequency) {
+  InitDefaultsParams_t init;
+  NextChanParams_t next;
+  ChannelAddParams_t add;
+  ChannelParams_t channel;
+  uint8_t id;
+  TimerTime_t time;
+  TimerTime_t aggregated;
+  uint32_t found = 0;
+
+  RadioSelectChip(aChip);
+  memset(&gNvmGroup1, 0, sizeof(gNvmGroup1));
+  memset(&gNvmGroup2, 0, sizeof(gNvmGroup2));
+  init.NvmGroup1 = &gNvmGroup1;
+  init.NvmGroup2 = &gNvmGroup2;
+  init.Bands = gRegionBands;
+  init.Type = INIT_TYPE_DEFAULTS;
+  RegionInitDefaults(aRegion, &init);
+
+  for (uint8_t i = 3; i < aChannels; i++) {
+    channel.Frequency = aFirstFrequency + (i - 3) * 200000;
+    channel.Rx1Frequency = 0;
+    channel.DrRange.Value = (DR_5 << 4) | DR_0;
+    channel.Band = 0;
+    add.NewChannel = &channel;
+    add.ChannelId = i;
+    RegionChannelAdd(aRegion, &add);
+  }
+
+  memset(&next, 0, sizeof(next));
+  next.Datarate = DR_3;
+  next.Joined = true;
+  next.DutyCycleEnabled = true;
+  next.PktLen = 20;
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  for (uint32_t n = 0; n < CHANNEL_CHECK_BENCH_CALLS; n++) {
+    if (RegionNextChannel(aRegion, &next, &id, &time, &aggregated) == LORAMAC_STATUS_OK) {
+      found++;
+    }
+  }
+  uint64_t us = HostOsGetWallTimeUs() - start_us;
+  printf("Channel %s %u channels: %.1f ns per RegionNextChannel()%s\n", aName, aChannels,
+         us * 1000.0 / CHANNEL_CHECK_BENCH_CALLS, (found == CHANNEL_CHECK_BENCH_CALLS) ? "" : ", no channel");
+}
+
+// The NextChannel of US915, AU915 and CN470 around RegionCommonIdentifyChannels()
+static void BenchTable(uint8_t aEnabled) {
+  RegionCommonIdentifyChannelsParam_t identify;
+  RegionCommonCountNbOfEnabledChannelsParams_t count;
+  uint8_t enabled[TABLE_CHANNELS];
+  uint8_t nb_enabled;
+  uint8_t nb_restricted;
+  TimerTime_t time;
+  TimerTime_t aggregated;
+  uint32_t sum = 0;
+
+  DenseTable(aEnabled);
+  memset(&identify, 0, sizeof(identify));
+  count.Joined = true;
+  count.Datarate = DR_2;
+  count.ChannelsMask = gMask;
+  count.Channels = gChannels;
+  count.Bands = gBands;
+  count.MaxNbChannels = TABLE_CHANNELS;
+  count.JoinChannels = NULL;
+  identify.DutyCycleEnabled = false;
+  identify.MaxBands = 1;
+  identify.ElapsedTimeSinceStartUp.Seconds = 10;
+  identify.ExpectedTimeOnAir = 100;
+  identify.CountNbOfEnabledChannelsParam = &count;
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  for (uint32_t n = 0; n < CHANNEL_CHECK_BENCH_CALLS; n++) {
+    if (RegionCommonIdentifyChannels(&identify, &aggregated, enabled, &nb_enabled, &nb_restricted, &time) ==
+        LORAMAC_STATUS_OK) {
+      sum += enabled[randr(0, nb_enabled - 1)];
+    }
+  }
+  uint64_t us = HostOsGetWallTimeUs() - start_us;
+  printf("Channel table 96 channels, %u enabled: %.1f ns per selection%s\n", aEnabled,
+         us * 1000.0 / CHANNEL_CHECK_BENCH_CALLS, (sum > 0) ? "" : ", no channel");
+}
+
+//==========================================================================
+//==========================================================================
+int ChannelCheckRunChecks(void) {
+  int failed = 0;
+
+  failed += CheckEnumeration();
+  BenchRegion("EU868", LORAMAC_REGION_EU868, RADIO_CHIP_SX126X, 3, 0);
+  BenchRegion("EU868", LORAMAC_REGION_EU868, RADIO_CHIP_SX126X, 8, 865100000);
+  BenchRegion("EU868", LORAMAC_REGION_EU868, RADIO_CHIP_SX126X, 16, 865100000);
+  BenchRegion("ISM2400", LORAMAC_REGION_ISM2400, RADIO_CHIP_SX1280, 3, 0);
+  BenchTable(8);
+  BenchTable(64);
+  BenchTable(96);
+  printf("Channel check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,28 @@
+//==========================================================================
+// Channel selection checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Compares the channel enumeration of mac/region/RegionCommon.c with the
+// bit by bit loop it replaced on random channel tables: frequencies,
+// datarate ranges, bands ready or not, join channels and masks. Then
+// prints the time per RegionNextChannel() call of the regions built into
+// the host port, and of a 96 channel table like US915, AU915 and CN470,
+// for several channel mask densities.
+//==========================================================================
+#ifndef INC_CHANNEL_CHECK_H
+#define INC_CHANNEL_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define CHANNEL_CHECK_TABLES 20000
+#define CHANNEL_CHECK_BENCH_CALLS 100000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int ChannelCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_CHANNEL_CHECK_H
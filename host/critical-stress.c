@@ -0,0 +1,136 @@
+//==========================================================================
+// Critical section contention test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "critical-stress.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "critical-section.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Critical"
+// Work between the read and the write of a counter, a preemption there
+// loses updates without the lock
+#define STRESS_WINDOW_LOOPS 20
+
+#define HOLD_DELAY_TICKS 2
+
+//==========================================================================
+// Variables
+//==========================================================================
+static volatile uint32_t gCounter[LORA_CRITICAL_COUNT];
+static uint32_t gTasksDone;
+
+//==========================================================================
+// Half of the tasks use the timer lock, the other half the radio lock.
+// Every fourth update enters the section again.
+//==========================================================================
+static void StressTask(void *aParam) {
+  LoRaCriticalId_t id = (LoRaCriticalId_t)(uintptr_t)aParam;
+
+  for (uint32_t i = 0; i < CRITICAL_STRESS_LOOPS; i++) {
+    bool nest = ((i & 3) == 0);
+    LoRaCriticalEnter(id);
+    if (nest) {
+      LoRaCriticalEnter(id);
+    }
+    uint32_t value = gCounter[id];
+    for (volatile uint32_t k = 0; k < STRESS_WINDOW_LOOPS; k++) {
+    }
+    gCounter[id] = value + 1;
+    if (nest) {
+      LoRaCriticalExit(id);
+    }
+    LoRaCriticalExit(id);
+  }
+  __atomic_fetch_add(&gTasksDone, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckContention(void) {
+  const LoRaCriticalId_t kIds[2] = {LORA_CRITICAL_TIMER, LORA_CRITICAL_RADIO};
+  uint32_t expected = CRITICAL_STRESS_TASKS / 2 * CRITICAL_STRESS_LOOPS;
+  LoRaCriticalStats_t timer_stats;
+  LoRaCriticalStats_t radio_stats;
+
+  gCounter[LORA_CRITICAL_TIMER] = 0;
+  gCounter[LORA_CRITICAL_RADIO] = 0;
+  gTasksDone = 0;
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  for (uint8_t i = 0; i < CRITICAL_STRESS_TASKS; i++) {
+    if (xTaskCreate(StressTask, "CriticalStress", 2048, (void *)(uintptr_t)kIds[i & 1], 1, NULL) != pdPASS) {
+      return HostOsCheck(CHECK_GROUP, false, "contention");
+    }
+  }
+  // Virtual time stands still until all stress tasks have ended
+  while (__atomic_load_n(&gTasksDone, __ATOMIC_ACQUIRE) < CRITICAL_STRESS_TASKS) {
+    vTaskDelay(1);
+  }
+  uint64_t wall_us = HostOsGetWallTimeUs() - start_us;
+
+  LoRaCriticalGetStats(LORA_CRITICAL_TIMER, &timer_stats);
+  LoRaCriticalGetStats(LORA_CRITICAL_RADIO, &radio_stats);
+  printf("Critical: %u tasks x %u sections on 2 locks in %.3f s, timer=%u radio=%u (expected %u each)\n",
+         CRITICAL_STRESS_TASKS, CRITICAL_STRESS_LOOPS, wall_us / 1e6, gCounter[LORA_CRITICAL_TIMER],
+         gCounter[LORA_CRITICAL_RADIO], expected);
+
+  bool ok = (gCounter[LORA_CRITICAL_TIMER] == expected) && (gCounter[LORA_CRITICAL_RADIO] == expected);
+  ok = ok && (timer_stats.enters == expected) && (timer_stats.nested == expected / 4);
+  ok = ok && (radio_stats.enters == expected) && (radio_stats.nested == expected / 4);
+  return HostOsCheck(CHECK_GROUP, ok, "contention");
+}
+
+// The hold time is taken from the outermost enter to its exit
+static int CheckHoldTime(void) {
+  LoRaCriticalStats_t stats;
+
+  LoRaCriticalEnter(LORA_CRITICAL_MAC);
+  LoRaCriticalEnter(LORA_CRITICAL_MAC);
+  LoRaCriticalExit(LORA_CRITICAL_MAC);
+  // Only the host allows to block in a section
+  vTaskDelay(HOLD_DELAY_TICKS);
+  LoRaCriticalExit(LORA_CRITICAL_MAC);
+
+  LoRaCriticalGetStats(LORA_CRITICAL_MAC, &stats);
+  uint32_t hold_us = HOLD_DELAY_TICKS * portTICK_PERIOD_MS * 1000;
+  bool ok = (stats.enters == 1) && (stats.nested == 1);
+  ok = ok && (stats.maxUs >= hold_us) && (stats.maxUs < hold_us + portTICK_PERIOD_MS * 1000);
+  ok = ok && (stats.bucket[32 - __builtin_clz(stats.maxUs)] == 1);
+  return HostOsCheck(CHECK_GROUP, ok, "hold time");
+}
+
+//==========================================================================
+//==========================================================================
+int CriticalStressRunChecks(void) {
+  int failed = 0;
+
+  LoRaCriticalResetStats();
+  failed += CheckContention();
+  failed += CheckHoldTime();
+  LoRaCriticalPrintStats();
+  LoRaCriticalResetStats();
+  printf("Critical check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,25 @@
+//==========================================================================
+// Critical section contention test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Runs platform/critical-section.c on POSIX threads: several tasks update
+// shared counters in the sections of two subsystems at once, a section is
+// entered again by its owner, and a hold is measured in virtual time.
+//==========================================================================
+#ifndef INC_CRITICAL_STRESS_H
+#define INC_CRITICAL_STRESS_H
+
+//==========================================================================
+//==========================================================================
+#define CRITICAL_STRESS_TASKS 4
+#define CRITICAL_STRESS_LOOPS 50000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int CriticalStressRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_CRITICAL_STRESS_H
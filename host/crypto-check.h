@@ -0,0 +1,26 @@
+//==========================================================================
+// Crypto checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Runs sec/aes.c against the FIPS-197 and SP800-38A vectors, compares the
+// table encryption with the byte version on random keys and blocks, and
+// prints the throughput of both. Then runs the CMAC and CTR of the
+// software crypto provider against RFC 4493 and SP800-38A.
+//==========================================================================
+#ifndef INC_CRYPTO_CHECK_H
+#define INC_CRYPTO_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define CRYPTO_CHECK_RANDOM_BLOCKS 100000
+#define CRYPTO_CHECK_SPEED_BLOCKS 1000000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int CryptoCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_CRYPTO_CHECK_H
@@ -0,0 +1,519 @@
+//==========================================================================
+// LoRa component on the host, join and uplink cycle in virtual time
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "airtime-check.h"
+#include "channel-check.h"
+#include "critical-section.h"
+#include "critical-stress.h"
+#include "crypto-check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "link-script.h"
+#include "lora_compon.h"
+#include "mock-busy.h"
+#include "mock-spi.h"
+#include "mock-sx126x-hal.h"
+#include "nvm-check.h"
+#include "nvs_flash.h"
+#include "radio_dio.h"
+#include "rxring-check.h"
+#include "rxtiming-check.h"
+#include "se-check.h"
+#include "status-stress.h"
+#include "timer-check.h"
+#include "toa-check.h"
+#include "txqueue-check.h"
+#include "utilities.h"
+#include "virtual-ns.h"
+#include "virtual-radio.h"
+#include "wakeup-check.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define DEFAULT_FRAME_COUNT 10
+#define DEFAULT_SEED 1
+#define PAYLOAD_SIZE 20
+#define APP_PORT 2  // Port of LoRaComponSendData()
+#define NS_DEV_ADDR 0x26011234
+#define NS_NET_ID 0x000013
+
+#define POLL_INTERVAL_MS 10
+#define JOIN_TIMEOUT_MS (10 * 60 * 1000)
+#define SEND_TIMEOUT_MS (5 * 60 * 1000)
+
+// Radio choice under the scripted link conditions of -l
+typedef enum {
+  LINK_MODE_NONE = 0,
+  LINK_MODE_AUTO,     // LoRaComponSetLinkSelect()
+  LINK_MODE_SUBGHZ,   // Stays on sub-GHz
+  LINK_MODE_ISM2400,  // Starts on ISM2400, the failure counts may switch
+} LinkMode_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static const uint8_t kNwkKey[16] = {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+                                    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+static const uint8_t kPidHash[32] = {0};
+
+static uint32_t gDropEvery;
+static bool gUseCopyApi;
+static bool gAlternateRadio;
+static bool gIsm2400Selected;
+static LinkMode_t gLinkMode;
+static bool gParallelJoin;
+static bool gJoinReport;  // -j or -w given
+static uint8_t gJoinLoss[2];  // Percent of the join requests lost, sub-GHz and ISM2400
+static uint32_t gJoinRandom;
+static uint16_t gDownlinkSize;
+static uint32_t gDownlinkCount;
+static uint32_t gDownlinkErrors;
+
+//==========================================================================
+// NS script, loses every n-th data uplink
+//==========================================================================
+static bool DropJoinRequest(RadioChip_t aChip) {
+  uint8_t loss = gJoinLoss[(aChip == RADIO_CHIP_SX1280) ? 1 : 0];
+
+  // xorshift32, the random numbers of the MAC stay as they are
+  gJoinRandom ^= gJoinRandom << 13;
+  gJoinRandom ^= gJoinRandom >> 17;
+  gJoinRandom ^= gJoinRandom << 5;
+  return (gJoinRandom % 100) < loss;
+}
+
+static VirtualNsAction_t NsScript(const VirtualNsUplink_t *aUplink, void *aArg) {
+  if ((aUplink->isJoin) && (DropJoinRequest(aUplink->frame->chip))) {
+    return VNS_ACTION_DROP;
+  }
+  if ((gLinkMode != LINK_MODE_NONE) && (LinkScriptDropUplink(aUplink->frame->chip))) {
+    return VNS_ACTION_DROP;
+  }
+  if ((gDropEvery > 0) && (!aUplink->isJoin) && (((aUplink->fCnt + 1) % gDropEvery) == 0)) {
+    return VNS_ACTION_DROP;
+  }
+  return VNS_ACTION_DEFAULT;
+}
+
+//==========================================================================
+//==========================================================================
+static bool IsSelectedRadioReady(void) {
+  return (LoRaComponIsIsm2400() == gIsm2400Selected) && LoRaComponIsTxReady();
+}
+
+static void PrintRadioStats(const char *aName, RadioChip_t aChip) {
+  VirtualRadioStats_t stats;
+
+  VirtualRadioGetStats(aChip, &stats);
+  printf("%s: tx=%u (%.1f ms on air), rx windows=%u done=%u timeout=%u (%.1f ms on), irq=%u\n", aName,
+         stats.txCount, stats.txAirTimeUs / 1000.0, stats.rxWindows, stats.rxDone, stats.rxTimeout,
+         stats.rxOnTimeUs / 1000.0, stats.irqCount);
+}
+
+static uint64_t GetCpuTimeUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//==========================================================================
+// Queue a frame, with a copy or built in the TX queue slot
+//==========================================================================
+static int8_t SendFrame(uint32_t aIndex, uint16_t aLen) {
+  uint8_t payload[LORAWAN_MAX_PAYLOAD_LEN];
+  uint8_t *buffer = payload;
+
+  if (!gUseCopyApi) {
+    buffer = LoRaComponReserveTxBuffer();
+    if (buffer == NULL) {
+      return -1;
+    }
+  }
+  memset(buffer, 0, aLen);
+  snprintf((char *)buffer, aLen, "frame %u", aIndex);
+
+  if (gUseCopyApi) {
+    return LoRaComponSendData(buffer, aLen);
+  } else {
+    return LoRaComponCommitTxBuffer(aLen, APP_PORT, LORA_TX_MODE_DEFAULT, LORA_TX_PRIORITY_NORMAL);
+  }
+}
+
+//==========================================================================
+// Downlink queued at the NS with each uplink, checked when received
+//==========================================================================
+static void FillDownlink(uint8_t *aData, uint16_t aLen, uint32_t aIndex) {
+  for (uint16_t i = 0; i < aLen; i++) {
+    aData[i] = (uint8_t)(aIndex + i);
+  }
+}
+
+static void CheckDownlink(const uint8_t *aData, uint16_t aLen) {
+  uint8_t expected[LORAWAN_MAX_PAYLOAD_LEN];
+
+  if (aLen > 0) {
+    FillDownlink(expected, aLen, aData[0]);
+  }
+  if ((aLen != gDownlinkSize) || (memcmp(aData, expected, aLen) != 0)) {
+    gDownlinkErrors++;
+  }
+  gDownlinkCount++;
+}
+
+static void ReceiveFrames(void) {
+  if (gUseCopyApi) {
+    uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+    int32_t len;
+    while ((len = LoRaComponGetData(data, sizeof(data), NULL)) >= 0) {
+      CheckDownlink(data, len);
+    }
+  } else {
+    LoRaRxView_t view;
+    while (LoRaComponBorrowData(&view) == 0) {
+      CheckDownlink(view.data, view.dataSize);
+      LoRaComponReleaseData(&view);
+    }
+  }
+}
+
+static void PrintCopyStats(uint32_t aUplinks, uint64_t aCpuUs) {
+  FrameCopyStats_t stats;
+
+  FrameCopyGetStats(&stats);
+  if (stats.TxFrames == 0) {
+    return;
+  }
+  printf("Uplink copies (%s): %u frames on air, %.2f copies and %.1f bytes per frame\n",
+         gUseCopyApi ? "copy" : "zero-copy", stats.TxFrames, (double)stats.TxCopies / stats.TxFrames,
+         (double)stats.TxBytes / stats.TxFrames);
+  if (stats.RxFrames > 0) {
+    printf("Downlink copies (%s): %u frames received, %.2f copies and %.1f bytes per frame, %u errors\n",
+           gUseCopyApi ? "copy" : "zero-copy", stats.RxFrames, (double)stats.RxCopies / stats.RxFrames,
+           (double)stats.RxBytes / stats.RxFrames, gDownlinkErrors);
+  }
+  if (aUplinks > 0) {
+    printf("CPU: %.1f us per uplink\n", (double)aCpuUs / aUplinks);
+  }
+}
+
+static void PrintTxOpportunity(uint16_t aLen) {
+  LoRaTxOpportunity_t info;
+
+  if (LoRaComponGetTxOpportunity(aLen, &info) != 0) {
+    printf("ERROR. LoRaComponGetTxOpportunity failed.\n");
+    return;
+  }
+  printf("Next uplink: DR%d, %u bytes, %u ms on air, in %u ms\n", info.datarate, aLen, info.timeOnAirMs,
+         info.txDelayMs);
+  for (uint8_t i = 0; i < info.bandCount; i++) {
+    LoRaBandBudget_t *band = &info.band[i];
+    if (band->usable) {
+      printf("Band %u 1/%u: %u of %u ms on air left, window %u ms left\n", band->band, band->dutyCycle,
+             band->airTimeLeftMs, band->maxAirTimeMs, band->windowLeftMs);
+    }
+  }
+}
+
+static const char *GetRadioName(bool aIsm2400) { return aIsm2400 ? "ISM2400" : "sub-GHz"; }
+
+//==========================================================================
+// TX energy of both radios per delivered frame, and the link model
+//==========================================================================
+static void PrintLinkStats(uint32_t aDelivered, uint32_t aFrames) {
+  static const char *kModeNames[] = {"", "auto", "sub-GHz", "ISM2400"};
+  VirtualRadioStats_t sub_ghz;
+  VirtualRadioStats_t ism2400;
+  LoRaLinkModel_t model;
+
+  VirtualRadioGetStats(RADIO_CHIP_SX126X, &sub_ghz);
+  VirtualRadioGetStats(RADIO_CHIP_SX1280, &ism2400);
+  uint64_t energy = sub_ghz.txEnergyUj + ism2400.txEnergyUj;
+  printf("Link %s: %u of %u frames delivered, TX energy %.1f mJ, %.1f uJ per delivered frame\n",
+         kModeNames[gLinkMode], aDelivered, aFrames, energy / 1000.0,
+         (aDelivered > 0) ? (double)energy / aDelivered : 0.0);
+  printf("Link %s: sub-GHz %u TX %.1f ms %.1f mJ, ISM2400 %u TX %.1f ms %.1f mJ\n", kModeNames[gLinkMode],
+         sub_ghz.txCount, sub_ghz.txAirTimeUs / 1000.0, sub_ghz.txEnergyUj / 1000.0, ism2400.txCount,
+         ism2400.txAirTimeUs / 1000.0, ism2400.txEnergyUj / 1000.0);
+
+  if (LoRaComponGetLinkModel(PAYLOAD_SIZE, &model) != 0) {
+    return;
+  }
+  printf("Link model: %s, on %s, %u switches, %u probes\n", model.enabled ? "on" : "off",
+         GetRadioName(model.selected == LORA_LINK_ISM2400), model.switches, model.probes);
+  for (uint8_t i = 0; i < LORA_LINK_RADIOS; i++) {
+    LoRaLinkRadio_t *radio = &model.radio[i];
+    if (!radio->known) {
+      printf("Link model %s: unknown\n", GetRadioName(i == LORA_LINK_ISM2400));
+      continue;
+    }
+    printf("Link model %s: rssi %d snr %d margin %d dB, %u/%u ACKs, ratio %u delivery %u frame %u, %d dBm, %u ms, "
+           "%u uJ per frame, %u nJ per byte, delay %u ms, %u ms on air left\n",
+           GetRadioName(i == LORA_LINK_ISM2400), radio->rssi, radio->snr, radio->snrMargin, radio->acks,
+           radio->attempts, radio->ackRatio, radio->delivery, radio->frameDelivery, radio->txPowerDbm, radio->timeOnAirMs, radio->energyUj,
+           radio->energyPerByteNj, radio->txDelayMs, radio->airTimeLeftMs);
+  }
+}
+
+static void PrintStats(void) {
+  VirtualNsStats_t ns_stats;
+  HostNvsStats_t nvs_stats;
+
+  PrintRadioStats("SX126x", RADIO_CHIP_SX126X);
+  PrintRadioStats("SX1280", RADIO_CHIP_SX1280);
+  RadioDioPrintStats();
+  LoRaCriticalPrintStats();
+
+  VirtualNsGetStats(&ns_stats);
+  printf("NS: join req=%u accept=%u, uplinks=%u, mic errors=%u, dropped=%u, downlinks=%u, acks=%u\n",
+         ns_stats.joinRequests, ns_stats.joinAccepts, ns_stats.uplinks, ns_stats.micErrors, ns_stats.dropped,
+         ns_stats.downlinks, ns_stats.acks);
+
+  HostNvsGetStats(&nvs_stats);
+  printf("NVS: set=%u (%u bytes), commit=%u, erase=%u\n", nvs_stats.setCount, nvs_stats.bytesWritten,
+         nvs_stats.commitCount, nvs_stats.eraseCount);
+
+  printf("Time: virtual %.3f s, wall %.3f s\n", HostOsGetTimeUs() / 1e6, HostOsGetWallTimeUs() / 1e6);
+}
+
+static void PrintUsage(const char *aProgram) {
+  printf(
+      "Usage: %s [-n frames] [-s seed] [-d drop_every] [-f nvs_file] [-r downlink_size] [-c] [-a] "
+      "[-l auto|subghz|ism2400] [-j sequential|parallel] [-w subghz_loss,ism2400_loss] [-t]\n",
+      aProgram);
+}
+
+//==========================================================================
+//==========================================================================
+int main(int argc, char *argv[]) {
+  uint32_t frame_count = DEFAULT_FRAME_COUNT;
+  uint32_t seed = DEFAULT_SEED;
+  const char *nvs_file = NULL;
+  bool radio_check = false;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+      frame_count = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "-d") == 0) && (i + 1 < argc)) {
+      gDropEvery = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) {
+      nvs_file = argv[++i];
+    } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+      gDownlinkSize = strtoul(argv[++i], NULL, 0);
+      if (gDownlinkSize > LORAWAN_MAX_PAYLOAD_LEN) {
+        gDownlinkSize = LORAWAN_MAX_PAYLOAD_LEN;
+      }
+    } else if (strcmp(argv[i], "-c") == 0) {
+      gUseCopyApi = true;
+    } else if (strcmp(argv[i], "-a") == 0) {
+      gAlternateRadio = true;
+    } else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) {
+      i++;
+      if (strcmp(argv[i], "auto") == 0) {
+        gLinkMode = LINK_MODE_AUTO;
+      } else if (strcmp(argv[i], "subghz") == 0) {
+        gLinkMode = LINK_MODE_SUBGHZ;
+      } else if (strcmp(argv[i], "ism2400") == 0) {
+        gLinkMode = LINK_MODE_ISM2400;
+      } else {
+        PrintUsage(argv[0]);
+        return 1;
+      }
+    } else if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc)) {
+      i++;
+      gJoinReport = true;
+      if (strcmp(argv[i], "parallel") == 0) {
+        gParallelJoin = true;
+      } else if (strcmp(argv[i], "sequential") != 0) {
+        PrintUsage(argv[0]);
+        return 1;
+      }
+    } else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc)) {
+      unsigned int sub_ghz;
+      unsigned int ism2400;
+      if ((sscanf(argv[++i], "%u,%u", &sub_ghz, &ism2400) != 2) || (sub_ghz > 100) || (ism2400 > 100)) {
+        PrintUsage(argv[0]);
+        return 1;
+      }
+      gJoinReport = true;
+      gJoinLoss[0] = sub_ghz;
+      gJoinLoss[1] = ism2400;
+    } else if (strcmp(argv[i], "-t") == 0) {
+      radio_check = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  HostOsInit(seed);
+  int failed = 0;
+  if (radio_check) {
+    failed += MockSpiRunChecks();
+    failed += MockBusyRunChecks();
+    failed += MockSx126xRunChecks();
+    failed += StatusStressRunChecks();
+    failed += CriticalStressRunChecks();
+    failed += ToaCheckRunChecks();
+    failed += ChannelCheckRunChecks();
+    failed += AirtimeCheckRunChecks();
+    failed += TimerCheckRunChecks();
+    failed += CryptoCheckRunChecks();
+    failed += SeCheckRunChecks();
+    failed += TxQueueCheckRunChecks();
+    failed += RxRingCheckRunChecks();
+  }
+  nvs_flash_init();
+  if ((nvs_file != NULL) && (HostNvsLoadFile(nvs_file) == 0)) {
+    printf("NVS loaded from %s.\n", nvs_file);
+  }
+  if (gLinkMode != LINK_MODE_NONE) {
+    LinkScriptInit(seed);
+    LinkScriptApply(0);
+    frame_count = LinkScriptFrameCount();
+  }
+  gJoinRandom = (seed != 0) ? seed : 1;
+  VirtualNsInit(kNwkKey, NS_DEV_ADDR, NS_NET_ID);
+  VirtualNsSetScript(NsScript, NULL);
+  if ((nvs_file != NULL) && (VirtualNsRestoreSession() == 0)) {
+    printf("NS session restored.\n");
+  }
+
+  LoRaComponHwInit();
+  if (LoRaComponStart("host", kPidHash, false) != 0) {
+    printf("ERROR. LoRaComponStart failed.\n");
+    return 1;
+  }
+  LoRaComponSetLinkSelect(gLinkMode == LINK_MODE_AUTO);
+  LoRaComponSetParallelJoin(gParallelJoin);
+  printf("Region: %s\n", LoRaComponRegionName());
+
+  uint64_t start_us = HostOsGetTimeUs();
+  if (!HostOsWaitFor(LoRaComponIsJoined, JOIN_TIMEOUT_MS, POLL_INTERVAL_MS)) {
+    printf("ERROR. Join timeout.\n");
+    PrintStats();
+    return 1;
+  }
+  printf("Joined in %.3f s.\n", (HostOsGetTimeUs() - start_us) / 1e6);
+  // The wakeup check needs the joined component, the NVM check stops it
+  // and goes on with the MAC it leaves
+  if (radio_check) {
+    failed += WakeupCheckRunChecks();
+    failed += TxQueueCheckRunRoundTrips();
+    failed += RxTimingCheckRunChecks();
+    failed += NvmCheckRunChecks();
+    return (failed == 0) ? 0 : 1;
+  }
+  if (gJoinReport) {
+    VirtualRadioStats_t sub_ghz;
+    VirtualRadioStats_t ism2400;
+    VirtualRadioGetStats(RADIO_CHIP_SX126X, &sub_ghz);
+    VirtualRadioGetStats(RADIO_CHIP_SX1280, &ism2400);
+    printf("Join %s: on %s, %u requests on sub-GHz, %u on ISM2400.\n", gParallelJoin ? "parallel" : "sequential",
+           GetRadioName(LoRaComponIsIsm2400()), sub_ghz.txCount, ism2400.txCount);
+  }
+  if (gLinkMode == LINK_MODE_ISM2400) {
+    gIsm2400Selected = true;
+    if ((LoRaComponSelectRadio(true) != 0) ||
+        (!HostOsWaitFor(IsSelectedRadioReady, JOIN_TIMEOUT_MS, POLL_INTERVAL_MS))) {
+      printf("ERROR. ISM2400 not joined.\n");
+      PrintStats();
+      return 1;
+    }
+  }
+
+  uint32_t success_count = 0;
+  uint64_t cpu_us = GetCpuTimeUs();
+  FrameCopyResetStats();
+  for (uint32_t i = 0; i < frame_count; i++) {
+    // Each radio keeps its session, only the first frame on ISM2400 joins
+    uint64_t ready_us = HostOsGetTimeUs();
+    if (gAlternateRadio) {
+      gIsm2400Selected = ((i % 2) == 1);
+      if (LoRaComponSelectRadio(gIsm2400Selected) != 0) {
+        printf("ERROR. LoRaComponSelectRadio failed.\n");
+        break;
+      }
+    }
+    if (gLinkMode != LINK_MODE_NONE) {
+      const char *phase = LinkScriptApply(i);
+      if (phase != NULL) {
+        printf("Phase: %s.\n", phase);
+      }
+    }
+    if (!HostOsWaitFor(gAlternateRadio ? IsSelectedRadioReady : LoRaComponIsTxReady,
+                       (gLinkMode != LINK_MODE_NONE) ? JOIN_TIMEOUT_MS : SEND_TIMEOUT_MS, POLL_INTERVAL_MS)) {
+      printf("ERROR. TX not ready.\n");
+      break;
+    }
+    ready_us = HostOsGetTimeUs() - ready_us;
+
+    if (gDownlinkSize > 0) {
+      uint8_t downlink[LORAWAN_MAX_PAYLOAD_LEN];
+      FillDownlink(downlink, gDownlinkSize, i);
+      VirtualNsQueueDownlink(APP_PORT, downlink, gDownlinkSize);
+    }
+
+    start_us = HostOsGetTimeUs();
+    if (SendFrame(i, PAYLOAD_SIZE) != 0) {
+      printf("ERROR. Failed to queue frame %u.\n", i);
+      break;
+    }
+    if (!HostOsWaitFor(LoRaComponIsSendDone, SEND_TIMEOUT_MS, POLL_INTERVAL_MS)) {
+      printf("ERROR. Send timeout.\n");
+      break;
+    }
+    bool success = LoRaComponIsSendSuccess();
+    if (success) {
+      success_count++;
+    }
+    ReceiveFrames();
+    if (gAlternateRadio) {
+      printf("Frame %u: %s in %.3f s on %s, radio ready after %.3f s.\n", i, success ? "ACK" : "no ACK",
+             (HostOsGetTimeUs() - start_us) / 1e6, GetRadioName(gIsm2400Selected), ready_us / 1e6);
+    } else if (gLinkMode != LINK_MODE_NONE) {
+      printf("Frame %u: %s in %.3f s on %s.\n", i, success ? "ACK" : "no ACK", (HostOsGetTimeUs() - start_us) / 1e6,
+             GetRadioName(LoRaComponIsIsm2400()));
+    } else {
+      printf("Frame %u: %s in %.3f s.\n", i, success ? "ACK" : "no ACK", (HostOsGetTimeUs() - start_us) / 1e6);
+    }
+  }
+  cpu_us = GetCpuTimeUs() - cpu_us;
+  printf("%u of %u frames acknowledged.\n", success_count, frame_count);
+  PrintCopyStats(frame_count, cpu_us);
+  PrintTxOpportunity(PAYLOAD_SIZE);
+  if (gLinkMode != LINK_MODE_NONE) {
+    PrintLinkStats(success_count, frame_count);
+  }
+
+  LoRaComponStop();
+  PrintStats();
+
+  if (nvs_file != NULL) {
+    VirtualNsSaveSession();
+    if (HostNvsSaveFile(nvs_file) != 0) {
+      printf("ERROR. Failed to save NVS to %s.\n", nvs_file);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,380 @@
+//==========================================================================
+// NVS for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvs_flash.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define NVS_KEY_NAME_MAX_SIZE 16
+#define NVS_MAX_NAMESPACES 16
+#define NVS_MAX_ENTRIES 64
+#define NVS_MAX_HANDLES 16
+#define NVS_MAX_BLOB_SIZE 4000
+
+typedef enum {
+  NVS_TYPE_U8 = 1,
+  NVS_TYPE_U32,
+  NVS_TYPE_BLOB,
+} NvsType_t;
+
+typedef struct {
+  bool used;
+  uint8_t nsIndex;
+  uint8_t type;
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  uint16_t size;
+  uint8_t *data;
+} NvsEntry_t;
+
+typedef struct {
+  bool used;
+  bool readOnly;
+  uint8_t nsIndex;
+} NvsHandle_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static pthread_mutex_t gNvsLock = PTHREAD_MUTEX_INITIALIZER;
+static bool gNvsReady;
+static char gNamespaces[NVS_MAX_NAMESPACES][NVS_KEY_NAME_MAX_SIZE];
+static uint8_t gNamespaceCount;
+static NvsEntry_t gEntries[NVS_MAX_ENTRIES];
+static NvsHandle_t gHandles[NVS_MAX_HANDLES];
+static HostNvsStats_t gNvsStats;
+
+//==========================================================================
+// Helpers. Must be called with gNvsLock held.
+//==========================================================================
+static int FindNamespace(const char *aName) {
+  for (int i = 0; i < gNamespaceCount; i++) {
+    if (strncmp(gNamespaces[i], aName, NVS_KEY_NAME_MAX_SIZE) == 0) return i;
+  }
+  return -1;
+}
+
+static NvsHandle_t *GetHandle(nvs_handle_t aHandle) {
+  if ((aHandle == 0) || (aHandle > NVS_MAX_HANDLES)) return NULL;
+  NvsHandle_t *h = &gHandles[aHandle - 1];
+  return h->used ? h : NULL;
+}
+
+static NvsEntry_t *FindEntry(uint8_t aNsIndex, const char *aKey) {
+  for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+    NvsEntry_t *e = &gEntries[i];
+    if ((e->used) && (e->nsIndex == aNsIndex) && (strncmp(e->key, aKey, NVS_KEY_NAME_MAX_SIZE) == 0)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static void FreeEntry(NvsEntry_t *aEntry) {
+  free(aEntry->data);
+  memset(aEntry, 0, sizeof(NvsEntry_t));
+}
+
+static esp_err_t SetValue(nvs_handle_t aHandle, const char *aKey, uint8_t aType, const void *aValue, size_t aLength) {
+  if ((strlen(aKey) >= NVS_KEY_NAME_MAX_SIZE) || (aLength > NVS_MAX_BLOB_SIZE)) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+
+  pthread_mutex_lock(&gNvsLock);
+  NvsHandle_t *h = GetHandle(aHandle);
+  if (h == NULL) {
+    pthread_mutex_unlock(&gNvsLock);
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  if (h->readOnly) {
+    pthread_mutex_unlock(&gNvsLock);
+    return ESP_ERR_NVS_READ_ONLY;
+  }
+
+  NvsEntry_t *e = FindEntry(h->nsIndex, aKey);
+  if (e == NULL) {
+    for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+      if (!gEntries[i].used) {
+        e = &gEntries[i];
+        break;
+      }
+    }
+    if (e == NULL) {
+      pthread_mutex_unlock(&gNvsLock);
+      return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+  }
+
+  uint8_t *data = malloc(aLength > 0 ? aLength : 1);
+  if (data == NULL) {
+    pthread_mutex_unlock(&gNvsLock);
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(data, aValue, aLength);
+  free(e->data);
+  e->used = true;
+  e->nsIndex = h->nsIndex;
+  e->type = aType;
+  strncpy(e->key, aKey, NVS_KEY_NAME_MAX_SIZE - 1);
+  e->size = (uint16_t)aLength;
+  e->data = data;
+
+  gNvsStats.setCount++;
+  gNvsStats.bytesWritten += aLength;
+  pthread_mutex_unlock(&gNvsLock);
+  return ESP_OK;
+}
+
+static esp_err_t GetValue(nvs_handle_t aHandle, const char *aKey, uint8_t aType, void *aValue, size_t *aLength) {
+  esp_err_t ret = ESP_OK;
+
+  pthread_mutex_lock(&gNvsLock);
+  NvsHandle_t *h = GetHandle(aHandle);
+  NvsEntry_t *e = (h != NULL) ? FindEntry(h->nsIndex, aKey) : NULL;
+  if (h == NULL) {
+    ret = ESP_ERR_NVS_INVALID_HANDLE;
+  } else if (e == NULL) {
+    ret = ESP_ERR_NVS_NOT_FOUND;
+  } else if (e->type != aType) {
+    ret = ESP_ERR_NVS_TYPE_MISMATCH;
+  } else if (aValue == NULL) {
+    // Size query
+    *aLength = e->size;
+  } else if (*aLength < e->size) {
+    ret = ESP_ERR_NVS_INVALID_LENGTH;
+  } else {
+    memcpy(aValue, e->data, e->size);
+    *aLength = e->size;
+  }
+  pthread_mutex_unlock(&gNvsLock);
+  return ret;
+}
+
+//==========================================================================
+// Init
+//==========================================================================
+esp_err_t nvs_flash_init(void) {
+  gNvsReady = true;
+  return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+  pthread_mutex_lock(&gNvsLock);
+  for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+    if (gEntries[i].used) FreeEntry(&gEntries[i]);
+  }
+  gNamespaceCount = 0;
+  gNvsStats.eraseCount++;
+  pthread_mutex_unlock(&gNvsLock);
+  return ESP_OK;
+}
+
+//==========================================================================
+// Handles
+//==========================================================================
+esp_err_t nvs_open(const char *aNamespace, nvs_open_mode_t aMode, nvs_handle_t *aHandle) {
+  if (!gNvsReady) return ESP_ERR_NVS_NOT_INITIALIZED;
+  if (strlen(aNamespace) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_INVALID_LENGTH;
+
+  pthread_mutex_lock(&gNvsLock);
+  int ns = FindNamespace(aNamespace);
+  if (ns < 0) {
+    if (aMode == NVS_READONLY) {
+      pthread_mutex_unlock(&gNvsLock);
+      return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (gNamespaceCount >= NVS_MAX_NAMESPACES) {
+      pthread_mutex_unlock(&gNvsLock);
+      return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    ns = gNamespaceCount++;
+    strncpy(gNamespaces[ns], aNamespace, NVS_KEY_NAME_MAX_SIZE - 1);
+  }
+
+  for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+    if (!gHandles[i].used) {
+      gHandles[i].used = true;
+      gHandles[i].readOnly = (aMode == NVS_READONLY);
+      gHandles[i].nsIndex = (uint8_t)ns;
+      *aHandle = (nvs_handle_t)(i + 1);
+      pthread_mutex_unlock(&gNvsLock);
+      return ESP_OK;
+    }
+  }
+  pthread_mutex_unlock(&gNvsLock);
+  return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t aHandle) {
+  pthread_mutex_lock(&gNvsLock);
+  NvsHandle_t *h = GetHandle(aHandle);
+  if (h != NULL) {
+    h->used = false;
+  }
+  pthread_mutex_unlock(&gNvsLock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t aHandle) {
+  pthread_mutex_lock(&gNvsLock);
+  esp_err_t ret = (GetHandle(aHandle) != NULL) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+  if (ret == ESP_OK) {
+    gNvsStats.commitCount++;
+  }
+  pthread_mutex_unlock(&gNvsLock);
+  return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t aHandle, const char *aKey) {
+  esp_err_t ret = ESP_OK;
+
+  pthread_mutex_lock(&gNvsLock);
+  NvsHandle_t *h = GetHandle(aHandle);
+  NvsEntry_t *e = (h != NULL) ? FindEntry(h->nsIndex, aKey) : NULL;
+  if ((h == NULL) || (h->readOnly)) {
+    ret = (h == NULL) ? ESP_ERR_NVS_INVALID_HANDLE : ESP_ERR_NVS_READ_ONLY;
+  } else if (e == NULL) {
+    ret = ESP_ERR_NVS_NOT_FOUND;
+  } else {
+    FreeEntry(e);
+    gNvsStats.eraseCount++;
+  }
+  pthread_mutex_unlock(&gNvsLock);
+  return ret;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t aHandle) {
+  pthread_mutex_lock(&gNvsLock);
+  NvsHandle_t *h = GetHandle(aHandle);
+  if ((h == NULL) || (h->readOnly)) {
+    pthread_mutex_unlock(&gNvsLock);
+    return (h == NULL) ? ESP_ERR_NVS_INVALID_HANDLE : ESP_ERR_NVS_READ_ONLY;
+  }
+  for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+    if ((gEntries[i].used) && (gEntries[i].nsIndex == h->nsIndex)) {
+      FreeEntry(&gEntries[i]);
+    }
+  }
+  gNvsStats.eraseCount++;
+  pthread_mutex_unlock(&gNvsLock);
+  return ESP_OK;
+}
+
+//==========================================================================
+// Values
+//==========================================================================
+esp_err_t nvs_get_blob(nvs_handle_t aHandle, const char *aKey, void *aValue, size_t *aLength) {
+  return GetValue(aHandle, aKey, NVS_TYPE_BLOB, aValue, aLength);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t aHandle, const char *aKey, const void *aValue, size_t aLength) {
+  return SetValue(aHandle, aKey, NVS_TYPE_BLOB, aValue, aLength);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t aHandle, const char *aKey, uint8_t *aValue) {
+  size_t len = sizeof(uint8_t);
+  return GetValue(aHandle, aKey, NVS_TYPE_U8, aValue, &len);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t aHandle, const char *aKey, uint8_t aValue) {
+  return SetValue(aHandle, aKey, NVS_TYPE_U8, &aValue, sizeof(aValue));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t aHandle, const char *aKey, uint32_t *aValue) {
+  size_t len = sizeof(uint32_t);
+  return GetValue(aHandle, aKey, NVS_TYPE_U32, aValue, &len);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t aHandle, const char *aKey, uint32_t aValue) {
+  return SetValue(aHandle, aKey, NVS_TYPE_U32, &aValue, sizeof(aValue));
+}
+
+//==========================================================================
+// Host only
+//==========================================================================
+void HostNvsGetStats(HostNvsStats_t *aStats) {
+  pthread_mutex_lock(&gNvsLock);
+  memcpy(aStats, &gNvsStats, sizeof(HostNvsStats_t));
+  pthread_mutex_unlock(&gNvsLock);
+}
+
+void HostNvsResetStats(void) {
+  pthread_mutex_lock(&gNvsLock);
+  memset(&gNvsStats, 0, sizeof(HostNvsStats_t));
+  pthread_mutex_unlock(&gNvsLock);
+}
+
+// File format: records of namespace, key, type, size, data
+int HostNvsSaveFile(const char *aPath) {
+  FILE *fp = fopen(aPath, "wb");
+  if (fp == NULL) {
+    printf("ERROR. HostNvsSaveFile fopen(%s) failed.\n", aPath);
+    return -1;
+  }
+
+  pthread_mutex_lock(&gNvsLock);
+  for (int i = 0; i < NVS_MAX_ENTRIES; i++) {
+    NvsEntry_t *e = &gEntries[i];
+    if (!e->used) continue;
+    fwrite(gNamespaces[e->nsIndex], 1, NVS_KEY_NAME_MAX_SIZE, fp);
+    fwrite(e->key, 1, NVS_KEY_NAME_MAX_SIZE, fp);
+    fwrite(&e->type, 1, sizeof(e->type), fp);
+    fwrite(&e->size, 1, sizeof(e->size), fp);
+    fwrite(e->data, 1, e->size, fp);
+  }
+  pthread_mutex_unlock(&gNvsLock);
+  fclose(fp);
+  return 0;
+}
+
+int HostNvsLoadFile(const char *aPath) {
+  FILE *fp = fopen(aPath, "rb");
+  if (fp == NULL) {
+    return -1;
+  }
+
+  nvs_flash_erase();
+  gNvsReady = true;
+  for (;;) {
+    char ns[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t type;
+    uint16_t size;
+    static uint8_t data[NVS_MAX_BLOB_SIZE];
+    if ((fread(ns, 1, sizeof(ns), fp) != sizeof(ns)) || (fread(key, 1, sizeof(key), fp) != sizeof(key)) ||
+        (fread(&type, 1, sizeof(type), fp) != sizeof(type)) || (fread(&size, 1, sizeof(size), fp) != sizeof(size)) ||
+        (size > sizeof(data)) || (fread(data, 1, size, fp) != size)) {
+      break;
+    }
+    ns[NVS_KEY_NAME_MAX_SIZE - 1] = 0;
+    key[NVS_KEY_NAME_MAX_SIZE - 1] = 0;
+
+    nvs_handle_t h;
+    if (nvs_open(ns, NVS_READWRITE, &h) == ESP_OK) {
+      SetValue(h, key, type, data, size);
+      nvs_close(h);
+    }
+  }
+  fclose(fp);
+
+  // Loading is not a write
+  HostNvsResetStats();
+  return 0;
+}
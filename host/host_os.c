@@ -0,0 +1,728 @@
+//==========================================================================
+// Host OS layer
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "host_os.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define HOST_MAX_TASKS 16
+#define HOST_MAX_TIMERS 16
+#define TIME_FOREVER UINT64_MAX
+
+#define TASK_PRIO_TIMER 20
+
+struct HostTask_s {
+  pthread_t thread;
+  pthread_cond_t cond;
+  const char *name;
+  TaskFunction_t func;
+  void *param;
+  bool used;
+
+  // Blocking state, protected by gOsLock
+  bool waiting;
+  bool woken;
+  bool timedOut;
+  uint64_t deadline;
+  const void *waitObj;
+
+  // Notification
+  uint32_t notifyValue;
+  bool notifyPending;
+
+  // Returns from a blocking call
+  uint32_t wakeups;
+};
+
+struct HostQueue_s {
+  uint8_t *buf;
+  UBaseType_t itemSize;  // 0 for semaphores
+  UBaseType_t length;
+  UBaseType_t head;
+  UBaseType_t count;
+};
+
+struct HostEspTimer_s {
+  esp_timer_cb_t callback;
+  void *arg;
+  const char *name;
+  uint32_t callbacks;
+  bool used;
+  bool armed;
+  uint64_t deadline;
+  uint64_t period;
+};
+
+//==========================================================================
+// Variables
+//==========================================================================
+static pthread_mutex_t gOsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gCriticalLock;  // vTaskSuspendAll()
+static pthread_mutex_t gMuxCreateLock = PTHREAD_MUTEX_INITIALIZER;
+static struct HostTask_s gTasks[HOST_MAX_TASKS];
+static __thread struct HostTask_s *gCurrentTask;
+
+// Number of tasks not blocked in a host primitive
+static int gRunningCount;
+
+// Virtual time
+static uint64_t gNowUs;
+static uint64_t gClockOffsetUs;
+static struct timespec gWallStart;
+
+// esp_timer
+static struct HostEspTimer_s gEspTimers[HOST_MAX_TIMERS];
+static const int kTimerWaitObj = 0;
+static const int kDelayWaitObj = 0;
+
+static uint32_t gRandomState;
+
+//==========================================================================
+// Scheduler core. Must be called with gOsLock held.
+//==========================================================================
+static uint64_t TicksToDeadline(TickType_t aTicks) {
+  if (aTicks == portMAX_DELAY) return TIME_FOREVER;
+  return gNowUs + (uint64_t)aTicks * portTICK_PERIOD_MS * 1000;
+}
+
+static void WakeTask(struct HostTask_s *aTask, bool aTimedOut) {
+  if ((aTask->waiting) && (!aTask->woken)) {
+    aTask->woken = true;
+    aTask->timedOut = aTimedOut;
+    gRunningCount++;
+    pthread_cond_signal(&aTask->cond);
+  }
+}
+
+static void WakeWaiters(const void *aObj) {
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    if ((gTasks[i].used) && (gTasks[i].waiting) && (gTasks[i].waitObj == aObj)) {
+      WakeTask(&gTasks[i], false);
+    }
+  }
+}
+
+// All tasks blocked, jump to the earliest deadline
+static void AdvanceTime(void) {
+  uint64_t next = TIME_FOREVER;
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    struct HostTask_s *t = &gTasks[i];
+    if ((t->used) && (t->waiting) && (!t->woken) && (t->deadline < next)) {
+      next = t->deadline;
+    }
+  }
+  if (next == TIME_FOREVER) {
+    printf("ERROR. All host tasks blocked without timeout.\n");
+    return;
+  }
+
+  if (next > gNowUs) {
+    __atomic_store_n(&gNowUs, next, __ATOMIC_RELEASE);
+  }
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    struct HostTask_s *t = &gTasks[i];
+    if ((t->used) && (t->waiting) && (!t->woken) && (t->deadline <= gNowUs)) {
+      WakeTask(t, true);
+    }
+  }
+}
+
+// Return false on timeout
+static bool BlockTask(const void *aObj, uint64_t aDeadline) {
+  struct HostTask_s *t = gCurrentTask;
+  if (t == NULL) {
+    printf("ERROR. Blocking call from a thread not created by xTaskCreate.\n");
+    abort();
+  }
+
+  t->waitObj = aObj;
+  t->deadline = aDeadline;
+  t->woken = false;
+  t->timedOut = false;
+  t->waiting = true;
+
+  gRunningCount--;
+  if (gRunningCount == 0) {
+    AdvanceTime();
+  }
+  while (!t->woken) {
+    pthread_cond_wait(&t->cond, &gOsLock);
+  }
+
+  t->waiting = false;
+  t->waitObj = NULL;
+  t->wakeups++;
+  return !t->timedOut;
+}
+
+static struct HostTask_s *AllocTask(const char *aName) {
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    struct HostTask_s *t = &gTasks[i];
+    if (!t->used) {
+      memset(t, 0, sizeof(struct HostTask_s));
+      pthread_cond_init(&t->cond, NULL);
+      t->name = aName;
+      t->used = true;
+      return t;
+    }
+  }
+  return NULL;
+}
+
+//==========================================================================
+// Tasks
+//==========================================================================
+static void *TaskEntry(void *aArg) {
+  struct HostTask_s *t = aArg;
+  gCurrentTask = t;
+  t->func(t->param);
+  vTaskDelete(NULL);
+  return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t aFunc, const char *aName, uint32_t aStackDepth, void *aParam, UBaseType_t aPrio,
+                       TaskHandle_t *aHandle) {
+  pthread_mutex_lock(&gOsLock);
+  struct HostTask_s *t = AllocTask(aName);
+  if (t == NULL) {
+    pthread_mutex_unlock(&gOsLock);
+    printf("ERROR. xTaskCreate() no free task slot.\n");
+    return pdFAIL;
+  }
+  t->func = aFunc;
+  t->param = aParam;
+  if (aHandle != NULL) {
+    *aHandle = t;
+  }
+
+  // Counted as running until it blocks
+  gRunningCount++;
+  if (pthread_create(&t->thread, NULL, TaskEntry, t) != 0) {
+    gRunningCount--;
+    t->used = false;
+    pthread_mutex_unlock(&gOsLock);
+    printf("ERROR. xTaskCreate() pthread_create failed.\n");
+    return pdFAIL;
+  }
+  pthread_detach(t->thread);
+  pthread_mutex_unlock(&gOsLock);
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t aTask) {
+  if ((aTask != NULL) && (aTask != gCurrentTask)) {
+    printf("ERROR. vTaskDelete() of another task is not supported.\n");
+    return;
+  }
+
+  pthread_mutex_lock(&gOsLock);
+  struct HostTask_s *t = gCurrentTask;
+  t->used = false;
+  gRunningCount--;
+  if (gRunningCount == 0) {
+    AdvanceTime();
+  }
+  pthread_mutex_unlock(&gOsLock);
+  pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t aTicks) {
+  if (aTicks == 0) {
+    sched_yield();
+    return;
+  }
+  pthread_mutex_lock(&gOsLock);
+  BlockTask(&kDelayWaitObj, TicksToDeadline(aTicks));
+  pthread_mutex_unlock(&gOsLock);
+}
+
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(HostOsGetTimeUs() / 1000 / portTICK_PERIOD_MS); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return gCurrentTask; }
+
+void vTaskSuspendAll(void) { pthread_mutex_lock(&gCriticalLock); }
+
+BaseType_t xTaskResumeAll(void) {
+  pthread_mutex_unlock(&gCriticalLock);
+  return pdFALSE;
+}
+
+// Each portMUX_TYPE gets its own recursive lock on first use, so sections
+// of different locks run in parallel like on the two cores.
+static pthread_mutex_t *MuxLock(portMUX_TYPE *aMux) {
+  pthread_mutex_t *lock = __atomic_load_n((pthread_mutex_t **)&aMux->lock, __ATOMIC_ACQUIRE);
+  if (lock == NULL) {
+    pthread_mutex_lock(&gMuxCreateLock);
+    lock = aMux->lock;
+    if (lock == NULL) {
+      pthread_mutexattr_t attr;
+      lock = malloc(sizeof(pthread_mutex_t));
+      if (lock == NULL) {
+        printf("ERROR. HostEnterCritical out of memory.\n");
+        abort();
+      }
+      pthread_mutexattr_init(&attr);
+      pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+      pthread_mutex_init(lock, &attr);
+      pthread_mutexattr_destroy(&attr);
+      __atomic_store_n((pthread_mutex_t **)&aMux->lock, lock, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&gMuxCreateLock);
+  }
+  return lock;
+}
+
+void HostEnterCritical(portMUX_TYPE *aMux) { pthread_mutex_lock(MuxLock(aMux)); }
+
+void HostExitCritical(portMUX_TYPE *aMux) { pthread_mutex_unlock(MuxLock(aMux)); }
+
+//==========================================================================
+// Task notification
+//==========================================================================
+BaseType_t xTaskNotify(TaskHandle_t aTask, uint32_t aValue, eNotifyAction aAction) {
+  BaseType_t ret = pdPASS;
+
+  pthread_mutex_lock(&gOsLock);
+  switch (aAction) {
+    case eSetBits:
+      aTask->notifyValue |= aValue;
+      break;
+    case eIncrement:
+      aTask->notifyValue++;
+      break;
+    case eSetValueWithoutOverwrite:
+      if (aTask->notifyPending) {
+        ret = pdFAIL;
+        break;
+      }
+      aTask->notifyValue = aValue;
+      break;
+    case eSetValueWithOverwrite:
+      aTask->notifyValue = aValue;
+      break;
+    default:
+      break;
+  }
+  if (ret == pdPASS) {
+    aTask->notifyPending = true;
+    if (aTask->waitObj == &aTask->notifyValue) {
+      WakeTask(aTask, false);
+    }
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return ret;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t aTask, uint32_t aValue, eNotifyAction aAction, BaseType_t *aWoken) {
+  if (aWoken != NULL) {
+    *aWoken = pdFALSE;
+  }
+  return xTaskNotify(aTask, aValue, aAction);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t aTask) { return xTaskNotify(aTask, 0, eIncrement); }
+
+void vTaskNotifyGiveFromISR(TaskHandle_t aTask, BaseType_t *aWoken) {
+  if (aWoken != NULL) {
+    *aWoken = pdFALSE;
+  }
+  xTaskNotify(aTask, 0, eIncrement);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t aClearOnEntry, uint32_t aClearOnExit, uint32_t *aValue, TickType_t aTicks) {
+  BaseType_t ret = pdFALSE;
+
+  pthread_mutex_lock(&gOsLock);
+  struct HostTask_s *t = gCurrentTask;
+  uint64_t deadline = TicksToDeadline(aTicks);
+  if (!t->notifyPending) {
+    t->notifyValue &= ~aClearOnEntry;
+  }
+  while (!t->notifyPending) {
+    if ((aTicks == 0) || (!BlockTask(&t->notifyValue, deadline))) break;
+  }
+  if (aValue != NULL) {
+    *aValue = t->notifyValue;
+  }
+  if (t->notifyPending) {
+    t->notifyValue &= ~aClearOnExit;
+    t->notifyPending = false;
+    ret = pdTRUE;
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return ret;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t aClearOnExit, TickType_t aTicks) {
+  pthread_mutex_lock(&gOsLock);
+  struct HostTask_s *t = gCurrentTask;
+  uint64_t deadline = TicksToDeadline(aTicks);
+  while (t->notifyValue == 0) {
+    if ((aTicks == 0) || (!BlockTask(&t->notifyValue, deadline))) break;
+  }
+  uint32_t value = t->notifyValue;
+  if (value != 0) {
+    t->notifyValue = aClearOnExit ? 0 : (value - 1);
+  }
+  t->notifyPending = false;
+  pthread_mutex_unlock(&gOsLock);
+  return value;
+}
+
+//==========================================================================
+// Queues. Semaphores are queues with zero item size.
+//==========================================================================
+QueueHandle_t xQueueCreate(UBaseType_t aLength, UBaseType_t aItemSize) {
+  struct HostQueue_s *q = calloc(1, sizeof(struct HostQueue_s));
+  if (q == NULL) return NULL;
+  q->itemSize = aItemSize;
+  q->length = aLength;
+  if (aItemSize > 0) {
+    q->buf = malloc((size_t)aLength * aItemSize);
+    if (q->buf == NULL) {
+      free(q);
+      return NULL;
+    }
+  }
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t aQueue) {
+  if (aQueue != NULL) {
+    free(aQueue->buf);
+    free(aQueue);
+  }
+}
+
+BaseType_t xQueueSend(QueueHandle_t aQueue, const void *aItem, TickType_t aTicks) {
+  BaseType_t ret = pdFALSE;
+
+  pthread_mutex_lock(&gOsLock);
+  uint64_t deadline = TicksToDeadline(aTicks);
+  while (aQueue->count >= aQueue->length) {
+    if ((aTicks == 0) || (!BlockTask(aQueue, deadline))) break;
+  }
+  if (aQueue->count < aQueue->length) {
+    if ((aQueue->itemSize > 0) && (aItem != NULL)) {
+      UBaseType_t tail = (aQueue->head + aQueue->count) % aQueue->length;
+      memcpy(aQueue->buf + tail * aQueue->itemSize, aItem, aQueue->itemSize);
+    }
+    aQueue->count++;
+    WakeWaiters(aQueue);
+    ret = pdTRUE;
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return ret;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t aQueue, const void *aItem, BaseType_t *aWoken) {
+  if (aWoken != NULL) {
+    *aWoken = pdFALSE;
+  }
+  return xQueueSend(aQueue, aItem, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t aQueue, void *aItem, TickType_t aTicks) {
+  BaseType_t ret = pdFALSE;
+
+  pthread_mutex_lock(&gOsLock);
+  uint64_t deadline = TicksToDeadline(aTicks);
+  while (aQueue->count == 0) {
+    if ((aTicks == 0) || (!BlockTask(aQueue, deadline))) break;
+  }
+  if (aQueue->count > 0) {
+    if ((aQueue->itemSize > 0) && (aItem != NULL)) {
+      memcpy(aItem, aQueue->buf + aQueue->head * aQueue->itemSize, aQueue->itemSize);
+    }
+    aQueue->head = (aQueue->head + 1) % aQueue->length;
+    aQueue->count--;
+    WakeWaiters(aQueue);
+    ret = pdTRUE;
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t aQueue) {
+  pthread_mutex_lock(&gOsLock);
+  UBaseType_t count = aQueue->count;
+  pthread_mutex_unlock(&gOsLock);
+  return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  SemaphoreHandle_t sem = xQueueCreate(1, 0);
+  if (sem != NULL) {
+    sem->count = 1;
+  }
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return xQueueCreate(1, 0); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t aSem, TickType_t aTicks) { return xQueueReceive(aSem, NULL, aTicks); }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t aSem) { return xQueueSend(aSem, NULL, 0); }
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t aSem, BaseType_t *aWoken) {
+  if (aWoken != NULL) {
+    *aWoken = pdFALSE;
+  }
+  return xQueueSend(aSem, NULL, 0);
+}
+
+//==========================================================================
+// esp_timer, callbacks are dispatched by the timer task
+//==========================================================================
+static void EspTimerTask(void *aParam) {
+  pthread_mutex_lock(&gOsLock);
+  for (;;) {
+    struct HostEspTimer_s *next = NULL;
+    for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+      struct HostEspTimer_s *tm = &gEspTimers[i];
+      if ((tm->used) && (tm->armed) && ((next == NULL) || (tm->deadline < next->deadline))) {
+        next = tm;
+      }
+    }
+
+    if ((next == NULL) || (next->deadline > gNowUs)) {
+      BlockTask(&kTimerWaitObj, (next == NULL) ? TIME_FOREVER : next->deadline);
+      continue;
+    }
+
+    // Expired
+    if (next->period > 0) {
+      next->deadline += next->period;
+    } else {
+      next->armed = false;
+    }
+    esp_timer_cb_t callback = next->callback;
+    void *arg = next->arg;
+    next->callbacks++;
+    pthread_mutex_unlock(&gOsLock);
+    callback(arg);
+    pthread_mutex_lock(&gOsLock);
+  }
+}
+
+int64_t esp_timer_get_time(void) {
+  return (int64_t)(HostOsGetTimeUs() + __atomic_load_n(&gClockOffsetUs, __ATOMIC_ACQUIRE));
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *aArgs, esp_timer_handle_t *aHandle) {
+  esp_err_t ret = ESP_ERR_NO_MEM;
+
+  pthread_mutex_lock(&gOsLock);
+  for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+    struct HostEspTimer_s *tm = &gEspTimers[i];
+    if (!tm->used) {
+      memset(tm, 0, sizeof(struct HostEspTimer_s));
+      tm->callback = aArgs->callback;
+      tm->arg = aArgs->arg;
+      tm->name = aArgs->name;
+      tm->used = true;
+      *aHandle = tm;
+      ret = ESP_OK;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return ret;
+}
+
+static esp_err_t StartEspTimer(esp_timer_handle_t aTimer, uint64_t aTimeoutUs, uint64_t aPeriodUs) {
+  pthread_mutex_lock(&gOsLock);
+  aTimer->deadline = gNowUs + aTimeoutUs;
+  aTimer->period = aPeriodUs;
+  aTimer->armed = true;
+  WakeWaiters(&kTimerWaitObj);
+  pthread_mutex_unlock(&gOsLock);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t aTimer, uint64_t aTimeoutUs) {
+  return StartEspTimer(aTimer, aTimeoutUs, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t aTimer, uint64_t aPeriodUs) {
+  return StartEspTimer(aTimer, aPeriodUs, aPeriodUs);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t aTimer) {
+  pthread_mutex_lock(&gOsLock);
+  aTimer->armed = false;
+  pthread_mutex_unlock(&gOsLock);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t aTimer) {
+  pthread_mutex_lock(&gOsLock);
+  aTimer->armed = false;
+  aTimer->used = false;
+  pthread_mutex_unlock(&gOsLock);
+  return ESP_OK;
+}
+
+//==========================================================================
+// esp_system
+//==========================================================================
+uint32_t esp_random(void) {
+  // xorshift32, reproducible for a given seed
+  pthread_mutex_lock(&gOsLock);
+  uint32_t x = gRandomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  gRandomState = x;
+  pthread_mutex_unlock(&gOsLock);
+  return x;
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *aMac) {
+  static const uint8_t kHostMac[6] = {0x24, 0x6f, 0x28, 0x00, 0x00, 0x01};
+  memcpy(aMac, kHostMac, sizeof(kHostMac));
+  return ESP_OK;
+}
+
+void esp_chip_info(esp_chip_info_t *aInfo) {
+  aInfo->model = 0;
+  aInfo->revision = 0;
+  aInfo->cores = 1;
+}
+
+const char *esp_err_to_name(esp_err_t aCode) {
+  static char unknown[24];
+  switch (aCode) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    default:
+      snprintf(unknown, sizeof(unknown), "0x%x", aCode);
+      return unknown;
+  }
+}
+
+//==========================================================================
+// Init
+//==========================================================================
+void HostOsInit(uint32_t aRandomSeed) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&gCriticalLock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  clock_gettime(CLOCK_MONOTONIC, &gWallStart);
+  gRandomState = (aRandomSeed != 0) ? aRandomSeed : 0x2545f491;
+
+  // The calling thread
+  pthread_mutex_lock(&gOsLock);
+  gCurrentTask = AllocTask("main");
+  gCurrentTask->thread = pthread_self();
+  gRunningCount = 1;
+  pthread_mutex_unlock(&gOsLock);
+
+  xTaskCreate(EspTimerTask, "esp_timer", 4096, NULL, TASK_PRIO_TIMER, NULL);
+}
+
+uint64_t HostOsGetTimeUs(void) { return __atomic_load_n(&gNowUs, __ATOMIC_ACQUIRE); }
+
+uint32_t HostOsGetTaskWakeups(const char *aName) {
+  uint32_t count = 0;
+
+  pthread_mutex_lock(&gOsLock);
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    if ((gTasks[i].used) && (strcmp(gTasks[i].name, aName) == 0)) {
+      count += gTasks[i].wakeups;
+    }
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return count;
+}
+
+bool HostOsIsTaskRunning(const char *aName) {
+  bool running = false;
+
+  pthread_mutex_lock(&gOsLock);
+  for (int i = 0; i < HOST_MAX_TASKS; i++) {
+    if ((gTasks[i].used) && (strcmp(gTasks[i].name, aName) == 0)) {
+      running = true;
+    }
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return running;
+}
+
+uint32_t HostOsGetTimerCallbacks(const char *aName) {
+  uint32_t count = 0;
+
+  pthread_mutex_lock(&gOsLock);
+  for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+    struct HostEspTimer_s *tm = &gEspTimers[i];
+    if ((tm->used) && (tm->name != NULL) && (strcmp(tm->name, aName) == 0)) {
+      count += tm->callbacks;
+    }
+  }
+  pthread_mutex_unlock(&gOsLock);
+  return count;
+}
+
+void HostOsSetClockOffsetUs(uint64_t aOffsetUs) { __atomic_store_n(&gClockOffsetUs, aOffsetUs, __ATOMIC_RELEASE); }
+
+uint64_t HostOsGetWallTimeUs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - gWallStart.tv_sec) * 1000000 + (now.tv_nsec - gWallStart.tv_nsec) / 1000;
+}
+
+bool HostOsWaitFor(bool (*aCondition)(void), uint32_t aTimeoutMs, uint32_t aPollMs) {
+  uint64_t start = HostOsGetTimeUs();
+  while (!aCondition()) {
+    if (HostOsGetTimeUs() - start >= (uint64_t)aTimeoutMs * 1000) {
+      return false;
+    }
+    vTaskDelay(aPollMs / portTICK_PERIOD_MS);
+  }
+  return true;
+}
+
+int HostOsCheck(const char *aGroup, bool aPassed, const char *aName) {
+  printf("%s check %s: %s\n", aGroup, aName, aPassed ? "passed" : "FAILED");
+  return aPassed ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+//==========================================================================
+// Host OS layer
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// FreeRTOS tasks, queues, semaphores and esp_timer on POSIX threads.
+//
+// Time is virtual. It only advances when every host task is blocked in
+// one of the primitives above, then it jumps to the earliest deadline.
+// A join with its 5s RX delay completes in a few ms of wall time, and
+// timing results do not depend on the load of the build machine.
+//==========================================================================
+#ifndef INC_HOST_OS_H
+#define INC_HOST_OS_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+//==========================================================================
+//==========================================================================
+// Must be called first, the calling thread becomes the "main" task.
+void HostOsInit(uint32_t aRandomSeed);
+
+// Virtual time since HostOsInit()
+uint64_t HostOsGetTimeUs(void);
+
+// Returns from blocking calls of the tasks with this name
+uint32_t HostOsGetTaskWakeups(const char *aName);
+
+// True until the task with this name has deleted itself
+bool HostOsIsTaskRunning(const char *aName);
+
+// Callbacks of the esp_timers with this name
+uint32_t HostOsGetTimerCallbacks(const char *aName);
+
+// Offset added to esp_timer_get_time(), e.g. to bring LoRaGetTick() close
+// to its wrap-around. The esp_timer deadlines are not moved, only change
+// it while no LoRa timer is started.
+void HostOsSetClockOffsetUs(uint64_t aOffsetUs);
+
+// Wall time since HostOsInit(), for comparing with the virtual time
+uint64_t HostOsGetWallTimeUs(void);
+
+// Polls aCondition every aPollMs of virtual time, false if it is still
+// not met after aTimeoutMs
+bool HostOsWaitFor(bool (*aCondition)(void), uint32_t aTimeoutMs, uint32_t aPollMs);
+
+// Prints the result of one check of aGroup, returns 1 if it failed so the
+// results can be summed up
+int HostOsCheck(const char *aGroup, bool aPassed, const char *aName);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_HOST_OS_H
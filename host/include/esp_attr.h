@@ -0,0 +1,12 @@
+//==========================================================================
+// esp_attr for the host port, placement attributes have no effect.
+//==========================================================================
+#ifndef INC_HOST_ESP_ATTR_H
+#define INC_HOST_ESP_ATTR_H
+
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif  // INC_HOST_ESP_ATTR_H
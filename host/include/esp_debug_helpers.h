@@ -0,0 +1,11 @@
+//==========================================================================
+// esp_debug_helpers for the host port
+//==========================================================================
+#ifndef INC_HOST_ESP_DEBUG_HELPERS_H
+#define INC_HOST_ESP_DEBUG_HELPERS_H
+
+#include "esp_err.h"
+
+#define esp_backtrace_print(depth) ((void)(depth), ESP_OK)
+
+#endif  // INC_HOST_ESP_DEBUG_HELPERS_H
@@ -0,0 +1,11 @@
+//==========================================================================
+// esp_random for the host port, seeded by HostOsInit()
+//==========================================================================
+#ifndef INC_HOST_ESP_RANDOM_H
+#define INC_HOST_ESP_RANDOM_H
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
+
+#endif  // INC_HOST_ESP_RANDOM_H
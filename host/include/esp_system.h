@@ -0,0 +1,22 @@
+//==========================================================================
+// esp_system for the host port
+//==========================================================================
+#ifndef INC_HOST_ESP_SYSTEM_H
+#define INC_HOST_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_random.h"
+
+typedef struct {
+  int model;
+  int revision;
+  int cores;
+} esp_chip_info_t;
+
+void esp_chip_info(esp_chip_info_t *aInfo);
+esp_err_t esp_efuse_mac_get_default(uint8_t *aMac);
+
+#endif  // INC_HOST_ESP_SYSTEM_H
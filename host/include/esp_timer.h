@@ -0,0 +1,46 @@
+//==========================================================================
+// esp_timer for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Callbacks run in the host timer task, like ESP_TIMER_TASK dispatch.
+//==========================================================================
+#ifndef INC_HOST_ESP_TIMER_H
+#define INC_HOST_ESP_TIMER_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+//==========================================================================
+//==========================================================================
+typedef struct HostEspTimer_s *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+  ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+//==========================================================================
+//==========================================================================
+int64_t esp_timer_get_time(void);
+esp_err_t esp_timer_create(const esp_timer_create_args_t *aArgs, esp_timer_handle_t *aHandle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t aTimer, uint64_t aTimeoutUs);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t aTimer, uint64_t aPeriodUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t aTimer);
+esp_err_t esp_timer_delete(esp_timer_handle_t aTimer);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_HOST_ESP_TIMER_H
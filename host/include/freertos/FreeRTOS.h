@@ -0,0 +1,116 @@
+//==========================================================================
+// FreeRTOS subset for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Tasks are POSIX threads. Time is virtual, see host_os.h.
+//==========================================================================
+#ifndef INC_HOST_FREERTOS_H
+#define INC_HOST_FREERTOS_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// As the ESP-IDF port headers do
+#include "esp_system.h"
+
+//==========================================================================
+// Types and constants
+//==========================================================================
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+typedef struct HostTask_s *TaskHandle_t;
+typedef struct HostQueue_s *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+typedef struct HostQueue_s *SemaphoreHandle_t;
+typedef struct HostEventGroup_s *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x) / portTICK_PERIOD_MS)
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+
+#define portYIELD_FROM_ISR(...) \
+  do {                          \
+  } while (0)
+#define xPortInIsrContext() 0
+
+typedef enum {
+  eNoAction = 0,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+//==========================================================================
+// Critical sections. A portMUX_TYPE maps to its own recursive lock.
+//==========================================================================
+typedef struct {
+  void *lock;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED \
+  { NULL }
+
+void HostEnterCritical(portMUX_TYPE *aMux);
+void HostExitCritical(portMUX_TYPE *aMux);
+
+#define portENTER_CRITICAL(m) HostEnterCritical(m)
+#define portEXIT_CRITICAL(m) HostExitCritical(m)
+#define portENTER_CRITICAL_ISR(m) HostEnterCritical(m)
+#define portEXIT_CRITICAL_ISR(m) HostExitCritical(m)
+#define taskENTER_CRITICAL(m) HostEnterCritical(m)
+#define taskEXIT_CRITICAL(m) HostExitCritical(m)
+#define taskENTER_CRITICAL_ISR(m) HostEnterCritical(m)
+#define taskEXIT_CRITICAL_ISR(m) HostExitCritical(m)
+
+//==========================================================================
+// Tasks
+//==========================================================================
+BaseType_t xTaskCreate(TaskFunction_t aFunc, const char *aName, uint32_t aStackDepth, void *aParam, UBaseType_t aPrio,
+                       TaskHandle_t *aHandle);
+void vTaskDelete(TaskHandle_t aTask);
+void vTaskDelay(TickType_t aTicks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+
+BaseType_t xTaskNotify(TaskHandle_t aTask, uint32_t aValue, eNotifyAction aAction);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t aTask, uint32_t aValue, eNotifyAction aAction, BaseType_t *aWoken);
+BaseType_t xTaskNotifyWait(uint32_t aClearOnEntry, uint32_t aClearOnExit, uint32_t *aValue, TickType_t aTicks);
+void vTaskNotifyGiveFromISR(TaskHandle_t aTask, BaseType_t *aWoken);
+BaseType_t xTaskNotifyGive(TaskHandle_t aTask);
+uint32_t ulTaskNotifyTake(BaseType_t aClearOnExit, TickType_t aTicks);
+
+//==========================================================================
+// Queues and semaphores
+//==========================================================================
+QueueHandle_t xQueueCreate(UBaseType_t aLength, UBaseType_t aItemSize);
+void vQueueDelete(QueueHandle_t aQueue);
+BaseType_t xQueueSend(QueueHandle_t aQueue, const void *aItem, TickType_t aTicks);
+BaseType_t xQueueSendFromISR(QueueHandle_t aQueue, const void *aItem, BaseType_t *aWoken);
+BaseType_t xQueueReceive(QueueHandle_t aQueue, void *aItem, TickType_t aTicks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t aQueue);
+#define xQueueSendToBack(q, i, t) xQueueSend(q, i, t)
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t aSem, TickType_t aTicks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t aSem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t aSem, BaseType_t *aWoken);
+#define vSemaphoreDelete(s) vQueueDelete(s)
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_HOST_FREERTOS_H
@@ -0,0 +1,9 @@
+//==========================================================================
+// FreeRTOS subset for the host port
+//==========================================================================
+#ifndef INC_HOST_FREERTOS_EVENT_GROUPS_H
+#define INC_HOST_FREERTOS_EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif  // INC_HOST_FREERTOS_EVENT_GROUPS_H
@@ -0,0 +1,9 @@
+//==========================================================================
+// FreeRTOS subset for the host port
+//==========================================================================
+#ifndef INC_HOST_FREERTOS_SEMPHR_H
+#define INC_HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif  // INC_HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,71 @@
+//==========================================================================
+// NVS for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Entries are kept in RAM. HostNvsSaveFile()/HostNvsLoadFile() keep the
+// content across runs to simulate a power cycle.
+//==========================================================================
+#ifndef INC_HOST_NVS_FLASH_H
+#define INC_HOST_NVS_FLASH_H
+
+//==========================================================================
+//==========================================================================
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+//==========================================================================
+//==========================================================================
+#define ESP_ERR_NVS_BASE 0x1100
+#define ESP_ERR_NVS_NOT_INITIALIZED (ESP_ERR_NVS_BASE + 0x01)
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_TYPE_MISMATCH (ESP_ERR_NVS_BASE + 0x03)
+#define ESP_ERR_NVS_READ_ONLY (ESP_ERR_NVS_BASE + 0x04)
+#define ESP_ERR_NVS_NOT_ENOUGH_SPACE (ESP_ERR_NVS_BASE + 0x05)
+#define ESP_ERR_NVS_INVALID_HANDLE (ESP_ERR_NVS_BASE + 0x07)
+#define ESP_ERR_NVS_INVALID_LENGTH (ESP_ERR_NVS_BASE + 0x0c)
+
+typedef uint32_t nvs_handle_t;
+typedef nvs_handle_t nvs_handle;
+
+typedef enum {
+  NVS_READONLY,
+  NVS_READWRITE,
+} nvs_open_mode_t;
+
+typedef struct {
+  uint32_t setCount;      // nvs_set_*() calls
+  uint32_t bytesWritten;  // Data bytes of nvs_set_*()
+  uint32_t commitCount;
+  uint32_t eraseCount;
+} HostNvsStats_t;
+
+//==========================================================================
+//==========================================================================
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+esp_err_t nvs_open(const char *aNamespace, nvs_open_mode_t aMode, nvs_handle_t *aHandle);
+void nvs_close(nvs_handle_t aHandle);
+esp_err_t nvs_commit(nvs_handle_t aHandle);
+esp_err_t nvs_erase_key(nvs_handle_t aHandle, const char *aKey);
+esp_err_t nvs_erase_all(nvs_handle_t aHandle);
+
+esp_err_t nvs_get_blob(nvs_handle_t aHandle, const char *aKey, void *aValue, size_t *aLength);
+esp_err_t nvs_set_blob(nvs_handle_t aHandle, const char *aKey, const void *aValue, size_t aLength);
+esp_err_t nvs_get_u8(nvs_handle_t aHandle, const char *aKey, uint8_t *aValue);
+esp_err_t nvs_set_u8(nvs_handle_t aHandle, const char *aKey, uint8_t aValue);
+esp_err_t nvs_get_u32(nvs_handle_t aHandle, const char *aKey, uint32_t *aValue);
+esp_err_t nvs_set_u32(nvs_handle_t aHandle, const char *aKey, uint32_t aValue);
+
+// Host only
+void HostNvsGetStats(HostNvsStats_t *aStats);
+void HostNvsResetStats(void);
+int HostNvsSaveFile(const char *aPath);
+int HostNvsLoadFile(const char *aPath);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_HOST_NVS_FLASH_H
@@ -0,0 +1,73 @@
+//==========================================================================
+// Configuration of the host build, takes the place of the generated
+// sdkconfig.h. Values follow the Kconfig defaults, except:
+// - the sub-GHz radio is preferred, so the demo joins in EU868
+// - no device provisioning, the host has no provisioning server
+// - both radios with their own session, the link selection and the
+//   parallel join are on, Kconfig defaults them to n. Build with
+//   -DHOST_KCONFIG_DEFAULTS to keep them at their defaults, or with
+//   -DHOST_LINK_SELECT=0 or -DHOST_PARALLEL_JOIN=0 to turn one off.
+// - the session is kept in NVS, Kconfig defaults it to n. The demo prints
+//   the NVS writes it costs. -DHOST_KCONFIG_DEFAULTS or
+//   -DHOST_NVM_PERSIST=0 turn it off.
+// - the RX window timing is logged for the RX timing check, always, and
+//   read through LoRaMacGetRxTiming() instead of printed
+// - the critical section hold time is kept, always, for the histogram of
+//   the critical section stress check. Kconfig defaults it to n.
+//==========================================================================
+#ifndef INC_HOST_SDKCONFIG_H
+#define INC_HOST_SDKCONFIG_H
+
+#if defined(HOST_KCONFIG_DEFAULTS)
+#define HOST_DUAL_CONTEXT 0
+#define HOST_LINK_SELECT 0
+#define HOST_PARALLEL_JOIN 0
+#define HOST_NVM_PERSIST 0
+#endif
+#ifndef HOST_DUAL_CONTEXT
+#define HOST_DUAL_CONTEXT 1
+#endif
+#ifndef HOST_LINK_SELECT
+#define HOST_LINK_SELECT HOST_DUAL_CONTEXT
+#endif
+#ifndef HOST_PARALLEL_JOIN
+#define HOST_PARALLEL_JOIN HOST_DUAL_CONTEXT
+#endif
+#ifndef HOST_NVM_PERSIST
+#define HOST_NVM_PERSIST 1
+#endif
+
+#define CONFIG_LORAWAN_ADR_ON 1
+#define CONFIG_LORAWAN_DEFAULT_DATARATE 3
+#define CONFIG_LORAWAN_UNCONFIRMED_COUNT 0
+#define CONFIG_LORAWAN_TX_QUEUE_SIZE 4
+#define CONFIG_LORAWAN_RX_RING_SIZE 4
+#if HOST_NVM_PERSIST
+#define CONFIG_LORAWAN_NVM_PERSIST 1
+#endif
+#define CONFIG_LORAWAN_MAX_NOACK_RETRY 3
+#define CONFIG_LORAWAN_NOACK_RETRY_INTERVAL 20
+#define CONFIG_LORAWAN_LINK_FAIL_COUNT 8
+#if HOST_DUAL_CONTEXT
+#define CONFIG_LORAWAN_SW_RADIO_COUNT 2
+#define CONFIG_LORAWAN_DUAL_CONTEXT 1
+#else
+#define CONFIG_LORAWAN_SW_RADIO_COUNT 0
+#endif
+#if HOST_LINK_SELECT
+#define CONFIG_LORAWAN_LINK_SELECT 1
+#define CONFIG_LORAWAN_LINK_PROBE_INTERVAL 16
+#endif
+#if HOST_PARALLEL_JOIN
+#define CONFIG_LORAWAN_PARALLEL_JOIN 1
+#endif
+#define CONFIG_LORAWAN_PREFERRED_SUBGHZ 1
+#define CONFIG_LORAWAN_REGION_EU868 1
+#define CONFIG_LORAWAN_MAX_RX_ERROR 20
+#define CONFIG_LORAWAN_SE_CRYPTO_SOFTWARE 1
+#define CONFIG_LORAWAN_AES_TTABLE 1
+#define CONFIG_LORAWAN_CRITICAL_STATS 1
+#define CONFIG_LORAMAC_RX_TIMING_LOG 1
+#define LORAMAC_RX_TIMING_PRINT 0
+
+#endif  // INC_HOST_SDKCONFIG_H
@@ -0,0 +1,95 @@
+//==========================================================================
+// Scripted link conditions for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "link-script.h"
+
+#include <stddef.h>
+
+#include "virtual-radio.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define LINK_CHIPS 2
+
+typedef struct {
+  int16_t rssi;
+  int8_t snr;
+  uint8_t lossPercent;
+} LinkCondition_t;
+
+typedef struct {
+  const char *name;
+  uint32_t frames;
+  LinkCondition_t link[LINK_CHIPS];  // SX126x, SX1280
+} LinkPhase_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static const LinkPhase_t kLinkPhases[] = {
+    {"both links good", 15, {{-95, 6, 0}, {-85, 8, 0}}},
+    {"ISM2400 link lost", 15, {{-95, 6, 0}, {-125, -15, 100}}},
+    {"ISM2400 link marginal", 20, {{-95, 6, 0}, {-110, -4, 40}}},
+    {"sub-GHz link disturbed", 15, {{-110, -5, 60}, {-85, 8, 0}}},
+};
+#define LINK_PHASE_COUNT (sizeof(kLinkPhases) / sizeof(kLinkPhases[0]))
+
+static const LinkPhase_t *gLinkPhase = &kLinkPhases[0];
+static uint32_t gLinkRandom;
+
+//==========================================================================
+//==========================================================================
+static uint32_t NextRandom(void) {
+  // xorshift32
+  gLinkRandom ^= gLinkRandom << 13;
+  gLinkRandom ^= gLinkRandom >> 17;
+  gLinkRandom ^= gLinkRandom << 5;
+  return gLinkRandom;
+}
+
+void LinkScriptInit(uint32_t aSeed) {
+  gLinkRandom = (aSeed != 0) ? aSeed : 1;
+  gLinkPhase = &kLinkPhases[0];
+}
+
+uint32_t LinkScriptFrameCount(void) {
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < LINK_PHASE_COUNT; i++) {
+    count += kLinkPhases[i].frames;
+  }
+  return count;
+}
+
+const char *LinkScriptApply(uint32_t aFrame) {
+  uint32_t start = 0;
+  uint8_t i;
+
+  for (i = 0; i < LINK_PHASE_COUNT - 1; i++) {
+    if (aFrame < start + kLinkPhases[i].frames) {
+      break;
+    }
+    start += kLinkPhases[i].frames;
+  }
+  gLinkPhase = &kLinkPhases[i];
+  VirtualRadioSetLinkQuality(RADIO_CHIP_SX126X, gLinkPhase->link[0].rssi, gLinkPhase->link[0].snr);
+  VirtualRadioSetLinkQuality(RADIO_CHIP_SX1280, gLinkPhase->link[1].rssi, gLinkPhase->link[1].snr);
+  return (aFrame == start) ? gLinkPhase->name : NULL;
+}
+
+bool LinkScriptDropUplink(RadioChip_t aChip) {
+  const LinkCondition_t *link = &gLinkPhase->link[(aChip == RADIO_CHIP_SX1280) ? 1 : 0];
+  return (NextRandom() % 100) < link->lossPercent;
+}
@@ -0,0 +1,36 @@
+//==========================================================================
+// Scripted link conditions for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Phases of uplinks in which each radio has its own downlink RSSI and SNR
+// and loses a share of its uplinks, joins included: both links good, the
+// ISM2400 link lost, the ISM2400 link marginal, then the sub-GHz link
+// disturbed. The losses come from their own generator, seeded like
+// esp_random(), and leave the random numbers of the MAC as they are.
+//==========================================================================
+#ifndef INC_LINK_SCRIPT_H
+#define INC_LINK_SCRIPT_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "radio.h"
+
+//==========================================================================
+//==========================================================================
+void LinkScriptInit(uint32_t aSeed);
+uint32_t LinkScriptFrameCount(void);
+
+// Sets the link quality of the phase of frame aFrame, returns its name when
+// the phase starts at aFrame, otherwise NULL
+const char *LinkScriptApply(uint32_t aFrame);
+
+// An uplink on aChip is lost
+bool LinkScriptDropUplink(RadioChip_t aChip);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LINK_SCRIPT_H
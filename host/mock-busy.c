@@ -0,0 +1,192 @@
+//==========================================================================
+// Simulated BUSY pin for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "mock-busy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_os.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "BUSY"
+#define CHECK_CMD_SHORT 0x80
+#define CHECK_CMD_LONG 0x83
+#define CHECK_CMD_POLL 0x84
+#define CHECK_CMD_STUCK 0x85
+
+//==========================================================================
+// Pin ops
+//==========================================================================
+static uint64_t MockGetTimeUs(RadioBusy_t *aBusy) {
+  MockBusy_t *mock = aBusy->ctx;
+  return HostOsGetTimeUs() + mock->pollUs;
+}
+
+static int MockGetLevel(RadioBusy_t *aBusy) {
+  MockBusy_t *mock = aBusy->ctx;
+
+  mock->reads++;
+  mock->pollUs += MOCK_BUSY_POLL_US;
+  if (mock->level && (MockGetTimeUs(aBusy) >= mock->highUntilUs)) {
+    mock->level = false;
+  }
+  return mock->level ? 1 : 0;
+}
+
+static int8_t MockEnableIrq(RadioBusy_t *aBusy) {
+  MockBusy_t *mock = aBusy->ctx;
+
+  if (!mock->irqAvailable) {
+    return -1;
+  }
+  mock->irqEnables++;
+  mock->irqEnabled = true;
+  return 0;
+}
+
+static void MockDisableIrq(RadioBusy_t *aBusy) {
+  MockBusy_t *mock = aBusy->ctx;
+  mock->irqEnabled = false;
+}
+
+static const RadioBusyOps_t kMockBusyOps = {
+    .getLevel = MockGetLevel,
+    .getTimeUs = MockGetTimeUs,
+    .enableIrq = MockEnableIrq,
+    .disableIrq = MockDisableIrq,
+};
+
+// Falling edge
+static void MockBusyTimerFunc(void *aArg) {
+  MockBusy_t *mock = aArg;
+
+  mock->level = false;
+  if (mock->irqEnabled) {
+    RadioBusyIsr(mock->busy);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+int8_t MockBusyInit(RadioBusy_t *aBusy, MockBusy_t *aMock, const char *aName) {
+  esp_timer_create_args_t args = {
+      .callback = MockBusyTimerFunc,
+      .arg = aMock,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "MockBusy",
+  };
+
+  memset(aMock, 0, sizeof(MockBusy_t));
+  aMock->busy = aBusy;
+  aMock->irqAvailable = true;
+  if (esp_timer_create(&args, &aMock->timer) != ESP_OK) {
+    printf("ERROR. MockBusyInit create timer failed.\n");
+    return -1;
+  }
+  return RadioBusyInit(aBusy, &kMockBusyOps, aMock, aName);
+}
+
+//==========================================================================
+//==========================================================================
+void MockBusyStart(MockBusy_t *aMock, uint32_t aUs) {
+  esp_timer_stop(aMock->timer);
+  if (aUs == MOCK_BUSY_STUCK) {
+    aMock->highUntilUs = UINT64_MAX;
+  } else {
+    aMock->highUntilUs = HostOsGetTimeUs() + aMock->pollUs + aUs;
+    esp_timer_start_once(aMock->timer, aUs);
+  }
+  aMock->level = true;
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static RadioBusy_t gCheckBusy;
+static MockBusy_t gCheckMock;
+
+// A wait shorter than the spin phase doesn't enable the interrupt
+static int CheckShort(void) {
+  uint32_t enables = gCheckMock.irqEnables;
+
+  MockBusyStart(&gCheckMock, 10);
+  bool ok = (RadioBusyWait(&gCheckBusy, CHECK_CMD_SHORT) == 0);
+  const RadioBusyHist_t *hist = RadioBusyGetHist(&gCheckBusy, CHECK_CMD_SHORT);
+  ok = ok && (gCheckMock.irqEnables == enables) && (gCheckBusy.spinWaits == 1);
+  // 10 us is in bucket [8, 16)
+  ok = ok && (hist != NULL) && (hist->count == 1) && (hist->bucket[4] == 1);
+  return HostOsCheck(CHECK_GROUP, ok, "short");
+}
+
+// A long wait sleeps until the falling edge, without polling
+static int CheckLong(void) {
+  uint32_t reads = gCheckMock.reads;
+
+  MockBusyStart(&gCheckMock, 3000);
+  bool ok = (RadioBusyWait(&gCheckBusy, CHECK_CMD_LONG) == 0);
+  const RadioBusyHist_t *hist = RadioBusyGetHist(&gCheckBusy, CHECK_CMD_LONG);
+  ok = ok && (gCheckBusy.irqWaits == 1) && !gCheckMock.irqEnabled;
+  ok = ok && (gCheckMock.reads - reads <= RADIO_BUSY_SPIN_US / MOCK_BUSY_POLL_US + 4);
+  ok = ok && (hist != NULL) && (hist->maxUs >= 3000) && (hist->maxUs < 3000 + 2 * RADIO_BUSY_SPIN_US);
+  return HostOsCheck(CHECK_GROUP, ok, "long");
+}
+
+// Without the interrupt, the wait polls once per tick
+static int CheckPoll(void) {
+  uint64_t start_us = HostOsGetTimeUs();
+
+  gCheckMock.irqAvailable = false;
+  MockBusyStart(&gCheckMock, 3000);
+  bool ok = (RadioBusyWait(&gCheckBusy, CHECK_CMD_POLL) == 0);
+  gCheckMock.irqAvailable = true;
+  uint64_t waited_us = HostOsGetTimeUs() - start_us;
+  ok = ok && (waited_us >= 3000) && (waited_us <= 3000 + portTICK_PERIOD_MS * 1000);
+  return HostOsCheck(CHECK_GROUP, ok, "poll");
+}
+
+// A stuck BUSY line times out as before
+static int CheckTimeout(void) {
+  uint64_t start_us = HostOsGetTimeUs();
+
+  MockBusyStart(&gCheckMock, MOCK_BUSY_STUCK);
+  bool ok = (RadioBusyWait(&gCheckBusy, CHECK_CMD_STUCK) != 0);
+  uint64_t waited_us = HostOsGetTimeUs() - start_us;
+  MockBusyStart(&gCheckMock, 0);
+  ok = ok && (gCheckBusy.timeouts == 1);
+  ok = ok && (waited_us >= (uint64_t)RADIO_BUSY_TIMEOUT_MS * 1000 - RADIO_BUSY_SPIN_US);
+  ok = ok && (waited_us <= (uint64_t)(RADIO_BUSY_TIMEOUT_MS + 2 * portTICK_PERIOD_MS) * 1000);
+  return HostOsCheck(CHECK_GROUP, ok, "timeout");
+}
+
+//==========================================================================
+//==========================================================================
+int MockBusyRunChecks(void) {
+  int failed = 0;
+
+  if (MockBusyInit(&gCheckBusy, &gCheckMock, "mock") != 0) {
+    return 1;
+  }
+  failed += CheckShort();
+  failed += CheckLong();
+  failed += CheckPoll();
+  failed += CheckTimeout();
+  failed += HostOsCheck(CHECK_GROUP, gCheckBusy.histCount == 4, "histogram per command");
+  RadioBusyPrintStats(&gCheckBusy);
+  printf("BUSY check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,52 @@
+//==========================================================================
+// Simulated BUSY pin for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Implements the radio_busy.h pin ops without hardware. MockBusyStart()
+// holds the pin high for a time; the falling edge comes from an esp_timer
+// in virtual time. Each level read costs MOCK_BUSY_POLL_US on the pin
+// clock, so a spin phase ends although the virtual time stands still.
+//==========================================================================
+#ifndef INC_MOCK_BUSY_H
+#define INC_MOCK_BUSY_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "radio_busy.h"
+
+//==========================================================================
+//==========================================================================
+#define MOCK_BUSY_POLL_US 1
+#define MOCK_BUSY_STUCK UINT32_MAX
+
+typedef struct {
+  RadioBusy_t *busy;
+  esp_timer_handle_t timer;
+  bool irqAvailable;
+  bool irqEnabled;
+  volatile bool level;
+  uint64_t highUntilUs;  // Pin clock
+  uint64_t pollUs;       // Added to the virtual time by the level reads
+
+  uint32_t reads;
+  uint32_t irqEnables;
+} MockBusy_t;
+
+//==========================================================================
+//==========================================================================
+int8_t MockBusyInit(RadioBusy_t *aBusy, MockBusy_t *aMock, const char *aName);
+// BUSY high for aUs, or until the next call with MOCK_BUSY_STUCK
+void MockBusyStart(MockBusy_t *aMock, uint32_t aUs);
+
+// Runs the BUSY wait checks against a simulated pin. Returns the number of
+// failed checks.
+int MockBusyRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_MOCK_BUSY_H
@@ -0,0 +1,374 @@
+//==========================================================================
+// Mock SPI bus for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "mock-spi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/task.h"
+#include "host_os.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "SPI"
+#define TASK_PRIO_DMA 10
+
+#define CHECK_CMD_WRITE 0x0E
+#define CHECK_CMD_READ 0x1E
+#define CHECK_CMD_OTHER_TASK 0xB0
+#define CHECK_CMD_READY 0xC0
+
+//==========================================================================
+// Bus ops
+//==========================================================================
+static int8_t MockAcquire(RadioSpiBus_t *aBus) {
+  MockSpi_t *mock = aBus->ctx;
+  mock->acquired = true;
+  mock->acquires++;
+  return 0;
+}
+
+static void MockRelease(RadioSpiBus_t *aBus) {
+  MockSpi_t *mock = aBus->ctx;
+  mock->acquired = false;
+}
+
+static int8_t MockSubmit(RadioSpiBus_t *aBus, uint8_t aSlot) {
+  MockSpi_t *mock = aBus->ctx;
+
+  if (xQueueSend(mock->requests, &aSlot, 0) != pdPASS) {
+    return -1;
+  }
+  mock->inFlight++;
+  if (mock->inFlight > mock->maxInFlight) {
+    mock->maxInFlight = mock->inFlight;
+  }
+  return 0;
+}
+
+static int8_t MockWaitDone(RadioSpiBus_t *aBus) {
+  MockSpi_t *mock = aBus->ctx;
+  int8_t result;
+
+  xQueueReceive(mock->results, &result, portMAX_DELAY);
+  mock->inFlight--;
+  return result;
+}
+
+static int8_t MockWaitReady(RadioSpiBus_t *aBus, uint8_t aCmd) {
+  MockSpi_t *mock = aBus->ctx;
+
+  if (mock->inFlight > 0) {
+    mock->readyInFlight++;
+  }
+  mock->readyCmd = aCmd;
+  mock->readyWaits++;
+  if (mock->readyWaits == mock->readyFailAt) {
+    return -1;
+  }
+  vTaskDelay(1);
+  return 0;
+}
+
+static const RadioSpiBusOps_t kMockBusOps = {
+    .acquire = MockAcquire,
+    .release = MockRelease,
+    .submit = MockSubmit,
+    .waitDone = MockWaitDone,
+    .waitReady = MockWaitReady,
+};
+
+//==========================================================================
+// DMA, runs the transfers in submit order
+//==========================================================================
+static int8_t RunTransfer(MockSpi_t *aMock, const RadioSpiXfer_t *aXfer) {
+  uint16_t offset = 0;
+
+  if (!aMock->acquired) {
+    aMock->unownedTransfers++;
+  }
+  if (aMock->logCount < MOCK_SPI_LOG_SIZE) {
+    aMock->log[aMock->logCount++] = aXfer->cmd;
+  }
+  aMock->completions++;
+  if (aMock->completions == aMock->failAt) {
+    return -1;
+  }
+
+  if (aXfer->addrBits >= 8) {
+    offset = (aXfer->addr >> (aXfer->addrBits - 8)) & 0xff;
+  }
+  if (offset + aXfer->length > MOCK_SPI_MEMORY_SIZE) {
+    return -1;
+  }
+  if (aXfer->rxData != NULL) {
+    memcpy(aXfer->rxData, &aMock->memory[offset], aXfer->length);
+  } else if (aXfer->txData != NULL) {
+    memcpy(&aMock->memory[offset], aXfer->txData, aXfer->length);
+  } else {
+    memset(&aMock->memory[offset], 0, aXfer->length);
+  }
+  return 0;
+}
+
+static void MockDmaTask(void *aParam) {
+  MockSpi_t *mock = aParam;
+  uint8_t slot;
+
+  for (;;) {
+    xQueueReceive(mock->requests, &slot, portMAX_DELAY);
+    vTaskDelay(1);
+    int8_t result = RunTransfer(mock, &mock->bus->slot[slot]);
+    xQueueSend(mock->results, &result, portMAX_DELAY);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+int8_t MockSpiInit(RadioSpiBus_t *aBus, MockSpi_t *aMock, const char *aName) {
+  memset(aMock, 0, sizeof(MockSpi_t));
+  aMock->bus = aBus;
+  aMock->requests = xQueueCreate(RADIO_SPI_QUEUE_DEPTH, sizeof(uint8_t));
+  aMock->results = xQueueCreate(RADIO_SPI_QUEUE_DEPTH, sizeof(int8_t));
+  if ((aMock->requests == NULL) || (aMock->results == NULL)) {
+    printf("ERROR. MockSpiInit create queue failed.\n");
+    return -1;
+  }
+  if (RadioSpiInit(aBus, &kMockBusOps, aMock, aName) != 0) {
+    return -1;
+  }
+  if (xTaskCreate(MockDmaTask, "MockSpiDma", 2048, aMock, TASK_PRIO_DMA, NULL) != pdPASS) {
+    printf("ERROR. MockSpiInit create task failed.\n");
+    return -1;
+  }
+  return 0;
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static RadioSpiBus_t gCheckBus;
+static MockSpi_t gCheckMock;
+static volatile bool gOtherTaskDone;
+
+static int8_t Write(uint8_t aCmd, uint8_t aOffset, const uint8_t *aData, uint16_t aLen) {
+  RadioSpiXfer_t xfer = {.cmd = aCmd, .addrBits = 8, .addr = aOffset, .txData = aData, .length = aLen};
+  return RadioSpiTransfer(&gCheckBus, &xfer);
+}
+
+static int8_t WriteReady(uint8_t aCmd, uint8_t aOffset, uint8_t aData) {
+  RadioSpiXfer_t xfer = {
+      .cmd = aCmd, .addrBits = 8, .addr = aOffset, .txData = &aData, .length = 1, .waitReady = true};
+  return RadioSpiTransfer(&gCheckBus, &xfer);
+}
+
+static int8_t Read(uint8_t aOffset, uint8_t *aData, uint16_t aLen) {
+  RadioSpiXfer_t xfer = {
+      .cmd = CHECK_CMD_READ, .addrBits = 16, .addr = (uint32_t)aOffset << 8, .rxData = aData, .length = aLen};
+  return RadioSpiTransfer(&gCheckBus, &xfer);
+}
+
+// A single transfer acquires the bus and returns when it is done
+static int CheckSingle(void) {
+  uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  uint8_t readback[8];
+  uint32_t acquires = gCheckMock.acquires;
+
+  bool ok = (Write(CHECK_CMD_WRITE, 0x10, data, sizeof(data)) == 0);
+  ok = ok && (memcmp(&gCheckMock.memory[0x10], data, sizeof(data)) == 0);
+  ok = ok && (Read(0x10, readback, sizeof(readback)) == 0);
+  ok = ok && (memcmp(readback, data, sizeof(data)) == 0);
+  ok = ok && (gCheckMock.acquires == acquires + 2) && !gCheckMock.acquired;
+  return HostOsCheck(CHECK_GROUP, ok, "single");
+}
+
+// Chained writes take one bus acquisition, are queued up to the queue
+// depth and run in order. Short write data is copied, so the caller buffer
+// can be reused at once; long write data is sent from the caller buffer.
+static int CheckChain(void) {
+  static uint8_t payload[100];
+  uint8_t data[4];
+  uint32_t acquires = gCheckMock.acquires;
+  uint16_t log_start = gCheckMock.logCount;
+  bool ok = true;
+
+  for (int i = 0; i < sizeof(payload); i++) {
+    payload[i] = (uint8_t)(0x80 + i);
+  }
+  gCheckMock.maxInFlight = 0;
+
+  RadioSpiBegin(&gCheckBus);
+  uint64_t start_us = HostOsGetTimeUs();
+  for (uint8_t i = 0; i < 8; i++) {
+    memset(data, i, sizeof(data));
+    ok = ok && (Write(i, 0x20 + 4 * i, data, sizeof(data)) == 0);
+  }
+  ok = ok && (Write(8, 0x60, payload, sizeof(payload)) == 0);
+  uint64_t queued_us = HostOsGetTimeUs() - start_us;
+  ok = ok && (RadioSpiEnd(&gCheckBus) == 0);
+  uint64_t done_us = HostOsGetTimeUs() - start_us;
+
+  for (uint8_t i = 0; i < 8; i++) {
+    memset(data, i, sizeof(data));
+    ok = ok && (memcmp(&gCheckMock.memory[0x20 + 4 * i], data, sizeof(data)) == 0);
+  }
+  ok = ok && (memcmp(&gCheckMock.memory[0x60], payload, sizeof(payload)) == 0);
+  for (uint8_t i = 0; i <= 8; i++) {
+    ok = ok && (gCheckMock.log[log_start + i] == i);
+  }
+  ok = ok && (gCheckMock.acquires == acquires + 1);
+  ok = ok && (gCheckMock.maxInFlight == RADIO_SPI_QUEUE_DEPTH);
+  // Only the writes beyond the queue depth waited
+  ok = ok && (queued_us < done_us);
+  return HostOsCheck(CHECK_GROUP, ok, "chain");
+}
+
+// A read in a chain returns the data written before it in the same chain
+static int CheckChainRead(void) {
+  uint8_t data[4] = {0xde, 0xad, 0xbe, 0xef};
+  uint8_t readback[4];
+  uint32_t acquires = gCheckMock.acquires;
+
+  RadioSpiBegin(&gCheckBus);
+  bool ok = (Write(CHECK_CMD_WRITE, 0xc0, data, sizeof(data)) == 0);
+  ok = ok && (Read(0xc0, readback, sizeof(readback)) == 0);
+  ok = ok && (memcmp(readback, data, sizeof(data)) == 0);
+  ok = ok && (RadioSpiEnd(&gCheckBus) == 0);
+  ok = ok && (gCheckMock.acquires == acquires + 1);
+  return HostOsCheck(CHECK_GROUP, ok, "chain read");
+}
+
+// A transfer of another task waits until the chain ends
+static void OtherTask(void *aParam) {
+  uint8_t data = 0x55;
+  Write(CHECK_CMD_OTHER_TASK, 0xf0, &data, 1);
+  gOtherTaskDone = true;
+  vTaskDelete(NULL);
+}
+
+static int CheckOtherTask(void) {
+  uint8_t data = 0;
+  uint16_t log_start = gCheckMock.logCount;
+
+  gOtherTaskDone = false;
+  RadioSpiBegin(&gCheckBus);
+  xTaskCreate(OtherTask, "SpiCheckOther", 2048, NULL, TASK_PRIO_DMA, NULL);
+  vTaskDelay(5);
+  bool ok = !gOtherTaskDone;
+  ok = ok && (Write(0xa0, 0xf1, &data, 1) == 0);
+  ok = ok && (Write(0xa1, 0xf2, &data, 1) == 0);
+  ok = ok && (RadioSpiEnd(&gCheckBus) == 0);
+  while (!gOtherTaskDone) {
+    vTaskDelay(1);
+  }
+  ok = ok && (gCheckMock.logCount == log_start + 3);
+  ok = ok && (gCheckMock.log[log_start] == 0xa0) && (gCheckMock.log[log_start + 1] == 0xa1) &&
+       (gCheckMock.log[log_start + 2] == CHECK_CMD_OTHER_TASK);
+  return HostOsCheck(CHECK_GROUP, ok, "other task");
+}
+
+// A failed transfer in a chain is returned by RadioSpiEnd(), the next
+// transfer is not affected
+static int CheckError(void) {
+  uint8_t data = 0;
+
+  gCheckMock.failAt = gCheckMock.completions + 2;
+  RadioSpiBegin(&gCheckBus);
+  for (uint8_t i = 0; i < 3; i++) {
+    Write(CHECK_CMD_WRITE, 0xe0 + i, &data, 1);
+  }
+  bool ok = (RadioSpiEnd(&gCheckBus) != 0);
+  gCheckMock.failAt = 0;
+  ok = ok && (Write(CHECK_CMD_WRITE, 0xe0, &data, 1) == 0);
+  return HostOsCheck(CHECK_GROUP, ok, "error");
+}
+
+// In a chain, a transfer that waits for the chip does so in the calling
+// task, after the transfers before it are done. The first one does not
+// wait, the caller waited before the chain.
+static int CheckWaitReady(void) {
+  uint32_t waits = gCheckMock.readyWaits;
+
+  gCheckMock.readyInFlight = 0;
+  RadioSpiBegin(&gCheckBus);
+  bool ok = (WriteReady(CHECK_CMD_READY, 0xd0, 1) == 0);
+  ok = ok && (gCheckMock.readyWaits == waits);
+  ok = ok && (WriteReady(CHECK_CMD_READY + 1, 0xd1, 2) == 0);
+  ok = ok && (gCheckMock.readyWaits == waits + 1) && (gCheckMock.readyCmd == CHECK_CMD_READY);
+  ok = ok && (WriteReady(CHECK_CMD_READY + 2, 0xd2, 3) == 0);
+  ok = ok && (gCheckMock.readyWaits == waits + 2) && (gCheckMock.readyCmd == CHECK_CMD_READY + 1);
+  ok = ok && (RadioSpiEnd(&gCheckBus) == 0);
+  ok = ok && (gCheckMock.readyInFlight == 0);
+  ok = ok && (gCheckMock.memory[0xd0] == 1) && (gCheckMock.memory[0xd1] == 2) && (gCheckMock.memory[0xd2] == 3);
+
+  // Outside of a chain the caller waits
+  ok = ok && (WriteReady(CHECK_CMD_READY, 0xd3, 4) == 0);
+  ok = ok && (gCheckMock.readyWaits == waits + 2);
+  return HostOsCheck(CHECK_GROUP, ok, "wait ready");
+}
+
+// A chip that stays busy fails the transfer waiting for it, which is not
+// clocked out, and the rest of the chain without waiting again. The next
+// chain is not affected.
+static int CheckNotReady(void) {
+  uint16_t log_start = gCheckMock.logCount;
+  uint32_t waits = gCheckMock.readyWaits;
+
+  gCheckMock.memory[0xd5] = 0;
+  gCheckMock.memory[0xd6] = 0;
+  gCheckMock.readyFailAt = waits + 1;
+  RadioSpiBegin(&gCheckBus);
+  bool ok = (WriteReady(CHECK_CMD_READY, 0xd4, 1) == 0);
+  ok = ok && (WriteReady(CHECK_CMD_READY + 1, 0xd5, 2) != 0);
+  ok = ok && (WriteReady(CHECK_CMD_READY + 2, 0xd6, 3) != 0);
+  ok = ok && (RadioSpiEnd(&gCheckBus) != 0);
+  gCheckMock.readyFailAt = 0;
+  ok = ok && (gCheckMock.readyWaits == waits + 1);
+  ok = ok && (gCheckMock.logCount == log_start + 1) && (gCheckMock.log[log_start] == CHECK_CMD_READY);
+  ok = ok && (gCheckMock.memory[0xd5] == 0) && (gCheckMock.memory[0xd6] == 0);
+
+  RadioSpiBegin(&gCheckBus);
+  ok = ok && (WriteReady(CHECK_CMD_READY, 0xd5, 2) == 0);
+  ok = ok && (WriteReady(CHECK_CMD_READY + 1, 0xd6, 3) == 0);
+  ok = ok && (RadioSpiEnd(&gCheckBus) == 0);
+  ok = ok && (gCheckMock.memory[0xd5] == 2) && (gCheckMock.memory[0xd6] == 3);
+  return HostOsCheck(CHECK_GROUP, ok, "not ready");
+}
+
+//==========================================================================
+//==========================================================================
+int MockSpiRunChecks(void) {
+  int failed = 0;
+
+  if (MockSpiInit(&gCheckBus, &gCheckMock, "mock") != 0) {
+    return 1;
+  }
+  failed += CheckSingle();
+  failed += CheckChain();
+  failed += CheckChainRead();
+  failed += CheckOtherTask();
+  failed += CheckError();
+  failed += CheckWaitReady();
+  failed += CheckNotReady();
+  if (gCheckMock.unownedTransfers > 0) {
+    printf("SPI check: %u transfers ran without the bus.\n", gCheckMock.unownedTransfers);
+    failed++;
+  }
+  printf("SPI check: %u transfers, %u bus acquisitions, %d failed.\n", gCheckMock.completions, gCheckMock.acquires,
+         failed);
+  return failed;
+}
@@ -0,0 +1,61 @@
+//==========================================================================
+// Mock SPI bus for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Implements the radio_spi.h bus ops without hardware. A DMA task
+// completes the submitted transfers in order, each taking one tick of
+// virtual time, on a 256 byte memory addressed by the first address byte.
+// The write data is read when the transfer runs, as a DMA would. The chip
+// is ready again one tick after a command, unless a ready wait is made to
+// fail.
+//==========================================================================
+#ifndef INC_MOCK_SPI_H
+#define INC_MOCK_SPI_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "radio_spi.h"
+
+//==========================================================================
+//==========================================================================
+#define MOCK_SPI_LOG_SIZE 64
+#define MOCK_SPI_MEMORY_SIZE 256
+
+typedef struct {
+  RadioSpiBus_t *bus;
+  QueueHandle_t requests;
+  QueueHandle_t results;
+  bool acquired;
+  uint8_t inFlight;
+
+  uint32_t acquires;
+  uint32_t completions;
+  uint32_t failAt;           // Fail this completion, 0 for none
+  uint8_t maxInFlight;
+  uint32_t unownedTransfers;  // Ran while the bus was not acquired
+  uint32_t readyWaits;
+  uint32_t readyFailAt;       // Fail this ready wait, 0 for none
+  uint32_t readyInFlight;     // Ready waits with a transfer in flight
+  uint8_t readyCmd;           // Command of the last ready wait
+  uint16_t logCount;
+  uint8_t log[MOCK_SPI_LOG_SIZE];  // Opcodes in the order they ran
+  uint8_t memory[MOCK_SPI_MEMORY_SIZE];
+} MockSpi_t;
+
+//==========================================================================
+//==========================================================================
+int8_t MockSpiInit(RadioSpiBus_t *aBus, MockSpi_t *aMock, const char *aName);
+
+// Runs the transaction scheduling checks against a mock bus. Returns the
+// number of failed checks.
+int MockSpiRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_MOCK_SPI_H
@@ -0,0 +1,311 @@
+//==========================================================================
+// Mock SX126x HAL for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "mock-sx126x-hal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_os.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "SX126x"
+#define CHECK_FREQ_1 868100000
+#define CHECK_FREQ_2 868300000
+#define CHECK_PAYLOAD_SIZE 23
+
+// Written into the data buffer by a simulated reception or sleep
+#define GARBAGE 0xA5
+
+//==========================================================================
+// Simulated chip
+//==========================================================================
+MockSx126x_t gMockSx126x;
+
+static void Count(uint8_t aOpcode, uint16_t aBytes) {
+  gMockSx126x.opcodes[aOpcode]++;
+  RadioShadowCountSpi(&SX126xShadow, aBytes);
+}
+
+// Like BeginCommand() of the ESP-IDF HAL
+static void BeginCommand(void) { SX126xCheckDeviceReady(); }
+
+//==========================================================================
+// sx126x-hal.h
+//==========================================================================
+void SX126xIoIrqInit(DioIrqHandler dioIrq) {}
+void SX126xIoDeInit(void) {}
+void SX126xIoTcxoInit(void) {}
+void SX126xIoRfSwitchInit(void) { SX126xSetDio2AsRfSwitchCtrl(true); }
+void SX126xIoDbgInit(void) {}
+
+uint32_t SX126xGetBoardTcxoWakeupTime(void) { return 0; }
+uint32_t SX126xGetDio1PinState(void) { return 0; }
+bool SX126xCheckRfFrequency(uint32_t frequency) { return true; }
+
+RadioOperatingModes_t SX126xGetOperatingMode(void) { return gMockSx126x.mode; }
+void SX126xSetOperatingMode(RadioOperatingModes_t mode) { gMockSx126x.mode = mode; }
+
+void SX126xReset(void) {
+  memset(gMockSx126x.reg, 0, sizeof(gMockSx126x.reg));
+  memset(gMockSx126x.buffer, 0, sizeof(gMockSx126x.buffer));
+  gMockSx126x.irqStatus = 0;
+  RadioShadowInvalidate(&SX126xShadow, RADIO_SHADOW_ALL);
+}
+
+int8_t SX126xWaitOnBusy(void) { return 0; }
+
+void SX126xWakeup(void) {
+  Count(RADIO_GET_STATUS, 2);
+  gMockSx126x.wakeups++;
+  SX126xSetOperatingMode(MODE_STDBY_RC);
+}
+
+void SX126xChainBegin(void) {}
+void SX126xChainEnd(void) {}
+
+void SX126xWriteCommand(RadioCommands_t command, uint8_t *buffer, uint16_t size) {
+  BeginCommand();
+  Count(command, 1 + size);
+  if (command == RADIO_CLR_IRQSTATUS) {
+    gMockSx126x.irqStatus &= ~((buffer[0] << 8) | buffer[1]);
+  } else if (command == RADIO_SET_SLEEP) {
+    // The data buffer is lost in sleep, also with warm start
+    memset(gMockSx126x.buffer, GARBAGE, sizeof(gMockSx126x.buffer));
+  }
+}
+
+uint8_t SX126xReadCommand(RadioCommands_t command, uint8_t *buffer, uint16_t size) {
+  BeginCommand();
+  Count(command, 2 + size);
+  memset(buffer, 0, size);
+  if ((command == RADIO_GET_IRQSTATUS) && (size == 2)) {
+    buffer[0] = gMockSx126x.irqStatus >> 8;
+    buffer[1] = gMockSx126x.irqStatus & 0xFF;
+  }
+  return 0;
+}
+
+void SX126xWriteRegisters(uint16_t address, uint8_t *buffer, uint16_t size) {
+  BeginCommand();
+  Count(RADIO_WRITE_REGISTER, 3 + size);
+  for (uint16_t i = 0; i < size; i++) {
+    gMockSx126x.reg[(address + i) % MOCK_SX126X_REGISTERS] = buffer[i];
+  }
+}
+
+void SX126xWriteRegister(uint16_t address, uint8_t value) { SX126xWriteRegisters(address, &value, 1); }
+
+void SX126xReadRegisters(uint16_t address, uint8_t *buffer, uint16_t size) {
+  BeginCommand();
+  Count(RADIO_READ_REGISTER, 4 + size);
+  for (uint16_t i = 0; i < size; i++) {
+    buffer[i] = gMockSx126x.reg[(address + i) % MOCK_SX126X_REGISTERS];
+  }
+}
+
+uint8_t SX126xReadRegister(uint16_t address) {
+  uint8_t data;
+  SX126xReadRegisters(address, &data, 1);
+  return data;
+}
+
+void SX126xWriteBuffer(uint8_t offset, uint8_t *buffer, uint8_t size) {
+  BeginCommand();
+  Count(RADIO_WRITE_BUFFER, 2 + size);
+  for (uint16_t i = 0; i < size; i++) {
+    gMockSx126x.buffer[(offset + i) % MOCK_SX126X_BUFFER_SIZE] = buffer[i];
+  }
+}
+
+void SX126xReadBuffer(uint8_t offset, uint8_t *buffer, uint8_t size) {
+  BeginCommand();
+  Count(RADIO_READ_BUFFER, 3 + size);
+  for (uint16_t i = 0; i < size; i++) {
+    buffer[i] = gMockSx126x.buffer[(offset + i) % MOCK_SX126X_BUFFER_SIZE];
+  }
+}
+
+void SX126xSetRfTxPower(int8_t power) { SX126xSetTxParams(power, RADIO_RAMP_40_US); }
+uint8_t SX126xGetDeviceId(void) { return SX1261; }
+void SX126xAntSwOn(void) {}
+void SX126xAntSwOff(void) {}
+
+void SX126xPrintBusyStats(void) {}
+void SX126xPrintSpiStats(void) { RadioShadowPrintStats(&SX126xShadow); }
+
+//==========================================================================
+// Uplink cycle, as radio_sx126x.c drives the chip driver
+//==========================================================================
+static ModulationParams_t gModParams = {
+    .PacketType = PACKET_TYPE_LORA,
+    .Params.LoRa = {.SpreadingFactor = LORA_SF7, .Bandwidth = LORA_BW_125, .CodingRate = LORA_CR_4_5},
+};
+
+static void SetPacket(bool aIqInverted, uint8_t aPayloadLength) {
+  PacketParams_t packet = {
+      .PacketType = PACKET_TYPE_LORA,
+      .Params.LoRa = {.PreambleLength = 8,
+                      .HeaderType = LORA_PACKET_VARIABLE_LENGTH,
+                      .PayloadLength = aPayloadLength,
+                      .CrcMode = aIqInverted ? LORA_CRC_OFF : LORA_CRC_ON,
+                      .InvertIQ = aIqInverted ? LORA_IQ_INVERTED : LORA_IQ_NORMAL},
+  };
+  SX126xSetPacketParams(&packet);
+}
+
+static void SetLoRaConfig(bool aIqInverted) {
+  SX126xSetStandby(STDBY_RC);
+  SX126xSetPacketType(PACKET_TYPE_LORA);
+  SX126xSetConfigRegister(REG_LR_SYNCWORD, (LORA_MAC_PUBLIC_SYNCWORD >> 8) & 0xFF);
+  SX126xSetConfigRegister(REG_LR_SYNCWORD + 1, LORA_MAC_PUBLIC_SYNCWORD & 0xFF);
+  SX126xSetModulationParams(&gModParams);
+  SetPacket(aIqInverted, 0xFF);
+}
+
+static void ProcessIrqs(void) {
+  SX126xClearIrqStatus(SX126xGetIrqStatus());
+  SX126xSetOperatingMode(MODE_STDBY_RC);
+}
+
+// aRxIrqs are raised in the RX window, e.g. a header with no RX done
+static void Uplink(uint32_t aFreq, uint8_t *aPayload, uint16_t aRxIrqs) {
+  // RadioSetChannel, RadioSetTxConfig
+  SX126xSetRfFrequency(aFreq);
+  SetLoRaConfig(false);
+  SX126xSetConfigRegister(REG_TX_MODULATION, SX126xGetConfigRegister(REG_TX_MODULATION) | (1 << 2));
+  SX126xSetRfTxPower(14);
+
+  // RadioSend
+  SX126xSetDioIrqParams(IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT, IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT, IRQ_RADIO_NONE,
+                        IRQ_RADIO_NONE);
+  SetPacket(false, CHECK_PAYLOAD_SIZE);
+  SX126xSendPayload(aPayload, CHECK_PAYLOAD_SIZE, 0);
+  gMockSx126x.irqStatus |= IRQ_TX_DONE;
+  ProcessIrqs();
+
+  // RX window: RadioSetRxConfig, RadioRx
+  SX126xSetRfFrequency(aFreq);
+  SetLoRaConfig(true);
+  SX126xSetLoRaSymbNumTimeout(8);
+  SX126xSetConfigRegister(REG_IQ_POLARITY, SX126xGetConfigRegister(REG_IQ_POLARITY) & ~(1 << 2));
+  SX126xSetDioIrqParams(IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT | IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID,
+                        IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT, IRQ_RADIO_NONE, IRQ_RADIO_NONE);
+  SX126xSetRx(0);
+  if (aRxIrqs != 0) {
+    memset(gMockSx126x.buffer, GARBAGE, sizeof(gMockSx126x.buffer));
+    gMockSx126x.irqStatus |= aRxIrqs;
+  }
+  // Timeout, the latched IRQs stay until the next status read
+  gMockSx126x.irqStatus |= IRQ_RX_TX_TIMEOUT;
+  SX126xClearIrqStatus(IRQ_RX_TX_TIMEOUT);
+  SX126xSetOperatingMode(MODE_STDBY_RC);
+  SX126xSetStandby(STDBY_RC);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static uint32_t gOpcodesBefore[256];
+static uint32_t gCommandsBefore;
+
+static void Begin(void) {
+  memcpy(gOpcodesBefore, gMockSx126x.opcodes, sizeof(gOpcodesBefore));
+  gCommandsBefore = SX126xShadow.stats.commands;
+}
+
+// Commands sent with aOpcode since Begin()
+static uint32_t Sent(uint8_t aOpcode) { return gMockSx126x.opcodes[aOpcode] - gOpcodesBefore[aOpcode]; }
+
+static uint32_t SentTotal(void) { return SX126xShadow.stats.commands - gCommandsBefore; }
+
+static bool HasPayload(const uint8_t *aPayload) {
+  return memcmp(gMockSx126x.buffer, aPayload, CHECK_PAYLOAD_SIZE) == 0;
+}
+
+//==========================================================================
+//==========================================================================
+int MockSx126xRunChecks(void) {
+  uint8_t payload[CHECK_PAYLOAD_SIZE];
+  uint32_t first, repeat;
+  int failed = 0;
+  bool ok;
+
+  memset(&gMockSx126x, 0, sizeof(gMockSx126x));
+  memset(payload, 0x11, sizeof(payload));
+  SX126xInit(NULL);
+
+  // The second identical cycle sends only what changed in between
+  Begin();
+  Uplink(CHECK_FREQ_1, payload, 0);
+  first = SentTotal();
+  ok = (Sent(RADIO_SET_MODULATIONPARAMS) == 1) && (Sent(RADIO_SET_PACKETTYPE) == 1) && HasPayload(payload);
+  payload[0]++;
+  Begin();
+  Uplink(CHECK_FREQ_1, payload, 0);
+  repeat = SentTotal();
+  ok = ok && (repeat < first) && (Sent(RADIO_SET_MODULATIONPARAMS) == 0) && (Sent(RADIO_SET_PACKETTYPE) == 0);
+  ok = ok && (Sent(RADIO_SET_TXPARAMS) == 0) && (Sent(RADIO_SET_RFFREQUENCY) == 0) && HasPayload(payload);
+  printf("SX126x cycle: %u commands first, %u repeated\n", first, repeat);
+  failed += HostOsCheck(CHECK_GROUP, ok, "repeated config");
+
+  // A new channel sends the frequency only
+  payload[0]++;
+  Begin();
+  Uplink(CHECK_FREQ_2, payload, 0);
+  ok = (Sent(RADIO_SET_RFFREQUENCY) == 1) && (SentTotal() == repeat + 1) && HasPayload(payload);
+  failed += HostOsCheck(CHECK_GROUP, ok, "frequency only");
+
+  // A retransmission reuses the payload in the data buffer
+  uint32_t reuses = SX126xShadow.stats.payloadReuses;
+  Begin();
+  Uplink(CHECK_FREQ_2, payload, 0);
+  ok = (Sent(RADIO_WRITE_BUFFER) == 0) && (SX126xShadow.stats.payloadReuses == reuses + 1) && HasPayload(payload);
+  ok = ok && (SX126xShadow.stats.uplinkCommands < first);
+  failed += HostOsCheck(CHECK_GROUP, ok, "retransmission");
+
+  // A reception started in the RX window overwrote the buffer
+  Uplink(CHECK_FREQ_2, payload, IRQ_HEADER_VALID);
+  Begin();
+  Uplink(CHECK_FREQ_2, payload, 0);
+  ok = (Sent(RADIO_WRITE_BUFFER) == 1) && HasPayload(payload) && (gMockSx126x.irqStatus == 0);
+  failed += HostOsCheck(CHECK_GROUP, ok, "header valid");
+
+  // A warm sleep keeps the configuration only
+  SleepParams_t sleep = {0};
+  sleep.Fields.WarmStart = 1;
+  SX126xSetSleep(sleep);
+  uint32_t wakeups = gMockSx126x.wakeups;
+  Begin();
+  Uplink(CHECK_FREQ_2, payload, 0);
+  ok = (gMockSx126x.wakeups == wakeups + 1) && (Sent(RADIO_SET_MODULATIONPARAMS) == 0);
+  ok = ok && (Sent(RADIO_WRITE_BUFFER) == 1) && (Sent(RADIO_READ_REGISTER) > 0) && HasPayload(payload);
+  failed += HostOsCheck(CHECK_GROUP, ok, "warm sleep");
+
+  // After a reset everything is sent again
+  SX126xReset();
+  Begin();
+  Uplink(CHECK_FREQ_2, payload, 0);
+  ok = (Sent(RADIO_SET_MODULATIONPARAMS) == 1) && (Sent(RADIO_SET_PACKETTYPE) == 1);
+  ok = ok && (Sent(RADIO_SET_RFFREQUENCY) >= 1) && (Sent(RADIO_WRITE_BUFFER) == 1) && HasPayload(payload);
+  ok = ok && (gMockSx126x.reg[REG_LR_SYNCWORD] == ((LORA_MAC_PUBLIC_SYNCWORD >> 8) & 0xFF));
+  failed += HostOsCheck(CHECK_GROUP, ok, "reset");
+
+  SX126xPrintSpiStats();
+  printf("SX126x check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,47 @@
+//==========================================================================
+// Mock SX126x HAL for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Implements the sx126x-hal.h functions, except SX126xIoInit() and
+// SX126xIsError() from virtual-radio.c, on a simulated chip: register and
+// data buffer memory, a settable IRQ status, and a count per opcode. The
+// SPI traffic is counted into SX126xShadow like the ESP-IDF HAL does.
+//
+// MockSx126xRunChecks() drives the sx126x.c chip driver through uplink
+// cycles the way radio_sx126x.c does, and checks what reaches the chip.
+//==========================================================================
+#ifndef INC_MOCK_SX126X_HAL_H
+#define INC_MOCK_SX126X_HAL_H
+
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+
+#include "sx126x-hal.h"
+
+//==========================================================================
+//==========================================================================
+#define MOCK_SX126X_REGISTERS 0x1000
+#define MOCK_SX126X_BUFFER_SIZE 256
+
+typedef struct {
+  RadioOperatingModes_t mode;
+  uint16_t irqStatus;
+  uint8_t reg[MOCK_SX126X_REGISTERS];
+  uint8_t buffer[MOCK_SX126X_BUFFER_SIZE];
+
+  uint32_t opcodes[256];  // Commands sent per opcode
+  uint32_t wakeups;
+} MockSx126x_t;
+
+extern MockSx126x_t gMockSx126x;
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int MockSx126xRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_MOCK_SX126X_HAL_H
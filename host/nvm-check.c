@@ -0,0 +1,298 @@
+//==========================================================================
+// MAC NVM checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "nvm-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_compon.h"
+#include "lora_nvm.h"
+#include "sdkconfig.h"
+#include "secure-element.h"
+#include "utilities.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "NVM"
+#define CRC_CHECK_MAX_LENGTH 1500
+#define TASK_END_TIMEOUT_MS 10000
+#define JOIN_TIMEOUT_MS (10 * 60 * 1000)
+#define SEND_TIMEOUT_MS 60000
+#define POLL_INTERVAL_MS 100
+#define UPLINK_SIZE 12
+
+// Both radios send, then the session of each MAC context is read back
+#if defined(CONFIG_LORAWAN_DUAL_CONTEXT) && defined(CONFIG_LORAWAN_NVM_PERSIST)
+#define NVM_CHECK_SESSIONS 1
+#else
+#define NVM_CHECK_SESSIONS 0
+#endif
+
+//==========================================================================
+// Variables
+//==========================================================================
+static uint8_t gBuffer[CRC_CHECK_MAX_LENGTH];
+static volatile uint32_t gSink;
+
+#if (LORAMAC_NB_CONTEXTS > 1)
+static void OnMcpsConfirm(McpsConfirm_t *aConfirm) {}
+static void OnMcpsIndication(McpsIndication_t *aIndication) {}
+static void OnMlmeConfirm(MlmeConfirm_t *aConfirm) {}
+static void OnMlmeIndication(MlmeIndication_t *aIndication) {}
+
+static LoRaMacPrimitives_t gPrimitives = {
+    .MacMcpsConfirm = OnMcpsConfirm,
+    .MacMcpsIndication = OnMcpsIndication,
+    .MacMlmeConfirm = OnMlmeConfirm,
+    .MacMlmeIndication = OnMlmeIndication,
+};
+static LoRaMacCallback_t gCallbacks;
+#endif
+
+#if NVM_CHECK_SESSIONS
+static bool gIsm2400Selected;
+static LoRaMacNvmData_t gRestored;
+#endif
+
+//==========================================================================
+//==========================================================================
+// The CRC32 of utilities.c before the tables
+static uint32_t ReferenceCrc32(const uint8_t *aBuf, uint16_t aLen) {
+  uint32_t crc = 0xFFFFFFFF;
+
+  for (uint16_t i = 0; i < aLen; i++) {
+    crc ^= aBuf[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (uint32_t)(-(int32_t)(crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static LoRaMacNvmData_t *GetNvm(void) {
+  MibRequestConfirm_t mibReq;
+
+  mibReq.Type = MIB_NVM_CTXS;
+  if (LoRaMacMibGetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK) {
+    return NULL;
+  }
+  return mibReq.Param.Contexts;
+}
+
+static uint32_t SecureElementCrc(const LoRaMacNvmData_t *aNvm) {
+  return LoRaCrc32((uint8_t *)&aNvm->SecureElement, sizeof(aNvm->SecureElement) - sizeof(aNvm->SecureElement.Crc32));
+}
+
+// Runs the NVM check of the MAC in the context in use
+static void HandleNvm(LoRaMacNvmData_t *aNvm) {
+  LoRaMacTestSetDutyCycleOn(aNvm->MacGroup2.DutyCycleOn);
+  LoRaMacProcess();
+}
+
+#if NVM_CHECK_SESSIONS
+static bool IsSelectedRadioReady(void) {
+  return (LoRaComponIsIsm2400() == gIsm2400Selected) && LoRaComponIsTxReady();
+}
+
+// One uplink on the radio, joined first if it has no session yet
+static bool SendOn(bool aIsm2400) {
+  uint8_t data[UPLINK_SIZE] = {0};
+
+  gIsm2400Selected = aIsm2400;
+  if ((LoRaComponSelectRadio(aIsm2400) != 0) ||
+      (!HostOsWaitFor(IsSelectedRadioReady, JOIN_TIMEOUT_MS, POLL_INTERVAL_MS)) ||
+      (LoRaComponSendData(data, sizeof(data)) != 0)) {
+    return false;
+  }
+  // Wait for the frame to be taken, then for both windows
+  vTaskDelay(POLL_INTERVAL_MS / portTICK_PERIOD_MS);
+  return HostOsWaitFor(LoRaComponIsSendDone, SEND_TIMEOUT_MS, POLL_INTERVAL_MS);
+}
+#endif
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckCrc(void) {
+  static uint8_t kText[] = "123456789";
+  bool ok = (LoRaCrc32(kText, 9) == 0xCBF43926);
+
+  for (uint32_t i = 0; (i < NVM_CHECK_RANDOM_BUFFERS) && ok; i++) {
+    uint16_t len = esp_random() % CRC_CHECK_MAX_LENGTH;
+    uint16_t offset = esp_random() % (CRC_CHECK_MAX_LENGTH - len + 1);
+    uint16_t split = (len == 0) ? 0 : esp_random() % len;
+    for (uint16_t k = 0; k < len; k++) {
+      gBuffer[offset + k] = (uint8_t)esp_random();
+    }
+    uint32_t expected = ReferenceCrc32(&gBuffer[offset], len);
+    uint32_t crc = LoRaCrc32Init();
+    crc = LoRaCrc32Update(crc, &gBuffer[offset], split);
+    crc = LoRaCrc32Finalize(LoRaCrc32Update(crc, &gBuffer[offset + split], len - split));
+    ok = (LoRaCrc32(&gBuffer[offset], len) == expected) && (crc == expected);
+  }
+  return HostOsCheck(CHECK_GROUP, ok, "CRC32");
+}
+
+static double MeasureUsPerNvm(bool aReference, const LoRaMacNvmData_t *aNvm) {
+  uint32_t crc = 0;
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  for (uint32_t i = 0; i < NVM_CHECK_SPEED_ROUNDS; i++) {
+    if (aReference) {
+      crc ^= ReferenceCrc32((const uint8_t *)aNvm, sizeof(LoRaMacNvmData_t));
+    } else {
+      crc ^= LoRaCrc32((uint8_t *)aNvm, sizeof(LoRaMacNvmData_t));
+    }
+  }
+  uint64_t wall_us = HostOsGetWallTimeUs() - start_us;
+  gSink = crc;
+  return (double)wall_us / NVM_CHECK_SPEED_ROUNDS;
+}
+
+static void PrintThroughput(const LoRaMacNvmData_t *aNvm) {
+  double table_us = MeasureUsPerNvm(false, aNvm);
+  double bits_us = MeasureUsPerNvm(true, aNvm);
+  printf("CRC32 of LoRaMacNvmData_t (%u bytes): tables %.2f us, bit by bit %.2f us, %.1fx; "
+         "skipped secure element group %u bytes\n",
+         (unsigned)sizeof(LoRaMacNvmData_t), table_us, bits_us, bits_us / table_us,
+         (unsigned)sizeof(aNvm->SecureElement));
+}
+
+// A write the secure element does not know of is not seen, one through
+// its API is
+static int CheckSkip(LoRaMacNvmData_t *aNvm) {
+  uint8_t pin[SE_PIN_SIZE];
+  bool ok;
+
+  // The MIB handed out a writable pointer, the group is hashed
+  HandleNvm(aNvm);
+  ok = (aNvm->SecureElement.Crc32 == SecureElementCrc(aNvm));
+  uint32_t crc = aNvm->SecureElement.Crc32;
+
+  memcpy(pin, aNvm->SecureElement.Pin, SE_PIN_SIZE);
+  aNvm->SecureElement.Pin[0] ^= 0xFF;
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == crc);
+
+  SecureElementSetPin(aNvm->SecureElement.Pin);
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == SecureElementCrc(aNvm)) && (aNvm->SecureElement.Crc32 != crc);
+
+  SecureElementSetPin(pin);
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == crc);
+  return HostOsCheck(CHECK_GROUP, ok, "secure element skip");
+}
+
+#if NVM_CHECK_SESSIONS
+// Each context is saved in its own keys and with its own region when the
+// radio changes, so both sessions are read back from flash
+static int CheckSessions(bool aSent) {
+  uint8_t id = LoRaMacGetContext();
+  bool ok = aSent && (LoRaNvmInit() == 0);
+
+  for (uint8_t ctx = 0; (ctx < LORAMAC_NB_CONTEXTS) && (ok); ctx++) {
+    ok = (LoRaMacSwitchContext(ctx) == LORAMAC_STATUS_OK);
+    LoRaMacNvmData_t *nvm = GetNvm();
+    memset(&gRestored, 0, sizeof(gRestored));
+    ok = ok && (nvm != NULL) && (LoRaNvmRestore(ctx, &gRestored, nvm->MacGroup2.Region) > 0);
+    ok = ok && (gRestored.MacGroup2.DevAddr != 0) && (gRestored.MacGroup2.DevAddr == nvm->MacGroup2.DevAddr) &&
+         (gRestored.Crypto.FCntList.FCntUp == nvm->Crypto.FCntList.FCntUp);
+  }
+  ok = (LoRaMacSwitchContext(id) == LORAMAC_STATUS_OK) && ok;
+  return HostOsCheck(CHECK_GROUP, ok, "session per context");
+}
+#endif
+
+#if (LORAMAC_NB_CONTEXTS > 1)
+// Changed in one context, switched before the NVM check ran
+static int CheckContextSwitch(LoRaMacNvmData_t *aNvm) {
+  uint8_t id = LoRaMacGetContext();
+  uint8_t other = (id + 1) % LORAMAC_NB_CONTEXTS;
+  uint8_t pin[SE_PIN_SIZE];
+  bool ok = true;
+
+  HandleNvm(aNvm);
+  uint32_t crc = aNvm->SecureElement.Crc32;
+  memcpy(pin, aNvm->SecureElement.Pin, SE_PIN_SIZE);
+  pin[0] ^= 0xFF;
+  SecureElementSetPin(pin);
+
+  // Set up again, the host run may not have used it. Its secure element
+  // reports the change of its own key list.
+  ok = ok && (LoRaMacSwitchContext(other) == LORAMAC_STATUS_OK);
+  ok = ok && (LoRaMacInitialization(&gPrimitives, &gCallbacks, LORAMAC_REGION_ISM2400) == LORAMAC_STATUS_OK);
+  LoRaMacStart();
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == SecureElementCrc(aNvm));
+
+  ok = ok && (LoRaMacSwitchContext(id) == LORAMAC_STATUS_OK);
+  LoRaMacStart();
+  ok = ok && (aNvm->SecureElement.Crc32 == crc);
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == SecureElementCrc(aNvm)) && (aNvm->SecureElement.Crc32 != crc);
+
+  pin[0] ^= 0xFF;
+  SecureElementSetPin(pin);
+  HandleNvm(aNvm);
+  ok = ok && (aNvm->SecureElement.Crc32 == crc);
+  return HostOsCheck(CHECK_GROUP, ok, "context switch");
+}
+#endif
+
+//==========================================================================
+//==========================================================================
+int NvmCheckRunChecks(void) {
+  int failed = 0;
+
+#if NVM_CHECK_SESSIONS
+  // The sub-GHz context leaves for ISM2400 and comes back
+  bool sent = SendOn(true) && SendOn(false);
+#endif
+  LoRaComponStop();
+  for (uint32_t ms = 0; HostOsIsTaskRunning("LoRaTask"); ms++) {
+    if (ms >= TASK_END_TIMEOUT_MS) {
+      return HostOsCheck(CHECK_GROUP, false, "LoRa task end");
+    }
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+#if NVM_CHECK_SESSIONS
+  failed += CheckSessions(sent);
+#endif
+  LoRaMacStart();
+  LoRaMacNvmData_t *nvm = GetNvm();
+  if (nvm == NULL) {
+    return HostOsCheck(CHECK_GROUP, false, "MIB");
+  }
+
+  failed += CheckCrc();
+  PrintThroughput(nvm);
+  failed += CheckSkip(nvm);
+#if (LORAMAC_NB_CONTEXTS > 1)
+  failed += CheckContextSwitch(nvm);
+#endif
+  LoRaMacStop();
+  printf("NVM check: %d failed.\n", failed);
+  return failed;
+}
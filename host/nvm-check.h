@@ -0,0 +1,30 @@
+//==========================================================================
+// MAC NVM checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Compares LoRaCrc32() with the bit by bit CRC on random buffers and
+// prints the time to hash LoRaMacNvmData_t with both. Then drives the NVM
+// check of the stopped MAC: the secure element group must not be hashed
+// again while the secure element reports no change, and must be once it
+// does. A change made before a context switch must be hashed when the
+// context is back, not in the other one.
+//==========================================================================
+#ifndef INC_NVM_CHECK_H
+#define INC_NVM_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define NVM_CHECK_RANDOM_BUFFERS 10000
+#define NVM_CHECK_SPEED_ROUNDS 10000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks. Runs on the joined component and
+// stops it, then waits for the LoRa task to end and uses the MAC on its
+// own.
+int NvmCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_NVM_CHECK_H
@@ -0,0 +1,190 @@
+//==========================================================================
+// RX ring stress test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "rxring-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_rxring.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "RX ring"
+// The index wraps after this many frames
+#define WRAP_AFTER_FRAMES 1000
+
+// Every 64th frame the consumer stops for a while
+#define SLOW_EVERY_MASK 63
+#define SLOW_LOOPS 2000
+
+//==========================================================================
+// Variables
+//==========================================================================
+static uint32_t gTasksDone;
+static uint32_t gProduced;
+static uint32_t gDropped;
+static uint32_t gConsumed;
+static uint32_t gOutOfOrder;
+static uint32_t gCorrupted;
+static uint32_t gMaxCount;
+
+//==========================================================================
+// Each frame carries its sequence in the data pointer, and its complement
+// in the size and the info
+//==========================================================================
+static void FillView(LoRaRxView_t *aView, uint32_t aSeq) {
+  aView->data = (const uint8_t *)(uintptr_t)aSeq;
+  aView->dataSize = (uint16_t)~aSeq;
+  aView->info.rssi = (int16_t)(aSeq >> 16);
+  aView->info.fport = (uint8_t)aSeq;
+}
+
+static bool IsConsistent(const LoRaRxView_t *aView, uint32_t *aSeq) {
+  uint32_t seq = (uint32_t)(uintptr_t)aView->data;
+  *aSeq = seq;
+  return (aView->dataSize == (uint16_t)~seq) && (aView->info.rssi == (int16_t)(seq >> 16)) &&
+         (aView->info.fport == (uint8_t)seq);
+}
+
+static void ProducerTask(void *aParam) {
+  for (uint32_t seq = 1; seq <= RXRING_CHECK_FRAMES; seq++) {
+    LoRaRxView_t *slot = LoRaRxRingGetWriteSlot();
+    if (slot == NULL) {
+      LoRaRxRingCountOverflow();
+      gDropped++;
+      // Let the consumer catch up, also with a single CPU
+      vTaskDelay(0);
+      continue;
+    }
+    FillView(slot, seq);
+    LoRaRxRingCommit();
+    gProduced++;
+  }
+  __atomic_fetch_add(&gTasksDone, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+static void ConsumerTask(void *aParam) {
+  uint32_t last = 0;
+
+  // Until the producer has ended and the ring is empty
+  for (;;) {
+    const LoRaRxView_t *view = LoRaRxRingPeek();
+    if (view == NULL) {
+      if (__atomic_load_n(&gTasksDone, __ATOMIC_ACQUIRE) > 0) {
+        if (LoRaRxRingPeek() == NULL) break;
+      }
+      vTaskDelay(0);
+      continue;
+    }
+
+    uint16_t count = LoRaRxRingCount();
+    if (count > gMaxCount) {
+      gMaxCount = count;
+    }
+    uint32_t seq;
+    if (!IsConsistent(view, &seq)) {
+      gCorrupted++;
+    } else if (seq <= last) {
+      gOutOfOrder++;
+    }
+    last = seq;
+    LoRaRxRingRelease();
+    gConsumed++;
+
+    if ((seq & SLOW_EVERY_MASK) == 0) {
+      for (volatile uint32_t k = 0; k < SLOW_LOOPS; k++) {
+      }
+    }
+  }
+  __atomic_fetch_add(&gTasksDone, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+// Fill across the wrap-around without a consumer
+static int CheckOverflow(void) {
+  uint32_t start = UINT32_MAX - LORA_RX_RING_SIZE / 2;
+  uint32_t seq;
+  bool ok = true;
+
+  LoRaRxRingInitAt(start);
+  for (uint32_t i = 0; i < LORA_RX_RING_SIZE; i++) {
+    LoRaRxView_t *slot = LoRaRxRingGetWriteSlot();
+    ok = ok && (slot != NULL);
+    if (slot == NULL) break;
+    FillView(slot, start + i);
+    LoRaRxRingCommit();
+  }
+  ok = ok && (LoRaRxRingCount() == LORA_RX_RING_SIZE) && (LoRaRxRingGetWriteSlot() == NULL);
+  LoRaRxRingCountOverflow();
+
+  for (uint32_t i = 0; i < LORA_RX_RING_SIZE; i++) {
+    const LoRaRxView_t *view = LoRaRxRingPeek();
+    ok = ok && (view != NULL) && IsConsistent(view, &seq) && (seq == start + i);
+    LoRaRxRingRelease();
+  }
+  ok = ok && (LoRaRxRingPeek() == NULL) && (LoRaRxRingCount() == 0) && (LoRaRxRingOverflowCount() == 1);
+  return HostOsCheck(CHECK_GROUP, ok, "overflow");
+}
+
+static int CheckStress(void) {
+  gTasksDone = 0;
+  gProduced = 0;
+  gDropped = 0;
+  gConsumed = 0;
+  gOutOfOrder = 0;
+  gCorrupted = 0;
+  gMaxCount = 0;
+  LoRaRxRingInitAt(UINT32_MAX - WRAP_AFTER_FRAMES);
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  if ((xTaskCreate(ConsumerTask, "RxRingConsumer", 2048, NULL, 1, NULL) != pdPASS) ||
+      (xTaskCreate(ProducerTask, "RxRingProducer", 2048, NULL, 1, NULL) != pdPASS)) {
+    return HostOsCheck(CHECK_GROUP, false, "stress");
+  }
+  // Virtual time stands still until both tasks have ended
+  while (__atomic_load_n(&gTasksDone, __ATOMIC_ACQUIRE) < 2) {
+    vTaskDelay(1);
+  }
+  uint64_t wall_us = HostOsGetWallTimeUs() - start_us;
+
+  printf("RX ring: %u frames in %.3f s, %u delivered, %u dropped (counted %u), max depth %u of %u\n",
+         RXRING_CHECK_FRAMES, wall_us / 1e6, gConsumed, gDropped, LoRaRxRingOverflowCount(), gMaxCount,
+         LORA_RX_RING_SIZE);
+  bool ok = (gProduced + gDropped == RXRING_CHECK_FRAMES) && (gConsumed == gProduced);
+  ok = ok && (LoRaRxRingOverflowCount() == gDropped) && (gDropped > 0) && (gConsumed > WRAP_AFTER_FRAMES);
+  ok = ok && (gOutOfOrder == 0) && (gCorrupted == 0) && (gMaxCount <= LORA_RX_RING_SIZE);
+  return HostOsCheck(CHECK_GROUP, ok, "stress");
+}
+
+//==========================================================================
+//==========================================================================
+int RxRingCheckRunChecks(void) {
+  int failed = 0;
+
+  failed += CheckOverflow();
+  failed += CheckStress();
+  LoRaRxRingInit();
+  printf("RX ring check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,27 @@
+//==========================================================================
+// RX ring stress test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Runs main/lora_rxring.c with a producer and a consumer task on POSIX
+// threads. The consumer is slower at times, so the ring overflows and
+// the producer drops and counts frames. The index start close to 2^32
+// and wrap during the run. Every frame must arrive once and in order,
+// and every missing one must be counted as dropped.
+//==========================================================================
+#ifndef INC_RXRING_CHECK_H
+#define INC_RXRING_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define RXRING_CHECK_FRAMES 1000000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks. Must run before the component is
+// started, it uses the ring on its own.
+int RxRingCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RXRING_CHECK_H
@@ -0,0 +1,117 @@
+//==========================================================================
+// RX window timing check for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "rxtiming-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "LoRaMac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_compon.h"
+#include "sdkconfig.h"
+#include "virtual-ns.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "RX timing"
+#if defined(CONFIG_LORAWAN_MAX_RX_ERROR)
+#define MAX_RX_ERROR_US (CONFIG_LORAWAN_MAX_RX_ERROR * 1000)
+#else
+#define MAX_RX_ERROR_US (20 * 1000)
+#endif
+
+#define SEND_TIMEOUT_MS 60000
+#define POLL_INTERVAL_MS 100
+#define UPLINK_PORT 5
+#define UPLINK_SIZE 12
+
+//==========================================================================
+// Variables
+//==========================================================================
+// The last one is above the max RX error
+static const uint32_t kDioLatencyMs[] = {0, 1, 8, 30};
+
+// End of the last uplink on air
+static uint64_t gUplinkEndUs;
+
+//==========================================================================
+//==========================================================================
+static VirtualNsAction_t RecordUplink(const VirtualNsUplink_t *aUplink, void *aArg) {
+  __atomic_store_n(&gUplinkEndUs, aUplink->frame->endUs, __ATOMIC_RELAXED);
+  return VNS_ACTION_DEFAULT;
+}
+
+static bool SendUplink(void) {
+  uint8_t data[UPLINK_SIZE] = {0};
+
+  if ((!HostOsWaitFor(LoRaComponIsTxReady, SEND_TIMEOUT_MS, POLL_INTERVAL_MS)) ||
+      (LoRaComponEnqueueData(data, sizeof(data), UPLINK_PORT, LORA_TX_MODE_UNCONFIRMED, LORA_TX_PRIORITY_NORMAL) !=
+       0)) {
+    return false;
+  }
+  // Wait for the frame to be taken, then for both windows
+  vTaskDelay(POLL_INTERVAL_MS / portTICK_PERIOD_MS);
+  return HostOsWaitFor(LoRaComponIsSendDone, SEND_TIMEOUT_MS, POLL_INTERVAL_MS);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckWindows(void) {
+  LoRaMacRxTiming_t timing;
+  int64_t max_error_us = 0;
+  uint32_t windows = 0;
+  bool ok = true;
+
+  VirtualNsSetScript(RecordUplink, NULL);
+  for (uint8_t i = 0; i < sizeof(kDioLatencyMs) / sizeof(kDioLatencyMs[0]); i++) {
+    int64_t latency_max_us = 0;
+
+    HostBoardSetDioLatencyMs(kDioLatencyMs[i]);
+    for (uint8_t k = 0; k < RXTIMING_CHECK_UPLINKS; k++) {
+      ok = ok && SendUplink() && LoRaMacGetRxTiming(&timing);
+      ok = ok && (timing.TxDoneUs == __atomic_load_n(&gUplinkEndUs, __ATOMIC_RELAXED));
+      for (uint8_t w = 0; (w < 2) && ok; w++) {
+        int64_t error_us = (int64_t)(timing.OpenedUs[w] - timing.ScheduledUs[w]);
+        if (error_us < 0) error_us = -error_us;
+        ok = (timing.OpenedUs[w] != 0) && (error_us <= MAX_RX_ERROR_US);
+        if (error_us > latency_max_us) latency_max_us = error_us;
+        windows++;
+      }
+    }
+    printf("RX timing: DIO latency %u ms, RX1 at %.3f ms, RX2 at %.3f ms from TxDone, max error %lld us of %u us\n",
+           kDioLatencyMs[i], (timing.OpenedUs[0] - timing.TxDoneUs) / 1000.0,
+           (timing.OpenedUs[1] - timing.TxDoneUs) / 1000.0, (long long)latency_max_us, MAX_RX_ERROR_US);
+    if (latency_max_us > max_error_us) max_error_us = latency_max_us;
+  }
+  HostBoardSetDioLatencyMs(0);
+  VirtualNsSetScript(NULL, NULL);
+  return HostOsCheck(CHECK_GROUP,
+                     ok && (windows == 2 * RXTIMING_CHECK_UPLINKS * sizeof(kDioLatencyMs) / sizeof(kDioLatencyMs[0])),
+                     "windows");
+}
+
+//==========================================================================
+//==========================================================================
+int RxTimingCheckRunChecks(void) {
+  int failed = CheckWindows();
+  printf("RX timing check: %d failed.\n", failed);
+  return failed;
+}
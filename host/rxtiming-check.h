@@ -0,0 +1,26 @@
+//==========================================================================
+// RX window timing check for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Sends unconfirmed uplinks through the joined component, so both RX
+// windows open, while the DIO interrupt is dispatched late by up to more
+// than the max RX error. The MAC must take TxDone at the end of the frame
+// on air, and open RX1 and RX2 within CONFIG_LORAWAN_MAX_RX_ERROR of the
+// time scheduled from it. Reads the log of LORAMAC_RX_TIMING_LOG.
+//==========================================================================
+#ifndef INC_RXTIMING_CHECK_H
+#define INC_RXTIMING_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define RXTIMING_CHECK_UPLINKS 3
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks. Needs the joined component.
+int RxTimingCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RXTIMING_CHECK_H
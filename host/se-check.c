@@ -0,0 +1,298 @@
+//==========================================================================
+// Secure element checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "se-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "aes.h"
+#include "cmac.h"
+#include "esp_random.h"
+#include "host_os.h"
+#include "secure-element-nvm.h"
+#include "secure-element.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Secure element"
+// Session and root keys, more than the key cache holds
+#define CHECK_KEY_COUNT 8
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef enum {
+  kSeOpSetKey = 0,
+  kSeOpSetSameKey,
+  kSeOpRestoreKey,
+  kSeOpEncrypt,
+  kSeOpCmac,
+  kSeOpCtr,
+  kSeOpCount,
+} SeOp_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static const KeyIdentifier_t kCheckKeys[CHECK_KEY_COUNT] = {
+    APP_KEY, NWK_KEY, J_S_INT_KEY, J_S_ENC_KEY, F_NWK_S_INT_KEY, S_NWK_S_INT_KEY, NWK_S_ENC_KEY, APP_S_KEY,
+};
+
+static SecureElementNvmData_t gSeNvm;
+
+// Value each key must have
+static uint8_t gKeyValue[CHECK_KEY_COUNT][SE_KEY_SIZE];
+
+// Set when the key is in the cache with its current value
+static bool gKeyPrepared[CHECK_KEY_COUNT];
+
+static volatile uint32_t gSink;
+
+//==========================================================================
+//==========================================================================
+static void RandomBytes(uint8_t *aBuf, uint16_t aLen) {
+  for (uint16_t i = 0; i < aLen; i++) {
+    aBuf[i] = (uint8_t)esp_random();
+  }
+}
+
+// Time stamp counter of the host, wall clock ns where there is none
+static uint64_t ReadCycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return HostOsGetWallTimeUs() * 1000;
+#endif
+}
+
+static Key_t *FindKey(KeyIdentifier_t aKeyId) {
+  for (uint8_t i = 0; i < NUM_OF_KEYS; i++) {
+    if (gSeNvm.KeyList[i].KeyID == aKeyId) {
+      return &gSeNvm.KeyList[i];
+    }
+  }
+  return NULL;
+}
+
+// CMAC of B0 and the message with the plain AES-CMAC
+static uint32_t ReferenceMic(const uint8_t aKey[SE_KEY_SIZE], const uint8_t *aB0, const uint8_t *aMsg,
+                             uint16_t aSize) {
+  AES_CMAC_CTX ctx;
+  uint8_t mac[AES_CMAC_DIGEST_LENGTH];
+
+  AES_CMAC_Init(&ctx);
+  AES_CMAC_SetKey(&ctx, aKey);
+  AES_CMAC_Update(&ctx, aB0, N_BLOCK);
+  AES_CMAC_Update(&ctx, aMsg, aSize);
+  AES_CMAC_Final(mac, &ctx);
+  return (uint32_t)mac[3] << 24 | (uint32_t)mac[2] << 16 | (uint32_t)mac[1] << 8 | (uint32_t)mac[0];
+}
+
+// Key stream of the counter blocks, 128 bits big endian
+static void ReferenceCtr(const uint8_t aKey[SE_KEY_SIZE], const uint8_t *aCounter, uint8_t *aBuf, uint16_t aSize) {
+  aes_context ctx;
+  uint8_t counter[N_BLOCK];
+  uint8_t stream[N_BLOCK];
+
+  lora_aes_set_key(aKey, SE_KEY_SIZE, &ctx);
+  memcpy(counter, aCounter, N_BLOCK);
+  for (uint16_t pos = 0; pos < aSize; pos += N_BLOCK) {
+    laes_encrypt(counter, stream, &ctx);
+    for (uint16_t i = 0; (i < N_BLOCK) && (pos + i < aSize); i++) {
+      aBuf[pos + i] ^= stream[i];
+    }
+    for (int8_t i = N_BLOCK - 1; i >= 0; i--) {
+      if (++counter[i] != 0) break;
+    }
+  }
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+// Runs one AES operation with key aIdx and compares it with AES on the
+// value the key must have. aMisses is the number of keys the secure
+// element may prepare for it.
+static bool RunOp(SeOp_t aOp, uint8_t aIdx, uint32_t *aMisses) {
+  KeyIdentifier_t key_id = kCheckKeys[aIdx];
+  uint8_t b0[N_BLOCK];
+  uint8_t msg[SE_CHECK_FRAME_SIZE];
+  uint8_t out[SE_CHECK_FRAME_SIZE];
+  uint8_t expected[SE_CHECK_FRAME_SIZE];
+  uint16_t size = 1 + esp_random() % SE_CHECK_FRAME_SIZE;
+  bool ok = false;
+
+  *aMisses = gKeyPrepared[aIdx] ? 0 : 1;
+  RandomBytes(b0, sizeof(b0));
+  RandomBytes(msg, sizeof(msg));
+  switch (aOp) {
+    case kSeOpEncrypt: {
+      aes_context ctx;
+      size = N_BLOCK;
+      lora_aes_set_key(gKeyValue[aIdx], SE_KEY_SIZE, &ctx);
+      laes_encrypt(msg, expected, &ctx);
+      ok = (SecureElementAesEncrypt(msg, size, key_id, out) == SECURE_ELEMENT_SUCCESS);
+      break;
+    }
+    case kSeOpCmac: {
+      uint32_t mic = 0;
+      ok = (SecureElementComputeAesCmac(b0, msg, size, key_id, &mic) == SECURE_ELEMENT_SUCCESS);
+      ok = ok && (mic == ReferenceMic(gKeyValue[aIdx], b0, msg, size));
+      memset(out, 0, size);
+      memset(expected, 0, size);
+      break;
+    }
+    case kSeOpCtr:
+    default:
+      memcpy(out, msg, size);
+      memcpy(expected, msg, size);
+      ReferenceCtr(gKeyValue[aIdx], b0, expected, size);
+      ok = (SecureElementAesCtrCrypt(b0, out, size, key_id) == SECURE_ELEMENT_SUCCESS);
+      break;
+  }
+  gKeyPrepared[aIdx] = true;
+  return ok && (memcmp(out, expected, size) == 0);
+}
+
+// Random operations on random keys. A key changed through SetKey or in
+// the key list must be prepared again once, also when the value stays.
+static int CheckKeyChanges(void) {
+  uint32_t set_keys = 0;
+  uint32_t restores = 0;
+  uint32_t wrong_results = 0;
+  uint32_t wrong_misses = 0;
+  uint32_t cached = 0;
+
+  for (uint8_t i = 0; i < CHECK_KEY_COUNT; i++) {
+    memcpy(gKeyValue[i], FindKey(kCheckKeys[i])->KeyValue, SE_KEY_SIZE);
+    gKeyPrepared[i] = false;
+  }
+
+  for (uint32_t round = 0; round < SE_CHECK_ROUNDS; round++) {
+    uint8_t idx = esp_random() % CHECK_KEY_COUNT;
+    SeOp_t op = (SeOp_t)(esp_random() % kSeOpCount);
+
+    if (op == kSeOpSetKey) {
+      RandomBytes(gKeyValue[idx], SE_KEY_SIZE);
+    }
+    switch (op) {
+      case kSeOpSetKey:
+      case kSeOpSetSameKey:
+        if (SecureElementSetKey(kCheckKeys[idx], gKeyValue[idx]) != SECURE_ELEMENT_SUCCESS) {
+          wrong_results++;
+        }
+        gKeyPrepared[idx] = false;
+        set_keys++;
+        break;
+      case kSeOpRestoreKey:
+        RandomBytes(gKeyValue[idx], SE_KEY_SIZE);
+        memcpy(FindKey(kCheckKeys[idx])->KeyValue, gKeyValue[idx], SE_KEY_SIZE);
+        gKeyPrepared[idx] = false;
+        restores++;
+        break;
+      default: {
+        uint32_t before = SecureElementGetKeyCacheMisses();
+        uint32_t misses;
+        if (!RunOp(op, idx, &misses)) {
+          wrong_results++;
+        }
+        uint32_t done = SecureElementGetKeyCacheMisses() - before;
+        // A key not changed may have been evicted by the others
+        if ((done != misses) && !((misses == 0) && (done == 1))) {
+          wrong_misses++;
+        }
+        cached += (done == 0) ? 1 : 0;
+        break;
+      }
+    }
+  }
+  printf("Secure element: %u SetKey, %u restores, %u operations from the cache, %u keys prepared\n", set_keys,
+         restores, cached, SecureElementGetKeyCacheMisses());
+  return HostOsCheck(CHECK_GROUP, (wrong_results == 0) && (wrong_misses == 0) && (cached > 0), "key changes");
+}
+
+// Once per SetKey, also without an operation in between, and never for
+// an operation right after another one on the same key
+static int CheckSetKeyInvalidates(void) {
+  bool ok = true;
+  uint32_t misses;
+
+  for (uint8_t i = 0; i < CHECK_KEY_COUNT; i++) {
+    ok = ok && RunOp(kSeOpCmac, i, &misses);
+    uint32_t before = SecureElementGetKeyCacheMisses();
+    ok = ok && RunOp(kSeOpCtr, i, &misses) && (SecureElementGetKeyCacheMisses() == before);
+
+    SecureElementSetKey(kCheckKeys[i], gKeyValue[i]);
+    SecureElementSetKey(kCheckKeys[i], gKeyValue[i]);
+    gKeyPrepared[i] = false;
+    before = SecureElementGetKeyCacheMisses();
+    ok = ok && RunOp(kSeOpEncrypt, i, &misses) && (SecureElementGetKeyCacheMisses() == before + 1);
+  }
+  return HostOsCheck(CHECK_GROUP, ok, "SetKey invalidates");
+}
+
+static double MeasureCyclesPerByte(bool aMic, bool aSetKey) {
+  uint8_t b0[N_BLOCK] = {0};
+  uint8_t msg[SE_CHECK_FRAME_SIZE] = {0};
+  uint8_t key[SE_KEY_SIZE] = {0};
+  uint32_t mic = 0;
+
+  SecureElementSetKey(APP_S_KEY, key);
+  uint64_t start = ReadCycles();
+  for (uint32_t i = 0; i < SE_CHECK_SPEED_ROUNDS; i++) {
+    if (aSetKey) {
+      SecureElementSetKey(APP_S_KEY, key);
+    }
+    if (aMic) {
+      SecureElementComputeAesCmac(b0, msg, sizeof(msg), APP_S_KEY, &mic);
+    } else {
+      SecureElementAesCtrCrypt(b0, msg, sizeof(msg), APP_S_KEY);
+    }
+  }
+  uint64_t cycles = ReadCycles() - start;
+  gSink = mic ^ msg[0];
+  return (double)cycles / ((double)SE_CHECK_SPEED_ROUNDS * SE_CHECK_FRAME_SIZE);
+}
+
+static void PrintThroughput(void) {
+  double mic_hit = MeasureCyclesPerByte(true, false);
+  double mic_miss = MeasureCyclesPerByte(true, true);
+  double ctr_hit = MeasureCyclesPerByte(false, false);
+  double ctr_miss = MeasureCyclesPerByte(false, true);
+  printf("Secure element cycles per byte of a %u bytes frame: MIC %.1f cached, %.1f after SetKey; "
+         "CTR %.1f cached, %.1f after SetKey\n",
+         SE_CHECK_FRAME_SIZE, mic_hit, mic_miss, ctr_hit, ctr_miss);
+}
+
+//==========================================================================
+//==========================================================================
+int SeCheckRunChecks(void) {
+  int failed = 0;
+
+  if (SecureElementInit(&gSeNvm) != SECURE_ELEMENT_SUCCESS) {
+    return HostOsCheck(CHECK_GROUP, false, "init");
+  }
+  failed += CheckKeyChanges();
+  failed += CheckSetKeyInvalidates();
+  PrintThroughput();
+  printf("Secure element check: %d failed.\n", failed);
+  return failed;
+}
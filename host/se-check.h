@@ -0,0 +1,31 @@
+//==========================================================================
+// Secure element checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Runs sec/soft-se.c on a key list of its own. Keys are changed through
+// SecureElementSetKey() and by writing the key list like a restore from
+// NVM, between encryptions, CMACs and CTR runs on random keys. Every
+// result must match AES on the current key value, every change must
+// prepare the key again exactly once, and a key in the cache must not be
+// prepared again. Then prints the cycles per byte of a MIC and of a
+// payload encryption, with the key in the cache and after SetKey.
+//==========================================================================
+#ifndef INC_SE_CHECK_H
+#define INC_SE_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define SE_CHECK_ROUNDS 20000
+#define SE_CHECK_SPEED_ROUNDS 100000
+#define SE_CHECK_FRAME_SIZE 64
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks. Must run before the component is
+// started, SecureElementInit() drops the keys of the MAC.
+int SeCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_SE_CHECK_H
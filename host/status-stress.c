@@ -0,0 +1,184 @@
+//==========================================================================
+// Link status read stress test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "status-stress.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_status.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Status"
+// Same timeout as the component mutex
+#define STRESS_MUTEX_WAIT_MS 50
+
+//==========================================================================
+// Variables
+//==========================================================================
+static SemaphoreHandle_t gStressMutex;
+static LoRaStatusSnapshot_t gLockedSnapshot;  // The mutex version
+static bool gUseMutex;
+
+static uint32_t gReadersDone;
+static uint32_t gTasksDone;
+static uint32_t gTornReads;
+static uint32_t gLockTimeouts;
+static uint32_t gPublishes;
+
+//==========================================================================
+// Every field is derived from the sequence, a mix of two publishes does
+// not match.
+//==========================================================================
+static void MakeSnapshot(uint32_t aSeq, LoRaStatusSnapshot_t *aSnapshot) {
+  aSnapshot->linkStatus = aSeq;
+  aSnapshot->linkState = (uint8_t)aSeq;
+  aSnapshot->txFull = ((aSeq & 1) != 0);
+  aSnapshot->txLen = (int16_t)(aSeq & 0x7fff);
+  aSnapshot->txQueued = (uint16_t)~aSeq;
+  aSnapshot->macBusy = ((aSeq & 2) != 0);
+  aSnapshot->linkTick = aSeq * 3;
+  aSnapshot->joinInterval = ~aSeq;
+}
+
+static bool IsConsistent(const LoRaStatusSnapshot_t *aSnapshot) {
+  LoRaStatusSnapshot_t expected;
+  MakeSnapshot(aSnapshot->linkStatus, &expected);
+  return (aSnapshot->linkState == expected.linkState) && (aSnapshot->txFull == expected.txFull) &&
+         (aSnapshot->txLen == expected.txLen) && (aSnapshot->txQueued == expected.txQueued) &&
+         (aSnapshot->macBusy == expected.macBusy) && (aSnapshot->linkTick == expected.linkTick) &&
+         (aSnapshot->joinInterval == expected.joinInterval);
+}
+
+//==========================================================================
+// Tasks
+//==========================================================================
+// The writer holds the mutex while it publishes, like loraTask does
+static void WriterTask(void *aParam) {
+  LoRaStatusSnapshot_t snapshot;
+  uint32_t seq = 0;
+
+  while (__atomic_load_n(&gReadersDone, __ATOMIC_ACQUIRE) < STATUS_STRESS_READERS) {
+    MakeSnapshot(++seq, &snapshot);
+    if (xSemaphoreTake(gStressMutex, STRESS_MUTEX_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE) {
+      __atomic_fetch_add(&gLockTimeouts, 1, __ATOMIC_RELAXED);
+      continue;
+    }
+    if (gUseMutex) {
+      gLockedSnapshot = snapshot;
+    } else {
+      LoRaStatusPublish(&snapshot);
+    }
+    xSemaphoreGive(gStressMutex);
+  }
+  gPublishes = seq;
+  __atomic_fetch_add(&gTasksDone, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+static void ReaderTask(void *aParam) {
+  LoRaStatusSnapshot_t snapshot;
+
+  for (uint32_t i = 0; i < STATUS_STRESS_READS; i++) {
+    if (gUseMutex) {
+      if (xSemaphoreTake(gStressMutex, STRESS_MUTEX_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE) {
+        __atomic_fetch_add(&gLockTimeouts, 1, __ATOMIC_RELAXED);
+        continue;
+      }
+      snapshot = gLockedSnapshot;
+      xSemaphoreGive(gStressMutex);
+    } else {
+      LoRaStatusRead(&snapshot);
+    }
+    if (!IsConsistent(&snapshot)) {
+      __atomic_fetch_add(&gTornReads, 1, __ATOMIC_RELAXED);
+    }
+  }
+  __atomic_fetch_add(&gReadersDone, 1, __ATOMIC_RELEASE);
+  __atomic_fetch_add(&gTasksDone, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+//==========================================================================
+// Returns the reads per second, 0 on error
+//==========================================================================
+static double RunStress(bool aUseMutex) {
+  gUseMutex = aUseMutex;
+  gReadersDone = 0;
+  gTasksDone = 0;
+  gTornReads = 0;
+  gLockTimeouts = 0;
+  MakeSnapshot(0, &gLockedSnapshot);
+  LoRaStatusInit();
+  LoRaStatusPublish(&gLockedSnapshot);
+
+  uint64_t start_us = HostOsGetWallTimeUs();
+  if (xTaskCreate(WriterTask, "StressWriter", 2048, NULL, 1, NULL) != pdPASS) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < STATUS_STRESS_READERS; i++) {
+    if (xTaskCreate(ReaderTask, "StressReader", 2048, NULL, 1, NULL) != pdPASS) {
+      return 0;
+    }
+  }
+  // Virtual time stands still until all stress tasks have ended
+  while (__atomic_load_n(&gTasksDone, __ATOMIC_ACQUIRE) < STATUS_STRESS_READERS + 1) {
+    vTaskDelay(1);
+  }
+  uint64_t wall_us = HostOsGetWallTimeUs() - start_us;
+
+  double reads_per_s = (double)STATUS_STRESS_READERS * STATUS_STRESS_READS * 1e6 / (wall_us ? wall_us : 1);
+  printf("Status %s: %u readers x %u reads, %u publishes in %.3f s, %.2f M reads/s, torn=%u timeouts=%u",
+         aUseMutex ? "mutex" : "seqlock", STATUS_STRESS_READERS, STATUS_STRESS_READS, gPublishes, wall_us / 1e6,
+         reads_per_s / 1e6, gTornReads, gLockTimeouts);
+  if (aUseMutex) {
+    printf("\n");
+  } else {
+    printf(" retries=%u\n", LoRaStatusRetryCount());
+  }
+  return reads_per_s;
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+int StatusStressRunChecks(void) {
+  int failed = 0;
+
+  gStressMutex = xSemaphoreCreateMutex();
+  if (gStressMutex == NULL) {
+    printf("ERROR. StatusStressRunChecks create mutex failed.\n");
+    return 1;
+  }
+
+  double mutex_rate = RunStress(true);
+  failed += HostOsCheck(CHECK_GROUP, (mutex_rate > 0) && (gTornReads == 0), "mutex reads");
+  double seqlock_rate = RunStress(false);
+  failed += HostOsCheck(CHECK_GROUP, (seqlock_rate > 0) && (gTornReads == 0), "seqlock reads");
+  if ((mutex_rate > 0) && (seqlock_rate > 0)) {
+    printf("Status seqlock/mutex read throughput: %.1fx\n", seqlock_rate / mutex_rate);
+  }
+
+  vSemaphoreDelete(gStressMutex);
+  gStressMutex = NULL;
+  printf("Status check: %d failed.\n", failed);
+  return failed;
+}
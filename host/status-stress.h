@@ -0,0 +1,26 @@
+//==========================================================================
+// Link status read stress test for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Several reader tasks poll the link status while a writer task publishes
+// it as fast as it can, once through lora_status.h and once through a
+// mutex protected copy like GetStatus() did before. Every snapshot is
+// checked for a torn read, and the reads per second of both are printed.
+//==========================================================================
+#ifndef INC_STATUS_STRESS_H
+#define INC_STATUS_STRESS_H
+
+//==========================================================================
+//==========================================================================
+#define STATUS_STRESS_READERS 4
+#define STATUS_STRESS_READS 100000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int StatusStressRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_STATUS_STRESS_H
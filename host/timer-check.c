@@ -0,0 +1,181 @@
+//==========================================================================
+// Timer checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "timer-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "board.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "timer.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Timer"
+// Longer than the delay before the restarts, so none has expired by then
+#define MIN_TIMER_VALUE_US 2000
+#define MAX_TIMER_VALUE_US 2000000
+
+// LoRaGetTick() is this close to 2^32 when the wrap-around timers start
+#define WRAP_BEFORE_MS 50
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint8_t id;
+  uint32_t tick;
+  uint32_t elapsedMs;
+  uint64_t latencyUs;
+} FiredTimer_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static TimerEvent_t gTimers[TIMER_CHECK_TIMERS];
+static FiredTimer_t gFired[TIMER_CHECK_TIMERS];
+static volatile uint8_t gFiredCount;
+static uint32_t gStartTick;
+
+//==========================================================================
+//==========================================================================
+static void OnTimer(void *aContext) {
+  uint8_t id = (uint8_t)(uintptr_t)aContext;
+  if (gFiredCount < TIMER_CHECK_TIMERS) {
+    FiredTimer_t *fired = &gFired[gFiredCount];
+    fired->id = id;
+    fired->tick = LoRaGetTick();
+    fired->elapsedMs = TimerGetElapsedTime(gStartTick);
+    fired->latencyUs = LoRaGetTickUs() - gTimers[id].Deadline;
+    gFiredCount++;
+  }
+}
+
+static void InitTimers(void) {
+  gFiredCount = 0;
+  for (uint8_t i = 0; i < TIMER_CHECK_TIMERS; i++) {
+    TimerInit(&gTimers[i], OnTimer);
+    TimerSetContext(&gTimers[i], (void *)(uintptr_t)i);
+  }
+}
+
+// Virtual time only moves while this task waits
+static void WaitFired(uint8_t aCount, uint32_t aTimeoutMs) {
+  uint32_t start = LoRaGetTick();
+  while ((gFiredCount < aCount) && (LoRaTickElapsed(start) < aTimeoutMs)) {
+    vTaskDelay(1);
+  }
+  // Nothing more is expected
+  vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+// Timers 0-2 are started again, 3 is stopped and 4 initialized again
+// while queued. The other ones expire in the order of their deadlines.
+static int CheckOrdering(void) {
+  const uint8_t kExpected = TIMER_CHECK_TIMERS - 2;
+  uint64_t max_latency = 0;
+  uint64_t sum_latency = 0;
+  bool ok = true;
+
+  InitTimers();
+  gStartTick = LoRaGetTick();
+  for (uint8_t i = 0; i < TIMER_CHECK_TIMERS; i++) {
+    uint32_t value = MIN_TIMER_VALUE_US + esp_random() % (MAX_TIMER_VALUE_US - MIN_TIMER_VALUE_US);
+    if (i & 1) {
+      TimerSetValueUs(&gTimers[i], value);
+    } else {
+      TimerSetValue(&gTimers[i], value / 1000);
+    }
+    TimerStart(&gTimers[i]);
+  }
+  vTaskDelay(1);
+  for (uint8_t i = 0; i < 3; i++) {
+    TimerStart(&gTimers[i]);
+  }
+  TimerStop(&gTimers[3]);
+  TimerInit(&gTimers[4], OnTimer);
+  ok = ok && !TimerExists(&gTimers[3]) && !TimerExists(&gTimers[4]) && TimerExists(&gTimers[5]);
+
+  WaitFired(kExpected, MAX_TIMER_VALUE_US / 1000 + 10);
+
+  ok = ok && (gFiredCount == kExpected);
+  for (uint8_t i = 0; i < gFiredCount; i++) {
+    const FiredTimer_t *fired = &gFired[i];
+    ok = ok && (fired->id != 3) && (fired->id != 4) && !TimerIsStarted(&gTimers[fired->id]);
+    if (i > 0) {
+      ok = ok && (gTimers[gFired[i - 1].id].Deadline <= gTimers[fired->id].Deadline);
+    }
+    sum_latency += fired->latencyUs;
+    if (fired->latencyUs > max_latency) {
+      max_latency = fired->latencyUs;
+    }
+  }
+  ok = ok && (max_latency <= TIMER_CHECK_MAX_LATENCY_US);
+  printf("Timer: %u of %u timers expired in order, latency mean %.1f us, max %u us (limit %u us)\n", gFiredCount,
+         TIMER_CHECK_TIMERS, (gFiredCount > 0) ? (double)sum_latency / gFiredCount : 0.0, (unsigned)max_latency,
+         TIMER_CHECK_MAX_LATENCY_US);
+  return HostOsCheck(CHECK_GROUP, ok, "ordering");
+}
+
+// Started in the reverse order, the first one expires before the tick
+// wraps, the other two after
+static int CheckWrapAround(void) {
+  const uint32_t kValueMs[3] = {WRAP_BEFORE_MS - 20, WRAP_BEFORE_MS + 30, WRAP_BEFORE_MS * 3};
+  bool ok = true;
+
+  InitTimers();
+  uint64_t target_us = ((1ULL << 32) - WRAP_BEFORE_MS) * 1000;
+  HostOsSetClockOffsetUs(target_us - HostOsGetTimeUs());
+  gStartTick = LoRaGetTick();
+  for (int8_t i = 2; i >= 0; i--) {
+    TimerSetValue(&gTimers[i], kValueMs[i]);
+    TimerStart(&gTimers[i]);
+  }
+
+  WaitFired(3, kValueMs[2] + 10);
+  HostOsSetClockOffsetUs(0);
+
+  ok = ok && (gStartTick == UINT32_MAX - WRAP_BEFORE_MS + 1) && (gFiredCount == 3);
+  for (uint8_t i = 0; i < gFiredCount; i++) {
+    const FiredTimer_t *fired = &gFired[i];
+    ok = ok && (fired->id == i) && (fired->elapsedMs == kValueMs[i]);
+    ok = ok && (fired->latencyUs <= TIMER_CHECK_MAX_LATENCY_US);
+    ok = ok && ((i == 0) ? (fired->tick > gStartTick) : (fired->tick < gStartTick));
+  }
+  printf("Timer: start tick 0x%08x, expired at 0x%08x 0x%08x 0x%08x\n", (unsigned)gStartTick,
+         (unsigned)gFired[0].tick, (unsigned)gFired[1].tick, (unsigned)gFired[2].tick);
+  return HostOsCheck(CHECK_GROUP, ok, "wrap-around");
+}
+
+//==========================================================================
+//==========================================================================
+int TimerCheckRunChecks(void) {
+  int failed = 0;
+
+  // Creates the board alarm
+  LoRaBoardInitMcu();
+  failed += CheckOrdering();
+  failed += CheckWrapAround();
+  printf("Timer check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,29 @@
+//==========================================================================
+// Timer checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Runs platform/timer.c on the virtual clock: timers with random values
+// expire in deadline order, also when restarted, stopped or initialized
+// again while queued. The clock is then moved close to the LoRaGetTick()
+// wrap-around and timers are run across it. The callback latency is
+// taken from the deadline to the callback.
+//==========================================================================
+#ifndef INC_TIMER_CHECK_H
+#define INC_TIMER_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define TIMER_CHECK_TIMERS 12
+
+// The polled timer list had up to 1 ms, the deadline heap adds none
+#define TIMER_CHECK_MAX_LATENCY_US 100
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int TimerCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_TIMER_CHECK_H
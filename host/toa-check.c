@@ -0,0 +1,213 @@
+//==========================================================================
+// Time on air checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "toa-check.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "RegionCommon.h"
+#include "host_os.h"
+#include "radio_toa.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "ToA"
+#define ISM2400_DATARATES 8
+#define ISM2400_BW_KHZ 812
+
+//==========================================================================
+// Variables
+//==========================================================================
+static const uint16_t kLoRaBwKhz[] = {203, 406, 812, 1625};
+static const uint16_t kGfskBitsPerMs[] = {2000, 1600, 1000, 800, 500, 400, 250, 125};
+
+static uint16_t gCache[ISM2400_DATARATES][REGION_COMMON_TOA_CACHE_LEN];
+static uint32_t gComputeCalls;
+static volatile uint32_t gSink;
+
+//==========================================================================
+// The floating point formulas radio_sx1280.c used before
+//==========================================================================
+static __attribute__((noinline)) uint32_t DoubleLoRa(uint16_t aBwKhz, uint8_t aSf, uint8_t aCoderate,
+                                                     uint16_t aPreambleLen, bool aFixLen, uint8_t aPayloadLen,
+                                                     bool aCrcOn) {
+  double npayload;
+  uint8_t crc = aCrcOn ? 16 : 0;
+  uint8_t header = aFixLen ? 0 : 20;
+
+  if (aSf < 7) {
+    npayload = fmax((double)(aPayloadLen + crc - (4 * aSf) + header), 0.0);
+    npayload = ceil(npayload / (double)(4 * aSf));
+    npayload = npayload * (aCoderate + 4) + aPreambleLen + 6.25 + 8;
+  } else if (aSf > 10) {
+    npayload = fmax((double)(aPayloadLen + crc - (4 * aSf) + 8 + header), 0.0);
+    npayload = ceil(npayload / (double)(4 * (aSf - 2)));
+    npayload = npayload * (aCoderate + 4) + aPreambleLen + 4.25 + 8;
+  } else {
+    npayload = fmax((double)(aPayloadLen + crc - (4 * aSf) + 8 + header), 0.0);
+    npayload = ceil(npayload / (double)(4 * aSf));
+    npayload = npayload * (aCoderate + 4) + aPreambleLen + 4.25 + 8;
+  }
+  return ceil(npayload * ((double)(1 << aSf) / (double)aBwKhz));
+}
+
+static __attribute__((noinline)) uint32_t DoubleGfsk(uint16_t aBitsPerMs, uint16_t aPreambleLen, bool aFixLen,
+                                                     uint8_t aPayloadLen, bool aCrcOn) {
+  uint16_t bits = 4 + (aPreambleLen >> 4) * 4;
+
+  bits = bits + 8 + (3 >> 1) * 8;
+  bits = bits + (aFixLen ? 0 : 80);
+  bits = bits + aPayloadLen * 8;
+  bits = bits + (aCrcOn ? 8 : 0);
+  return ceil((double)bits / (double)aBitsPerMs);
+}
+
+// ISM2400 uplink: SF12 to SF5, 812 kHz, CR 4/5, 8 symbols preamble
+static TimerTime_t ComputeIsm2400(int8_t aDatarate, uint16_t aPktLen) {
+  gComputeCalls++;
+  return RadioToaSx1280LoRa(ISM2400_BW_KHZ, 12 - aDatarate, 1, 8, false, (uint8_t)aPktLen, true);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckLoRa(void) {
+  uint32_t points = 0;
+  uint32_t mismatches = 0;
+
+  for (uint8_t b = 0; b < sizeof(kLoRaBwKhz) / sizeof(kLoRaBwKhz[0]); b++) {
+    for (uint8_t sf = 5; sf <= 12; sf++) {
+      for (uint8_t cr = 1; cr <= 7; cr++) {
+        for (uint16_t preamble = 0; preamble <= TOA_CHECK_MAX_PREAMBLE; preamble++) {
+          for (uint16_t len = 0; len < 256; len++) {
+            for (uint8_t flags = 0; flags < 4; flags++) {
+              bool fix_len = (flags & 1) != 0;
+              bool crc_on = (flags & 2) != 0;
+              uint32_t expected = DoubleLoRa(kLoRaBwKhz[b], sf, cr, preamble, fix_len, (uint8_t)len, crc_on);
+              uint32_t got = RadioToaSx1280LoRa(kLoRaBwKhz[b], sf, cr, preamble, fix_len, (uint8_t)len, crc_on);
+              points++;
+              if (got != expected) {
+                if (mismatches++ == 0) {
+                  printf("ToA LoRa: bw=%u sf=%u cr=%u preamble=%u fix=%d len=%u crc=%d: %u, expected %u\n",
+                         kLoRaBwKhz[b], sf, cr, preamble, fix_len, len, crc_on, got, expected);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  printf("ToA LoRa: %u points, %u differ\n", points, mismatches);
+  return HostOsCheck(CHECK_GROUP, mismatches == 0, "LoRa");
+}
+
+// The preamble counts in steps of 16 bits
+static int CheckGfsk(void) {
+  uint32_t points = 0;
+  uint32_t mismatches = 0;
+
+  for (uint8_t r = 0; r < sizeof(kGfskBitsPerMs) / sizeof(kGfskBitsPerMs[0]); r++) {
+    for (uint32_t step = 0; step < 0x1000; step++) {
+      uint16_t preamble = (uint16_t)((step << 4) | (step & 0x0F));
+      for (uint16_t len = 0; len < 256; len++) {
+        for (uint8_t flags = 0; flags < 4; flags++) {
+          bool fix_len = (flags & 1) != 0;
+          bool crc_on = (flags & 2) != 0;
+          uint32_t expected = DoubleGfsk(kGfskBitsPerMs[r], preamble, fix_len, (uint8_t)len, crc_on);
+          uint32_t got = RadioToaSx1280Gfsk(kGfskBitsPerMs[r], preamble, fix_len, (uint8_t)len, crc_on);
+          points++;
+          if ((got != expected) && (mismatches++ == 0)) {
+            printf("ToA GFSK: rate=%u preamble=%u fix=%d len=%u crc=%d: %u, expected %u\n", kGfskBitsPerMs[r],
+                   preamble, fix_len, len, crc_on, got, expected);
+          }
+        }
+      }
+    }
+  }
+  printf("ToA GFSK: %u points, %u differ\n", points, mismatches);
+  return HostOsCheck(CHECK_GROUP, mismatches == 0, "GFSK");
+}
+
+// Every entry is computed once, the second pass is served from the cache
+static int CheckCache(void) {
+  bool ok = true;
+
+  memset(gCache, 0, sizeof(gCache));
+  gComputeCalls = 0;
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (int8_t dr = 0; dr < ISM2400_DATARATES; dr++) {
+      for (uint16_t len = 0; len < REGION_COMMON_TOA_CACHE_LEN; len++) {
+        TimerTime_t toa = RegionCommonGetCachedTimeOnAir(gCache[0], ISM2400_DATARATES, dr, len, ComputeIsm2400);
+        ok = ok && (toa == RadioToaSx1280LoRa(ISM2400_BW_KHZ, 12 - dr, 1, 8, false, (uint8_t)len, true));
+      }
+    }
+  }
+  ok = ok && (gComputeCalls == ISM2400_DATARATES * REGION_COMMON_TOA_CACHE_LEN);
+
+  // Outside of the cache, computed every time
+  gComputeCalls = 0;
+  RegionCommonGetCachedTimeOnAir(gCache[0], ISM2400_DATARATES, ISM2400_DATARATES, 10, ComputeIsm2400);
+  RegionCommonGetCachedTimeOnAir(gCache[0], ISM2400_DATARATES, 0, REGION_COMMON_TOA_CACHE_LEN, ComputeIsm2400);
+  ok = ok && (gComputeCalls == 2);
+  return HostOsCheck(CHECK_GROUP, ok, "cache");
+}
+
+//==========================================================================
+// Time per call over all ISM2400 uplinks
+//==========================================================================
+static void Benchmark(void) {
+  const uint32_t calls = TOA_CHECK_BENCH_LOOPS * ISM2400_DATARATES * 256;
+  uint64_t us[3];
+  uint32_t sum = 0;
+
+  for (uint8_t kind = 0; kind < 3; kind++) {
+    uint64_t start_us = HostOsGetWallTimeUs();
+    for (uint32_t loop = 0; loop < TOA_CHECK_BENCH_LOOPS; loop++) {
+      for (int8_t dr = 0; dr < ISM2400_DATARATES; dr++) {
+        for (uint16_t len = 0; len < 256; len++) {
+          if (kind == 0) {
+            sum += DoubleLoRa(ISM2400_BW_KHZ, 12 - dr, 1, 8, false, (uint8_t)len, true);
+          } else if (kind == 1) {
+            sum += RadioToaSx1280LoRa(ISM2400_BW_KHZ, 12 - dr, 1, 8, false, (uint8_t)len, true);
+          } else {
+            sum += RegionCommonGetCachedTimeOnAir(gCache[0], ISM2400_DATARATES, dr, len, ComputeIsm2400);
+          }
+        }
+      }
+    }
+    us[kind] = HostOsGetWallTimeUs() - start_us;
+  }
+  gSink = sum;
+  printf("ToA per call: double %.1f ns, integer %.1f ns, cache %.1f ns\n", us[0] * 1000.0 / calls,
+         us[1] * 1000.0 / calls, us[2] * 1000.0 / calls);
+}
+
+//==========================================================================
+//==========================================================================
+int ToaCheckRunChecks(void) {
+  int failed = 0;
+
+  failed += CheckLoRa();
+  failed += CheckGfsk();
+  failed += CheckCache();
+  Benchmark();
+  printf("ToA check: %d failed.\n", failed);
+  return failed;
+}
@@ -0,0 +1,27 @@
+//==========================================================================
+// Time on air checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Compares the integer SX1280 time on air of radio/radio_toa.c with the
+// floating point formulas it replaced, for every bandwidth, spreading
+// factor, coding rate, preamble, header mode, payload length and CRC
+// setting. Checks the region time on air cache, and prints the time per
+// call of the three.
+//==========================================================================
+#ifndef INC_TOA_CHECK_H
+#define INC_TOA_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define TOA_CHECK_MAX_PREAMBLE 64
+#define TOA_CHECK_BENCH_LOOPS 200
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int ToaCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_TOA_CHECK_H
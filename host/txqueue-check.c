@@ -0,0 +1,317 @@
+//==========================================================================
+// TX queue checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "txqueue-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_compon.h"
+#include "lora_txqueue.h"
+#include "virtual-ns.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "TX queue"
+// Frames pushed per round, more than fit, then the queue is drained
+#define ROUND_PUSHES (LORA_TX_QUEUE_SIZE + 2)
+
+#define ROUND_TRIP_PORT 10
+#define ROUND_TRIP_FRAMES 4
+#define ROUND_TRIP_UPLINKS 8
+#define SEND_TIMEOUT_MS 120000
+#define POLL_INTERVAL_MS 100
+
+// MHDR, DevAddr, FCtrl and FCnt in front of the FOpts
+#define FHDR_SIZE 8
+#define FOPTS_MAX_SIZE 15
+#define SRV_MAC_DEV_STATUS_REQ 0x06
+#define DEV_STATUS_ANS_SIZE 3
+
+// First payload byte, a frame to drop once
+#define FRAME_RETRY 'R'
+#define FRAME_ONCE 'U'
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint8_t headerSize;  // In front of the payload
+  uint8_t fOptsLen;
+  bool micValid;
+  uint8_t payloadSize;
+  uint8_t payload[LORAWAN_MAX_PAYLOAD_LEN];
+} RecordedUplink_t;
+
+typedef struct {
+  uint8_t kind;
+  LoRaTxMode_t mode;
+  uint8_t size;
+} RoundTripFrame_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static RecordedUplink_t gUplinks[ROUND_TRIP_UPLINKS];
+static uint8_t gUplinkCount;
+static bool gDroppedOnce[ROUND_TRIP_FRAMES];
+
+//==========================================================================
+//==========================================================================
+static uint64_t GetTimeNs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Byte 0-3 the frame id, then a pattern of it
+static void FillPayload(uint8_t *aData, uint16_t aLen, uint32_t aId) {
+  for (uint16_t i = 0; i < aLen; i++) {
+    aData[i] = (i < 4) ? (uint8_t)(aId >> (i * 8)) : (uint8_t)(aId + i);
+  }
+}
+
+static uint32_t GetPayloadId(const uint8_t *aData) {
+  return aData[0] | (aData[1] << 8) | (aData[2] << 16) | ((uint32_t)aData[3] << 24);
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+// Take all frames, highest priority first and oldest first within a
+// priority. Returns the number of frames.
+static uint32_t DrainQueue(bool *aOk) {
+  uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+  const LoRaTxFrame_t *last = NULL;
+  uint8_t last_priority = 0;
+  uint32_t last_seq = 0;
+  uint32_t count = 0;
+  LoRaTxFrame_t *frame;
+
+  while ((frame = LoRaTxQueueTakeHead()) != NULL) {
+    const uint8_t *payload = LORA_TX_FRAME_PAYLOAD(frame);
+    FillPayload(data, frame->dataSize, GetPayloadId(payload));
+    *aOk = *aOk && (memcmp(payload, data, frame->dataSize) == 0) && (frame->port == ROUND_TRIP_PORT);
+    if (last != NULL) {
+      *aOk = *aOk && ((frame->priority < last_priority) ||
+                      ((frame->priority == last_priority) && ((int32_t)(frame->seq - last_seq) > 0)));
+    }
+    last = frame;
+    last_priority = frame->priority;
+    last_seq = frame->seq;
+    LoRaTxQueueReleaseSending();
+    count++;
+  }
+  return count;
+}
+
+// A frame that does not fit is dropped, or replaces the newest of a lower
+// priority. The queue is drained after each round.
+static int CheckPushLatency(void) {
+  const uint8_t kPriorities[3] = {LORA_TX_PRIORITY_LOW, LORA_TX_PRIORITY_NORMAL, LORA_TX_PRIORITY_HIGH};
+  uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+  uint32_t accepted = 0;
+  uint32_t rejected = 0;
+  uint32_t drained = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+  bool ok = true;
+
+  LoRaTxQueueInit();
+  for (uint32_t id = 0; id < TXQUEUE_CHECK_FRAMES; id++) {
+    uint16_t len = 4 + esp_random() % (LORAWAN_MAX_PAYLOAD_LEN - 3);
+    uint8_t priority = kPriorities[esp_random() % 3];
+    FillPayload(data, len, id);
+
+    uint64_t start_ns = GetTimeNs();
+    int8_t ret = LoRaTxQueuePush(data, len, ROUND_TRIP_PORT, LORA_TX_MODE_UNCONFIRMED, priority);
+    uint64_t push_ns = GetTimeNs() - start_ns;
+    total_ns += push_ns;
+    if (push_ns > max_ns) {
+      max_ns = push_ns;
+    }
+    if (ret == 0) {
+      accepted++;
+    } else {
+      rejected++;
+    }
+
+    if ((id % ROUND_PUSHES) == ROUND_PUSHES - 1) {
+      drained += DrainQueue(&ok);
+    }
+  }
+  drained += DrainQueue(&ok);
+
+  LoRaTxQueueStats_t stats;
+  LoRaTxQueueGetStats(&stats);
+  ok = ok && (stats.enqueued == accepted) && (stats.dropped == rejected + (accepted - drained)) &&
+       (stats.maxDepth == LORA_TX_QUEUE_SIZE) && (stats.depth == 0);
+  printf("TX queue: %u frames, %u queued, %u dropped, push %.1f ns mean, %u ns max\n", TXQUEUE_CHECK_FRAMES,
+         accepted, stats.dropped, (double)total_ns / TXQUEUE_CHECK_FRAMES, (unsigned)max_ns);
+  LoRaTxQueueInit();
+  return HostOsCheck(CHECK_GROUP, ok, "push");
+}
+
+// Deep sleep drops the queued frames. The frame in use by the MAC and the
+// reserved slot stay.
+static int CheckSleepDrop(void) {
+  uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+  bool ok = true;
+
+  LoRaTxQueueInit();
+  for (uint32_t id = 0; id < LORA_TX_QUEUE_SIZE; id++) {
+    FillPayload(data, 8, id);
+    ok = ok && (LoRaTxQueuePush(data, 8, ROUND_TRIP_PORT, LORA_TX_MODE_UNCONFIRMED, LORA_TX_PRIORITY_NORMAL) == 0);
+  }
+  LoRaTxFrame_t *sending = LoRaTxQueueTakeHead();
+  ok = ok && (sending != NULL) && (LoRaTxQueueReserve() != NULL);
+
+  uint16_t dropped = LoRaTxQueueDropQueued();
+  LoRaTxQueueStats_t stats;
+  LoRaTxQueueGetStats(&stats);
+  ok = ok && (dropped == LORA_TX_QUEUE_SIZE - 1) && (stats.dropped == dropped) && (stats.depth == 0) &&
+       (LoRaTxQueuePeekHead() == NULL);
+  // The frame being sent is untouched, a commit still queues
+  ok = ok && (sending != NULL) && (GetPayloadId(LORA_TX_FRAME_PAYLOAD(sending)) == 0);
+  LoRaTxQueueReleaseSending();
+  ok = ok && (LoRaTxQueueCommit(8, ROUND_TRIP_PORT, LORA_TX_MODE_UNCONFIRMED, LORA_TX_PRIORITY_NORMAL) == 0) &&
+       (LoRaTxQueueCount() == 1);
+  LoRaTxQueueInit();
+  return HostOsCheck(CHECK_GROUP, ok, "deep sleep drop");
+}
+
+//==========================================================================
+// Round trips through the MAC
+//==========================================================================
+static VirtualNsAction_t RecordUplink(const VirtualNsUplink_t *aUplink, void *aArg) {
+  if ((aUplink->isJoin) || (aUplink->fPort != ROUND_TRIP_PORT) || (aUplink->payloadSize < 5)) {
+    return VNS_ACTION_DEFAULT;
+  }
+
+  if (gUplinkCount < ROUND_TRIP_UPLINKS) {
+    RecordedUplink_t *uplink = &gUplinks[gUplinkCount++];
+    uplink->fOptsLen = aUplink->frame->data[5] & 0x0f;
+    uplink->headerSize = FHDR_SIZE + uplink->fOptsLen + 1;
+    uplink->micValid = aUplink->micValid;
+    uplink->payloadSize = aUplink->payloadSize;
+    memcpy(uplink->payload, aUplink->payload, aUplink->payloadSize);
+  }
+
+  // The frame without ACK is sent again
+  uint32_t id = GetPayloadId(aUplink->payload + 1);
+  if ((aUplink->payload[0] == FRAME_RETRY) && (id < ROUND_TRIP_FRAMES) && (!gDroppedOnce[id])) {
+    gDroppedOnce[id] = true;
+    return VNS_ACTION_NO_REPLY;
+  }
+  return VNS_ACTION_DEFAULT;
+}
+
+static bool SendRoundTripFrame(const RoundTripFrame_t *aFrame, uint32_t aId) {
+  uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+
+  data[0] = aFrame->kind;
+  FillPayload(data + 1, aFrame->size - 1, aId);
+  if ((!HostOsWaitFor(LoRaComponIsTxReady, SEND_TIMEOUT_MS, POLL_INTERVAL_MS)) ||
+      (LoRaComponEnqueueData(data, aFrame->size, ROUND_TRIP_PORT, aFrame->mode, LORA_TX_PRIORITY_NORMAL) != 0)) {
+    return false;
+  }
+  // Wait for the frame to be taken, then for its result
+  vTaskDelay(POLL_INTERVAL_MS / portTICK_PERIOD_MS);
+  return HostOsWaitFor(LoRaComponIsSendDone, SEND_TIMEOUT_MS, POLL_INTERVAL_MS);
+}
+
+// Each uplink of frame aId must carry its plain payload with a valid MIC.
+// Returns the number of uplinks, the first one in aFirst.
+static uint8_t CheckUplinksOf(const RoundTripFrame_t *aFrame, uint32_t aId, const RecordedUplink_t **aFirst,
+                              bool *aOk) {
+  uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+  uint8_t count = 0;
+
+  data[0] = aFrame->kind;
+  FillPayload(data + 1, aFrame->size - 1, aId);
+  *aFirst = NULL;
+  for (uint8_t i = 0; i < gUplinkCount; i++) {
+    const RecordedUplink_t *uplink = &gUplinks[i];
+    if (GetPayloadId(uplink->payload + 1) != aId) continue;
+    *aOk = *aOk && uplink->micValid && (uplink->payloadSize == aFrame->size) &&
+           (memcmp(uplink->payload, data, aFrame->size) == 0);
+    if (*aFirst == NULL) {
+      *aFirst = uplink;
+    }
+    count++;
+  }
+  return count;
+}
+
+// 0: sent once. 1: no ACK, restored and sent again. 2: brings the
+// DevStatusReq downlink. 3: sent with the answers in FOpts, no ACK,
+// restored and sent again.
+static int CheckRoundTrips(void) {
+  const RoundTripFrame_t kFrames[ROUND_TRIP_FRAMES] = {
+      {FRAME_ONCE, LORA_TX_MODE_UNCONFIRMED, 20},
+      {FRAME_RETRY, LORA_TX_MODE_CONFIRMED, 40},
+      {FRAME_ONCE, LORA_TX_MODE_UNCONFIRMED, 12},
+      {FRAME_RETRY, LORA_TX_MODE_CONFIRMED, 16},
+  };
+  uint8_t dev_status[FOPTS_MAX_SIZE / DEV_STATUS_ANS_SIZE];
+  const RecordedUplink_t *first;
+  bool ok = true;
+
+  gUplinkCount = 0;
+  memset(gDroppedOnce, 0, sizeof(gDroppedOnce));
+  VirtualNsSetScript(RecordUplink, NULL);
+  for (uint32_t id = 0; id < ROUND_TRIP_FRAMES; id++) {
+    if (id == 2) {
+      memset(dev_status, SRV_MAC_DEV_STATUS_REQ, sizeof(dev_status));
+      VirtualNsQueueDownlink(0, dev_status, sizeof(dev_status));
+    }
+    ok = ok && SendRoundTripFrame(&kFrames[id], id);
+  }
+  VirtualNsSetScript(NULL, NULL);
+
+  for (uint32_t id = 0; id < ROUND_TRIP_FRAMES; id++) {
+    uint8_t expected = (kFrames[id].kind == FRAME_RETRY) ? 2 : 1;
+    ok = ok && (CheckUplinksOf(&kFrames[id], id, &first, &ok) == expected);
+  }
+  // First uplink of frame 3, with the DevStatusAns in FOpts
+  ok = ok && (first != NULL) && (first->fOptsLen == FOPTS_MAX_SIZE) &&
+       (first->headerSize == LORAMAC_FRAME_HEADROOM);
+  printf("TX queue: %u uplinks of %u frames, FOpts %u bytes, header %u of %u bytes\n", gUplinkCount,
+         ROUND_TRIP_FRAMES, (first != NULL) ? first->fOptsLen : 0, (first != NULL) ? first->headerSize : 0,
+         LORAMAC_FRAME_HEADROOM);
+  return HostOsCheck(CHECK_GROUP, ok, "round trips");
+}
+
+//==========================================================================
+//==========================================================================
+int TxQueueCheckRunChecks(void) {
+  int failed = CheckPushLatency();
+  failed += CheckSleepDrop();
+  printf("TX queue check: %d failed.\n", failed);
+  return failed;
+}
+
+int TxQueueCheckRunRoundTrips(void) {
+  int failed = CheckRoundTrips();
+  printf("TX queue round trip check: %d failed.\n", failed);
+  return failed;
+}
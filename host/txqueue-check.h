@@ -0,0 +1,33 @@
+//==========================================================================
+// TX queue checks for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Pushes thousands of frames with random priorities and lengths through
+// main/lora_txqueue.c, checks the order, the payloads and the counters,
+// and prints the time per push. Checks that deep sleep drops the queued
+// frames but keeps the one in use by the MAC. Then sends queued frames
+// through the MAC in place: a frame without ACK is sent again after
+// LoRaMacMcpsRestorePayload(), also after an uplink with 15 bytes of
+// FOpts, which fills LORAMAC_FRAME_HEADROOM completely.
+//==========================================================================
+#ifndef INC_TXQUEUE_CHECK_H
+#define INC_TXQUEUE_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define TXQUEUE_CHECK_FRAMES 10000
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks. Must run before the component is
+// started, it uses the queue on its own.
+int TxQueueCheckRunChecks(void);
+
+// Returns the number of failed checks. Needs a started and joined
+// component.
+int TxQueueCheckRunRoundTrips(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_TXQUEUE_CHECK_H
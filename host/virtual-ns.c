@@ -0,0 +1,425 @@
+//==========================================================================
+// Network server stub for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "virtual-ns.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aes.h"
+#include "cmac.h"
+#include "nvs_flash.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define MTYPE_JOIN_REQUEST 0
+#define MTYPE_JOIN_ACCEPT 1
+#define MTYPE_UNCONFIRMED_UP 2
+#define MTYPE_UNCONFIRMED_DOWN 3
+#define MTYPE_CONFIRMED_UP 4
+
+#define JOIN_REQUEST_SIZE 23
+#define DATA_MIN_SIZE 12
+#define FCTRL_ACK 0x20
+#define FCTRL_ADR_ACK_REQ 0x40
+
+#define JOIN_ACCEPT_DELAY_US 5000000
+#define RX1_DELAY_S 1
+
+#define DIR_UPLINK 0
+#define DIR_DOWNLINK 1
+
+#define NS_NVS_NAMESPACE "VirtualNs"
+#define NS_NVS_KEY "session"
+
+// A network per radio chip, sub-GHz and ISM2400
+#define NS_NETWORK_COUNT 2
+
+//==========================================================================
+// Variables
+//==========================================================================
+static pthread_mutex_t gNsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static aes_context gNwkKey;
+static uint32_t gNetId;
+static uint32_t gAssignDevAddr;
+
+// Session, kept in NVS next to the device contexts
+typedef struct {
+  bool joined;
+  uint32_t devAddr;
+  uint32_t joinNonce;
+  uint32_t fCntUp;
+  uint32_t fCntDown;
+  uint8_t nwkSKey[16];
+  uint8_t appSKey[16];
+} NsSession_t;
+
+typedef struct {
+  NsSession_t session;
+  aes_context nwkSKey;
+  aes_context appSKey;
+} NsNetwork_t;
+
+static NsNetwork_t gNetworks[NS_NETWORK_COUNT];
+
+// Pending application downlink
+static bool gDownlinkPending;
+static uint8_t gDownlinkPort;
+static uint8_t gDownlinkSize;
+static uint8_t gDownlinkData[VIRTUAL_RADIO_MAX_FRAME];
+
+static VirtualNsScript_t gScript;
+static void *gScriptArg;
+static VirtualNsStats_t gNsStats;
+
+//==========================================================================
+// Crypto helpers
+//==========================================================================
+static void PutU32(uint8_t *aBuf, uint32_t aValue) {
+  aBuf[0] = (uint8_t)aValue;
+  aBuf[1] = (uint8_t)(aValue >> 8);
+  aBuf[2] = (uint8_t)(aValue >> 16);
+  aBuf[3] = (uint8_t)(aValue >> 24);
+}
+
+static uint32_t GetU32(const uint8_t *aBuf) {
+  return (uint32_t)aBuf[0] | ((uint32_t)aBuf[1] << 8) | ((uint32_t)aBuf[2] << 16) | ((uint32_t)aBuf[3] << 24);
+}
+
+static void ComputeMic(const aes_context *aKey, const uint8_t *aB0, const uint8_t *aMsg, uint16_t aLen, uint8_t *aMic) {
+  AES_CMAC_CTX ctx;
+  uint8_t cmac[16];
+
+  AES_CMAC_Init(&ctx);
+  AES_CMAC_SetKeySchedule(&ctx, aKey);
+  if (aB0 != NULL) {
+    AES_CMAC_Update(&ctx, aB0, 16);
+  }
+  AES_CMAC_Update(&ctx, aMsg, aLen);
+  AES_CMAC_Final(cmac, &ctx);
+  memcpy(aMic, cmac, 4);
+}
+
+static void PrepareB0(uint8_t *aB0, uint8_t aDir, uint32_t aDevAddr, uint32_t aFCnt, uint8_t aLen) {
+  memset(aB0, 0, 16);
+  aB0[0] = 0x49;
+  aB0[5] = aDir;
+  PutU32(&aB0[6], aDevAddr);
+  PutU32(&aB0[10], aFCnt);
+  aB0[15] = aLen;
+}
+
+// FRMPayload encryption, same operation both ways
+static void CryptPayload(const aes_context *aKey, uint8_t aDir, uint32_t aDevAddr, uint32_t aFCnt, uint8_t *aData,
+                         uint8_t aLen) {
+  uint8_t a_block[16];
+  uint8_t s_block[16];
+
+  memset(a_block, 0, sizeof(a_block));
+  a_block[0] = 0x01;
+  a_block[5] = aDir;
+  PutU32(&a_block[6], aDevAddr);
+  PutU32(&a_block[10], aFCnt);
+  for (uint8_t i = 0; i < aLen; i += 16) {
+    a_block[15] = (uint8_t)(i / 16 + 1);
+    laes_encrypt(a_block, s_block, aKey);
+    for (uint8_t j = 0; (j < 16) && (i + j < aLen); j++) {
+      aData[i + j] ^= s_block[j];
+    }
+  }
+}
+
+static void DeriveSessionKey(uint8_t aType, uint32_t aJoinNonce, uint16_t aDevNonce, uint8_t *aKey) {
+  uint8_t block[16];
+
+  memset(block, 0, sizeof(block));
+  block[0] = aType;
+  block[1] = (uint8_t)aJoinNonce;
+  block[2] = (uint8_t)(aJoinNonce >> 8);
+  block[3] = (uint8_t)(aJoinNonce >> 16);
+  block[4] = (uint8_t)gNetId;
+  block[5] = (uint8_t)(gNetId >> 8);
+  block[6] = (uint8_t)(gNetId >> 16);
+  block[7] = (uint8_t)aDevNonce;
+  block[8] = (uint8_t)(aDevNonce >> 8);
+  laes_encrypt(block, aKey, &gNwkKey);
+}
+
+//==========================================================================
+// Downlinks, sent in RX1 on the channel and SF of the uplink
+//==========================================================================
+static void SendDownlink(const VirtualRadioFrame_t *aUplink, uint64_t aDelayUs, const uint8_t *aData, uint8_t aSize) {
+  VirtualRadioFrame_t frame;
+
+  memset(&frame, 0, sizeof(frame));
+  frame.chip = aUplink->chip;
+  frame.frequency = aUplink->frequency;
+  frame.sf = aUplink->sf;
+  frame.bandwidthHz = aUplink->bandwidthHz;
+  frame.coderate = 1;
+  frame.preambleLen = 8;
+  frame.power = 14;
+  frame.startUs = aUplink->endUs + aDelayUs;
+  frame.size = aSize;
+  memcpy(frame.data, aData, aSize);
+  if (VirtualRadioScheduleDownlink(&frame) == 0) {
+    gNsStats.downlinks++;
+  }
+}
+
+static void HandleJoinRequest(NsNetwork_t *aNet, const VirtualRadioFrame_t *aFrame) {
+  NsSession_t *session = &aNet->session;
+  uint8_t mic[4];
+  uint8_t msg[17];
+  uint8_t out[17];
+
+  gNsStats.joinRequests++;
+  ComputeMic(&gNwkKey, NULL, aFrame->data, JOIN_REQUEST_SIZE - 4, mic);
+  if (memcmp(mic, &aFrame->data[JOIN_REQUEST_SIZE - 4], 4) != 0) {
+    gNsStats.micErrors++;
+    return;
+  }
+  uint16_t dev_nonce = (uint16_t)(aFrame->data[17] | (aFrame->data[18] << 8));
+
+  // MHDR | JoinNonce | NetID | DevAddr | DLSettings | RxDelay | MIC
+  uint32_t join_nonce = session->joinNonce++;
+  msg[0] = MTYPE_JOIN_ACCEPT << 5;
+  msg[1] = (uint8_t)join_nonce;
+  msg[2] = (uint8_t)(join_nonce >> 8);
+  msg[3] = (uint8_t)(join_nonce >> 16);
+  msg[4] = (uint8_t)gNetId;
+  msg[5] = (uint8_t)(gNetId >> 8);
+  msg[6] = (uint8_t)(gNetId >> 16);
+  PutU32(&msg[7], gAssignDevAddr);
+  msg[11] = 0x00;  // LoRaWAN 1.0.x, RX1DROffset 0, RX2 default
+  msg[12] = RX1_DELAY_S;
+  ComputeMic(&gNwkKey, NULL, msg, 13, &msg[13]);
+
+  // The device encrypts to decrypt
+  out[0] = msg[0];
+  aes_decrypt(&msg[1], &out[1], &gNwkKey);
+
+  session->joined = true;
+  session->devAddr = gAssignDevAddr;
+  session->fCntUp = 0;
+  session->fCntDown = 0;
+  DeriveSessionKey(0x01, join_nonce, dev_nonce, session->nwkSKey);
+  DeriveSessionKey(0x02, join_nonce, dev_nonce, session->appSKey);
+  lora_aes_set_key(session->nwkSKey, 16, &aNet->nwkSKey);
+  lora_aes_set_key(session->appSKey, 16, &aNet->appSKey);
+
+  gNsStats.joinAccepts++;
+  SendDownlink(aFrame, JOIN_ACCEPT_DELAY_US, out, sizeof(out));
+}
+
+static void SendDataDownlink(NsNetwork_t *aNet, const VirtualRadioFrame_t *aUplink, bool aAck) {
+  NsSession_t *session = &aNet->session;
+  uint8_t msg[VIRTUAL_RADIO_MAX_FRAME];
+  uint8_t b0[16];
+  uint8_t len = 0;
+
+  msg[len++] = MTYPE_UNCONFIRMED_DOWN << 5;
+  PutU32(&msg[len], session->devAddr);
+  len += 4;
+  msg[len++] = aAck ? FCTRL_ACK : 0;
+  msg[len++] = (uint8_t)session->fCntDown;
+  msg[len++] = (uint8_t)(session->fCntDown >> 8);
+  if (gDownlinkPending) {
+    msg[len++] = gDownlinkPort;
+    memcpy(&msg[len], gDownlinkData, gDownlinkSize);
+    CryptPayload((gDownlinkPort == 0) ? &aNet->nwkSKey : &aNet->appSKey, DIR_DOWNLINK, session->devAddr,
+                 session->fCntDown, &msg[len], gDownlinkSize);
+    len += gDownlinkSize;
+    gDownlinkPending = false;
+  }
+  PrepareB0(b0, DIR_DOWNLINK, session->devAddr, session->fCntDown, len);
+  ComputeMic(&aNet->nwkSKey, b0, msg, len, &msg[len]);
+  len += 4;
+
+  session->fCntDown++;
+  if (aAck) {
+    gNsStats.acks++;
+  }
+  SendDownlink(aUplink, (uint64_t)RX1_DELAY_S * 1000000, msg, len);
+}
+
+//==========================================================================
+// Uplink from the virtual radio
+//==========================================================================
+static bool ParseDataUplink(NsNetwork_t *aNet, const VirtualRadioFrame_t *aFrame, VirtualNsUplink_t *aUplink) {
+  NsSession_t *session = &aNet->session;
+  const uint8_t *data = aFrame->data;
+  uint8_t b0[16];
+  uint8_t mic[4];
+
+  if ((!session->joined) || (aFrame->size < DATA_MIN_SIZE) || (GetU32(&data[1]) != session->devAddr)) {
+    return false;
+  }
+
+  // 32-bit counter from the 16 LSB
+  uint16_t fcnt16 = (uint16_t)(data[6] | (data[7] << 8));
+  uint32_t fcnt = (session->fCntUp & 0xffff0000) | fcnt16;
+  if (fcnt < session->fCntUp) {
+    fcnt += 0x10000;
+  }
+
+  uint8_t fopts_len = data[5] & 0x0f;
+  uint8_t mac_len = aFrame->size - 4;
+  PrepareB0(b0, DIR_UPLINK, session->devAddr, fcnt, mac_len);
+  ComputeMic(&aNet->nwkSKey, b0, data, mac_len, mic);
+
+  aUplink->confirmed = ((data[0] >> 5) == MTYPE_CONFIRMED_UP);
+  aUplink->micValid = (memcmp(mic, &data[mac_len], 4) == 0);
+  aUplink->fCnt = fcnt;
+  uint8_t index = 8 + fopts_len;
+  if (index < mac_len) {
+    aUplink->fPort = data[index];
+    aUplink->payloadSize = mac_len - index - 1;
+    memcpy(aUplink->payload, &data[index + 1], aUplink->payloadSize);
+    CryptPayload((aUplink->fPort == 0) ? &aNet->nwkSKey : &aNet->appSKey, DIR_UPLINK, session->devAddr, fcnt,
+                 aUplink->payload, aUplink->payloadSize);
+  }
+  return true;
+}
+
+static void OnUplink(const VirtualRadioFrame_t *aFrame, void *aArg) {
+  VirtualNsUplink_t uplink;
+
+  memset(&uplink, 0, sizeof(uplink));
+  uplink.frame = aFrame;
+
+  // Separate networks, a session on each band
+  NsNetwork_t *net = &gNetworks[(aFrame->chip == RADIO_CHIP_SX1280) ? 1 : 0];
+
+  pthread_mutex_lock(&gNsLock);
+  uint8_t mtype = aFrame->data[0] >> 5;
+  if ((mtype == MTYPE_JOIN_REQUEST) && (aFrame->size == JOIN_REQUEST_SIZE)) {
+    uplink.isJoin = true;
+    uplink.micValid = true;
+  } else if (((mtype == MTYPE_UNCONFIRMED_UP) || (mtype == MTYPE_CONFIRMED_UP)) && (ParseDataUplink(net, aFrame, &uplink))) {
+    // Data uplink of the device
+  } else {
+    pthread_mutex_unlock(&gNsLock);
+    return;
+  }
+
+  VirtualNsAction_t action = (gScript != NULL) ? gScript(&uplink, gScriptArg) : VNS_ACTION_DEFAULT;
+  if (action == VNS_ACTION_DROP) {
+    gNsStats.dropped++;
+  } else if (uplink.isJoin) {
+    if (action == VNS_ACTION_DEFAULT) {
+      HandleJoinRequest(net, aFrame);
+    }
+  } else if (!uplink.micValid) {
+    gNsStats.micErrors++;
+  } else {
+    gNsStats.uplinks++;
+    net->session.fCntUp = uplink.fCnt;
+    bool adr_ack_req = (aFrame->data[5] & FCTRL_ADR_ACK_REQ) != 0;
+    if ((action == VNS_ACTION_DEFAULT) && ((uplink.confirmed) || (gDownlinkPending) || (adr_ack_req))) {
+      SendDataDownlink(net, aFrame, uplink.confirmed);
+    }
+  }
+  pthread_mutex_unlock(&gNsLock);
+}
+
+//==========================================================================
+//==========================================================================
+void VirtualNsInit(const uint8_t *aNwkKey, uint32_t aDevAddr, uint32_t aNetId) {
+  pthread_mutex_lock(&gNsLock);
+  lora_aes_set_key(aNwkKey, 16, &gNwkKey);
+  gAssignDevAddr = aDevAddr;
+  gNetId = aNetId;
+  memset(gNetworks, 0, sizeof(gNetworks));
+  for (uint8_t i = 0; i < NS_NETWORK_COUNT; i++) {
+    gNetworks[i].session.joinNonce = 1;
+  }
+  gDownlinkPending = false;
+  memset(&gNsStats, 0, sizeof(gNsStats));
+  pthread_mutex_unlock(&gNsLock);
+
+  VirtualRadioSetUplinkHandler(OnUplink, NULL);
+}
+
+void VirtualNsSetScript(VirtualNsScript_t aScript, void *aArg) {
+  pthread_mutex_lock(&gNsLock);
+  gScript = aScript;
+  gScriptArg = aArg;
+  pthread_mutex_unlock(&gNsLock);
+}
+
+// Sent with the reply to the next uplink
+int8_t VirtualNsQueueDownlink(uint8_t aPort, const uint8_t *aData, uint8_t aLen) {
+  if (aLen > VIRTUAL_RADIO_MAX_FRAME - 13) return -1;
+
+  pthread_mutex_lock(&gNsLock);
+  gDownlinkPort = aPort;
+  gDownlinkSize = aLen;
+  memcpy(gDownlinkData, aData, aLen);
+  gDownlinkPending = true;
+  pthread_mutex_unlock(&gNsLock);
+  return 0;
+}
+
+//==========================================================================
+// Session in NVS, so that a device restored from NVS keeps its link
+//==========================================================================
+int8_t VirtualNsSaveSession(void) {
+  nvs_handle_t handle;
+
+  if (nvs_open(NS_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) return -1;
+  pthread_mutex_lock(&gNsLock);
+  NsSession_t sessions[NS_NETWORK_COUNT];
+  for (uint8_t i = 0; i < NS_NETWORK_COUNT; i++) {
+    sessions[i] = gNetworks[i].session;
+  }
+  esp_err_t esp_ret = nvs_set_blob(handle, NS_NVS_KEY, sessions, sizeof(sessions));
+  pthread_mutex_unlock(&gNsLock);
+  if (esp_ret == ESP_OK) {
+    esp_ret = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return (esp_ret == ESP_OK) ? 0 : -1;
+}
+
+int8_t VirtualNsRestoreSession(void) {
+  nvs_handle_t handle;
+  NsSession_t sessions[NS_NETWORK_COUNT];
+  size_t length = sizeof(sessions);
+
+  if (nvs_open(NS_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return -1;
+  esp_err_t esp_ret = nvs_get_blob(handle, NS_NVS_KEY, sessions, &length);
+  nvs_close(handle);
+  if ((esp_ret != ESP_OK) || (length != sizeof(sessions))) return -1;
+
+  pthread_mutex_lock(&gNsLock);
+  for (uint8_t i = 0; i < NS_NETWORK_COUNT; i++) {
+    NsNetwork_t *net = &gNetworks[i];
+    net->session = sessions[i];
+    lora_aes_set_key(net->session.nwkSKey, 16, &net->nwkSKey);
+    lora_aes_set_key(net->session.appSKey, 16, &net->appSKey);
+  }
+  pthread_mutex_unlock(&gNsLock);
+  return 0;
+}
+
+void VirtualNsGetStats(VirtualNsStats_t *aStats) {
+  pthread_mutex_lock(&gNsLock);
+  memcpy(aStats, &gNsStats, sizeof(VirtualNsStats_t));
+  pthread_mutex_unlock(&gNsLock);
+}
@@ -0,0 +1,66 @@
+//==========================================================================
+// Network server stub for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Answers a single LoRaWAN 1.0.x device on the virtual radio: accepts
+// joins, checks the uplink MIC, ACKs confirmed uplinks and sends queued
+// application downlinks in RX1. A script callback can drop uplinks or
+// suppress replies to test retries and link loss. The SX126x and the
+// SX1280 frames go to separate networks, each with its own session.
+//==========================================================================
+#ifndef INC_VIRTUAL_NS_H
+#define INC_VIRTUAL_NS_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "virtual-radio.h"
+
+//==========================================================================
+//==========================================================================
+typedef enum {
+  VNS_ACTION_DEFAULT = 0,  // Reply as a network server would
+  VNS_ACTION_DROP,         // Uplink is lost on the air
+  VNS_ACTION_NO_REPLY,     // Uplink received, the downlink is lost
+} VirtualNsAction_t;
+
+typedef struct {
+  const VirtualRadioFrame_t *frame;
+  bool isJoin;
+  bool confirmed;
+  bool micValid;
+  uint32_t fCnt;
+  uint8_t fPort;
+  uint8_t payloadSize;
+  uint8_t payload[VIRTUAL_RADIO_MAX_FRAME];  // Decrypted
+} VirtualNsUplink_t;
+
+typedef VirtualNsAction_t (*VirtualNsScript_t)(const VirtualNsUplink_t *aUplink, void *aArg);
+
+typedef struct {
+  uint32_t joinRequests;
+  uint32_t joinAccepts;
+  uint32_t uplinks;
+  uint32_t micErrors;
+  uint32_t dropped;
+  uint32_t downlinks;
+  uint32_t acks;
+} VirtualNsStats_t;
+
+//==========================================================================
+//==========================================================================
+void VirtualNsInit(const uint8_t *aNwkKey, uint32_t aDevAddr, uint32_t aNetId);
+void VirtualNsSetScript(VirtualNsScript_t aScript, void *aArg);
+int8_t VirtualNsQueueDownlink(uint8_t aPort, const uint8_t *aData, uint8_t aLen);
+void VirtualNsGetStats(VirtualNsStats_t *aStats);
+
+// Keep the session across runs when the NVS is saved to a file
+int8_t VirtualNsSaveSession(void);
+int8_t VirtualNsRestoreSession(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_VIRTUAL_NS_H
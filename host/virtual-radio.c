@@ -0,0 +1,582 @@
+//==========================================================================
+// Virtual radio for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "virtual-radio.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_random.h"
+#include "esp_timer.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define VIRTUAL_CHIP_COUNT 2
+#define AIR_MAX_DOWNLINKS 8
+#define TIME_FOREVER UINT64_MAX
+
+// Preamble symbols the receiver needs to lock
+#define RX_MIN_PREAMBLE_SYMBOLS 4
+
+#define VIRTUAL_IRQ_TX_DONE 0x01
+#define VIRTUAL_IRQ_RX_DONE 0x02
+#define VIRTUAL_IRQ_RX_TIMEOUT 0x04
+#define VIRTUAL_IRQ_CAD_DONE 0x08
+
+typedef enum {
+  OP_NONE = 0,
+  OP_TX,
+  OP_RX,
+} VirtualOp_t;
+
+typedef struct {
+  RadioChip_t chip;
+  RadioEvents_t *events;
+  RadioState_t state;
+  RadioModems_t modem;
+  uint32_t frequency;
+  bool publicNetwork;
+  uint8_t maxPayloadLen;
+
+  // TX config
+  int8_t txPower;
+  uint8_t txSf;
+  uint32_t txBandwidthHz;
+  uint32_t txBitrate;
+  uint8_t txCoderate;
+  uint16_t txPreambleLen;
+  bool txFixLen;
+  bool txCrcOn;
+
+  // RX config
+  uint8_t rxSf;
+  uint32_t rxBandwidthHz;
+  uint16_t rxPreambleLen;
+  uint16_t rxSymbTimeout;
+  bool rxContinuous;
+
+  // Operation in progress
+  esp_timer_handle_t timer;
+  VirtualOp_t op;
+  uint64_t rxOpenUs;
+  uint64_t rxCloseUs;
+  bool rxMatched;
+  VirtualRadioFrame_t frame;  // Sending or receiving
+
+  // Quality of the downlinks received
+  int16_t linkRssi;
+  int8_t linkSnr;
+
+  // Result for IrqProcess
+  uint8_t pendingIrq;
+  uint8_t rxSize;
+  uint8_t rxData[VIRTUAL_RADIO_MAX_FRAME];
+
+  VirtualRadioStats_t stats;
+} VirtualChip_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static pthread_mutex_t gRadioLock = PTHREAD_MUTEX_INITIALIZER;
+static VirtualChip_t gChips[VIRTUAL_CHIP_COUNT] = {
+    {.chip = RADIO_CHIP_SX126X, .modem = MODEM_LORA, .maxPayloadLen = 255, .linkRssi = -60, .linkSnr = 8},
+    {.chip = RADIO_CHIP_SX1280, .modem = MODEM_LORA, .maxPayloadLen = 255, .linkRssi = -60, .linkSnr = 8},
+};
+
+static VirtualRadioFrame_t gAir[AIR_MAX_DOWNLINKS];
+static bool gAirUsed[AIR_MAX_DOWNLINKS];
+
+static VirtualRadioUplinkHandler_t gUplinkHandler;
+static void *gUplinkHandlerArg;
+
+//==========================================================================
+// Time-on-air, as of the SX126x/SX1280 datasheets
+//==========================================================================
+uint32_t VirtualRadioLoRaTimeOnAirUs(uint8_t aSf, uint32_t aBandwidthHz, uint8_t aCoderate, uint16_t aPreambleLen,
+                                     bool aFixLen, uint8_t aSize, bool aCrcOn, bool aLowDatarateOpt) {
+  if ((aSf == 0) || (aBandwidthHz == 0)) return 0;
+
+  int32_t num = 8 * aSize + (aCrcOn ? 16 : 0) - 4 * aSf + (aFixLen ? 0 : 20);
+  int32_t den;
+  uint32_t preamble_quarters;
+  if (aSf < 7) {
+    den = 4 * aSf;
+    preamble_quarters = aPreambleLen * 4 + 25;  // + 6.25 symbols
+  } else {
+    num += 8;
+    den = 4 * (aSf - (aLowDatarateOpt ? 2 : 0));
+    preamble_quarters = aPreambleLen * 4 + 17;  // + 4.25 symbols
+  }
+  if (num < 0) num = 0;
+
+  uint32_t payload_symbols = 8 + ((num + den - 1) / den) * (aCoderate + 4);
+  uint64_t quarters = preamble_quarters + payload_symbols * 4;
+  uint64_t den_us = 4ULL * aBandwidthHz;
+  return (uint32_t)(((quarters << aSf) * 1000000ULL + den_us - 1) / den_us);
+}
+
+static uint64_t SymbolTimeUs(uint8_t aSf, uint32_t aBandwidthHz) {
+  if (aBandwidthHz == 0) return 0;
+  return ((1ULL << aSf) * 1000000ULL) / aBandwidthHz;
+}
+
+static uint32_t GetBandwidthHz(RadioChip_t aChip, uint32_t aBandwidth) {
+  static const uint32_t kSx126xBandwidths[] = {125000, 250000, 500000};
+  static const uint32_t kSx1280Bandwidths[] = {203125, 406250, 812500, 1625000};
+  if (aChip == RADIO_CHIP_SX1280) {
+    return (aBandwidth < 4) ? kSx1280Bandwidths[aBandwidth] : 0;
+  }
+  return (aBandwidth < 3) ? kSx126xBandwidths[aBandwidth] : 0;
+}
+
+// SX1280 long interleaving codes map to the same symbol count
+static uint8_t GetCoderate(RadioChip_t aChip, uint8_t aCoderate) {
+  if ((aChip == RADIO_CHIP_SX1280) && (aCoderate > 4)) {
+    return (aCoderate == 7) ? 4 : (aCoderate - 4);
+  }
+  return (aCoderate == 0) ? 1 : aCoderate;
+}
+
+static bool UseLowDatarateOpt(RadioChip_t aChip, uint8_t aSf, uint32_t aBandwidthHz) {
+  if (aChip == RADIO_CHIP_SX1280) return (aSf > 10);
+  return ((aBandwidthHz == 125000) && (aSf >= 11)) || ((aBandwidthHz == 250000) && (aSf == 12));
+}
+
+static uint32_t GetFskTimeOnAirUs(uint32_t aBitrate, uint16_t aPreambleLen, uint8_t aSize, bool aCrcOn) {
+  if (aBitrate == 0) return 0;
+  // Preamble, 3 bytes sync word, length byte, payload, CRC
+  uint32_t bits = 8 * (aPreambleLen + 3 + 1 + aSize + (aCrcOn ? 2 : 0));
+  return (uint32_t)(((uint64_t)bits * 1000000ULL + aBitrate - 1) / aBitrate);
+}
+
+//==========================================================================
+// Air, downlinks waiting for a receiver. Must be called with gRadioLock.
+//==========================================================================
+static bool IsDetectable(const VirtualChip_t *aChip, const VirtualRadioFrame_t *aFrame) {
+  if ((aFrame->chip != aChip->chip) || (aFrame->frequency != aChip->frequency) || (aFrame->sf != aChip->rxSf) ||
+      (aFrame->bandwidthHz != aChip->rxBandwidthHz)) {
+    return false;
+  }
+  // Receiver must open before the preamble is over and the preamble
+  // must start before the window closes.
+  uint64_t tsym = SymbolTimeUs(aFrame->sf, aFrame->bandwidthHz);
+  uint16_t lock_symbols =
+      (aFrame->preambleLen > RX_MIN_PREAMBLE_SYMBOLS) ? (aFrame->preambleLen - RX_MIN_PREAMBLE_SYMBOLS) : 0;
+  return (aFrame->startUs + lock_symbols * tsym >= aChip->rxOpenUs) && (aFrame->startUs <= aChip->rxCloseUs);
+}
+
+static void ArmChipTimer(VirtualChip_t *aChip, uint64_t aAtUs) {
+  uint64_t now = (uint64_t)esp_timer_get_time();
+  esp_timer_stop(aChip->timer);
+  esp_timer_start_once(aChip->timer, (aAtUs > now) ? (aAtUs - now) : 0);
+}
+
+// Look for a downlink in the open RX window, else wait for the timeout
+static void ArmRx(VirtualChip_t *aChip) {
+  for (int i = 0; i < AIR_MAX_DOWNLINKS; i++) {
+    if ((gAirUsed[i]) && (IsDetectable(aChip, &gAir[i]))) {
+      memcpy(&aChip->frame, &gAir[i], sizeof(VirtualRadioFrame_t));
+      gAirUsed[i] = false;
+      aChip->rxMatched = true;
+      ArmChipTimer(aChip, aChip->frame.endUs);
+      return;
+    }
+  }
+
+  aChip->rxMatched = false;
+  if (aChip->rxCloseUs != TIME_FOREVER) {
+    ArmChipTimer(aChip, aChip->rxCloseUs);
+  } else {
+    esp_timer_stop(aChip->timer);
+  }
+}
+
+// Downlinks nobody can receive any more
+static void DropStaleDownlinks(uint64_t aNowUs) {
+  for (int i = 0; i < AIR_MAX_DOWNLINKS; i++) {
+    if ((gAirUsed[i]) && (gAir[i].endUs < aNowUs)) {
+      gAirUsed[i] = false;
+    }
+  }
+}
+
+//==========================================================================
+// Chip operations
+//==========================================================================
+static void EndRxTime(VirtualChip_t *aChip) {
+  if (aChip->op == OP_RX) {
+    aChip->stats.rxOnTimeUs += (uint64_t)esp_timer_get_time() - aChip->rxOpenUs;
+  }
+}
+
+static void ChipTimerCb(void *aArg) {
+  VirtualChip_t *chip = aArg;
+  VirtualRadioFrame_t uplink;
+  bool is_uplink = false;
+
+  pthread_mutex_lock(&gRadioLock);
+  if (chip->op == OP_TX) {
+    chip->op = OP_NONE;
+    chip->state = RF_IDLE;
+    chip->pendingIrq |= VIRTUAL_IRQ_TX_DONE;
+    memcpy(&uplink, &chip->frame, sizeof(VirtualRadioFrame_t));
+    is_uplink = true;
+  } else if (chip->op == OP_RX) {
+    EndRxTime(chip);
+    if (chip->rxMatched) {
+      chip->pendingIrq |= VIRTUAL_IRQ_RX_DONE;
+      chip->rxSize = chip->frame.size;
+      memcpy(chip->rxData, chip->frame.data, chip->frame.size);
+      chip->stats.rxDone++;
+    } else {
+      chip->pendingIrq |= VIRTUAL_IRQ_RX_TIMEOUT;
+      chip->stats.rxTimeout++;
+    }
+    if (chip->rxContinuous) {
+      // Keep listening
+      chip->rxOpenUs = (uint64_t)esp_timer_get_time();
+      ArmRx(chip);
+    } else {
+      chip->op = OP_NONE;
+      chip->state = RF_IDLE;
+    }
+  } else {
+    pthread_mutex_unlock(&gRadioLock);
+    return;
+  }
+  chip->stats.irqCount++;
+  pthread_mutex_unlock(&gRadioLock);
+
+  if ((is_uplink) && (gUplinkHandler != NULL)) {
+    gUplinkHandler(&uplink, gUplinkHandlerArg);
+  }
+  HostBoardRaiseDioIrq(chip->chip);
+}
+
+static void ChipInit(VirtualChip_t *aChip, RadioEvents_t *aEvents) {
+  pthread_mutex_lock(&gRadioLock);
+  aChip->events = aEvents;
+  if (aChip->timer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = &ChipTimerCb,
+        .arg = aChip,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "virtual_radio",
+    };
+    esp_timer_create(&timer_args, &aChip->timer);
+  }
+  aChip->op = OP_NONE;
+  aChip->state = RF_IDLE;
+  aChip->pendingIrq = 0;
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static void ChipStandby(VirtualChip_t *aChip) {
+  pthread_mutex_lock(&gRadioLock);
+  if (aChip->timer != NULL) {
+    esp_timer_stop(aChip->timer);
+  }
+  EndRxTime(aChip);
+  aChip->op = OP_NONE;
+  aChip->state = RF_IDLE;
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static void ChipSetRxConfig(VirtualChip_t *aChip, RadioModems_t aModem, uint32_t aBandwidth, uint32_t aDatarate,
+                            uint16_t aPreambleLen, uint16_t aSymbTimeout, bool aRxContinuous) {
+  pthread_mutex_lock(&gRadioLock);
+  aChip->modem = aModem;
+  aChip->rxContinuous = aRxContinuous;
+  if (aModem == MODEM_LORA) {
+    aChip->rxSf = (uint8_t)aDatarate;
+    aChip->rxBandwidthHz = GetBandwidthHz(aChip->chip, aBandwidth);
+    aChip->rxPreambleLen = aPreambleLen;
+    aChip->rxSymbTimeout = aSymbTimeout;
+  } else {
+    // Only LoRa downlinks are on the virtual air
+    aChip->rxSf = 0;
+    aChip->rxBandwidthHz = 0;
+    aChip->rxSymbTimeout = 0;
+  }
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static void ChipSetTxConfig(VirtualChip_t *aChip, RadioModems_t aModem, int8_t aPower, uint32_t aBandwidth,
+                            uint32_t aDatarate, uint8_t aCoderate, uint16_t aPreambleLen, bool aFixLen, bool aCrcOn) {
+  pthread_mutex_lock(&gRadioLock);
+  aChip->modem = aModem;
+  aChip->txPower = aPower;
+  aChip->txPreambleLen = aPreambleLen;
+  aChip->txFixLen = aFixLen;
+  aChip->txCrcOn = aCrcOn;
+  if (aModem == MODEM_LORA) {
+    aChip->txSf = (uint8_t)aDatarate;
+    aChip->txBandwidthHz = GetBandwidthHz(aChip->chip, aBandwidth);
+    aChip->txCoderate = GetCoderate(aChip->chip, aCoderate);
+    aChip->txBitrate = 0;
+  } else {
+    aChip->txSf = 0;
+    aChip->txBandwidthHz = 0;
+    aChip->txBitrate = aDatarate;
+  }
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static uint32_t ChipTimeOnAir(VirtualChip_t *aChip, RadioModems_t aModem, uint32_t aBandwidth, uint32_t aDatarate,
+                              uint8_t aCoderate, uint16_t aPreambleLen, bool aFixLen, uint8_t aPayloadLen,
+                              bool aCrcOn) {
+  uint32_t toa_us;
+  if (aModem == MODEM_LORA) {
+    uint32_t bw = GetBandwidthHz(aChip->chip, aBandwidth);
+    toa_us = VirtualRadioLoRaTimeOnAirUs((uint8_t)aDatarate, bw, GetCoderate(aChip->chip, aCoderate), aPreambleLen,
+                                         aFixLen, aPayloadLen, aCrcOn,
+                                         UseLowDatarateOpt(aChip->chip, (uint8_t)aDatarate, bw));
+  } else {
+    toa_us = GetFskTimeOnAirUs(aDatarate, aPreambleLen, aPayloadLen, aCrcOn);
+  }
+  return (toa_us + 999) / 1000;
+}
+
+static void ChipSend(VirtualChip_t *aChip, uint8_t *aBuffer, uint8_t aSize) {
+  pthread_mutex_lock(&gRadioLock);
+  uint64_t now = (uint64_t)esp_timer_get_time();
+  uint32_t toa_us;
+  if (aChip->modem == MODEM_LORA) {
+    toa_us = VirtualRadioLoRaTimeOnAirUs(aChip->txSf, aChip->txBandwidthHz, aChip->txCoderate, aChip->txPreambleLen,
+                                         aChip->txFixLen, aSize, aChip->txCrcOn,
+                                         UseLowDatarateOpt(aChip->chip, aChip->txSf, aChip->txBandwidthHz));
+  } else {
+    toa_us = GetFskTimeOnAirUs(aChip->txBitrate, aChip->txPreambleLen, aSize, aChip->txCrcOn);
+  }
+
+  EndRxTime(aChip);
+  VirtualRadioFrame_t *frame = &aChip->frame;
+  memset(frame, 0, sizeof(VirtualRadioFrame_t));
+  frame->chip = aChip->chip;
+  frame->frequency = aChip->frequency;
+  frame->sf = aChip->txSf;
+  frame->bandwidthHz = aChip->txBandwidthHz;
+  frame->coderate = aChip->txCoderate;
+  frame->preambleLen = aChip->txPreambleLen;
+  frame->power = aChip->txPower;
+  frame->startUs = now;
+  frame->endUs = now + toa_us;
+  frame->size = aSize;
+  memcpy(frame->data, aBuffer, aSize);
+
+  aChip->op = OP_TX;
+  aChip->state = RF_TX_RUNNING;
+  aChip->stats.txCount++;
+  aChip->stats.txAirTimeUs += toa_us;
+  aChip->stats.txEnergyUj += (uint64_t)(toa_us * pow(10.0, aChip->txPower / 10.0) / 1000.0 + 0.5);
+  ArmChipTimer(aChip, frame->endUs);
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static void ChipRx(VirtualChip_t *aChip, uint32_t aTimeoutMs) {
+  pthread_mutex_lock(&gRadioLock);
+  uint64_t now = (uint64_t)esp_timer_get_time();
+  DropStaleDownlinks(now);
+  EndRxTime(aChip);
+
+  aChip->op = OP_RX;
+  aChip->state = RF_RX_RUNNING;
+  aChip->rxOpenUs = now;
+  if ((aChip->rxContinuous) || ((aChip->rxSymbTimeout == 0) && (aTimeoutMs == 0))) {
+    aChip->rxCloseUs = TIME_FOREVER;
+  } else if (aChip->rxSymbTimeout > 0) {
+    aChip->rxCloseUs = now + aChip->rxSymbTimeout * SymbolTimeUs(aChip->rxSf, aChip->rxBandwidthHz);
+  } else {
+    aChip->rxCloseUs = now + (uint64_t)aTimeoutMs * 1000;
+  }
+  aChip->stats.rxWindows++;
+  ArmRx(aChip);
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+static void ChipStartCad(VirtualChip_t *aChip) {
+  pthread_mutex_lock(&gRadioLock);
+  aChip->pendingIrq |= VIRTUAL_IRQ_CAD_DONE;
+  pthread_mutex_unlock(&gRadioLock);
+  HostBoardRaiseDioIrq(aChip->chip);
+}
+
+// rxData is the chip FIFO. A reception is read into a radio RX buffer, as
+// the chip drivers do over SPI.
+static void ChipIrqProcess(VirtualChip_t *aChip) {
+  uint8_t *rx_payload = NULL;
+
+  pthread_mutex_lock(&gRadioLock);
+  uint8_t irq = aChip->pendingIrq;
+  uint8_t rx_size = aChip->rxSize;
+  int16_t rssi = aChip->linkRssi;
+  int8_t snr = aChip->linkSnr;
+  RadioEvents_t *events = aChip->events;
+  aChip->pendingIrq = 0;
+  if (irq & VIRTUAL_IRQ_RX_DONE) {
+    rx_payload = RadioRxBufferAcquire();
+    memcpy(rx_payload, aChip->rxData, rx_size);
+  }
+  pthread_mutex_unlock(&gRadioLock);
+
+  if ((irq == 0) || (events == NULL)) return;
+  if ((irq & VIRTUAL_IRQ_TX_DONE) && (events->TxDone != NULL)) {
+    events->TxDone();
+  }
+  if ((irq & VIRTUAL_IRQ_RX_DONE) && (events->RxDone != NULL)) {
+    events->RxDone(rx_payload, rx_size, rssi, snr);
+  }
+  if ((irq & VIRTUAL_IRQ_RX_TIMEOUT) && (events->RxTimeout != NULL)) {
+    events->RxTimeout();
+  }
+  if ((irq & VIRTUAL_IRQ_CAD_DONE) && (events->CadDone != NULL)) {
+    events->CadDone(false);
+  }
+}
+
+//==========================================================================
+// struct Radio_s for each chip
+//==========================================================================
+#define VIRTUAL_RADIO_FUNCTIONS(aName, aIndex)                                                                         \
+  static void aName##Init(RadioEvents_t *events) { ChipInit(&gChips[aIndex], events); }                              \
+  static RadioState_t aName##GetStatus(void) { return gChips[aIndex].state; }                                        \
+  static void aName##SetModem(RadioModems_t modem) { gChips[aIndex].modem = modem; }                                 \
+  static void aName##SetChannel(uint32_t freq) { gChips[aIndex].frequency = freq; }                                  \
+  static bool aName##IsChannelFree(uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh,                          \
+                                   uint32_t maxCarrierSenseTime) {                                                   \
+    return true;                                                                                                     \
+  }                                                                                                                  \
+  static uint32_t aName##Random(void) { return esp_random(); }                                                       \
+  static void aName##SetRxConfig(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,       \
+                                 uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,     \
+                                 uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted, \
+                                 bool rxContinuous) {                                                                \
+    ChipSetRxConfig(&gChips[aIndex], modem, bandwidth, datarate, preambleLen, symbTimeout, rxContinuous);            \
+  }                                                                                                                  \
+  static void aName##SetTxConfig(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,               \
+                                 uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, \
+                                 bool freqHopOn, uint8_t hopPeriod, bool iqInverted, uint32_t timeout) {             \
+    ChipSetTxConfig(&gChips[aIndex], modem, power, bandwidth, datarate, coderate, preambleLen, fixLen, crcOn);       \
+  }                                                                                                                  \
+  static bool aName##CheckRfFrequency(uint32_t frequency) { return true; }                                           \
+  static uint32_t aName##TimeOnAir(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,     \
+                                   uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn) {              \
+    return ChipTimeOnAir(&gChips[aIndex], modem, bandwidth, datarate, coderate, preambleLen, fixLen, payloadLen,      \
+                         crcOn);                                                                                     \
+  }                                                                                                                  \
+  static void aName##Send(uint8_t *buffer, uint8_t size) { ChipSend(&gChips[aIndex], buffer, size); }                \
+  static void aName##Sleep(void) { ChipStandby(&gChips[aIndex]); }                                                   \
+  static void aName##Standby(void) { ChipStandby(&gChips[aIndex]); }                                                 \
+  static void aName##Rx(uint32_t timeout) { ChipRx(&gChips[aIndex], timeout); }                                      \
+  static void aName##StartCad(void) { ChipStartCad(&gChips[aIndex]); }                                               \
+  static void aName##SetTxContinuousWave(uint32_t freq, int8_t power, uint16_t time) {}                              \
+  static int16_t aName##Rssi(RadioModems_t modem) { return gChips[aIndex].linkRssi; }                                \
+  static void aName##Write(uint32_t addr, uint8_t data) {}                                                           \
+  static uint8_t aName##Read(uint32_t addr) { return 0; }                                                            \
+  static void aName##WriteBuffer(uint32_t addr, uint8_t *buffer, uint8_t size) {}                                    \
+  static void aName##ReadBuffer(uint32_t addr, uint8_t *buffer, uint8_t size) { memset(buffer, 0, size); }           \
+  static void aName##SetMaxPayloadLength(RadioModems_t modem, uint8_t max) { gChips[aIndex].maxPayloadLen = max; }   \
+  static void aName##SetPublicNetwork(bool enable) { gChips[aIndex].publicNetwork = enable; }                        \
+  static uint32_t aName##GetWakeupTime(void) { return 0; }                                                           \
+  static void aName##IrqProcess(void) { ChipIrqProcess(&gChips[aIndex]); }                                           \
+  static void aName##SetRxDutyCycle(uint32_t rxTime, uint32_t sleepTime) { ChipRx(&gChips[aIndex], 0); }
+
+#define VIRTUAL_RADIO_STRUCT(aName)                                                                                \
+  {                                                                                                                \
+    .Init = aName##Init, .GetStatus = aName##GetStatus, .SetModem = aName##SetModem,                               \
+    .SetChannel = aName##SetChannel, .IsChannelFree = aName##IsChannelFree, .Random = aName##Random,               \
+    .SetRxConfig = aName##SetRxConfig, .SetTxConfig = aName##SetTxConfig,                                          \
+    .CheckRfFrequency = aName##CheckRfFrequency, .TimeOnAir = aName##TimeOnAir, .Send = aName##Send,               \
+    .Sleep = aName##Sleep, .Standby = aName##Standby, .Rx = aName##Rx, .StartCad = aName##StartCad,                \
+    .SetTxContinuousWave = aName##SetTxContinuousWave, .Rssi = aName##Rssi, .Write = aName##Write,                 \
+    .Read = aName##Read, .WriteBuffer = aName##WriteBuffer, .ReadBuffer = aName##ReadBuffer,                       \
+    .SetMaxPayloadLength = aName##SetMaxPayloadLength, .SetPublicNetwork = aName##SetPublicNetwork,                \
+    .GetWakeupTime = aName##GetWakeupTime, .IrqProcess = aName##IrqProcess, .RxBoosted = aName##Rx,                \
+    .SetRxDutyCycle = aName##SetRxDutyCycle,                                                                       \
+  }
+
+VIRTUAL_RADIO_FUNCTIONS(VirtualSx126x, 0)
+VIRTUAL_RADIO_FUNCTIONS(VirtualSx1280, 1)
+
+const struct Radio_s RadioSx126x = VIRTUAL_RADIO_STRUCT(VirtualSx126x);
+const struct Radio_s RadioSx1280 = VIRTUAL_RADIO_STRUCT(VirtualSx1280);
+
+//==========================================================================
+// HAL functions used by radio.c
+//==========================================================================
+bool SX126xIsError(void) { return false; }
+void SX126xIoInit(void) {}
+bool SX1280IsError(void) { return false; }
+void SX1280HalInit(void) {}
+
+//==========================================================================
+// Air interface
+//==========================================================================
+void VirtualRadioSetUplinkHandler(VirtualRadioUplinkHandler_t aHandler, void *aArg) {
+  pthread_mutex_lock(&gRadioLock);
+  gUplinkHandler = aHandler;
+  gUplinkHandlerArg = aArg;
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+// aFrame->startUs must be set, endUs is calculated
+int8_t VirtualRadioScheduleDownlink(const VirtualRadioFrame_t *aFrame) {
+  int8_t ret = -1;
+
+  pthread_mutex_lock(&gRadioLock);
+  for (int i = 0; i < AIR_MAX_DOWNLINKS; i++) {
+    if (!gAirUsed[i]) {
+      VirtualRadioFrame_t *frame = &gAir[i];
+      memcpy(frame, aFrame, sizeof(VirtualRadioFrame_t));
+      frame->endUs = frame->startUs + VirtualRadioLoRaTimeOnAirUs(
+                                          frame->sf, frame->bandwidthHz, frame->coderate, frame->preambleLen, false,
+                                          frame->size, false, UseLowDatarateOpt(frame->chip, frame->sf, frame->bandwidthHz));
+      gAirUsed[i] = true;
+      ret = 0;
+      break;
+    }
+  }
+
+  // A receiver may be listening already
+  for (int i = 0; (ret == 0) && (i < VIRTUAL_CHIP_COUNT); i++) {
+    VirtualChip_t *chip = &gChips[i];
+    if ((chip->op == OP_RX) && (!chip->rxMatched)) {
+      ArmRx(chip);
+    }
+  }
+  pthread_mutex_unlock(&gRadioLock);
+
+  if (ret < 0) {
+    printf("ERROR. VirtualRadioScheduleDownlink air full.\n");
+  }
+  return ret;
+}
+
+void VirtualRadioSetLinkQuality(RadioChip_t aChip, int16_t aRssi, int8_t aSnr) {
+  pthread_mutex_lock(&gRadioLock);
+  gChips[(aChip == RADIO_CHIP_SX1280) ? 1 : 0].linkRssi = aRssi;
+  gChips[(aChip == RADIO_CHIP_SX1280) ? 1 : 0].linkSnr = aSnr;
+  pthread_mutex_unlock(&gRadioLock);
+}
+
+void VirtualRadioGetStats(RadioChip_t aChip, VirtualRadioStats_t *aStats) {
+  pthread_mutex_lock(&gRadioLock);
+  memcpy(aStats, &gChips[(aChip == RADIO_CHIP_SX1280) ? 1 : 0].stats, sizeof(VirtualRadioStats_t));
+  pthread_mutex_unlock(&gRadioLock);
+}
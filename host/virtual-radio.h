@@ -0,0 +1,73 @@
+//==========================================================================
+// Virtual radio for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Provides RadioSx126x and RadioSx1280 in place of the chip drivers.
+// TX and RX take their LoRa time-on-air in virtual time. Uplinks go to
+// the handler set by VirtualRadioSetUplinkHandler(), downlinks are put on
+// the air by VirtualRadioScheduleDownlink() and received when an RX
+// window with the same frequency and SF is open at their start.
+//==========================================================================
+#ifndef INC_VIRTUAL_RADIO_H
+#define INC_VIRTUAL_RADIO_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "radio.h"
+
+//==========================================================================
+//==========================================================================
+#define VIRTUAL_RADIO_MAX_FRAME 255
+
+typedef struct {
+  RadioChip_t chip;
+  uint32_t frequency;
+  uint8_t sf;
+  uint32_t bandwidthHz;
+  uint8_t coderate;  // 1..4 for 4/5..4/8
+  uint16_t preambleLen;
+  int8_t power;
+  uint64_t startUs;  // Virtual time on air
+  uint64_t endUs;
+  uint8_t size;
+  uint8_t data[VIRTUAL_RADIO_MAX_FRAME];
+} VirtualRadioFrame_t;
+
+typedef struct {
+  uint32_t txCount;
+  uint64_t txAirTimeUs;
+  uint64_t txEnergyUj;  // Time on air x TX power
+  uint32_t rxWindows;
+  uint32_t rxDone;
+  uint32_t rxTimeout;
+  uint64_t rxOnTimeUs;
+  uint32_t irqCount;
+} VirtualRadioStats_t;
+
+// Called in the timer task at the end of each uplink
+typedef void (*VirtualRadioUplinkHandler_t)(const VirtualRadioFrame_t *aFrame, void *aArg);
+
+//==========================================================================
+//==========================================================================
+void VirtualRadioSetUplinkHandler(VirtualRadioUplinkHandler_t aHandler, void *aArg);
+int8_t VirtualRadioScheduleDownlink(const VirtualRadioFrame_t *aFrame);
+// RSSI and SNR of the downlinks received by aChip
+void VirtualRadioSetLinkQuality(RadioChip_t aChip, int16_t aRssi, int8_t aSnr);
+void VirtualRadioGetStats(RadioChip_t aChip, VirtualRadioStats_t *aStats);
+
+uint32_t VirtualRadioLoRaTimeOnAirUs(uint8_t aSf, uint32_t aBandwidthHz, uint8_t aCoderate, uint16_t aPreambleLen,
+                                     bool aFixLen, uint8_t aSize, bool aCrcOn, bool aLowDatarateOpt);
+
+// Implemented by the board, plays the DIO interrupt of aChip
+void HostBoardRaiseDioIrq(RadioChip_t aChip);
+// Implemented by the board, delays the dispatch of each DIO interrupt
+// like a busy CPU would. The edge time is taken without delay.
+void HostBoardSetDioLatencyMs(uint32_t aLatencyMs);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_VIRTUAL_RADIO_H
@@ -0,0 +1,122 @@
+//==========================================================================
+// Wakeup count check for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "wakeup-check.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_os.h"
+#include "lora_compon.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define CHECK_GROUP "Wakeup"
+#define UPLINK_INTERVAL_MS (WAKEUP_CHECK_HOUR_MS / WAKEUP_CHECK_UPLINKS)
+#define SEND_TIMEOUT_MS 60000
+#define POLL_INTERVAL_MS 100
+#define UPLINK_SIZE 12
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint32_t loraTask;
+  uint32_t dioTask;
+  uint32_t boardTimer;
+} Wakeups_t;
+
+//==========================================================================
+//==========================================================================
+static void GetWakeups(Wakeups_t *aWakeups) {
+  aWakeups->loraTask = HostOsGetTaskWakeups("LoRaTask");
+  aWakeups->dioTask = HostOsGetTaskWakeups("LoRaDioIrqTask");
+  aWakeups->boardTimer = HostOsGetTimerCallbacks("lora_timer");
+}
+
+static void GetWakeupsSince(const Wakeups_t *aStart, Wakeups_t *aWakeups) {
+  GetWakeups(aWakeups);
+  aWakeups->loraTask -= aStart->loraTask;
+  aWakeups->dioTask -= aStart->dioTask;
+  aWakeups->boardTimer -= aStart->boardTimer;
+}
+
+static void DelayUntil(uint64_t aTimeUs) {
+  uint64_t now = HostOsGetTimeUs();
+  if (aTimeUs > now) {
+    vTaskDelay(pdMS_TO_TICKS((aTimeUs - now) / 1000));
+  }
+}
+
+//==========================================================================
+// Checks
+//==========================================================================
+static int CheckIdle(void) {
+  Wakeups_t start;
+  Wakeups_t count;
+
+  GetWakeups(&start);
+  vTaskDelay(pdMS_TO_TICKS(WAKEUP_CHECK_HOUR_MS));
+  GetWakeupsSince(&start, &count);
+
+  printf("Wakeups idle per hour: LoRa task %u, DIO task %u, board timer %u (limit %u)\n", count.loraTask,
+         count.dioTask, count.boardTimer, WAKEUP_CHECK_MAX_IDLE);
+  bool ok = (count.loraTask <= WAKEUP_CHECK_MAX_IDLE) && (count.dioTask <= WAKEUP_CHECK_MAX_IDLE) &&
+            (count.boardTimer <= WAKEUP_CHECK_MAX_IDLE);
+  return HostOsCheck(CHECK_GROUP, ok, "idle");
+}
+
+static int CheckUplinks(void) {
+  const uint8_t kPayload[UPLINK_SIZE] = {0};
+  Wakeups_t start;
+  Wakeups_t count;
+  uint8_t sent = 0;
+
+  uint64_t start_us = HostOsGetTimeUs();
+  GetWakeups(&start);
+  for (uint8_t i = 0; i < WAKEUP_CHECK_UPLINKS; i++) {
+    DelayUntil(start_us + (uint64_t)i * UPLINK_INTERVAL_MS * 1000);
+    if ((!HostOsWaitFor(LoRaComponIsTxReady, SEND_TIMEOUT_MS, POLL_INTERVAL_MS)) ||
+        (LoRaComponSendData(kPayload, sizeof(kPayload)) != 0) ||
+        (!HostOsWaitFor(LoRaComponIsSendDone, SEND_TIMEOUT_MS, POLL_INTERVAL_MS))) {
+      break;
+    }
+    sent++;
+  }
+  DelayUntil(start_us + (uint64_t)WAKEUP_CHECK_HOUR_MS * 1000);
+  GetWakeupsSince(&start, &count);
+
+  printf("Wakeups per hour with %u uplinks: LoRa task %u, DIO task %u, board timer %u\n", sent, count.loraTask,
+         count.dioTask, count.boardTimer);
+  bool ok = (sent == WAKEUP_CHECK_UPLINKS);
+  ok = ok && (count.loraTask <= WAKEUP_CHECK_UPLINKS * WAKEUP_CHECK_MAX_TASK_PER_UPLINK);
+  ok = ok && (count.dioTask <= WAKEUP_CHECK_UPLINKS * WAKEUP_CHECK_MAX_TASK_PER_UPLINK);
+  ok = ok && (count.boardTimer <= WAKEUP_CHECK_UPLINKS * WAKEUP_CHECK_MAX_TIMER_PER_UPLINK);
+  return HostOsCheck(CHECK_GROUP, ok, "uplinks");
+}
+
+//==========================================================================
+//==========================================================================
+int WakeupCheckRunChecks(void) {
+  int failed = 0;
+
+  failed += CheckIdle();
+  failed += CheckUplinks();
+  printf("Wakeup check: %d failed.\n", failed);
+  return failed;
+}
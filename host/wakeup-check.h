@@ -0,0 +1,31 @@
+//==========================================================================
+// Wakeup count check for the host port
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Counts the wakeups of the LoRa task, the DIO task and the board timer
+// over one hour of virtual time, once idle and once with an uplink every
+// 10 minutes. The 10 ms polling loop woke the LoRa task 360000 times an
+// hour. Needs a started and joined component.
+//==========================================================================
+#ifndef INC_WAKEUP_CHECK_H
+#define INC_WAKEUP_CHECK_H
+
+//==========================================================================
+//==========================================================================
+#define WAKEUP_CHECK_HOUR_MS (60 * 60 * 1000)
+#define WAKEUP_CHECK_UPLINKS 6
+
+// Limits per hour idle, and per uplink
+#define WAKEUP_CHECK_MAX_IDLE 0
+#define WAKEUP_CHECK_MAX_TASK_PER_UPLINK 10
+#define WAKEUP_CHECK_MAX_TIMER_PER_UPLINK 4
+
+//==========================================================================
+//==========================================================================
+// Returns the number of failed checks
+int WakeupCheckRunChecks(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_WAKEUP_CHECK_H
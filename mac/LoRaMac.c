@@ -45,6 +45,7 @@
 #include "LoRaMacAdr.h"
 #include "LoRaMacSerializer.h"
 #include "radio.h"
+#include "radio_dio.h"
 #include "LoRaMac_debug.h"
 
 #include "LoRaMac.h"
@@ -84,6 +85,11 @@
  */
 #define ABP_JOIN_PENDING_DELAY_MS                   10
 
+/*!
+ * Maximum time-on-air of an uplink when the uplink dwell time applies
+ */
+#define UPLINK_DWELL_TIME_MS                        400
+
 /*!
  * LoRaMac internal states
  */
@@ -132,9 +138,16 @@ typedef struct sLoRaMacCtx
     */
     uint8_t AppDataSize;
     /*
-    * Buffer containing the upper layer data.
+    * Payload of the current in place uplink, NULL if the payload is copied.
     */
-    uint8_t RxPayload[LORAMAC_PHY_MAXPAYLOAD];
+    uint8_t* TxInPlacePayload;
+    /*
+    * Set when TxInPlacePayload was encrypted with the following parameters.
+    */
+    bool TxInPlaceEncrypted;
+    uint8_t TxInPlacePort;
+    uint8_t TxInPlaceSize;
+    uint32_t TxInPlaceFCnt;
     SysTime_t LastTxSysTime;
     /*
     * LoRaMac internal state
@@ -169,6 +182,11 @@ typedef struct sLoRaMacCtx
     uint32_t RxWindow1Delay;
     uint32_t RxWindow2Delay;
     /*
+    * LoRaMac reception windows delay in microseconds, used to arm the RX timers
+    */
+    uint32_t RxWindow1DelayUs;
+    uint32_t RxWindow2DelayUs;
+    /*
     * LoRaMac Rx windows configuration
     */
     RxConfigParams_t RxWindow1Config;
@@ -267,6 +285,11 @@ typedef struct sLoRaMacCtx
      * Buffer containing the MAC layer commands
      */
     uint8_t MacCommandsBuffer[LORA_MAC_COMMAND_MAX_LENGTH];
+    /*
+     * NVM groups to check even without a change notice, only tracked
+     * groups are used
+     */
+    uint16_t NvmCheckGroups;
 }LoRaMacCtx_t;
 
 /*
@@ -278,6 +301,33 @@ static LoRaMacNvmData_t Nvm;
 
 static Band_t RegionBands[REGION_NVM_MAX_NB_BANDS];
 
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+/*!
+ * Rejoin cycle timers running when a context is left
+ */
+#define CONTEXT_REJOIN0_TIMER                       0x01
+#define CONTEXT_REJOIN1_TIMER                       0x02
+#define CONTEXT_FORCE_REJOIN_TIMER                  0x04
+
+/*
+ * Context kept while another one is in use, see LoRaMacSwitchContext.
+ */
+typedef struct sLoRaMacContextSlot
+{
+    LoRaMacCtx_t MacCtx;
+    LoRaMacNvmData_t Nvm;
+    Band_t RegionBands[REGION_NVM_MAX_NB_BANDS];
+    uint8_t RejoinTimers;
+}LoRaMacContextSlot_t;
+
+static LoRaMacContextSlot_t ContextSlots[LORAMAC_NB_CONTEXTS];
+
+/*
+ * Slot of the context in MacCtx, Nvm and RegionBands.
+ */
+static uint8_t ContextId;
+#endif
+
 /*!
  * Defines the LoRaMac radio events status
  */
@@ -300,6 +350,30 @@ typedef union uLoRaMacRadioEvents
  */
 LoRaMacRadioEvents_t LoRaMacRadioEvents = { .Value = 0 };
 
+/*!
+ * Writes a radio event flag. The flags are set by the radio events on the
+ * DIO task and handled by LoRaMacProcess( ).
+ */
+#define RADIO_EVENT_WRITE( event, value )                  \
+    do                                                     \
+    {                                                      \
+        CRITICAL_SECTION_BEGIN( LORA_CRITICAL_RADIO );     \
+        LoRaMacRadioEvents.Events.event = ( value );       \
+        CRITICAL_SECTION_END( LORA_CRITICAL_RADIO );       \
+    } while( 0 )
+
+/*!
+ * Writes a MAC flag. The flags are also written by the MAC timer events,
+ * which run on the timer task.
+ */
+#define MAC_FLAG_WRITE( flag, value )                      \
+    do                                                     \
+    {                                                      \
+        CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );       \
+        MacCtx.MacFlags.Bits.flag = ( value );             \
+        CRITICAL_SECTION_END( LORA_CRITICAL_MAC );         \
+    } while( 0 )
+
 /*!
  * \brief Function to be executed on Radio Tx Done event
  */
@@ -434,9 +508,10 @@ static void ProcessMacCommands( uint8_t* payload, uint8_t macIndex, uint8_t comm
  * \param [IN] fPort       MAC payload port
  * \param [IN] fBuffer     MAC data buffer to be sent
  * \param [IN] fBufferSize MAC data buffer size
+ * \param [IN] inPlace     Build the frame in fBuffer, see McpsReqUnconfirmed_t
  * \retval status          Status of the operation.
  */
-LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuffer, uint16_t fBufferSize );
+LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuffer, uint16_t fBufferSize, bool inPlace );
 
 /*!
  * \brief LoRaMAC layer send join/rejoin request
@@ -456,9 +531,10 @@ LoRaMacStatus_t SendReJoinReq( JoinReqIdentifier_t joinReqType );
  * \param [IN] fPort       MAC payload port
  * \param [IN] fBuffer     MAC data buffer to be sent
  * \param [IN] fBufferSize MAC data buffer size
+ * \param [IN] inPlace     Build the frame in fBuffer, see McpsReqUnconfirmed_t
  * \retval status          Status of the operation.
  */
-LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize );
+LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize, bool inPlace );
 
 /*
  * \brief Schedules the frame according to the duty cycle
@@ -545,6 +621,10 @@ static bool IsReJoin0Required( void );
  */
 static void RxWindowSetup( TimerEvent_t* rxTimer, RxConfigParams_t* rxConfig );
 
+#if LORAMAC_RX_TIMING_LOG
+static void PrintRxTiming( void );
+#endif
+
 /*!
  * \brief Opens up a continuous RX C window. This is used for
  *        class c devices.
@@ -707,6 +787,12 @@ static void LoRaMacHandleRejoinEvents( void );
  */
 static void LoRaMacHandleNvm( LoRaMacNvmData_t* nvmData );
 
+/*!
+ * \brief Takes the change flag of the secure element. It has a single
+ *        flag for all contexts, the change belongs to the context in use.
+ */
+static void TakeSecureElementNvmChange( void );
+
 /*!
  * \brief This function verifies if the response timeout has been elapsed. If
  *        this is the case, the status of Nvm.MacGroup1.SrvAckRequested will be
@@ -728,8 +814,20 @@ static bool LoRaMacHandleResponseTimeout( TimerTime_t timeoutInMs, TimerTime_t s
 struct
 {
     TimerTime_t CurTime;
+    uint64_t CurTimeUs;
 }TxDoneParams;
 
+#if LORAMAC_RX_TIMING_LOG
+/*!
+ * Scheduled and actual opening time of the last RX windows, in us
+ */
+static struct
+{
+    LoRaMacRxTiming_t Timing;
+    bool Pending[2];
+}RxTimingLog;
+#endif
+
 /*!
  * Structure used to store the radio Rx event data
  */
@@ -742,47 +840,72 @@ struct
     int8_t Snr;
 }RxDoneParams;
 
+/*!
+ * \brief Time elapsed since the DIO edge of the radio event in dispatch
+ *
+ * \param [out] edgeUs        DIO edge time [us, LoRaGetTickUs]
+ * \retval      elapsed       Time since the edge [us]
+ */
+static uint32_t GetRadioEventDelayUs( uint64_t *edgeUs )
+{
+    uint64_t nowUs = LoRaGetTickUs( );
+
+    *edgeUs = RadioDioGetEdgeUs( );
+    if( *edgeUs > nowUs )
+    {
+        *edgeUs = nowUs;
+    }
+    return ( uint32_t )( nowUs - *edgeUs );
+}
+
 static void OnRadioTxDone( void )
 {
-    TxDoneParams.CurTime = TimerGetCurrentTime( );
-    MacCtx.LastTxSysTime = SysTimeGet( );
+    // The RX windows start from the DIO edge, not from the IRQ processing
+    uint64_t edgeUs;
+    uint32_t delayMs = GetRadioEventDelayUs( &edgeUs ) / 1000;
 
-    LoRaMacRadioEvents.Events.TxDone = 1;
+    TxDoneParams.CurTimeUs = edgeUs;
+    TxDoneParams.CurTime = TimerGetCurrentTime( ) - delayMs;
+    MacCtx.LastTxSysTime = SysTimeSub( SysTimeGet( ), ( SysTime_t ){ .Seconds = delayMs / 1000, .SubSeconds = delayMs % 1000 } );
+
+    RADIO_EVENT_WRITE( TxDone, 1 );
 
     OnMacProcessNotify( );
 }
 
 static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 {
-    RxDoneParams.LastRxDone = TimerGetCurrentTime( );
+    uint64_t edgeUs;
+
+    RxDoneParams.LastRxDone = TimerGetCurrentTime( ) - GetRadioEventDelayUs( &edgeUs ) / 1000;
     RxDoneParams.Payload = payload;
     RxDoneParams.Size = size;
     RxDoneParams.Rssi = rssi;
     RxDoneParams.Snr = snr;
 
-    LoRaMacRadioEvents.Events.RxDone = 1;
-    LoRaMacRadioEvents.Events.RxProcessPending = 1;
+    RADIO_EVENT_WRITE( RxDone, 1 );
+    RADIO_EVENT_WRITE( RxProcessPending, 1 );
 
     OnMacProcessNotify( );
 }
 
 static void OnRadioTxTimeout( void )
 {
-    LoRaMacRadioEvents.Events.TxTimeout = 1;
+    RADIO_EVENT_WRITE( TxTimeout, 1 );
 
     OnMacProcessNotify( );
 }
 
 static void OnRadioRxError( void )
 {
-    LoRaMacRadioEvents.Events.RxError = 1;
+    RADIO_EVENT_WRITE( RxError, 1 );
 
     OnMacProcessNotify( );
 }
 
 static void OnRadioRxTimeout( void )
 {
-    LoRaMacRadioEvents.Events.RxTimeout = 1;
+    RADIO_EVENT_WRITE( RxTimeout, 1 );
 
     OnMacProcessNotify( );
 }
@@ -810,16 +933,27 @@ static void ProcessRadioTxDone( void )
         Radio.Sleep( );
     }
 
-    // Setup timers
-    CRITICAL_SECTION_BEGIN( );
-    uint32_t offset = TimerGetCurrentTime( ) - TxDoneParams.CurTime;
-    TimerSetValue( &MacCtx.RxWindowTimer1, MacCtx.RxWindow1Delay - offset );
+    // Setup timers, with us resolution relative to the TxDone event
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_TIMER );
+    uint32_t offset = ( uint32_t )( LoRaGetTickUs( ) - TxDoneParams.CurTimeUs );
+    uint32_t rx1Delay = ( MacCtx.RxWindow1DelayUs > offset ) ? ( MacCtx.RxWindow1DelayUs - offset ) : 0;
+    uint32_t rx2Delay = ( MacCtx.RxWindow2DelayUs > offset ) ? ( MacCtx.RxWindow2DelayUs - offset ) : 0;
+    TimerSetValueUs( &MacCtx.RxWindowTimer1, rx1Delay );
     TimerStart( &MacCtx.RxWindowTimer1 );
-    TimerSetValue( &MacCtx.RxWindowTimer2, MacCtx.RxWindow2Delay - offset );
+    TimerSetValueUs( &MacCtx.RxWindowTimer2, rx2Delay );
     TimerStart( &MacCtx.RxWindowTimer2 );
-    CRITICAL_SECTION_END( );
-    LORAMAC_PRINTLINE("RxWindowTimer1=%d", MacCtx.RxWindow1Delay - offset);
-    LORAMAC_PRINTLINE("RxWindowTimer2=%d", MacCtx.RxWindow2Delay - offset);
+#if LORAMAC_RX_TIMING_LOG
+    RxTimingLog.Timing.TxDoneUs = TxDoneParams.CurTimeUs;
+    RxTimingLog.Timing.ScheduledUs[0] = TxDoneParams.CurTimeUs + MacCtx.RxWindow1DelayUs;
+    RxTimingLog.Timing.ScheduledUs[1] = TxDoneParams.CurTimeUs + MacCtx.RxWindow2DelayUs;
+    RxTimingLog.Timing.OpenedUs[0] = 0;
+    RxTimingLog.Timing.OpenedUs[1] = 0;
+    RxTimingLog.Pending[0] = false;
+    RxTimingLog.Pending[1] = false;
+#endif
+    CRITICAL_SECTION_END( LORA_CRITICAL_TIMER );
+    LORAMAC_PRINTLINE("RxWindowTimer1=%uus", rx1Delay);
+    LORAMAC_PRINTLINE("RxWindowTimer2=%uus", rx2Delay);
 
     if( MacCtx.NodeAckRequested == true )
     {
@@ -860,8 +994,8 @@ static void PrepareRxDoneAbort( void )
         OnRetransmitTimeoutTimerEvent( NULL );
     }
 
-    MacCtx.MacFlags.Bits.McpsInd = 1;
-    MacCtx.MacFlags.Bits.MacDone = 1;
+    MAC_FLAG_WRITE( McpsInd, 1 );
+    MAC_FLAG_WRITE( MacDone, 1 );
 
     UpdateRxSlotIdleState( );
 }
@@ -891,7 +1025,7 @@ static void ProcessRadioRxDone( void )
     uint8_t macCmdPayload[2] = { 0 };
     Mlme_t joinType = MLME_JOIN;
 
-    LoRaMacRadioEvents.Events.RxProcessPending = 0;
+    RADIO_EVENT_WRITE( RxProcessPending, 0 );
 
     MacCtx.McpsConfirm.AckReceived = false;
     MacCtx.McpsIndication.Rssi = rssi;
@@ -1136,8 +1270,8 @@ static void ProcessRadioRxDone( void )
             }
             macMsgData.Buffer = payload;
             macMsgData.BufSize = size;
-            macMsgData.FRMPayload = MacCtx.RxPayload;
-            macMsgData.FRMPayloadSize = LORAMAC_PHY_MAXPAYLOAD;
+            macMsgData.FRMPayload = NULL;
+            macMsgData.FRMPayloadSize = 0;
 
             if( LORAMAC_PARSER_SUCCESS != LoRaMacParserData( &macMsgData ) )
             {
@@ -1397,15 +1531,14 @@ static void ProcessRadioRxDone( void )
 
             // Provide always an indication, skip the callback to the user application,
             // in case of a confirmed downlink retransmission.
-            MacCtx.MacFlags.Bits.McpsInd = 1;
+            MAC_FLAG_WRITE( McpsInd, 1 );
 
             break;
         case FRAME_TYPE_PROPRIETARY:
             if(( LoRaMacConfirmQueueIsCmdActive( MLME_PROPRIETARY ) == true ) && (size >= (pktHeaderLen + 4)))
             {
                 // MLME Proprietary handling (MatchX)
-                memcpy1( MacCtx.RxPayload, &payload[pktHeaderLen], size - pktHeaderLen - 4 );
-                MacCtx.MlmeConfirm.ProprietaryPayload = MacCtx.RxPayload;
+                MacCtx.MlmeConfirm.ProprietaryPayload = &payload[pktHeaderLen];
                 MacCtx.MlmeConfirm.ProprietaryPayloadLen = size - pktHeaderLen - 4;
                 MacCtx.MlmeConfirm.ProprietaryRssi = rssi;
 
@@ -1424,14 +1557,12 @@ static void ProcessRadioRxDone( void )
             }
             else
             {
-                memcpy1( MacCtx.RxPayload, &payload[pktHeaderLen], size - pktHeaderLen );
-
                 MacCtx.McpsIndication.McpsIndication = MCPS_PROPRIETARY;
                 MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-                MacCtx.McpsIndication.Buffer = MacCtx.RxPayload;
+                MacCtx.McpsIndication.Buffer = &payload[pktHeaderLen];
                 MacCtx.McpsIndication.BufferSize = size - pktHeaderLen;
 
-                MacCtx.MacFlags.Bits.McpsInd = 1;
+                MAC_FLAG_WRITE( McpsInd, 1 );
             }
             break;
         default:
@@ -1456,7 +1587,7 @@ static void ProcessRadioRxDone( void )
 
     if( MacCtx.McpsIndication.RxSlot != RX_SLOT_WIN_CLASS_C )
     {
-        MacCtx.MacFlags.Bits.MacDone = 1;
+        MAC_FLAG_WRITE( MacDone, 1 );
     }
 
     UpdateRxSlotIdleState( );
@@ -1476,7 +1607,7 @@ static void ProcessRadioTxTimeout( void )
     {
         MacCtx.RetransmitTimeoutRetry = true;
     }
-    MacCtx.MacFlags.Bits.MacDone = 1;
+    MAC_FLAG_WRITE( MacDone, 1 );
 }
 
 static void HandleRadioRxErrorTimeout( LoRaMacEventInfoStatus_t rx1EventInfoStatus, LoRaMacEventInfoStatus_t rx2EventInfoStatus )
@@ -1523,7 +1654,7 @@ static void HandleRadioRxErrorTimeout( LoRaMacEventInfoStatus_t rx1EventInfoStat
             if( TimerGetElapsedTime( Nvm.MacGroup1.LastTxDoneTime ) >= MacCtx.RxWindow2Delay )
             {
                 TimerStop( &MacCtx.RxWindowTimer2 );
-                MacCtx.MacFlags.Bits.MacDone = 1;
+                MAC_FLAG_WRITE( MacDone, 1 );
             }
         }
         else
@@ -1533,7 +1664,7 @@ static void HandleRadioRxErrorTimeout( LoRaMacEventInfoStatus_t rx1EventInfoStat
                 MacCtx.McpsConfirm.Status = rx2EventInfoStatus;
             }
             LoRaMacConfirmQueueSetStatusCmn( rx2EventInfoStatus );
-            MacCtx.MacFlags.Bits.MacDone = 1;
+            MAC_FLAG_WRITE( MacDone, 1 );
         }
     }
 
@@ -1554,10 +1685,10 @@ static void LoRaMacHandleIrqEvents( void )
 {
     LoRaMacRadioEvents_t events;
 
-    CRITICAL_SECTION_BEGIN( );
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_RADIO );
     events = LoRaMacRadioEvents;
     LoRaMacRadioEvents.Value = 0;
-    CRITICAL_SECTION_END( );
+    CRITICAL_SECTION_END( LORA_CRITICAL_RADIO );
 
     if( events.Value != 0 )
     {
@@ -1620,12 +1751,12 @@ static void LoRaMacHandleRequestEvents( void )
         // Update event bits
         if( MacCtx.MacFlags.Bits.McpsReq == 1 )
         {
-            MacCtx.MacFlags.Bits.McpsReq = 0;
+            MAC_FLAG_WRITE( McpsReq, 0 );
         }
 
         if( MacCtx.MacFlags.Bits.MlmeReq == 1 )
         {
-            MacCtx.MacFlags.Bits.MlmeReq = 0;
+            MAC_FLAG_WRITE( MlmeReq, 0 );
         }
 
         // Allow requests again
@@ -1642,7 +1773,7 @@ static void LoRaMacHandleRequestEvents( void )
             LoRaMacConfirmQueueHandleCb( &MacCtx.MlmeConfirm );
             if( LoRaMacConfirmQueueGetCnt( ) > 0 )
             {
-                MacCtx.MacFlags.Bits.MlmeReq = 1;
+                MAC_FLAG_WRITE( MlmeReq, 1 );
             }
         }
 
@@ -1650,7 +1781,7 @@ static void LoRaMacHandleRequestEvents( void )
         LoRaMacClassBResumeBeaconing( );
 
         // Procedure done. Reset variables.
-        MacCtx.MacFlags.Bits.MacDone = 0;
+        MAC_FLAG_WRITE( MacDone, 0 );
     }
 }
 
@@ -1659,14 +1790,14 @@ static void LoRaMacHandleIndicationEvents( void )
     // Handle MLME indication
     if( MacCtx.MacFlags.Bits.MlmeInd == 1 )
     {
-        MacCtx.MacFlags.Bits.MlmeInd = 0;
+        MAC_FLAG_WRITE( MlmeInd, 0 );
         MacCtx.MacPrimitives->MacMlmeIndication( &MacCtx.MlmeIndication );
     }
 
     // Handle MCPS indication
     if( MacCtx.MacFlags.Bits.McpsInd == 1 )
     {
-        MacCtx.MacFlags.Bits.McpsInd = 0;
+        MAC_FLAG_WRITE( McpsInd, 0 );
         MacCtx.MacPrimitives->MacMcpsIndication( &MacCtx.McpsIndication );
     }
 }
@@ -1741,7 +1872,7 @@ static void LoRaMacHandleMcpsRequest( void )
         }
         else if( waitForRetransmission == false )
         {// Arrange further retransmission
-            MacCtx.MacFlags.Bits.MacDone = 0;
+            MAC_FLAG_WRITE( MacDone, 0 );
             // Reset the state of the AckTimeout
             MacCtx.RetransmitTimeoutRetry = false;
             // Sends the same frame again
@@ -1810,6 +1941,14 @@ static void LoRaMacCheckForRxAbort( void )
     }
 }
 
+static void TakeSecureElementNvmChange( void )
+{
+    if( SecureElementIsNvmChanged( ) == true )
+    {
+        MacCtx.NvmCheckGroups |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+    }
+}
+
 static void LoRaMacHandleNvm( LoRaMacNvmData_t* nvmData )
 {
     uint32_t crc = 0;
@@ -1847,13 +1986,19 @@ static void LoRaMacHandleNvm( LoRaMacNvmData_t* nvmData )
         notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2;
     }
 
-    // Secure Element
-    crc = LoRaCrc32( ( uint8_t* ) &nvmData->SecureElement, sizeof( nvmData->SecureElement ) -
-                                                       sizeof( nvmData->SecureElement.Crc32 ) );
-    if( crc != nvmData->SecureElement.Crc32 )
+    // Secure Element, only written through the secure element API.
+    // Skip the CRC when it reports no change.
+    TakeSecureElementNvmChange( );
+    if( ( MacCtx.NvmCheckGroups & LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) != 0 )
     {
-        nvmData->SecureElement.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+        MacCtx.NvmCheckGroups &= ~LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+        crc = LoRaCrc32( ( uint8_t* ) &nvmData->SecureElement, sizeof( nvmData->SecureElement ) -
+                                                           sizeof( nvmData->SecureElement.Crc32 ) );
+        if( crc != nvmData->SecureElement.Crc32 )
+        {
+            nvmData->SecureElement.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+        }
     }
 
     // Region
@@ -1905,6 +2050,9 @@ void LoRaMacProcess( void )
 
     LoRaMacHandleIrqEvents( );
     LoRaMacClassBProcess( );
+#if LORAMAC_RX_TIMING_LOG
+    PrintRxTiming( );
+#endif
 
     // MAC proceeded a state and is ready to check
     if( MacCtx.MacFlags.Bits.MacDone == 1 )
@@ -1925,7 +2073,7 @@ void LoRaMacProcess( void )
         }
         LoRaMacHandleRequestEvents( );
         LoRaMacEnableRequests( LORAMAC_REQUEST_HANDLING_ON );
-        MacCtx.MacFlags.Bits.NvmHandle = 1;
+        MAC_FLAG_WRITE( NvmHandle, 1 );
     }
     LoRaMacHandleIndicationEvents( );
     LoRaMacHandleRejoinEvents( );
@@ -1936,7 +2084,7 @@ void LoRaMacProcess( void )
     }
     if( MacCtx.MacFlags.Bits.NvmHandle == 1 )
     {
-        MacCtx.MacFlags.Bits.NvmHandle = 0;
+        MAC_FLAG_WRITE( NvmHandle, 0 );
         LoRaMacHandleNvm( &Nvm );
     }
 }
@@ -2703,7 +2851,7 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
     }
 }
 
-LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuffer, uint16_t fBufferSize )
+LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuffer, uint16_t fBufferSize, bool inPlace )
 {
     LoRaMacFrameCtrl_t fCtrl;
     LoRaMacStatus_t status = LORAMAC_STATUS_PARAMETER_INVALID;
@@ -2759,7 +2907,7 @@ LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuffer, uin
                                                &Nvm.MacGroup2.MacParams.ChannelsNbTrans, &adrAckCounter );
 
     // Prepare the frame
-    status = PrepareFrame( macHdr, &fCtrl, fPort, fBuffer, fBufferSize );
+    status = PrepareFrame( macHdr, &fCtrl, fPort, fBuffer, fBufferSize, inPlace );
 
     // Validate status
     if( ( status == LORAMAC_STATUS_OK ) || ( status == LORAMAC_STATUS_SKIPPED_APP_DATA ) )
@@ -2954,14 +3102,18 @@ static void ComputeRxWindowParameters( void )
                                      &MacCtx.RxWindow2Config );
 
     // Default setup, in case the device joined
-    MacCtx.RxWindow1Delay = Nvm.MacGroup2.MacParams.ReceiveDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-    MacCtx.RxWindow2Delay = Nvm.MacGroup2.MacParams.ReceiveDelay2 + MacCtx.RxWindow2Config.WindowOffset;
+    uint32_t rx1Delay = Nvm.MacGroup2.MacParams.ReceiveDelay1;
+    uint32_t rx2Delay = Nvm.MacGroup2.MacParams.ReceiveDelay2;
 
     if( MacCtx.TxMsg.Type != LORAMAC_MSG_TYPE_DATA )
     {
-        MacCtx.RxWindow1Delay = Nvm.MacGroup2.MacParams.JoinAcceptDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-        MacCtx.RxWindow2Delay = Nvm.MacGroup2.MacParams.JoinAcceptDelay2 + MacCtx.RxWindow2Config.WindowOffset;
+        rx1Delay = Nvm.MacGroup2.MacParams.JoinAcceptDelay1;
+        rx2Delay = Nvm.MacGroup2.MacParams.JoinAcceptDelay2;
     }
+    MacCtx.RxWindow1Delay = rx1Delay + MacCtx.RxWindow1Config.WindowOffset;
+    MacCtx.RxWindow2Delay = rx2Delay + MacCtx.RxWindow2Config.WindowOffset;
+    MacCtx.RxWindow1DelayUs = rx1Delay * 1000 + MacCtx.RxWindow1Config.WindowOffsetUs;
+    MacCtx.RxWindow2DelayUs = rx2Delay * 1000 + MacCtx.RxWindow2Config.WindowOffsetUs;
 }
 
 static LoRaMacStatus_t VerifyTxFrame( void )
@@ -3171,6 +3323,16 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
                 return LORAMAC_STATUS_CRYPTO_ERROR;
             }
             MacCtx.PktBufferLen = MacCtx.TxMsg.Message.Data.BufSize;
+
+            // The first transmission encrypts the payload, keep what is needed to restore it
+            if( ( MacCtx.TxInPlacePayload != NULL ) && ( MacCtx.ChannelsNbTransCounter == 0 ) &&
+                ( MacCtx.TxMsg.Message.Data.FRMPayload == MacCtx.TxInPlacePayload ) )
+            {
+                MacCtx.TxInPlaceEncrypted = true;
+                MacCtx.TxInPlacePort = MacCtx.TxMsg.Message.Data.FPort;
+                MacCtx.TxInPlaceSize = MacCtx.TxMsg.Message.Data.FRMPayloadSize;
+                MacCtx.TxInPlaceFCnt = fCntUp;
+            }
             break;
         case LORAMAC_MSG_TYPE_PROPRIETARY:
             // MLME Proprietary frame (MatchX)
@@ -3347,8 +3509,51 @@ static void RxWindowSetup( TimerEvent_t* rxTimer, RxConfigParams_t* rxConfig )
     {
         Radio.Rx( Nvm.MacGroup2.MacParams.MaxRxWindow );
         MacCtx.RxSlot = rxConfig->RxSlot;
+#if LORAMAC_RX_TIMING_LOG
+        if( rxConfig->RxSlot <= RX_SLOT_WIN_2 )
+        {
+            RxTimingLog.Timing.OpenedUs[rxConfig->RxSlot] = LoRaGetTickUs( );
+            RxTimingLog.Pending[rxConfig->RxSlot] = true;
+        }
+#endif
+    }
+}
+
+#if LORAMAC_RX_TIMING_LOG
+/*!
+ * \brief Prints scheduled vs. actual RX window opening time. Called from
+ *        LoRaMacProcess so the print does not delay the RX windows.
+ */
+static void PrintRxTiming( void )
+{
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        if( RxTimingLog.Pending[i] == true )
+        {
+            RxTimingLog.Pending[i] = false;
+#if LORAMAC_RX_TIMING_PRINT
+            printf( "RX%d timing: scheduled=%llu opened=%llu late=%dus\n", i + 1,
+                    ( unsigned long long )RxTimingLog.Timing.ScheduledUs[i],
+                    ( unsigned long long )RxTimingLog.Timing.OpenedUs[i],
+                    ( int )( RxTimingLog.Timing.OpenedUs[i] - RxTimingLog.Timing.ScheduledUs[i] ) );
+#endif
+        }
     }
 }
+#endif
+
+bool LoRaMacGetRxTiming( LoRaMacRxTiming_t* timing )
+{
+#if LORAMAC_RX_TIMING_LOG
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_TIMER );
+    *timing = RxTimingLog.Timing;
+    CRITICAL_SECTION_END( LORA_CRITICAL_TIMER );
+    return true;
+#else
+    memset1( ( uint8_t* )timing, 0, sizeof( LoRaMacRxTiming_t ) );
+    return false;
+#endif
+}
 
 static void OpenContinuousRxCWindow( void )
 {
@@ -3373,7 +3578,7 @@ static void OpenContinuousRxCWindow( void )
     }
 }
 
-LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize )
+LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize, bool inPlace )
 {
     MacCtx.PktBufferLen = 0;
     MacCtx.NodeAckRequested = false;
@@ -3385,8 +3590,22 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl
     {
         fBufferSize = 0;
     }
+    if( ( fBufferSize == 0 ) || ( macHdr->Bits.MType == FRAME_TYPE_PROPRIETARY ) )
+    {
+        inPlace = false;
+    }
 
-    memcpy1( MacCtx.AppData, ( uint8_t* ) fBuffer, fBufferSize );
+    MacCtx.TxInPlaceEncrypted = false;
+    if( inPlace == true )
+    {
+        MacCtx.TxInPlacePayload = ( uint8_t* ) fBuffer;
+    }
+    else
+    {
+        MacCtx.TxInPlacePayload = NULL;
+        memcpy1( MacCtx.AppData, ( uint8_t* ) fBuffer, fBufferSize );
+        FrameCopyCountTx( fBufferSize );
+    }
     MacCtx.AppDataSize = fBufferSize;
     MacCtx.PktBuffer[0] = macHdr->Value;
 
@@ -3404,7 +3623,7 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl
             MacCtx.TxMsg.Message.Data.FHDR.DevAddr = Nvm.MacGroup2.DevAddr;
             MacCtx.TxMsg.Message.Data.FHDR.FCtrl.Value = fCtrl->Value;
             MacCtx.TxMsg.Message.Data.FRMPayloadSize = MacCtx.AppDataSize;
-            MacCtx.TxMsg.Message.Data.FRMPayload = MacCtx.AppData;
+            MacCtx.TxMsg.Message.Data.FRMPayload = ( inPlace == true ) ? MacCtx.TxInPlacePayload : MacCtx.AppData;
 
             if( LORAMAC_CRYPTO_SUCCESS != LoRaMacCryptoGetFCntUp( &fCntUp ) )
             {
@@ -3463,6 +3682,16 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl
                 }
             }
 
+            // Build the headers in the headroom in front of an in place payload
+            if( inPlace == true )
+            {
+                uint8_t hdrSize = LORAMAC_MHDR_FIELD_SIZE + LORAMAC_FHDR_DEV_ADDR_FIELD_SIZE +
+                                  LORAMAC_FHDR_F_CTRL_FIELD_SIZE + LORAMAC_FHDR_F_CNT_FIELD_SIZE +
+                                  fCtrl->Bits.FOptsLen + LORAMAC_F_PORT_FIELD_SIZE;
+
+                MacCtx.TxMsg.Message.Data.Buffer = MacCtx.TxInPlacePayload - hdrSize;
+                MacCtx.TxMsg.Message.Data.BufSize = hdrSize + MacCtx.AppDataSize + LORAMAC_MIC_FIELD_SIZE;
+            }
             break;
         case FRAME_TYPE_PROPRIETARY:
             if( ( fBuffer != NULL ) && ( MacCtx.AppDataSize > 0 ) )
@@ -3536,8 +3765,16 @@ LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
     MacCtx.McpsConfirm.NbTrans = MacCtx.ChannelsNbTransCounter;
     MacCtx.ResponseTimeoutStartTime = 0;
 
-    // Send now
-    Radio.Send( MacCtx.PktBuffer, MacCtx.PktBufferLen );
+    // Send now, data frames may be in place in the application buffer
+    if( MacCtx.TxMsg.Type == LORAMAC_MSG_TYPE_DATA )
+    {
+        FrameCopyCountTxFrame( );
+        Radio.Send( MacCtx.TxMsg.Message.Data.Buffer, MacCtx.PktBufferLen );
+    }
+    else
+    {
+        Radio.Send( MacCtx.PktBuffer, MacCtx.PktBufferLen );
+    }
 
     return LORAMAC_STATUS_OK;
 }
@@ -3781,7 +4018,7 @@ static bool StopRetransmission( void )
             if( Nvm.MacGroup1.RekeyIndUplinksCounter == Nvm.MacGroup2.MacParams.AdrAckLimit )
             {
                 Nvm.MacGroup2.NetworkActivation = ACTIVATION_TYPE_NONE;
-                MacCtx.MacFlags.Bits.MlmeInd = 1;
+                MAC_FLAG_WRITE( MlmeInd, 1 );
                 MacCtx.MlmeIndication.MlmeIndication = MLME_REVERT_JOIN;
             }
         }
@@ -4141,6 +4378,63 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
     }
 }
 
+LoRaMacStatus_t LoRaMacQueryTxOpportunity( uint8_t size, LoRaMacTxOpportunity_t* txOpportunity )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    NextChanParams_t nextChan;
+    size_t macCmdsSize = 0;
+
+    if( txOpportunity == NULL )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+
+    // Same parameters as ScheduleTx
+    nextChan.AggrTimeOff = Nvm.MacGroup1.AggregatedTimeOff;
+    nextChan.Datarate = Nvm.MacGroup1.ChannelsDatarate;
+    nextChan.DutyCycleEnabled = Nvm.MacGroup2.DutyCycleOn;
+    nextChan.ElapsedTimeSinceStartUp = SysTimeSub( SysTimeGetMcuTime( ), Nvm.MacGroup2.InitializationTime );
+    nextChan.LastAggrTx = Nvm.MacGroup1.LastTxDoneTime;
+    nextChan.LastTxIsJoinRequest = false;
+    nextChan.Joined = true;
+
+    if( Nvm.MacGroup2.NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        nextChan.LastTxIsJoinRequest = true;
+        nextChan.Joined = false;
+        nextChan.PktLen = LORAMAC_JOIN_REQ_MSG_SIZE;
+    }
+    else
+    {
+        if( LoRaMacCommandsGetSizeSerializedCmds( &macCmdsSize ) != LORAMAC_COMMANDS_SUCCESS )
+        {
+            return LORAMAC_STATUS_MAC_COMMAD_ERROR;
+        }
+        nextChan.PktLen = LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE + size + macCmdsSize;
+    }
+
+    getPhy.Attribute = PHY_TIME_ON_AIR;
+    getPhy.Datarate = nextChan.Datarate;
+    getPhy.PktLen = nextChan.PktLen;
+    phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
+
+    txOpportunity->Datarate = nextChan.Datarate;
+    txOpportunity->TimeOnAir = phyParam.Value;
+    txOpportunity->DwellTimeLeft = TIMERTIME_T_MAX;
+    if( Nvm.MacGroup2.MacParams.UplinkDwellTime != 0 )
+    {
+        txOpportunity->DwellTimeLeft = 0;
+        if( txOpportunity->TimeOnAir < UPLINK_DWELL_TIME_MS )
+        {
+            txOpportunity->DwellTimeLeft = UPLINK_DWELL_TIME_MS - txOpportunity->TimeOnAir;
+        }
+    }
+    txOpportunity->TxDelay = RegionGetTxOpportunity( Nvm.MacGroup2.Region, &nextChan,
+                                                     txOpportunity->Bands, &txOpportunity->NbBands );
+    return LORAMAC_STATUS_OK;
+}
+
 LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
@@ -4320,6 +4614,8 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
         case MIB_NVM_CTXS:
         {
             mibGet->Param.Contexts = GetNvmData( );
+            // The caller may write through the pointer
+            MacCtx.NvmCheckGroups |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
             break;
         }
         case MIB_DEFAULT_ANTENNA_GAIN:
@@ -5150,7 +5446,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
     if( status == LORAMAC_STATUS_OK )
     {
         // Handle NVM potential changes
-        MacCtx.MacFlags.Bits.NvmHandle = 1;
+        MAC_FLAG_WRITE( NvmHandle, 1 );
     }
     return status;
 }
@@ -5207,7 +5503,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetup( McChannelParams_t *channel )
     }
 
     Nvm.MacGroup2.MulticastChannelList[channel->GroupID].ChannelParams = *channel;
-    MacCtx.MacFlags.Bits.NvmHandle = 1;
+    MAC_FLAG_WRITE( NvmHandle, 1 );
 
     if( channel->IsRemotelySetup == true )
     {
@@ -5260,7 +5556,7 @@ LoRaMacStatus_t LoRaMacMcChannelDelete( AddressIdentifier_t groupID )
     memset1( ( uint8_t* )&channel, 0, sizeof( McChannelParams_t ) );
 
     Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams = channel;
-    MacCtx.MacFlags.Bits.NvmHandle = 1;
+    MAC_FLAG_WRITE( NvmHandle, 1 );
     return LORAMAC_STATUS_OK;
 }
 
@@ -5332,7 +5628,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetupRxParams( AddressIdentifier_t groupID, McRx
     {
         // Apply parameters
         Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams.RxParams = *rxParams;
-        MacCtx.MacFlags.Bits.NvmHandle = 1;
+        MAC_FLAG_WRITE( NvmHandle, 1 );
     }
     else
     {
@@ -5353,7 +5649,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetupRxParams( AddressIdentifier_t groupID, McRx
 static void OnAbpJoinPendingTimerEvent( void *context )
 {
     MacCtx.MacState &= ~LORAMAC_ABP_JOIN_PENDING;
-    MacCtx.MacFlags.Bits.MacDone = 1;
+    MAC_FLAG_WRITE( MacDone, 1 );
     OnMacProcessNotify( );
 }
 
@@ -5407,7 +5703,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
     }
     MacCtx.MlmeConfirm.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
 
-    MacCtx.MacFlags.Bits.MlmeReq = 1;
+    MAC_FLAG_WRITE( MlmeReq, 1 );
     queueElement.Request = mlmeRequest->Type;
     queueElement.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
     queueElement.RestrictCommonReadyToHandle = false;
@@ -5481,7 +5777,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
         }
         case MLME_REJOIN_0:
         {
-            MacCtx.MacFlags.Bits.MlmeReq = 1;
+            MAC_FLAG_WRITE( MlmeReq, 1 );
             MacCtx.MlmeConfirm.MlmeRequest = mlmeRequest->Type;
 
             status = SendReJoinReq( REJOIN_REQ_0 );
@@ -5490,7 +5786,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
         }
         case MLME_REJOIN_1:
         {
-            MacCtx.MacFlags.Bits.MlmeReq = 1;
+            MAC_FLAG_WRITE( MlmeReq, 1 );
             MacCtx.MlmeConfirm.MlmeRequest = mlmeRequest->Type;
 
             status = SendReJoinReq( REJOIN_REQ_1 );
@@ -5499,7 +5795,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
         }
         case MLME_REJOIN_2:
         {
-            MacCtx.MacFlags.Bits.MlmeReq = 1;
+            MAC_FLAG_WRITE( MlmeReq, 1 );
             MacCtx.MlmeConfirm.MlmeRequest = mlmeRequest->Type;
 
             status = SendReJoinReq( REJOIN_REQ_2 );
@@ -5589,7 +5885,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
         if( LoRaMacConfirmQueueGetCnt( ) == 0 )
         {
             MacCtx.NodeAckRequested = false;
-            MacCtx.MacFlags.Bits.MlmeReq = 0;
+            MAC_FLAG_WRITE( MlmeReq, 0 );
         }
     }
     else
@@ -5615,6 +5911,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest )
     uint16_t fBufferSize;
     int8_t datarate = DR_0;
     bool readyToSend = false;
+    bool inPlace = false;
 
     if( mcpsRequest == NULL )
     {
@@ -5656,6 +5953,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest )
             fBuffer = request.Req.Unconfirmed.fBuffer;
             fBufferSize = request.Req.Unconfirmed.fBufferSize;
             datarate = request.Req.Unconfirmed.Datarate;
+            inPlace = request.Req.Unconfirmed.InPlace;
             break;
         }
         case MCPS_CONFIRMED:
@@ -5667,6 +5965,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest )
             fBuffer = request.Req.Confirmed.fBuffer;
             fBufferSize = request.Req.Confirmed.fBufferSize;
             datarate = request.Req.Confirmed.Datarate;
+            inPlace = request.Req.Confirmed.InPlace;
             break;
         }
         case MCPS_PROPRIETARY:
@@ -5722,11 +6021,11 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest )
         LoRaMacHandleResponseTimeout( REGION_COMMON_CLASS_B_C_RESP_TIMEOUT,
                                       MacCtx.ResponseTimeoutStartTime );
 
-        status = Send( &macHdr, fPort, fBuffer, fBufferSize );
+        status = Send( &macHdr, fPort, fBuffer, fBufferSize, inPlace );
         if( status == LORAMAC_STATUS_OK )
         {
             MacCtx.McpsConfirm.McpsRequest = request.Type;
-            MacCtx.MacFlags.Bits.McpsReq = 1;
+            MAC_FLAG_WRITE( McpsReq, 1 );
         }
         else
         {
@@ -5740,6 +6039,26 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest )
     return status;
 }
 
+LoRaMacStatus_t LoRaMacMcpsRestorePayload( void* fBuffer )
+{
+    if( LoRaMacIsBusy( ) == true )
+    {
+        return LORAMAC_STATUS_BUSY;
+    }
+    if( ( MacCtx.TxInPlaceEncrypted == false ) || ( MacCtx.TxInPlacePayload != fBuffer ) )
+    {
+        return LORAMAC_STATUS_OK;
+    }
+
+    if( LoRaMacCryptoRestorePayload( MacCtx.TxInPlaceFCnt, MacCtx.TxInPlacePort, Nvm.MacGroup2.DevAddr,
+                                     MacCtx.TxInPlacePayload, MacCtx.TxInPlaceSize ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    MacCtx.TxInPlaceEncrypted = false;
+    return LORAMAC_STATUS_OK;
+}
+
 static bool ConvertRejoinCycleTime( uint32_t rejoinCycleTime, uint32_t* timeInMiliSec )
 {
     // Our timer implementation do not allow longer times than 4294967295 ms
@@ -5816,7 +6135,7 @@ void LoRaMacTestSetDutyCycleOn( bool enable )
     {
         Nvm.MacGroup2.DutyCycleOn = enable;
         // Handle NVM potential changes
-        MacCtx.MacFlags.Bits.NvmHandle = 1;
+        MAC_FLAG_WRITE( NvmHandle, 1 );
     }
 }
 
@@ -5848,11 +6167,131 @@ LoRaMacStatus_t LoRaMacDeInitialization( void )
     }
 }
 
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+static uint8_t StopContextTimers( void )
+{
+    uint8_t rejoinTimers = 0;
+
+    if( TimerIsStarted( &MacCtx.Rejoin0CycleTimer ) == true )
+    {
+        rejoinTimers |= CONTEXT_REJOIN0_TIMER;
+    }
+    if( TimerIsStarted( &MacCtx.Rejoin1CycleTimer ) == true )
+    {
+        rejoinTimers |= CONTEXT_REJOIN1_TIMER;
+    }
+    if( TimerIsStarted( &MacCtx.ForceRejoinReqCycleTimer ) == true )
+    {
+        rejoinTimers |= CONTEXT_FORCE_REJOIN_TIMER;
+    }
+
+    TimerStop( &MacCtx.TxDelayedTimer );
+    TimerStop( &MacCtx.RxWindowTimer1 );
+    TimerStop( &MacCtx.RxWindowTimer2 );
+    TimerStop( &MacCtx.RetransmitTimeoutTimer );
+    TimerStop( &MacCtx.Rejoin0CycleTimer );
+    TimerStop( &MacCtx.Rejoin1CycleTimer );
+    TimerStop( &MacCtx.ForceRejoinReqCycleTimer );
+    TimerStop( &MacCtx.AbpJoinPendingTimer );
+    return rejoinTimers;
+}
+
+static void StartContextTimers( uint8_t rejoinTimers )
+{
+    // Started with the last value set, a new cycle begins
+    if( ( rejoinTimers & CONTEXT_REJOIN0_TIMER ) != 0 )
+    {
+        TimerStart( &MacCtx.Rejoin0CycleTimer );
+    }
+    if( ( rejoinTimers & CONTEXT_REJOIN1_TIMER ) != 0 )
+    {
+        TimerStart( &MacCtx.Rejoin1CycleTimer );
+    }
+    if( ( rejoinTimers & CONTEXT_FORCE_REJOIN_TIMER ) != 0 )
+    {
+        TimerStart( &MacCtx.ForceRejoinReqCycleTimer );
+    }
+}
+#endif
+
+LoRaMacStatus_t LoRaMacSwitchContext( uint8_t id )
+{
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+    LoRaMacContextSlot_t* slot;
+
+    if( id >= LORAMAC_NB_CONTEXTS )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    if( id == ContextId )
+    {
+        return LORAMAC_STATUS_OK;
+    }
+
+    slot = &ContextSlots[ContextId];
+    slot->RejoinTimers = 0;
+
+    // Left with the context, not checked in the next one
+    TakeSecureElementNvmChange( );
+
+    // A context never initialized has nothing running
+    if( MacCtx.MacPrimitives != NULL )
+    {
+        if( LoRaMacStop( ) != LORAMAC_STATUS_OK )
+        {
+            return LORAMAC_STATUS_BUSY;
+        }
+        // Timers are queued by address, none may run while copied
+        slot->RejoinTimers = StopContextTimers( );
+        Radio.Sleep( );
+    }
+
+    // Pointers into MacCtx and Nvm stay valid, the contexts are copied
+    // back to the same place
+    memcpy1( ( uint8_t* )&slot->MacCtx, ( uint8_t* )&MacCtx, sizeof( LoRaMacCtx_t ) );
+    memcpy1( ( uint8_t* )&slot->Nvm, ( uint8_t* )&Nvm, sizeof( LoRaMacNvmData_t ) );
+    memcpy1( ( uint8_t* )slot->RegionBands, ( uint8_t* )RegionBands, sizeof( RegionBands ) );
+
+    slot = &ContextSlots[id];
+    memcpy1( ( uint8_t* )&MacCtx, ( uint8_t* )&slot->MacCtx, sizeof( LoRaMacCtx_t ) );
+    memcpy1( ( uint8_t* )&Nvm, ( uint8_t* )&slot->Nvm, sizeof( LoRaMacNvmData_t ) );
+    memcpy1( ( uint8_t* )RegionBands, ( uint8_t* )slot->RegionBands, sizeof( RegionBands ) );
+    LoRaMacCommandsSwitchContext( id );
+    ContextId = id;
+
+    if( MacCtx.MacPrimitives != NULL )
+    {
+        // The radio of the region was initialized with MacCtx.RadioEvents
+        if( Nvm.MacGroup2.Region == LORAMAC_REGION_ISM2400 )
+        {
+            RadioSelectChip( RADIO_CHIP_SX1280 );
+        }
+        else
+        {
+            RadioSelectChip( RADIO_CHIP_SX126X );
+        }
+        StartContextTimers( slot->RejoinTimers );
+    }
+    return LORAMAC_STATUS_OK;
+#else
+    return ( id == 0 ) ? LORAMAC_STATUS_OK : LORAMAC_STATUS_PARAMETER_INVALID;
+#endif
+}
+
+uint8_t LoRaMacGetContext( void )
+{
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+    return ContextId;
+#else
+    return 0;
+#endif
+}
+
 void LoRaMacReset( void )
 {
     // Reset state machine
     MacCtx.MacState &= ~LORAMAC_TX_RUNNING;
-    MacCtx.MacFlags.Bits.MacDone = 1;
+    MAC_FLAG_WRITE( MacDone, 1 );
 
     // Stop Timers
     TimerStop( &MacCtx.TxDelayedTimer );
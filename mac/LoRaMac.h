@@ -123,6 +123,17 @@ extern "C"
  */
 #define LORA_MAC_COMMAND_MAX_LENGTH                 128
 
+/*!
+ * Free bytes in front of an in place uplink payload, for the MHDR, the
+ * FHDR with the longest FOpts and the FPort. See McpsReqUnconfirmed_t.
+ */
+#define LORAMAC_FRAME_HEADROOM                      24
+
+/*!
+ * Free bytes behind an in place uplink payload, for the MIC
+ */
+#define LORAMAC_FRAME_TAILROOM                      4
+
 
 /*!
  * Bitmap value
@@ -882,6 +893,13 @@ typedef struct sMcpsReqUnconfirmed
      * Uplink datarate, if ADR is off
      */
     int8_t Datarate;
+    /*!
+     * fBuffer has LORAMAC_FRAME_HEADROOM free bytes in front and
+     * LORAMAC_FRAME_TAILROOM behind. The frame is built, encrypted and sent
+     * in that buffer without copying the payload. The buffer must be kept
+     * until the MCPS-Confirm, and it holds the encrypted payload after it.
+     */
+    bool InPlace;
 }McpsReqUnconfirmed_t;
 
 /*!
@@ -908,6 +926,13 @@ typedef struct sMcpsReqConfirmed
      * Uplink datarate, if ADR is off
      */
     int8_t Datarate;
+    /*!
+     * fBuffer has LORAMAC_FRAME_HEADROOM free bytes in front and
+     * LORAMAC_FRAME_TAILROOM behind. The frame is built, encrypted and sent
+     * in that buffer without copying the payload. The buffer must be kept
+     * until the MCPS-Confirm, and it holds the encrypted payload after it.
+     */
+    bool InPlace;
 }McpsReqConfirmed_t;
 
 /*!
@@ -2453,6 +2478,39 @@ typedef struct sLoRaMacTxInfo
     uint8_t CurrentPossiblePayloadSize;
 }LoRaMacTxInfo_t;
 
+/*!
+ * LoRaMAC next transmission opportunity
+ */
+typedef struct sLoRaMacTxOpportunity
+{
+    /*!
+     * Datarate of the next uplink
+     */
+    int8_t Datarate;
+    /*!
+     * Time-on-air of the next uplink. This is a value in ms
+     */
+    TimerTime_t TimeOnAir;
+    /*!
+     * Time until the uplink can be sent, 0 when it can be sent now,
+     * TIMERTIME_T_MAX when no channel can take it. This is a value in ms
+     */
+    TimerTime_t TxDelay;
+    /*!
+     * Time-on-air left under the dwell time limit, TIMERTIME_T_MAX
+     * when there is no limit. This is a value in ms
+     */
+    TimerTime_t DwellTimeLeft;
+    /*!
+     * Number of bands in Bands
+     */
+    uint8_t NbBands;
+    /*!
+     * Airtime budget of the bands with a defined channel
+     */
+    BandBudget_t Bands[REGION_NVM_MAX_NB_BANDS];
+}LoRaMacTxOpportunity_t;
+
 /*!
  * LoRaMAC Status
  */
@@ -2725,6 +2783,22 @@ void LoRaMacProcess( void );
  */
 LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo );
 
+/*!
+ * \brief   Queries the LoRaMAC when the next frame with a given application
+ *          data payload size could be sent, and the airtime budget left in
+ *          the bands. The scheduled MAC commands are taken into account, or
+ *          the join request when the device is not joined. The state of the
+ *          MAC and of the bands is not changed.
+ *
+ * \param   [IN] size - Size of application data payload to be send next
+ *
+ * \param   [OUT] txOpportunity - The structure \ref LoRaMacTxOpportunity_t
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. When the parameters are
+ *          not valid, the function returns \ref LORAMAC_STATUS_PARAMETER_INVALID.
+ */
+LoRaMacStatus_t LoRaMacQueryTxOpportunity( uint8_t size, LoRaMacTxOpportunity_t* txOpportunity );
+
 /*!
  * \brief   LoRaMAC channel add service
  *
@@ -2920,6 +2994,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest );
  * mcpsReq.Req.Unconfirmed.fPort = 1;
  * mcpsReq.Req.Unconfirmed.fBuffer = myBuffer;
  * mcpsReq.Req.Unconfirmed.fBufferSize = sizeof( myBuffer );
+ * mcpsReq.Req.Unconfirmed.InPlace = false;
  *
  * if( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_OK )
  * {
@@ -2939,6 +3014,24 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest );
  */
 LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest );
 
+/*!
+ * \brief   Restores the plain payload of an in place uplink
+ *
+ * \details An in place uplink holds the encrypted payload after it was sent.
+ *          Call this before requesting the same buffer again, e.g. when the
+ *          application retries a frame without ACK. The payload is only
+ *          restored if the last MCPS-Request encrypted fBuffer, the function
+ *          does nothing otherwise.
+ *
+ * \param   [IN] fBuffer - Payload of the last in place MCPS-Request.
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_BUSY,
+ *          \ref LORAMAC_STATUS_CRYPTO_ERROR.
+ */
+LoRaMacStatus_t LoRaMacMcpsRestorePayload( void* fBuffer );
+
 /*!
  * \brief   LoRaMAC deinitialization
  *
@@ -2951,6 +3044,34 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest );
  */
 LoRaMacStatus_t LoRaMacDeInitialization( void );
 
+/*!
+ * \brief   Switches the MAC to another context
+ *
+ * \details The MAC keeps \ref LORAMAC_NB_CONTEXTS contexts, each with its own
+ *          region, session, frame counters, bands and pending MAC commands.
+ *          The context in use is kept as it is and the MAC continues with the
+ *          context given. The MAC must be idle, it is stopped and has to be
+ *          started again with \ref LoRaMacStart. A context used for the first
+ *          time must be set up with \ref LoRaMacInitialization.
+ *
+ *          Class B and the confirm queue are not part of a context.
+ *
+ * \param   [IN] id - Context identifier, below \ref LORAMAC_NB_CONTEXTS
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_BUSY,
+ *          \ref LORAMAC_STATUS_PARAMETER_INVALID.
+ */
+LoRaMacStatus_t LoRaMacSwitchContext( uint8_t id );
+
+/*!
+ * \brief   Identifier of the context in use, see \ref LoRaMacSwitchContext
+ *
+ * \retval  Context identifier
+ */
+uint8_t LoRaMacGetContext( void );
+
 /*!
  * \brief   Resets the internal state machine.
  *
@@ -2958,6 +3079,34 @@ LoRaMacStatus_t LoRaMacDeInitialization( void );
  */
 void LoRaMacReset( void );
 
+/*!
+ * RX windows of the last uplink, see \ref LoRaMacGetRxTiming
+ */
+typedef struct sLoRaMacRxTiming
+{
+    /*!
+     * TxDone, taken at the DIO edge [us, LoRaGetTickUs]
+     */
+    uint64_t TxDoneUs;
+    /*!
+     * Time the RX1 and RX2 windows were scheduled to open [us]
+     */
+    uint64_t ScheduledUs[2];
+    /*!
+     * Time the RX1 and RX2 windows opened, 0 when not opened [us]
+     */
+    uint64_t OpenedUs[2];
+}LoRaMacRxTiming_t;
+
+/*!
+ * \brief   Gets the RX window timing of the last uplink
+ *
+ * \param   [OUT] timing - RX window timing
+ *
+ * \retval  False when built without LORAMAC_RX_TIMING_LOG
+ */
+bool LoRaMacGetRxTiming( LoRaMacRxTiming_t* timing );
+
 //
 int32_t LoRaMacQueryMacCommandsSize(void);
 
@@ -514,9 +514,10 @@ static void IndicateBeaconStatus( LoRaMacEventInfoStatus_t status )
     {
         Ctx.LoRaMacClassBParams.MlmeIndication->MlmeIndication = MLME_BEACON;
         Ctx.LoRaMacClassBParams.MlmeIndication->Status = status;
+        CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
         Ctx.LoRaMacClassBParams.LoRaMacFlags->Bits.MlmeInd = 1;
-
         Ctx.LoRaMacClassBParams.LoRaMacFlags->Bits.MacDone = 1;
+        CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
     }
     Ctx.BeaconCtx.Ctrl.ResumeBeaconing = 0;
 }
@@ -938,7 +939,9 @@ static void LoRaMacClassBProcessBeacon( void )
             {
                 Ctx.LoRaMacClassBParams.MlmeIndication->MlmeIndication = MLME_BEACON_LOST;
                 Ctx.LoRaMacClassBParams.MlmeIndication->Status = LORAMAC_EVENT_INFO_STATUS_OK;
+                CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
                 Ctx.LoRaMacClassBParams.LoRaMacFlags->Bits.MlmeInd = 1;
+                CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
             }
 
             // Stop slot timers
@@ -947,7 +950,9 @@ static void LoRaMacClassBProcessBeacon( void )
             // Initialize default state for class b
             InitClassBDefaults( );
 
+            CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
             Ctx.LoRaMacClassBParams.LoRaMacFlags->Bits.MacDone = 1;
+            CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
 
             break;
         }
@@ -1487,9 +1492,9 @@ void LoRaMacClassBHaltBeaconing( void )
             LoRaMacClassBBeaconTimerEvent( NULL );
         }
 
-        CRITICAL_SECTION_BEGIN( );
+        CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
         LoRaMacClassBEvents.Events.Beacon = 0;
-        CRITICAL_SECTION_END( );
+        CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
 
         // Halt ping slot state machine
         TimerStop( &Ctx.BeaconTimer );
@@ -1776,10 +1781,10 @@ void LoRaMacClassBStopRxSlots( void )
     TimerStop( &Ctx.PingSlotTimer );
     TimerStop( &Ctx.MulticastSlotTimer );
 
-    CRITICAL_SECTION_BEGIN( );
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
     LoRaMacClassBEvents.Events.PingSlot = 0;
     LoRaMacClassBEvents.Events.MulticastSlot = 0;
-    CRITICAL_SECTION_END( );
+    CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
 #endif // LORAMAC_CLASSB_ENABLED
 }
 
@@ -1843,10 +1848,10 @@ void LoRaMacClassBProcess( void )
 #ifdef LORAMAC_CLASSB_ENABLED
     LoRaMacClassBEvents_t events;
 
-    CRITICAL_SECTION_BEGIN( );
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_MAC );
     events = LoRaMacClassBEvents;
     LoRaMacClassBEvents.Value = 0;
-    CRITICAL_SECTION_END( );
+    CRITICAL_SECTION_END( LORA_CRITICAL_MAC );
 
     if( events.Value != 0 )
     {
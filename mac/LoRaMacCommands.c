@@ -74,6 +74,18 @@ typedef struct sLoRaMacCommandsCtx
  */
 static LoRaMacCommandsCtx_t CommandsCtx;
 
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+/*!
+ * Module contexts kept while another one is in use.
+ */
+static LoRaMacCommandsCtx_t CommandsCtxSlots[LORAMAC_NB_CONTEXTS];
+
+/*!
+ * Slot of the context in CommandsCtx.
+ */
+static uint8_t CommandsCtxId;
+#endif
+
 /* Memory management functions */
 
 /*!
@@ -319,6 +331,24 @@ LoRaMacCommandStatus_t LoRaMacCommandsInit( void )
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
+LoRaMacCommandStatus_t LoRaMacCommandsSwitchContext( uint8_t id )
+{
+#if ( LORAMAC_NB_CONTEXTS > 1 )
+    if( id >= LORAMAC_NB_CONTEXTS )
+    {
+        return LORAMAC_COMMANDS_ERROR;
+    }
+
+    // The list points into MacCommandSlots, copied back to the same place
+    memcpy1( ( uint8_t* )&CommandsCtxSlots[CommandsCtxId], ( uint8_t* )&CommandsCtx, sizeof( CommandsCtx ) );
+    memcpy1( ( uint8_t* )&CommandsCtx, ( uint8_t* )&CommandsCtxSlots[id], sizeof( CommandsCtx ) );
+    CommandsCtxId = id;
+    return LORAMAC_COMMANDS_SUCCESS;
+#else
+    return ( id == 0 ) ? LORAMAC_COMMANDS_SUCCESS : LORAMAC_COMMANDS_ERROR;
+#endif
+}
+
 LoRaMacCommandStatus_t LoRaMacCommandsAddCmd( uint8_t cid, uint8_t* payload, size_t payloadSize )
 {
     if( payload == NULL )
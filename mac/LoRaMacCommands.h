@@ -127,6 +127,16 @@ typedef void ( *LoRaMacCommandsNvmEvent )( void );
  */
 LoRaMacCommandStatus_t LoRaMacCommandsInit( void );
 
+/*!
+ * \brief Keeps the MAC commands of the current context and continues with
+ *        the ones of another context, see LoRaMacSwitchContext
+ *
+ * \param[IN]   id                 - Context identifier
+ *
+ * \retval                     - Status of the operation
+ */
+LoRaMacCommandStatus_t LoRaMacCommandsSwitchContext( uint8_t id );
+
 /*!
  * \brief Adds a new MAC command to be sent.
  *
@@ -142,9 +142,6 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
 
-    uint8_t bufferIndex = 0;
-    uint16_t ctr = 1;
-    uint8_t sBlock[16] = { 0 };
     uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
@@ -161,21 +158,15 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
     aBlock[12] = ( frameCounter >> 16 ) & 0xFF;
     aBlock[13] = ( frameCounter >> 24 ) & 0xFF;
 
-    while( size > 0 )
-    {
-        aBlock[15] = ctr & 0xFF;
-        ctr++;
-        if( SecureElementAesEncrypt( aBlock, 16, keyID, sBlock ) != SECURE_ELEMENT_SUCCESS )
-        {
-            return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
-        }
+    aBlock[15] = 1;
 
-        for( uint8_t i = 0; i < ( ( size > 16 ) ? 16 : size ); i++ )
-        {
-            buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
-        }
-        size -= 16;
-        bufferIndex += 16;
+    if( size <= 0 )
+    {
+        return LORAMAC_CRYPTO_SUCCESS;
+    }
+    if( SecureElementAesCtrCrypt( aBlock, buffer, size, keyID ) != SECURE_ELEMENT_SUCCESS )
+    {
+        return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
     }
 
     return LORAMAC_CRYPTO_SUCCESS;
@@ -1429,17 +1420,36 @@ LoRaMacCryptoStatus_t LoRaMacCryptoSecureMessage( uint32_t fCntUp, uint8_t txDr,
         }
     }
 
-    // Re-serialize message to add the MIC
-    if( LoRaMacSerializerData( macMsg ) != LORAMAC_SERIALIZER_SUCCESS )
-    {
-        return LORAMAC_CRYPTO_ERROR_SERIALIZER;
-    }
+    // Add the MIC, the rest of the message is serialized already
+    macMsg->Buffer[macMsg->BufSize - 4] = macMsg->MIC & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - 3] = ( macMsg->MIC >> 8 ) & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - 2] = ( macMsg->MIC >> 16 ) & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - 1] = ( macMsg->MIC >> 24 ) & 0xFF;
 
     CryptoNvm->FCntList.FCntUp = fCntUp;
 
     return LORAMAC_CRYPTO_SUCCESS;
 }
 
+LoRaMacCryptoStatus_t LoRaMacCryptoRestorePayload( uint32_t fCntUp, uint8_t fPort, uint32_t devAddr, uint8_t* buffer, uint16_t size )
+{
+    KeyIdentifier_t payloadDecryptionKeyID = APP_S_KEY;
+
+    if( buffer == NULL )
+    {
+        return LORAMAC_CRYPTO_ERROR_NPE;
+    }
+
+    if( fPort == 0 )
+    {
+        // Use network session key
+        payloadDecryptionKeyID = NWK_S_ENC_KEY;
+    }
+
+    // AES-CTR, encrypting the uplink again gives the plain payload
+    return PayloadEncrypt( buffer, size, payloadDecryptionKeyID, devAddr, UPLINK, fCntUp );
+}
+
 LoRaMacCryptoStatus_t LoRaMacCryptoUnsecureMessage( AddressIdentifier_t addrID, uint32_t address, FCntIdentifier_t fCntID, uint32_t fCntDown, LoRaMacMessageData_t* macMsg )
 {
     if( macMsg == 0 )
@@ -1457,12 +1467,6 @@ LoRaMacCryptoStatus_t LoRaMacCryptoUnsecureMessage( AddressIdentifier_t addrID,
     KeyIdentifier_t micComputationKeyID = S_NWK_S_INT_KEY;
     KeyAddr_t* curItem;
 
-    // Parse the message
-    if( LoRaMacParserData( macMsg ) != LORAMAC_PARSER_SUCCESS )
-    {
-        return LORAMAC_CRYPTO_ERROR_PARSER;
-    }
-
     // Determine current security context
     retval = GetKeyAddrItem( addrID, &curItem );
     if( retval != LORAMAC_CRYPTO_SUCCESS )
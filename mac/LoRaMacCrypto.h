@@ -297,14 +297,28 @@ LoRaMacCryptoStatus_t LoRaMacCryptoHandleJoinAccept( JoinReqIdentifier_t joinReq
  */
 LoRaMacCryptoStatus_t LoRaMacCryptoSecureMessage( uint32_t fCntUp, uint8_t txDr, uint8_t txCh, LoRaMacMessageData_t* macMsg );
 
+/*!
+ * Decrypts the payload of an uplink secured by LoRaMacCryptoSecureMessage,
+ * to send it again with a new frame counter.
+ *
+ * \param[IN]     fCntUp          - Uplink sequence counter used to secure the payload
+ * \param[IN]     fPort           - Port of the uplink
+ * \param[IN]     devAddr         - Device address
+ * \param[IN/OUT] buffer          - Encrypted payload
+ * \param[IN]     size            - Size of the payload
+ * \retval                        - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoRestorePayload( uint32_t fCntUp, uint8_t fPort, uint32_t devAddr, uint8_t* buffer, uint16_t size );
+
 /*!
  * Unsecures a message (decryption + integrity verification).
+ * The payload is decrypted in place.
  *
  * \param[IN]     addrID          - Address identifier
  * \param[IN]     address         - Address
  * \param[IN]     fCntID          - Frame counter identifier
  * \param[IN]     fCntDown        - Downlink sequence counter
- * \param[IN/OUT] macMsg          - Data message object
+ * \param[IN/OUT] macMsg          - Data message object, parsed by LoRaMacParserData
  * \retval                        - Status of the operation
  */
 LoRaMacCryptoStatus_t LoRaMacCryptoUnsecureMessage( AddressIdentifier_t addrID, uint32_t address, FCntIdentifier_t fCntID, uint32_t fCntDown, LoRaMacMessageData_t* macMsg );
@@ -92,13 +92,16 @@ LoRaMacParserStatus_t LoRaMacParserData( LoRaMacMessageData_t* macMsg )
     // Initialize anyway with zero.
     macMsg->FPort = 0;
     macMsg->FRMPayloadSize = 0;
+    // Empty view, a frame without FRMPayload is still decrypted
+    macMsg->FRMPayload = &macMsg->Buffer[bufItr];
 
     if( ( macMsg->BufSize - bufItr - LORAMAC_MIC_FIELD_SIZE ) > 0 )
     {
         macMsg->FPort = macMsg->Buffer[bufItr++];
 
+        // The payload is not copied, FRMPayload points into the buffer
         macMsg->FRMPayloadSize = ( macMsg->BufSize - bufItr - LORAMAC_MIC_FIELD_SIZE );
-        memcpy1( macMsg->FRMPayload, &macMsg->Buffer[bufItr], macMsg->FRMPayloadSize );
+        macMsg->FRMPayload = &macMsg->Buffer[bufItr];
         bufItr = bufItr + macMsg->FRMPayloadSize;
     }
 
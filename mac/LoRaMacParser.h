@@ -79,6 +79,7 @@ LoRaMacParserStatus_t LoRaMacParserJoinAccept( LoRaMacMessageJoinAccept_t *macMs
 
 /*!
  * Parse a serialized data message and fills the structured object.
+ * FRMPayload is set to point into the serialized message.
  *
  * \param[IN/OUT] macMsg       - Data message object
  * \retval                     - Status of the operation
@@ -219,7 +219,12 @@ LoRaMacSerializerStatus_t LoRaMacSerializerData( LoRaMacMessageData_t* macMsg )
         macMsg->Buffer[bufItr++] = macMsg->FPort;
     }
 
-    memcpy1( &macMsg->Buffer[bufItr], macMsg->FRMPayload, macMsg->FRMPayloadSize );
+    // An in place payload is at its position in the buffer already
+    if( macMsg->FRMPayload != &macMsg->Buffer[bufItr] )
+    {
+        memcpy1( &macMsg->Buffer[bufItr], macMsg->FRMPayload, macMsg->FRMPayloadSize );
+        FrameCopyCountTx( macMsg->FRMPayloadSize );
+    }
     bufItr = bufItr + macMsg->FRMPayloadSize;
 
     macMsg->Buffer[bufItr++] = macMsg->MIC & 0xFF;
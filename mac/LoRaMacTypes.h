@@ -60,6 +60,13 @@ extern "C"
  */
 #define LORAMAC_MAX_MC_CTX                          4
 
+/*!
+ * Number of independent MAC contexts, see LoRaMacSwitchContext
+ */
+#ifndef LORAMAC_NB_CONTEXTS
+#define LORAMAC_NB_CONTEXTS                         1
+#endif
+
 /*!
  * Region       | SF
  * ------------ | :-----:
@@ -1181,6 +1188,39 @@ typedef struct sBand
     bool ReadyForTransmission;
 }Band_t;
 
+/*!
+ * LoRaMAC band airtime budget, a snapshot of the band credits
+ */
+typedef struct sBandBudget
+{
+    /*!
+     * Index of the band
+     */
+    uint8_t Band;
+    /*!
+     * Duty cycle
+     */
+    uint16_t DCycle;
+    /*!
+     * Time credits available now. This is a value in ms
+     */
+    TimerTime_t TimeCredits;
+    /*!
+     * Time credits assigned at the start of the observation
+     * period. This is a value in ms
+     */
+    TimerTime_t MaxTimeCredits;
+    /*!
+     * Time until the credits are assigned again. This is a value in ms
+     */
+    TimerTime_t ObservationLeft;
+    /*!
+     * Set to true when an enabled channel of the current datarate
+     * uses the band.
+     */
+    bool Usable;
+}BandBudget_t;
+
 /*!
  * LoRaMAC channels parameters definition
  */
@@ -5,12 +5,27 @@
 
 //==========================================================================
 //==========================================================================
+#include "sdkconfig.h"
+
 #if defined(CONFIG_LORAMAC_DEBUG)
 #define LORAMAC_DEBUG 1
 #else
 #define LORAMAC_DEBUG 0
 #endif
 
+#if defined(CONFIG_LORAMAC_RX_TIMING_LOG)
+#define LORAMAC_RX_TIMING_LOG 1
+#include <stdio.h>
+#else
+#define LORAMAC_RX_TIMING_LOG 0
+#endif
+
+// A caller that reads the log through LoRaMacGetRxTiming() can turn the
+// print off
+#ifndef LORAMAC_RX_TIMING_PRINT
+#define LORAMAC_RX_TIMING_PRINT LORAMAC_RX_TIMING_LOG
+#endif
+
 #if LORAMAC_DEBUG
 #include <stdint.h>
 #include <stdio.h>
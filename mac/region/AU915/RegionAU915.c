@@ -71,7 +71,7 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+static TimerTime_t ComputeTimeOnAir( int8_t datarate, uint16_t pktLen )
 {
     int8_t phyDr = DataratesAU915[datarate];
     uint32_t bandwidth = RegionCommonGetBandwidth( datarate, BandwidthsAU915 );
@@ -79,6 +79,22 @@ static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
     return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
 }
 
+#ifdef REGION_TOA_CACHE
+/*!
+ * Time-on-air per datarate and frame length, filled on the first use
+ */
+static uint16_t TimeOnAirCache[ sizeof( DataratesAU915 ) ][ REGION_COMMON_TOA_CACHE_LEN ];
+#endif
+
+static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+#ifdef REGION_TOA_CACHE
+    return RegionCommonGetCachedTimeOnAir( TimeOnAirCache[0], sizeof( DataratesAU915 ), datarate, pktLen, ComputeTimeOnAir );
+#else
+    return ComputeTimeOnAir( datarate, pktLen );
+#endif
+}
+
 PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
 {
     PhyParam_t phyParam = { 0 };
@@ -301,6 +317,11 @@ PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.Value = RegionCommonGetBandwidth( getPhy->Datarate, BandwidthsAU915 );
             break;
         }
+        case PHY_TIME_ON_AIR:
+        {
+            phyParam.Value = GetTimeOnAir( getPhy->Datarate, getPhy->PktLen );
+            break;
+        }
         default:
         {
             break;
@@ -510,7 +531,7 @@ void RegionAU915ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
 
     tSymbolInUs = RegionCommonComputeSymbolTimeLoRa( DataratesAU915[rxConfigParams->Datarate], BandwidthsAU915[rxConfigParams->Datarate] );
 
-    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
+    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset, &rxConfigParams->WindowOffsetUs );
 }
 
 bool RegionAU915RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
@@ -892,6 +913,48 @@ LoRaMacStatus_t RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_
     return status;
 }
 
+TimerTime_t RegionAU915GetTxOpportunity( NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets )
+{
+    RegionCommonIdentifyChannelsParam_t identifyChannelsParam;
+    RegionCommonCountNbOfEnabledChannelsParams_t countChannelsParams;
+    uint16_t channelsMask[REGION_NVM_CHANNELS_MASK_SIZE];
+
+    // The channels left to hop on, refilled as the next uplink would
+    RegionCommonChanMaskCopy( channelsMask, RegionNvmGroup1->ChannelsMaskRemaining, REGION_NVM_CHANNELS_MASK_SIZE );
+    if( RegionCommonCountChannels( channelsMask, 0, 4 ) == 0 )
+    {
+        RegionCommonChanMaskCopy( channelsMask, RegionNvmGroup2->ChannelsMask, 4 );
+    }
+    if( nextChanParams->Datarate >= DR_6 )
+    {
+        if( ( channelsMask[4] & CHANNELS_MASK_500KHZ_MASK ) == 0 )
+        {
+            channelsMask[4] = RegionNvmGroup2->ChannelsMask[4];
+        }
+    }
+
+    countChannelsParams.Joined = nextChanParams->Joined;
+    countChannelsParams.Datarate = nextChanParams->Datarate;
+    countChannelsParams.ChannelsMask = channelsMask;
+    countChannelsParams.Channels = RegionNvmGroup2->Channels;
+    countChannelsParams.Bands = RegionBands;
+    countChannelsParams.MaxNbChannels = AU915_MAX_NB_CHANNELS;
+    countChannelsParams.JoinChannels = NULL;
+
+    identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
+    identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
+    identifyChannelsParam.DutyCycleEnabled = nextChanParams->DutyCycleEnabled;
+    identifyChannelsParam.MaxBands = AU915_MAX_NB_BANDS;
+
+    identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
+    identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
+    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+
+    identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
+
+    return RegionCommonGetTxOpportunity( &identifyChannelsParam, budgets, nbBudgets );
+}
+
 LoRaMacStatus_t RegionAU915ChannelAdd( ChannelAddParams_t* channelAdd )
 {
     return LORAMAC_STATUS_PARAMETER_INVALID;
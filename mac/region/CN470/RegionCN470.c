@@ -286,7 +286,7 @@ static bool VerifyRfFreq( uint32_t frequency )
     return ChannelPlanCtx.VerifyRfFreq( frequency );
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+static TimerTime_t ComputeTimeOnAir( int8_t datarate, uint16_t pktLen )
 {
     int8_t phyDr = DataratesCN470[datarate];
     uint32_t bandwidth = RegionCommonGetBandwidth( datarate, BandwidthsCN470 );
@@ -294,6 +294,22 @@ static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
     return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
 }
 
+#ifdef REGION_TOA_CACHE
+/*!
+ * Time-on-air per datarate and frame length, filled on the first use
+ */
+static uint16_t TimeOnAirCache[ sizeof( DataratesCN470 ) ][ REGION_COMMON_TOA_CACHE_LEN ];
+#endif
+
+static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+#ifdef REGION_TOA_CACHE
+    return RegionCommonGetCachedTimeOnAir( TimeOnAirCache[0], sizeof( DataratesCN470 ), datarate, pktLen, ComputeTimeOnAir );
+#else
+    return ComputeTimeOnAir( datarate, pktLen );
+#endif
+}
+
 PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
 {
     PhyParam_t phyParam = { 0 };
@@ -529,6 +545,11 @@ PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.Value = RegionCommonGetBandwidth( getPhy->Datarate, BandwidthsCN470 );
             break;
         }
+        case PHY_TIME_ON_AIR:
+        {
+            phyParam.Value = GetTimeOnAir( getPhy->Datarate, getPhy->PktLen );
+            break;
+        }
         default:
         {
             break;
@@ -715,7 +736,7 @@ void RegionCN470ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
 
     tSymbolInUs = RegionCommonComputeSymbolTimeLoRa( DataratesCN470[rxConfigParams->Datarate], BandwidthsCN470[rxConfigParams->Datarate] );
 
-    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
+    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset, &rxConfigParams->WindowOffsetUs );
 }
 
 bool RegionCN470RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
@@ -1013,6 +1034,54 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
     return status;
 }
 
+TimerTime_t RegionCN470GetTxOpportunity( NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets )
+{
+    RegionCommonIdentifyChannelsParam_t identifyChannelsParam;
+    RegionCommonCountNbOfEnabledChannelsParams_t countChannelsParams;
+    uint16_t channelsMask[REGION_NVM_CHANNELS_MASK_SIZE];
+    uint16_t joinChannelsMask[2] = CN470_JOIN_CHANNELS;
+
+    // The channels left to hop on, refilled as the next uplink would
+    RegionCommonChanMaskCopy( channelsMask, RegionNvmGroup1->ChannelsMaskRemaining, REGION_NVM_CHANNELS_MASK_SIZE );
+    if( RegionCommonCountChannels( channelsMask, 0, ChannelPlanCtx.ChannelsMaskSize ) == 0 )
+    {
+        for( uint8_t i = 0; i < ChannelPlanCtx.ChannelsMaskSize; i++ )
+        {
+            channelsMask[i] = 0xFFFF;
+        }
+    }
+
+    countChannelsParams.Joined = nextChanParams->Joined;
+    countChannelsParams.Datarate = nextChanParams->Datarate;
+    countChannelsParams.ChannelsMask = channelsMask;
+    countChannelsParams.Channels = RegionNvmGroup2->Channels;
+    countChannelsParams.Bands = RegionBands;
+    countChannelsParams.MaxNbChannels = CN470_MAX_NB_CHANNELS;
+    countChannelsParams.JoinChannels = NULL;
+
+    // Not joined, the common join channel plan applies
+    if( countChannelsParams.Joined == false )
+    {
+        countChannelsParams.ChannelsMask = joinChannelsMask;
+        countChannelsParams.Channels = CommonJoinChannels;
+        countChannelsParams.MaxNbChannels = CN470_COMMON_JOIN_CHANNELS_SIZE;
+        countChannelsParams.JoinChannels = joinChannelsMask;
+    }
+
+    identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
+    identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
+    identifyChannelsParam.DutyCycleEnabled = nextChanParams->DutyCycleEnabled;
+    identifyChannelsParam.MaxBands = CN470_MAX_NB_BANDS;
+
+    identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
+    identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
+    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+
+    identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
+
+    return RegionCommonGetTxOpportunity( &identifyChannelsParam, budgets, nbBudgets );
+}
+
 LoRaMacStatus_t RegionCN470ChannelAdd( ChannelAddParams_t* channelAdd )
 {
     return LORAMAC_STATUS_PARAMETER_INVALID;
@@ -58,7 +58,7 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+static TimerTime_t ComputeTimeOnAir( int8_t datarate, uint16_t pktLen )
 {
     int8_t phyDr = DataratesCN779[datarate];
     uint32_t bandwidth = RegionCommonGetBandwidth( datarate, BandwidthsCN779 );
@@ -75,6 +75,22 @@ static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
     return timeOnAir;
 }
 
+#ifdef REGION_TOA_CACHE
+/*!
+ * Time-on-air per datarate and frame length, filled on the first use
+ */
+static uint16_t TimeOnAirCache[ sizeof( DataratesCN779 ) ][ REGION_COMMON_TOA_CACHE_LEN ];
+#endif
+
+static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+#ifdef REGION_TOA_CACHE
+    return RegionCommonGetCachedTimeOnAir( TimeOnAirCache[0], sizeof( DataratesCN779 ), datarate, pktLen, ComputeTimeOnAir );
+#else
+    return ComputeTimeOnAir( datarate, pktLen );
+#endif
+}
+
 PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
 {
     PhyParam_t phyParam = { 0 };
@@ -262,6 +278,11 @@ PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.Value = RegionCommonGetBandwidth( getPhy->Datarate, BandwidthsCN779 );
             break;
         }
+        case PHY_TIME_ON_AIR:
+        {
+            phyParam.Value = GetTimeOnAir( getPhy->Datarate, getPhy->PktLen );
+            break;
+        }
         default:
         {
             break;
@@ -466,7 +487,7 @@ void RegionCN779ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
         tSymbolInUs = RegionCommonComputeSymbolTimeLoRa( DataratesCN779[rxConfigParams->Datarate], BandwidthsCN779[rxConfigParams->Datarate] );
     }
 
-    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
+    RegionCommonComputeRxWindowParameters( tSymbolInUs, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset, &rxConfigParams->WindowOffsetUs );
 }
 
 bool RegionCN779RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
@@ -825,6 +846,40 @@ LoRaMacStatus_t RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_
     return status;
 }
 
+TimerTime_t RegionCN779GetTxOpportunity( NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets )
+{
+    RegionCommonIdentifyChannelsParam_t identifyChannelsParam;
+    RegionCommonCountNbOfEnabledChannelsParams_t countChannelsParams;
+    uint16_t channelsMask = RegionNvmGroup2->ChannelsMask[0];
+    uint16_t joinChannels = CN779_JOIN_CHANNELS;
+
+    if( RegionCommonCountChannels( &channelsMask, 0, 1 ) == 0 )
+    { // The next uplink reactivates the default channels
+        channelsMask |= LC( 1 ) + LC( 2 ) + LC( 3 );
+    }
+
+    countChannelsParams.Joined = nextChanParams->Joined;
+    countChannelsParams.Datarate = nextChanParams->Datarate;
+    countChannelsParams.ChannelsMask = &channelsMask;
+    countChannelsParams.Channels = RegionNvmGroup2->Channels;
+    countChannelsParams.Bands = RegionBands;
+    countChannelsParams.MaxNbChannels = CN779_MAX_NB_CHANNELS;
+    countChannelsParams.JoinChannels = &joinChannels;
+
+    identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
+    identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
+    identifyChannelsParam.DutyCycleEnabled = nextChanParams->DutyCycleEnabled;
+    identifyChannelsParam.MaxBands = CN779_MAX_NB_BANDS;
+
+    identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
+    identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
+    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+
+    identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
+
+    return RegionCommonGetTxOpportunity( &identifyChannelsParam, budgets, nbBudgets );
+}
+
 LoRaMacStatus_t RegionCN779ChannelAdd( ChannelAddParams_t* channelAdd )
 {
     bool drInvalid = false;
@@ -403,6 +403,18 @@ int8_t RegionEU433AlternateDr( int8_t currentDr, AlternateDrType_t type );
  */
 LoRaMacStatus_t RegionEU433NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel, TimerTime_t* time, TimerTime_t* aggregatedTimeOff );
 
+/*!
+ * \brief Computes when the next uplink could be sent, without selecting a
+ *        channel or changing the state of the bands.
+ *
+ * \param [OUT] budgets Airtime budget of the bands.
+ *
+ * \param [OUT] nbBudgets Number of budgets stored.
+ *
+ * \retval Time to wait [ms], TIMERTIME_T_MAX when no channel can take it.
+ */
+TimerTime_t RegionEU433GetTxOpportunity( NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets );
+
 /*!
  * \brief Adds a channel.
  *
@@ -51,6 +51,7 @@
 #define AS923_DL_CHANNEL_REQ( )                    AS923_CASE { return RegionAS923DlChannelReq( dlChannelReq ); }
 #define AS923_ALTERNATE_DR( )                      AS923_CASE { return RegionAS923AlternateDr( currentDr, type ); }
 #define AS923_NEXT_CHANNEL( )                      AS923_CASE { return RegionAS923NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define AS923_GET_TX_OPPORTUNITY( )                AS923_CASE { return RegionAS923GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define AS923_CHANNEL_ADD( )                       AS923_CASE { return RegionAS923ChannelAdd( channelAdd ); }
 #define AS923_CHANNEL_REMOVE( )                    AS923_CASE { return RegionAS923ChannelsRemove( channelRemove ); }
 #define AS923_APPLY_DR_OFFSET( )                   AS923_CASE { return RegionAS923ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -74,6 +75,7 @@
 #define AS923_DL_CHANNEL_REQ( )
 #define AS923_ALTERNATE_DR( )
 #define AS923_NEXT_CHANNEL( )
+#define AS923_GET_TX_OPPORTUNITY( )
 #define AS923_CHANNEL_ADD( )
 #define AS923_CHANNEL_REMOVE( )
 #define AS923_APPLY_DR_OFFSET( )
@@ -100,6 +102,7 @@
 #define AU915_DL_CHANNEL_REQ( )                    AU915_CASE { return RegionAU915DlChannelReq( dlChannelReq ); }
 #define AU915_ALTERNATE_DR( )                      AU915_CASE { return RegionAU915AlternateDr( currentDr, type ); }
 #define AU915_NEXT_CHANNEL( )                      AU915_CASE { return RegionAU915NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define AU915_GET_TX_OPPORTUNITY( )                AU915_CASE { return RegionAU915GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define AU915_CHANNEL_ADD( )                       AU915_CASE { return RegionAU915ChannelAdd( channelAdd ); }
 #define AU915_CHANNEL_REMOVE( )                    AU915_CASE { return RegionAU915ChannelsRemove( channelRemove ); }
 #define AU915_APPLY_DR_OFFSET( )                   AU915_CASE { return RegionAU915ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -123,6 +126,7 @@
 #define AU915_DL_CHANNEL_REQ( )
 #define AU915_ALTERNATE_DR( )
 #define AU915_NEXT_CHANNEL( )
+#define AU915_GET_TX_OPPORTUNITY( )
 #define AU915_CHANNEL_ADD( )
 #define AU915_CHANNEL_REMOVE( )
 #define AU915_APPLY_DR_OFFSET( )
@@ -149,6 +153,7 @@
 #define CN470_DL_CHANNEL_REQ( )                    CN470_CASE { return RegionCN470DlChannelReq( dlChannelReq ); }
 #define CN470_ALTERNATE_DR( )                      CN470_CASE { return RegionCN470AlternateDr( currentDr, type ); }
 #define CN470_NEXT_CHANNEL( )                      CN470_CASE { return RegionCN470NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define CN470_GET_TX_OPPORTUNITY( )                CN470_CASE { return RegionCN470GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define CN470_CHANNEL_ADD( )                       CN470_CASE { return RegionCN470ChannelAdd( channelAdd ); }
 #define CN470_CHANNEL_REMOVE( )                    CN470_CASE { return RegionCN470ChannelsRemove( channelRemove ); }
 #define CN470_APPLY_DR_OFFSET( )                   CN470_CASE { return RegionCN470ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -172,6 +177,7 @@
 #define CN470_DL_CHANNEL_REQ( )
 #define CN470_ALTERNATE_DR( )
 #define CN470_NEXT_CHANNEL( )
+#define CN470_GET_TX_OPPORTUNITY( )
 #define CN470_CHANNEL_ADD( )
 #define CN470_CHANNEL_REMOVE( )
 #define CN470_APPLY_DR_OFFSET( )
@@ -198,6 +204,7 @@
 #define CN779_DL_CHANNEL_REQ( )                    CN779_CASE { return RegionCN779DlChannelReq( dlChannelReq ); }
 #define CN779_ALTERNATE_DR( )                      CN779_CASE { return RegionCN779AlternateDr( currentDr, type ); }
 #define CN779_NEXT_CHANNEL( )                      CN779_CASE { return RegionCN779NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define CN779_GET_TX_OPPORTUNITY( )                CN779_CASE { return RegionCN779GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define CN779_CHANNEL_ADD( )                       CN779_CASE { return RegionCN779ChannelAdd( channelAdd ); }
 #define CN779_CHANNEL_REMOVE( )                    CN779_CASE { return RegionCN779ChannelsRemove( channelRemove ); }
 #define CN779_APPLY_DR_OFFSET( )                   CN779_CASE { return RegionCN779ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -221,6 +228,7 @@
 #define CN779_DL_CHANNEL_REQ( )
 #define CN779_ALTERNATE_DR( )
 #define CN779_NEXT_CHANNEL( )
+#define CN779_GET_TX_OPPORTUNITY( )
 #define CN779_CHANNEL_ADD( )
 #define CN779_CHANNEL_REMOVE( )
 #define CN779_APPLY_DR_OFFSET( )
@@ -247,6 +255,7 @@
 #define EU433_DL_CHANNEL_REQ( )                    EU433_CASE { return RegionEU433DlChannelReq( dlChannelReq ); }
 #define EU433_ALTERNATE_DR( )                      EU433_CASE { return RegionEU433AlternateDr( currentDr, type ); }
 #define EU433_NEXT_CHANNEL( )                      EU433_CASE { return RegionEU433NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define EU433_GET_TX_OPPORTUNITY( )                EU433_CASE { return RegionEU433GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define EU433_CHANNEL_ADD( )                       EU433_CASE { return RegionEU433ChannelAdd( channelAdd ); }
 #define EU433_CHANNEL_REMOVE( )                    EU433_CASE { return RegionEU433ChannelsRemove( channelRemove ); }
 #define EU433_APPLY_DR_OFFSET( )                   EU433_CASE { return RegionEU433ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -270,6 +279,7 @@
 #define EU433_DL_CHANNEL_REQ( )
 #define EU433_ALTERNATE_DR( )
 #define EU433_NEXT_CHANNEL( )
+#define EU433_GET_TX_OPPORTUNITY( )
 #define EU433_CHANNEL_ADD( )
 #define EU433_CHANNEL_REMOVE( )
 #define EU433_APPLY_DR_OFFSET( )
@@ -296,6 +306,7 @@
 #define EU868_DL_CHANNEL_REQ( )                    EU868_CASE { return RegionEU868DlChannelReq( dlChannelReq ); }
 #define EU868_ALTERNATE_DR( )                      EU868_CASE { return RegionEU868AlternateDr( currentDr, type ); }
 #define EU868_NEXT_CHANNEL( )                      EU868_CASE { return RegionEU868NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define EU868_GET_TX_OPPORTUNITY( )                EU868_CASE { return RegionEU868GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define EU868_CHANNEL_ADD( )                       EU868_CASE { return RegionEU868ChannelAdd( channelAdd ); }
 #define EU868_CHANNEL_REMOVE( )                    EU868_CASE { return RegionEU868ChannelsRemove( channelRemove ); }
 #define EU868_APPLY_DR_OFFSET( )                   EU868_CASE { return RegionEU868ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -319,6 +330,7 @@
 #define EU868_DL_CHANNEL_REQ( )
 #define EU868_ALTERNATE_DR( )
 #define EU868_NEXT_CHANNEL( )
+#define EU868_GET_TX_OPPORTUNITY( )
 #define EU868_CHANNEL_ADD( )
 #define EU868_CHANNEL_REMOVE( )
 #define EU868_APPLY_DR_OFFSET( )
@@ -345,6 +357,7 @@
 #define KR920_DL_CHANNEL_REQ( )                    KR920_CASE { return RegionKR920DlChannelReq( dlChannelReq ); }
 #define KR920_ALTERNATE_DR( )                      KR920_CASE { return RegionKR920AlternateDr( currentDr, type ); }
 #define KR920_NEXT_CHANNEL( )                      KR920_CASE { return RegionKR920NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define KR920_GET_TX_OPPORTUNITY( )                KR920_CASE { return RegionKR920GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define KR920_CHANNEL_ADD( )                       KR920_CASE { return RegionKR920ChannelAdd( channelAdd ); }
 #define KR920_CHANNEL_REMOVE( )                    KR920_CASE { return RegionKR920ChannelsRemove( channelRemove ); }
 #define KR920_APPLY_DR_OFFSET( )                   KR920_CASE { return RegionKR920ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -368,6 +381,7 @@
 #define KR920_DL_CHANNEL_REQ( )
 #define KR920_ALTERNATE_DR( )
 #define KR920_NEXT_CHANNEL( )
+#define KR920_GET_TX_OPPORTUNITY( )
 #define KR920_CHANNEL_ADD( )
 #define KR920_CHANNEL_REMOVE( )
 #define KR920_APPLY_DR_OFFSET( )
@@ -394,6 +408,7 @@
 #define IN865_DL_CHANNEL_REQ( )                    IN865_CASE { return RegionIN865DlChannelReq( dlChannelReq ); }
 #define IN865_ALTERNATE_DR( )                      IN865_CASE { return RegionIN865AlternateDr( currentDr, type ); }
 #define IN865_NEXT_CHANNEL( )                      IN865_CASE { return RegionIN865NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define IN865_GET_TX_OPPORTUNITY( )                IN865_CASE { return RegionIN865GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define IN865_CHANNEL_ADD( )                       IN865_CASE { return RegionIN865ChannelAdd( channelAdd ); }
 #define IN865_CHANNEL_REMOVE( )                    IN865_CASE { return RegionIN865ChannelsRemove( channelRemove ); }
 #define IN865_APPLY_DR_OFFSET( )                   IN865_CASE { return RegionIN865ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -417,6 +432,7 @@
 #define IN865_DL_CHANNEL_REQ( )
 #define IN865_ALTERNATE_DR( )
 #define IN865_NEXT_CHANNEL( )
+#define IN865_GET_TX_OPPORTUNITY( )
 #define IN865_CHANNEL_ADD( )
 #define IN865_CHANNEL_REMOVE( )
 #define IN865_APPLY_DR_OFFSET( )
@@ -443,6 +459,7 @@
 #define US915_DL_CHANNEL_REQ( )                    US915_CASE { return RegionUS915DlChannelReq( dlChannelReq ); }
 #define US915_ALTERNATE_DR( )                      US915_CASE { return RegionUS915AlternateDr( currentDr, type ); }
 #define US915_NEXT_CHANNEL( )                      US915_CASE { return RegionUS915NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define US915_GET_TX_OPPORTUNITY( )                US915_CASE { return RegionUS915GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define US915_CHANNEL_ADD( )                       US915_CASE { return RegionUS915ChannelAdd( channelAdd ); }
 #define US915_CHANNEL_REMOVE( )                    US915_CASE { return RegionUS915ChannelsRemove( channelRemove ); }
 #define US915_APPLY_DR_OFFSET( )                   US915_CASE { return RegionUS915ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -466,6 +483,7 @@
 #define US915_DL_CHANNEL_REQ( )
 #define US915_ALTERNATE_DR( )
 #define US915_NEXT_CHANNEL( )
+#define US915_GET_TX_OPPORTUNITY( )
 #define US915_CHANNEL_ADD( )
 #define US915_CHANNEL_REMOVE( )
 #define US915_APPLY_DR_OFFSET( )
@@ -492,6 +510,7 @@
 #define RU864_DL_CHANNEL_REQ( )                    RU864_CASE { return RegionRU864DlChannelReq( dlChannelReq ); }
 #define RU864_ALTERNATE_DR( )                      RU864_CASE { return RegionRU864AlternateDr( currentDr, type ); }
 #define RU864_NEXT_CHANNEL( )                      RU864_CASE { return RegionRU864NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define RU864_GET_TX_OPPORTUNITY( )                RU864_CASE { return RegionRU864GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define RU864_CHANNEL_ADD( )                       RU864_CASE { return RegionRU864ChannelAdd( channelAdd ); }
 #define RU864_CHANNEL_REMOVE( )                    RU864_CASE { return RegionRU864ChannelsRemove( channelRemove ); }
 #define RU864_APPLY_DR_OFFSET( )                   RU864_CASE { return RegionRU864ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -515,6 +534,7 @@
 #define RU864_DL_CHANNEL_REQ( )
 #define RU864_ALTERNATE_DR( )
 #define RU864_NEXT_CHANNEL( )
+#define RU864_GET_TX_OPPORTUNITY( )
 #define RU864_CHANNEL_ADD( )
 #define RU864_CHANNEL_REMOVE( )
 #define RU864_APPLY_DR_OFFSET( )
@@ -541,6 +561,7 @@
 #define ISM2400_DL_CHANNEL_REQ( )                    ISM2400_CASE { return RegionISM2400DlChannelReq( dlChannelReq ); }
 #define ISM2400_ALTERNATE_DR( )                      ISM2400_CASE { return RegionISM2400AlternateDr( currentDr, type ); }
 #define ISM2400_NEXT_CHANNEL( )                      ISM2400_CASE { return RegionISM2400NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define ISM2400_GET_TX_OPPORTUNITY( )                ISM2400_CASE { return RegionISM2400GetTxOpportunity( nextChanParams, budgets, nbBudgets ); }
 #define ISM2400_CHANNEL_ADD( )                       ISM2400_CASE { return RegionISM2400ChannelAdd( channelAdd ); }
 #define ISM2400_CHANNEL_REMOVE( )                    ISM2400_CASE { return RegionISM2400ChannelsRemove( channelRemove ); }
 #define ISM2400_APPLY_DR_OFFSET( )                   ISM2400_CASE { return RegionISM2400ApplyDrOffset( downlinkDwellTime, dr, drOffset ); }
@@ -564,6 +585,7 @@
 #define ISM2400_DL_CHANNEL_REQ( )
 #define ISM2400_ALTERNATE_DR( )
 #define ISM2400_NEXT_CHANNEL( )
+#define ISM2400_GET_TX_OPPORTUNITY( )
 #define ISM2400_CHANNEL_ADD( )
 #define ISM2400_CHANNEL_REMOVE( )
 #define ISM2400_APPLY_DR_OFFSET( )
@@ -945,6 +967,29 @@ LoRaMacStatus_t RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t* nex
     }
 }
 
+TimerTime_t RegionGetTxOpportunity( LoRaMacRegion_t region, NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets )
+{
+    switch( region )
+    {
+        AS923_GET_TX_OPPORTUNITY( );
+        AU915_GET_TX_OPPORTUNITY( );
+        CN470_GET_TX_OPPORTUNITY( );
+        CN779_GET_TX_OPPORTUNITY( );
+        EU433_GET_TX_OPPORTUNITY( );
+        EU868_GET_TX_OPPORTUNITY( );
+        KR920_GET_TX_OPPORTUNITY( );
+        IN865_GET_TX_OPPORTUNITY( );
+        US915_GET_TX_OPPORTUNITY( );
+        RU864_GET_TX_OPPORTUNITY( );
+        ISM2400_GET_TX_OPPORTUNITY( );
+        default:
+        {
+            *nbBudgets = 0;
+            return TIMERTIME_T_MAX;
+        }
+    }
+}
+
 LoRaMacStatus_t RegionChannelAdd( LoRaMacRegion_t region, ChannelAddParams_t* channelAdd )
 {
     switch( region )
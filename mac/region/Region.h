@@ -315,6 +315,10 @@ typedef enum ePhyAttribute
      * The equivalent bandwith index from datarate
      */
     PHY_BW_FROM_DR,
+    /*!
+     * Time-on-air of an uplink frame [ms]
+     */
+    PHY_TIME_ON_AIR,
 }PhyAttribute_t;
 
 /*!
@@ -438,6 +442,12 @@ typedef struct sGetPhyParams
      * PHY_BEACON_CHANNEL_FREQ, PHY_PING_SLOT_CHANNEL_FREQ
      */
     uint8_t Channel;
+    /*!
+     * Length of the frame, MHDR to MIC.
+     * The parameter is needed for the following queries:
+     * PHY_TIME_ON_AIR
+     */
+    uint16_t PktLen;
 }GetPhyParams_t;
 
 /*!
@@ -591,6 +601,10 @@ typedef struct sRxConfigParams
      * RX window offset
      */
     int32_t WindowOffset;
+    /*!
+     * RX window offset in microseconds
+     */
+    int32_t WindowOffsetUs;
     /*!
      * Downlink dwell time.
      */
@@ -1108,6 +1122,23 @@ int8_t RegionAlternateDr( LoRaMacRegion_t region, int8_t currentDr, AlternateDrT
  */
 LoRaMacStatus_t RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t* nextChanParams, uint8_t* channel, TimerTime_t* time, TimerTime_t* aggregatedTimeOff );
 
+/*!
+ * \brief Computes when the next uplink could be sent, without selecting a
+ *        channel or changing the state of the bands.
+ *
+ * \param [IN] region LoRaWAN region.
+ *
+ * \param [IN] nextChanParams Pointer to the parameters of the uplink.
+ *
+ * \param [OUT] budgets Airtime budget of the bands, REGION_NVM_MAX_NB_BANDS entries.
+ *
+ * \param [OUT] nbBudgets Number of budgets stored.
+ *
+ * \retval Time to wait [ms], 0 when the uplink can be sent now,
+ *         TIMERTIME_T_MAX when no channel can take it.
+ */
+TimerTime_t RegionGetTxOpportunity( LoRaMacRegion_t region, NextChanParams_t* nextChanParams, BandBudget_t* budgets, uint8_t* nbBudgets );
+
 /*!
  * \brief Adds a channel.
  *
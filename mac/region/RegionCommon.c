@@ -94,16 +94,10 @@ static uint16_t GetDutyCycle( Band_t* band, bool joined, SysTime_t elapsedTimeSi
     return dutyCycle;
 }
 
-static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, SysTime_t elapsedTimeSinceStartup,
-                                   bool dutyCycleEnabled, bool lastTxIsJoinRequest )
+static TimerTime_t GetMaxTimeCredits( bool joined, SysTime_t elapsedTimeSinceStartup )
 {
-    uint16_t dutyCycle = band->DCycle;
     TimerTime_t maxCredits = DUTY_CYCLE_TIME_PERIOD;
 
-    // Get the band duty cycle. If not joined, the function either returns the join duty cycle
-    // or the band duty cycle, whichever is more restrictive.
-    dutyCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
-
     if( joined == false )
     {
         if( elapsedTimeSinceStartup.Seconds < BACKOFF_DUTY_CYCLE_1_HOUR_IN_S )
@@ -119,28 +113,11 @@ static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, SysTime_t elapsedT
             maxCredits = DUTY_CYCLE_TIME_PERIOD_JOIN_BACKOFF_24H;
         }
     }
-    else
-    {
-        if( dutyCycleEnabled == false )
-        {
-            // Assign max credits when the duty cycle is disabled.
-            band->TimeCredits = maxCredits;
-        }
-    }
-
-    // Setup the maximum allowed credits. We can assign them
-    // safely all the time.
-    band->MaxTimeCredits = maxCredits;
-
-    return dutyCycle;
+    return maxCredits;
 }
 
-static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnabled,
-                                   bool lastTxIsJoinRequest, SysTime_t elapsedTimeSinceStartup,
-                                   TimerTime_t currentTime, TimerTime_t lastBandUpdateTime )
+static TimerTime_t GetObservationPeriod( bool joined, SysTime_t elapsedTimeSinceStartup )
 {
-    uint16_t dutyCycle = SetMaxTimeCredits( band, joined, elapsedTimeSinceStartup,
-                                            dutyCycleEnabled, lastTxIsJoinRequest );
     TimerTime_t observation = DUTY_CYCLE_TIME_PERIOD;
 
     if( joined == false )
@@ -158,6 +135,39 @@ static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnab
             observation = ( BACKOFF_DUTY_CYCLE_24_HOURS_IN_S * 1000 );
         }
     }
+    return observation;
+}
+
+static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, SysTime_t elapsedTimeSinceStartup,
+                                   bool dutyCycleEnabled, bool lastTxIsJoinRequest )
+{
+    uint16_t dutyCycle = band->DCycle;
+    TimerTime_t maxCredits = GetMaxTimeCredits( joined, elapsedTimeSinceStartup );
+
+    // Get the band duty cycle. If not joined, the function either returns the join duty cycle
+    // or the band duty cycle, whichever is more restrictive.
+    dutyCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
+
+    if( ( joined == true ) && ( dutyCycleEnabled == false ) )
+    {
+        // Assign max credits when the duty cycle is disabled.
+        band->TimeCredits = maxCredits;
+    }
+
+    // Setup the maximum allowed credits. We can assign them
+    // safely all the time.
+    band->MaxTimeCredits = maxCredits;
+
+    return dutyCycle;
+}
+
+static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnabled,
+                                   bool lastTxIsJoinRequest, SysTime_t elapsedTimeSinceStartup,
+                                   TimerTime_t currentTime, TimerTime_t lastBandUpdateTime )
+{
+    uint16_t dutyCycle = SetMaxTimeCredits( band, joined, elapsedTimeSinceStartup,
+                                            dutyCycleEnabled, lastTxIsJoinRequest );
+    TimerTime_t observation = GetObservationPeriod( joined, elapsedTimeSinceStartup );
 
     // Apply new credits only if the observation period has been elapsed.
     if( ( observation <= lastBandUpdateTime ) ||
@@ -171,18 +181,211 @@ static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnab
     return dutyCycle;
 }
 
+/*!
+ * \brief Fills the budget of a band as UpdateTimeCredits would leave it at
+ *        currentTime, without changing the band.
+ */
+static void GetBandBudget( Band_t* band, bool joined, bool dutyCycleEnabled,
+                           SysTime_t elapsedTimeSinceStartup, TimerTime_t currentTime,
+                           BandBudget_t* budget )
+{
+    TimerTime_t observation = GetObservationPeriod( joined, elapsedTimeSinceStartup );
+    TimerTime_t elapsedTime = currentTime - band->LastBandUpdateTime;
+
+    budget->DCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
+    budget->MaxTimeCredits = GetMaxTimeCredits( joined, elapsedTimeSinceStartup );
+
+    if( ( observation <= elapsedTime ) ||
+        ( band->LastMaxCreditAssignTime != observation ) ||
+        ( band->LastBandUpdateTime == 0 ) )
+    {
+        // The next update starts a new observation period
+        budget->TimeCredits = budget->MaxTimeCredits;
+        budget->ObservationLeft = observation;
+    }
+    else
+    {
+        budget->TimeCredits = band->TimeCredits;
+        budget->ObservationLeft = observation - elapsedTime;
+    }
+
+    if( ( joined == true ) && ( dutyCycleEnabled == false ) )
+    {
+        budget->TimeCredits = budget->MaxTimeCredits;
+    }
+}
+
 static uint8_t CountChannels( uint16_t mask, uint8_t nbBits )
 {
-    uint8_t nbActiveBits = 0;
+    return ( uint8_t )__builtin_popcount( ( uint32_t )mask & ( ( 1UL << nbBits ) - 1 ) );
+}
+
+/*!
+ * \brief Lists the enabled channels supporting the datarate, in ascending
+ *        order. Only the set bits of the channels mask are visited.
+ *
+ * \param [IN] params Channel parameters, the band readiness is not checked.
+ *
+ * \param [OUT] channels The channels found, NULL to count them only.
+ *
+ * \param [OUT] bandsMask The bands of the channels found, bit per band.
+ *
+ * \retval Number of channels found.
+ */
+static uint8_t ListChannels( RegionCommonCountNbOfEnabledChannelsParams_t* params, uint8_t* channels,
+                             uint32_t* bandsMask )
+{
+    uint8_t nbChannels = 0;
+    uint32_t bands = 0;
+
+    for( uint8_t i = 0, k = 0; i < params->MaxNbChannels; i += 16, k++ )
+    {
+        uint32_t mask = params->ChannelsMask[k];
+
+        if( ( params->Joined == false ) && ( params->JoinChannels != NULL ) )
+        {
+            mask &= params->JoinChannels[k];
+        }
+        while( mask != 0 )
+        {
+            uint8_t id = i + __builtin_ctz( mask );
+            ChannelParams_t* channel = &params->Channels[id];
+
+            mask &= mask - 1;
+            if( ( channel->Frequency == 0 ) ||
+                ( RegionCommonValueInRange( params->Datarate, channel->DrRange.Fields.Min,
+                                            channel->DrRange.Fields.Max ) == false ) )
+            {
+                continue;
+            }
+            if( channels != NULL )
+            {
+                channels[nbChannels] = id;
+            }
+            nbChannels++;
+            bands |= 1UL << channel->Band;
+        }
+    }
+    *bandsMask = bands;
+    return nbChannels;
+}
+
+/*!
+ * \brief Keeps the channels of the bands ready for transmission, and counts
+ *        the others as restricted.
+ */
+static void SplitChannels( RegionCommonCountNbOfEnabledChannelsParams_t* params, uint8_t* channels,
+                           uint8_t nbChannels, uint32_t bandsMask,
+                           uint8_t* nbEnabledChannels, uint8_t* nbRestrictedChannels )
+{
+    uint32_t readyMask = 0;
+    uint8_t nbEnabled = 0;
+
+    for( uint32_t mask = bandsMask; mask != 0; mask &= mask - 1 )
+    {
+        uint8_t band = __builtin_ctz( mask );
+
+        if( params->Bands[band].ReadyForTransmission == true )
+        {
+            readyMask |= 1UL << band;
+        }
+    }
+    if( readyMask == bandsMask )
+    {
+        // Usual case, no channel to drop
+        *nbEnabledChannels = nbChannels;
+        *nbRestrictedChannels = 0;
+        return;
+    }
+
+    for( uint8_t i = 0; i < nbChannels; i++ )
+    {
+        if( ( readyMask & ( 1UL << params->Channels[channels[i]].Band ) ) != 0 )
+        {
+            channels[nbEnabled++] = channels[i];
+        }
+    }
+    *nbEnabledChannels = nbEnabled;
+    *nbRestrictedChannels = nbChannels - nbEnabled;
+}
+
+/*!
+ * \brief Synchronizes the credits of the bands in bandsMask and marks the
+ *        ones ready for transmission, see RegionCommonUpdateBandTimeOff.
+ *        The other bands are left as they are, a band is brought up to date
+ *        when one of its channels is considered again.
+ */
+static TimerTime_t UpdateBandsTimeOff( bool joined, Band_t* bands, uint32_t bandsMask, bool dutyCycleEnabled,
+                                       bool lastTxIsJoinRequest, SysTime_t elapsedTimeSinceStartup,
+                                       TimerTime_t expectedTimeOnAir )
+{
+    TimerTime_t minTimeToWait = TIMERTIME_T_MAX;
+    TimerTime_t currentTime = TimerGetCurrentTime( );
+    TimerTime_t creditCosts = 0;
+    uint16_t dutyCycle = 1;
+    uint8_t validBands = 0;
 
-    for( uint8_t j = 0; j < nbBits; j++ )
+    while( bandsMask != 0 )
     {
-        if( ( mask & ( 1 << j ) ) == ( 1 << j ) )
+        Band_t* band = &bands[__builtin_ctz( bandsMask )];
+        TimerTime_t elapsedTime = currentTime - band->LastBandUpdateTime;
+
+        bandsMask &= bandsMask - 1;
+
+        // Synchronization of bands and credits
+        dutyCycle = UpdateTimeCredits( band, joined, dutyCycleEnabled,
+                                       lastTxIsJoinRequest, elapsedTimeSinceStartup,
+                                       currentTime, elapsedTime );
+
+        // Calculate the credit costs for the next transmission
+        // with the duty cycle and the expected time on air
+        creditCosts = expectedTimeOnAir * dutyCycle;
+
+        // Check if the band is ready for transmission. Its ready,
+        // when the duty cycle is off, or the TimeCredits of the band
+        // is higher than the credit costs for the transmission.
+        if( ( band->TimeCredits > creditCosts ) ||
+            ( ( dutyCycleEnabled == false ) && ( joined == true ) ) )
+        {
+            band->ReadyForTransmission = true;
+            // This band is a potential candidate for an
+            // upcoming transmission, so increase the counter.
+            validBands++;
+        }
+        else
         {
-            nbActiveBits++;
+            // In this case, the band has not enough credits
+            // for the next transmission.
+            band->ReadyForTransmission = false;
+
+            if( band->MaxTimeCredits > creditCosts )
+            {
+                // The band can only be taken into account, if the maximum credits
+                // of the band are higher than the credit costs.
+                // We calculate the minTimeToWait among the bands which are not
+                // ready for transmission and which are potentially available
+                // for a transmission in the future.
+                TimerTime_t observationTimeDiff = 0;
+                if( band->LastMaxCreditAssignTime >= elapsedTime )
+                {
+                    observationTimeDiff = band->LastMaxCreditAssignTime - elapsedTime;
+                }
+                minTimeToWait = MIN( minTimeToWait, observationTimeDiff );
+                // This band is a potential candidate for an
+                // upcoming transmission (even if its time credits are not enough
+                // at the moment), so increase the counter.
+                validBands++;
+            }
         }
     }
-    return nbActiveBits;
+
+    if( validBands == 0 )
+    {
+        // There is no valid band available to handle a transmission
+        // in the given DUTY_CYCLE_TIME_PERIOD.
+        return TIMERTIME_T_MAX;
+    }
+    return minTimeToWait;
 }
 
 bool RegionCommonChanVerifyDr( uint8_t nbChannels, uint16_t* channelsMask, int8_t dr, int8_t minDr, int8_t maxDr, ChannelParams_t* channels )
@@ -194,16 +397,18 @@ bool RegionCommonChanVerifyDr( uint8_t nbChannels, uint16_t* channelsMask, int8_
 
     for( uint8_t i = 0, k = 0; i < nbChannels; i += 16, k++ )
     {
-        for( uint8_t j = 0; j < 16; j++ )
-        {
-            if( ( ( channelsMask[k] & ( 1 << j ) ) != 0 ) )
-            {// Check datarate validity for enabled channels
-                if( RegionCommonValueInRange( dr, ( channels[i + j].DrRange.Fields.Min & 0x0F ),
-                                                  ( channels[i + j].DrRange.Fields.Max & 0x0F ) ) == 1 )
-                {
-                    // At least 1 channel has been found we can return OK.
-                    return true;
-                }
+        uint32_t mask = channelsMask[k];
+
+        while( mask != 0 )
+        {// Check datarate validity for enabled channels
+            uint8_t id = i + __builtin_ctz( mask );
+
+            mask &= mask - 1;
+            if( RegionCommonValueInRange( dr, ( channels[id].DrRange.Fields.Min & 0x0F ),
+                                              ( channels[id].DrRange.Fields.Max & 0x0F ) ) == 1 )
+            {
+                // At least 1 channel has been found we can return OK.
+                return true;
             }
         }
     }
@@ -285,71 +490,8 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
                                            bool lastTxIsJoinRequest, SysTime_t elapsedTimeSinceStartup,
                                            TimerTime_t expectedTimeOnAir )
 {
-    TimerTime_t minTimeToWait = TIMERTIME_T_MAX;
-    TimerTime_t currentTime = TimerGetCurrentTime( );
-    TimerTime_t creditCosts = 0;
-    uint16_t dutyCycle = 1;
-    uint8_t validBands = 0;
-
-    for( uint8_t i = 0; i < nbBands; i++ )
-    {
-        TimerTime_t elapsedTime = TimerGetElapsedTime( bands[i].LastBandUpdateTime );
-
-        // Synchronization of bands and credits
-        dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
-                                       lastTxIsJoinRequest, elapsedTimeSinceStartup,
-                                       currentTime, elapsedTime );
-
-        // Calculate the credit costs for the next transmission
-        // with the duty cycle and the expected time on air
-        creditCosts = expectedTimeOnAir * dutyCycle;
-
-        // Check if the band is ready for transmission. Its ready,
-        // when the duty cycle is off, or the TimeCredits of the band
-        // is higher than the credit costs for the transmission.
-        if( ( bands[i].TimeCredits > creditCosts ) ||
-            ( ( dutyCycleEnabled == false ) && ( joined == true ) ) )
-        {
-            bands[i].ReadyForTransmission = true;
-            // This band is a potential candidate for an
-            // upcoming transmission, so increase the counter.
-            validBands++;
-        }
-        else
-        {
-            // In this case, the band has not enough credits
-            // for the next transmission.
-            bands[i].ReadyForTransmission = false;
-
-            if( bands[i].MaxTimeCredits > creditCosts )
-            {
-                // The band can only be taken into account, if the maximum credits
-                // of the band are higher than the credit costs.
-                // We calculate the minTimeToWait among the bands which are not
-                // ready for transmission and which are potentially available
-                // for a transmission in the future.
-                TimerTime_t observationTimeDiff = 0;
-                if( bands[i].LastMaxCreditAssignTime >= elapsedTime )
-                {
-                    observationTimeDiff = bands[i].LastMaxCreditAssignTime - elapsedTime;
-                }
-                minTimeToWait = MIN( minTimeToWait, observationTimeDiff );
-                // This band is a potential candidate for an
-                // upcoming transmission (even if its time credits are not enough
-                // at the moment), so increase the counter.
-                validBands++;
-            }
-        }
-    }
-
-
-    if( validBands == 0 )
-    {
-        // There is no valid band available to handle a transmission
-        // in the given DUTY_CYCLE_TIME_PERIOD.
-        return TIMERTIME_T_MAX;
-    }
-    return minTimeToWait;
+    return UpdateBandsTimeOff( joined, bands, ( 1UL << nbBands ) - 1, dutyCycleEnabled,
+                               lastTxIsJoinRequest, elapsedTimeSinceStartup, expectedTimeOnAir );
 }
 
 uint8_t RegionCommonParseLinkAdrReq( uint8_t* payload, RegionCommonLinkAdrParams_t* linkAdrParams )
@@ -451,12 +593,13 @@ uint32_t RegionCommonComputeSymbolTimeFsk( uint8_t phyDrInKbps )
     return 8000 / ( uint32_t )phyDrInKbps; // 1 symbol equals 1 byte
 }
 
-void RegionCommonComputeRxWindowParameters( uint32_t tSymbolInUs, uint8_t minRxSymbols, uint32_t rxErrorInMs, uint32_t wakeUpTimeInMs, uint32_t* windowTimeoutInSymbols, int32_t* windowOffsetInMs )
+void RegionCommonComputeRxWindowParameters( uint32_t tSymbolInUs, uint8_t minRxSymbols, uint32_t rxErrorInMs, uint32_t wakeUpTimeInMs, uint32_t* windowTimeoutInSymbols, int32_t* windowOffsetInMs, int32_t* windowOffsetInUs )
 {
     *windowTimeoutInSymbols = MAX( DIV_CEIL( ( ( 2 * minRxSymbols - 8 ) * tSymbolInUs + 2 * ( rxErrorInMs * 1000 ) ),  tSymbolInUs ), minRxSymbols ); // Computed number of symbols
-    *windowOffsetInMs = ( int32_t )DIV_CEIL( ( int32_t )( 4 * tSymbolInUs ) -
-                                               ( int32_t )DIV_CEIL( ( *windowTimeoutInSymbols * tSymbolInUs ), 2 ) -
-                                               ( int32_t )( wakeUpTimeInMs * 1000 ), 1000 );
+    *windowOffsetInUs = ( int32_t )( 4 * tSymbolInUs ) -
+                        ( int32_t )DIV_CEIL( ( *windowTimeoutInSymbols * tSymbolInUs ), 2 ) -
+                        ( int32_t )( wakeUpTimeInMs * 1000 );
+    *windowOffsetInMs = ( int32_t )DIV_CEIL( *windowOffsetInUs, 1000 );
 }
 
 int8_t RegionCommonComputeTxPower( int8_t txPowerIndex, float maxEirp, float antennaGain )
@@ -499,44 +642,11 @@ void RegionCommonRxBeaconSetup( RegionCommonRxBeaconSetupParams_t* rxBeaconSetup
 void RegionCommonCountNbOfEnabledChannels( RegionCommonCountNbOfEnabledChannelsParams_t* countNbOfEnabledChannelsParams,
                                            uint8_t* enabledChannels, uint8_t* nbEnabledChannels, uint8_t* nbRestrictedChannels )
 {
-    uint8_t nbChannelCount = 0;
-    uint8_t nbRestrictedChannelsCount = 0;
+    uint32_t bandsMask = 0;
+    uint8_t nbChannels = ListChannels( countNbOfEnabledChannelsParams, enabledChannels, &bandsMask );
 
-    for( uint8_t i = 0, k = 0; i < countNbOfEnabledChannelsParams->MaxNbChannels; i += 16, k++ )
-    {
-        for( uint8_t j = 0; j < 16; j++ )
-        {
-            if( ( countNbOfEnabledChannelsParams->ChannelsMask[k] & ( 1 << j ) ) != 0 )
-            {
-                if( countNbOfEnabledChannelsParams->Channels[i + j].Frequency == 0 )
-                { // Check if the channel is enabled
-                    continue;
-                }
-                if( ( countNbOfEnabledChannelsParams->Joined == false ) &&
-                    ( countNbOfEnabledChannelsParams->JoinChannels != NULL ) )
-                {
-                    if( ( countNbOfEnabledChannelsParams->JoinChannels[k] & ( 1 << j ) ) == 0 )
-                    {
-                        continue;
-                    }
-                }
-                if( RegionCommonValueInRange( countNbOfEnabledChannelsParams->Datarate,
-                                              countNbOfEnabledChannelsParams->Channels[i + j].DrRange.Fields.Min,
-                                              countNbOfEnabledChannelsParams->Channels[i + j].DrRange.Fields.Max ) == false )
-                { // Check if the current channel selection supports the given datarate
-                    continue;
-                }
-                if( countNbOfEnabledChannelsParams->Bands[countNbOfEnabledChannelsParams->Channels[i + j].Band].ReadyForTransmission == false )
-                { // Check if the band is available for transmission
-                    nbRestrictedChannelsCount++;
-                    continue;
-                }
-                enabledChannels[nbChannelCount++] = i + j;
-            }
-        }
-    }
-    *nbEnabledChannels = nbChannelCount;
-    *nbRestrictedChannels = nbRestrictedChannelsCount;
+    SplitChannels( countNbOfEnabledChannelsParams, enabledChannels, nbChannels, bandsMask,
+                   nbEnabledChannels, nbRestrictedChannels );
 }
 
 LoRaMacStatus_t RegionCommonIdentifyChannels( RegionCommonIdentifyChannelsParam_t* identifyChannelsParam,
@@ -552,20 +662,22 @@ LoRaMacStatus_t RegionCommonIdentifyChannels( RegionCommonIdentifyChannelsParam_
     if( ( identifyChannelsParam->LastAggrTx == 0 ) ||
         ( identifyChannelsParam->AggrTimeOff <= elapsed ) )
     {
+        RegionCommonCountNbOfEnabledChannelsParams_t* countParams = identifyChannelsParam->CountNbOfEnabledChannelsParam;
+        uint32_t bandsMask = 0;
+        uint8_t nbChannels = ListChannels( countParams, enabledChannels, &bandsMask );
+
         // Reset Aggregated time off
         *aggregatedTimeOff = 0;
 
-        // Update bands Time OFF
-        *nextTxDelay = RegionCommonUpdateBandTimeOff( identifyChannelsParam->CountNbOfEnabledChannelsParam->Joined,
-                                                      identifyChannelsParam->CountNbOfEnabledChannelsParam->Bands,
-                                                      identifyChannelsParam->MaxBands,
-                                                      identifyChannelsParam->DutyCycleEnabled,
-                                                      identifyChannelsParam->LastTxIsJoinRequest,
-                                                      identifyChannelsParam->ElapsedTimeSinceStartUp,
-                                                      identifyChannelsParam->ExpectedTimeOnAir );
+        // Update the time off of the bands with a channel for this datarate
+        *nextTxDelay = UpdateBandsTimeOff( countParams->Joined, countParams->Bands,
+                                           bandsMask & ( ( 1UL << identifyChannelsParam->MaxBands ) - 1 ),
+                                           identifyChannelsParam->DutyCycleEnabled,
+                                           identifyChannelsParam->LastTxIsJoinRequest,
+                                           identifyChannelsParam->ElapsedTimeSinceStartUp,
+                                           identifyChannelsParam->ExpectedTimeOnAir );
 
-        RegionCommonCountNbOfEnabledChannels( identifyChannelsParam->CountNbOfEnabledChannelsParam, enabledChannels,
-                                              nbEnabledChannels, nbRestrictedChannels );
+        SplitChannels( countParams, enabledChannels, nbChannels, bandsMask, nbEnabledChannels, nbRestrictedChannels );
     }
 
     if( *nbEnabledChannels > 0 )
@@ -583,6 +695,76 @@ LoRaMacStatus_t RegionCommonIdentifyChannels( RegionCommonIdentifyChannelsParam_
     }
 }
 
+TimerTime_t RegionCommonGetTxOpportunity( RegionCommonIdentifyChannelsParam_t* identifyChannelsParam,
+                                          BandBudget_t* budgets, uint8_t* nbBudgets )
+{
+    RegionCommonCountNbOfEnabledChannelsParams_t* countParams = identifyChannelsParam->CountNbOfEnabledChannelsParam;
+    TimerTime_t currentTime = TimerGetCurrentTime( );
+    TimerTime_t aggrTimeOff = 0;
+    TimerTime_t minTimeToWait = TIMERTIME_T_MAX;
+    uint32_t validBands = ( 1UL << identifyChannelsParam->MaxBands ) - 1;
+    uint32_t usableBands = 0;
+    uint32_t definedBands = 0;
+    uint8_t nb = 0;
+
+    if( identifyChannelsParam->LastAggrTx != 0 )
+    {
+        TimerTime_t elapsed = TimerGetElapsedTime( identifyChannelsParam->LastAggrTx );
+
+        if( identifyChannelsParam->AggrTimeOff > elapsed )
+        {
+            aggrTimeOff = identifyChannelsParam->AggrTimeOff - elapsed;
+        }
+    }
+
+    ListChannels( countParams, NULL, &usableBands );
+    usableBands &= validBands;
+    for( uint8_t i = 0; i < countParams->MaxNbChannels; i++ )
+    {
+        if( countParams->Channels[i].Frequency != 0 )
+        {
+            definedBands |= 1UL << countParams->Channels[i].Band;
+        }
+    }
+    definedBands = ( definedBands | usableBands ) & validBands;
+
+    for( uint32_t mask = definedBands; mask != 0; mask &= mask - 1 )
+    {
+        uint8_t bandId = __builtin_ctz( mask );
+        BandBudget_t* budget = &budgets[nb++];
+        TimerTime_t creditCosts;
+
+        budget->Band = bandId;
+        budget->Usable = ( usableBands & ( 1UL << bandId ) ) != 0;
+        GetBandBudget( &countParams->Bands[bandId], countParams->Joined,
+                       identifyChannelsParam->DutyCycleEnabled,
+                       identifyChannelsParam->ElapsedTimeSinceStartUp, currentTime, budget );
+        if( budget->Usable == false )
+        {
+            continue;
+        }
+
+        // Same conditions as UpdateBandsTimeOff
+        creditCosts = identifyChannelsParam->ExpectedTimeOnAir * budget->DCycle;
+        if( ( budget->TimeCredits > creditCosts ) ||
+            ( ( identifyChannelsParam->DutyCycleEnabled == false ) && ( countParams->Joined == true ) ) )
+        {
+            minTimeToWait = 0;
+        }
+        else if( budget->MaxTimeCredits > creditCosts )
+        {
+            minTimeToWait = MIN( minTimeToWait, budget->ObservationLeft );
+        }
+    }
+    *nbBudgets = nb;
+
+    if( minTimeToWait == TIMERTIME_T_MAX )
+    {
+        return TIMERTIME_T_MAX;
+    }
+    return MAX( aggrTimeOff, minTimeToWait );
+}
+
 int8_t RegionCommonGetNextLowerTxDr( RegionCommonGetNextLowerTxDrParams_t *params )
 {
     int8_t drLocal = params->CurrentDr;
@@ -622,3 +804,27 @@ uint32_t RegionCommonGetBandwidth( uint32_t drIndex, const uint32_t* bandwidths
             return 2;
     }
 }
+
+TimerTime_t RegionCommonGetCachedTimeOnAir( uint16_t* cache, uint8_t nbDatarates, int8_t datarate, uint16_t pktLen,
+                                            RegionCommonTimeOnAirFunc_t compute )
+{
+    uint16_t* entry = NULL;
+    TimerTime_t timeOnAir = 0;
+
+    if( ( datarate < 0 ) || ( datarate >= nbDatarates ) || ( pktLen >= REGION_COMMON_TOA_CACHE_LEN ) )
+    {
+        return compute( datarate, pktLen );
+    }
+
+    entry = &cache[( datarate * REGION_COMMON_TOA_CACHE_LEN ) + pktLen];
+    if( *entry == 0 )
+    {
+        timeOnAir = compute( datarate, pktLen );
+        if( timeOnAir > UINT16_MAX )
+        {
+            return timeOnAir;
+        }
+        *entry = ( uint16_t )timeOnAir;
+    }
+    return *entry;
+}
@@ -516,8 +516,10 @@ uint32_t RegionCommonComputeSymbolTimeFsk( uint8_t phyDrInKbps );
  * \param [OUT] windowTimeoutInSymbols RX window timeout.
  *
  * \param [OUT] windowOffsetInMs RX window time offset to be applied to the RX delay.
+ *
+ * \param [OUT] windowOffsetInUs RX window time offset to be applied to the RX delay, in microseconds.
  */
-void RegionCommonComputeRxWindowParameters( uint32_t tSymbolInUs, uint8_t minRxSymbols, uint32_t rxErrorInMs, uint32_t wakeUpTimeInMs, uint32_t* windowTimeoutInSymbols, int32_t* windowOffsetInMs );
+void RegionCommonComputeRxWindowParameters( uint32_t tSymbolInUs, uint8_t minRxSymbols, uint32_t rxErrorInMs, uint32_t wakeUpTimeInMs, uint32_t* windowTimeoutInSymbols, int32_t* windowOffsetInMs, int32_t* windowOffsetInUs );
 
 /*!
  * \brief Computes the txPower, based on the max EIRP and the antenna gain.
@@ -585,6 +587,25 @@ LoRaMacStatus_t RegionCommonIdentifyChannels( RegionCommonIdentifyChannelsParam_
                                               uint8_t* nbEnabledChannels, uint8_t* nbRestrictedChannels,
                                               TimerTime_t* nextTxDelay );
 
+/*!
+ * \brief Computes when an uplink could be sent at the earliest, and the
+ *        airtime budget of the bands. Nothing is changed, the result is the
+ *        one RegionCommonIdentifyChannels would give at the same time.
+ *
+ * \param [IN] identifyChannelsParam A pointer to the input parameters, as for
+ *                                   RegionCommonIdentifyChannels.
+ *
+ * \param [OUT] budgets A pointer to an array of MaxBands entries. The function
+ *                      stores the budget of the bands with a defined channel.
+ *
+ * \param [OUT] nbBudgets The number of budgets stored.
+ *
+ * \retval Time to wait for the uplink [ms], 0 when it can be sent now,
+ *         TIMERTIME_T_MAX when no band can take it.
+ */
+TimerTime_t RegionCommonGetTxOpportunity( RegionCommonIdentifyChannelsParam_t* identifyChannelsParam,
+                                          BandBudget_t* budgets, uint8_t* nbBudgets );
+
 /*!
  * \brief Selects the next lower datarate.
  *
@@ -616,6 +637,43 @@ int8_t RegionCommonLimitTxPower( int8_t txPower, int8_t maxBandTxPower );
  */
 uint32_t RegionCommonGetBandwidth( uint32_t drIndex, const uint32_t* bandwidths );
 
+/*!
+ * Frame lengths held by a time-on-air cache, 0 to 255 bytes.
+ */
+#define REGION_COMMON_TOA_CACHE_LEN                 256
+
+/*!
+ * \brief Computes the time-on-air of a frame of the region.
+ *
+ * \param [IN] datarate Datarate index.
+ *
+ * \param [IN] pktLen Frame length.
+ *
+ * \retval Time-on-air [ms].
+ */
+typedef TimerTime_t ( *RegionCommonTimeOnAirFunc_t )( int8_t datarate, uint16_t pktLen );
+
+/*!
+ * \brief Gets the time-on-air of a frame from a cache. The cache entry is
+ *        computed on the first use and kept, the time-on-air depends on the
+ *        datarate and the frame length only.
+ *
+ * \param [IN] cache nbDatarates rows of REGION_COMMON_TOA_CACHE_LEN entries,
+ *                   zero while not computed.
+ *
+ * \param [IN] nbDatarates Number of datarates in the cache.
+ *
+ * \param [IN] datarate Datarate index.
+ *
+ * \param [IN] pktLen Frame length.
+ *
+ * \param [IN] compute Computes the entries.
+ *
+ * \retval Time-on-air [ms].
+ */
+TimerTime_t RegionCommonGetCachedTimeOnAir( uint16_t* cache, uint8_t nbDatarates, int8_t datarate, uint16_t pktLen,
+                                            RegionCommonTimeOnAirFunc_t compute );
+
 /*! \} defgroup REGIONCOMMON */
 
 #ifdef __cplusplus
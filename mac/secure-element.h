@@ -138,6 +138,35 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size
  */
 SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID, uint8_t* encBuffer );
 
+/*!
+ * Encrypts or decrypts a buffer in counter mode
+ *
+ * Each 16 bytes of the buffer are XORed with the encrypted A block, then the
+ * A block is incremented as a 128 bits big endian counter.
+ *
+ * \param[IN/OUT] aBlock     - A block, holds the first counter value
+ * \param[IN/OUT] buffer     - Data buffer, processed in place
+ * \param[IN]     size       - Data buffer size, any length
+ * \param[IN]     keyID      - Key identifier to determine the AES key to be used
+ * \retval                   - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCtrCrypt( uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID );
+
+/*!
+ * Number of AES keys prepared since SecureElementInit. A key is prepared
+ * when it is not in the key cache, or was changed since it was cached.
+ *
+ * \retval                    - Key cache misses
+ */
+uint32_t SecureElementGetKeyCacheMisses( void );
+
+/*!
+ * Checks if the secure element changed its NVM data and clears the flag
+ *
+ * \retval                    - True when changed since the last call
+ */
+bool SecureElementIsNvmChanged( void );
+
 /*!
  * Derives and store a key
  *
@@ -32,7 +32,13 @@
 #include "freertos/task.h"
 #include "lora_crc.h"
 #include "lora_data.h"
+#include "lora_linksel.h"
 #include "lora_mutex_helper.h"
+#include "lora_nvm.h"
+#include "lora_rxring.h"
+#include "lora_status.h"
+#include "lora_txqueue.h"
+#include "RegionCommon.h"
 #include "radio.h"
 #include "timer.h"
 
@@ -129,6 +135,45 @@
 #define LORAWAN_CLASS_C 0
 #endif
 
+#if defined(CONFIG_LORAWAN_NVM_PERSIST)
+#define LORAWAN_NVM_PERSIST 1
+#else
+#define LORAWAN_NVM_PERSIST 0
+#endif
+
+#if defined(CONFIG_LORAWAN_DUAL_CONTEXT)
+#define LORAWAN_DUAL_CONTEXT 1
+#if (LORAMAC_NB_CONTEXTS < 2)
+#error "LORAWAN_DUAL_CONTEXT needs LORAMAC_NB_CONTEXTS=2."
+#endif
+#else
+#define LORAWAN_DUAL_CONTEXT 0
+#endif
+
+#if defined(CONFIG_LORAWAN_LINK_SELECT)
+#define LORAWAN_LINK_SELECT 1
+#if !LORAWAN_DUAL_CONTEXT
+#error "LORAWAN_LINK_SELECT needs LORAWAN_DUAL_CONTEXT."
+#endif
+#else
+#define LORAWAN_LINK_SELECT 0
+#endif
+
+#if defined(CONFIG_LORAWAN_PARALLEL_JOIN)
+#define LORAWAN_PARALLEL_JOIN 1
+#if !LORAWAN_DUAL_CONTEXT
+#error "LORAWAN_PARALLEL_JOIN needs LORAWAN_DUAL_CONTEXT."
+#endif
+#else
+#define LORAWAN_PARALLEL_JOIN 0
+#endif
+
+#if defined(CONFIG_LORAWAN_MAX_RX_ERROR)
+#define LORAWAN_MAX_RX_ERROR CONFIG_LORAWAN_MAX_RX_ERROR
+#else
+#define LORAWAN_MAX_RX_ERROR 20
+#endif
+
 #if defined(CONFIG_LORAWAN_DEV_PROVISIONING)
 #define LORAWAN_DEV_PROVISIONING 1
 #else
@@ -170,6 +215,15 @@
 #define TIME_PROVISIONING_AUTHWAIT 5000
 #define TIMEOUT_SEND_WAITING 17500
 
+// Upper bound of a task sleep while the MAC is busy. Safety net only, MAC
+// progress is signalled through MacProcessNotify.
+#define TIME_MAC_BUSY_WAIT_MAX 1000
+#define TIME_WAIT_FOREVER UINT32_MAX
+
+// Task notification bits
+#define EVENT_NOTIF_LORAMAC 0x01
+#define EVENT_NOTIF_APP 0x02
+
 /*!
  * Device states
  */
@@ -221,6 +275,10 @@ typedef struct TLoraAppData {
   int16_t dataSize;
   uint8_t port;
   uint8_t retry;
+  bool confirmed;
+  bool autoConfirm;  // Frame follows the unconfirmed/confirmed rotation
+  bool inPlace;      // data is a TX queue slot, the MAC builds the frame around it
+  bool encrypted;    // The MAC encrypted data in place, restore it before a retry
 } LoraAppData_t;
 
 // Link status bits
@@ -241,9 +299,12 @@ static uint32_t gProvisionStatus;
 //
 static uint8_t gTxBuf[LORAWAN_MAX_PAYLOAD_LEN];
 static LoraAppData_t gTxData = {.data = gTxBuf, .dataSize = -1, .port = LORAWAN_FPORT_DATA, .retry = 0};
+static uint32_t gTxCheckInterval = TIME_TXCHK_INTERVAL;
 
-static uint8_t gRxBuf[LORAWAN_MAX_PAYLOAD_LEN];
-static LoraAppData_t gRxData = {.data = gRxBuf, .dataSize = -1, .port = 0, .retry = 0};
+// RX delivery, used in this order: callback, queue, ring buffer
+static LoRaRxCallback_t gRxCallback;
+static void *gRxCallbackArg;
+static QueueHandle_t gRxQueue;
 
 static LoRaMacPrimitives_t gLoRaMacPrimitives;
 static LoRaMacCallback_t gLoRaMacCallbacks;
@@ -270,6 +331,33 @@ static LoRaSettings_t gLoRaSettings;
 static bool gWakeFromSleep;
 static bool gHoldProvisioning;
 
+// MAC context of each radio, see LORAWAN_DUAL_CONTEXT
+#define LORA_CONTEXT_SUBGHZ 0
+#define LORA_CONTEXT_ISM2400 1
+
+// Radio asked by LoRaComponSelectRadio(), -1 for none
+static int8_t gRadioRequest;
+
+// Radio of each frame chosen by lora_linksel, see LORAWAN_LINK_SELECT
+#define LORA_LINK_COST_LEN 128
+
+static bool gLinkSelectOn = LORAWAN_LINK_SELECT;
+// The radio of the frame at the head of the TX queue is chosen
+static bool gLinkDecided;
+
+// Join requests of both radios interleaved, see LORAWAN_PARALLEL_JOIN
+static bool gParallelJoinOn = LORAWAN_PARALLEL_JOIN;
+
+#if LORAWAN_PARALLEL_JOIN
+typedef struct {
+  bool ready;         // MAC context initialized for the join
+  uint32_t tick;      // Of the last join request
+  uint32_t interval;  // From tick until the next join request
+} JoinRadio_t;
+
+static JoinRadio_t gJoinRadio[LORA_LINK_RADIOS];
+#endif
+
 // Preserved data when sleep
 #define VALUE_PRESERVED_DATA_CRC_IV 0x1234
 #define VALUE_PRESERVED_DATA_MAGIC_CODE 0x48ad3f56
@@ -285,6 +373,32 @@ typedef struct {
 static RTC_DATA_ATTR LoRaPreservedData_t gLoRaPreservedData;
 static RTC_DATA_ATTR uint16_t gLoRaPreservedDataCrc;
 
+// MAC contexts in flash, survives power loss
+static bool gNvmChanged;
+static LoRaMacNvmData_t gNvmRestoreBuf;
+
+// LoRaComponGetTxOpportunity() is answered by the LoRa task, the MAC and
+// its context are not read from the calling task
+#define TX_OPPORTUNITY_WAIT_TIME 1000
+
+typedef struct {
+  bool pending;
+  uint16_t len;
+  int8_t result;
+  LoRaMacTxOpportunity_t opportunity;
+} TxOpportunityRequest_t;
+
+static TxOpportunityRequest_t gTxOpportunity;
+static SemaphoreHandle_t gTxOpportunityLock;  // One caller at a time
+static SemaphoreHandle_t gTxOpportunityDone;  // Given by the LoRa task
+
+// The MAC contexts are saved for a deep sleep by the LoRa task, like all
+// its other saves
+#define SLEEP_SAVE_WAIT_TIME 3000
+
+static bool gSleepSavePending;
+static SemaphoreHandle_t gSleepSaveDone;  // Given by the LoRa task
+
 //==========================================================================
 // MAC status strings
 //==========================================================================
@@ -356,6 +470,16 @@ static const char *getMacEventStatusString(uint8_t aStatus) {
 //==========================================================================
 static uint8_t GetBatteryLevel(void) { return gLoRaLinkVar.batteryValue; }
 
+//==========================================================================
+// Send notification bit to task
+//==========================================================================
+static void LoRaComponNotify(uint32_t aEvent) {
+  TaskHandle_t handle = gLoRaTaskHandle;
+  if (handle != NULL) {
+    xTaskNotify(handle, aEvent, eSetBits);
+  }
+}
+
 //==========================================================================
 // ProvisioningHello
 //==========================================================================
@@ -422,8 +546,35 @@ static void ProvisioningAuth(void) {
   }
 }
 
+#if LORAWAN_DUAL_CONTEXT
+//==========================================================================
+// Radio in use, as LORA_LINK_*, with its session record in lora_linksel
+//==========================================================================
+static uint8_t GetLinkRadio(void) { return gLoRaLinkVar.usingIsm2400 ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ; }
+#endif
+
+#if LORAWAN_LINK_SELECT
+//==========================================================================
+// LoRa SF of a downlink datarate, 0 if not LoRa
+//==========================================================================
+static uint8_t GetDownlinkSf(uint8_t aDatarate) {
+  if (gLoRaLinkVar.usingIsm2400) {
+    return (aDatarate <= DR_7) ? 12 - aDatarate : 0;
+  }
+#if defined(REGION_US915) || defined(REGION_AU915)
+  if (aDatarate >= DR_8) {
+    return (aDatarate <= DR_13) ? 20 - aDatarate : 0;
+  }
+#endif
+  if (aDatarate <= DR_5) {
+    return 12 - aDatarate;
+  }
+  return (aDatarate == DR_6) ? 7 : 0;
+}
+#endif
+
 //==========================================================================
-// Return: true - send failed
+// Return: 0 - sent, 1 - duty cycle restricted, try later, -1 - send failed
 //==========================================================================
 static int8_t sendFrame(void) {
   MibRequestConfirm_t mibReq;
@@ -438,6 +589,16 @@ static int8_t sendFrame(void) {
     LoRaMacMibSetRequestConfirm(&mibReq);
   }
 
+  // A retry sends the plain payload again
+  if (gTxData.encrypted) {
+    ret_mac = LoRaMacMcpsRestorePayload(gTxData.data);
+    if (ret_mac != LORAMAC_STATUS_OK) {
+      LORACOMPON_PRINTLINE("LoRaMacMcpsRestorePayload() failed, %s", getMacStatusString(ret_mac));
+      return -1;
+    }
+    gTxData.encrypted = false;
+  }
+
   // Workaround for 0 length
   // The MAC will wrong when send a 0 byte frame.
   // It will send 1 byte 0x00 instead.
@@ -474,11 +635,12 @@ static int8_t sendFrame(void) {
     }
   }
 
-  if ((gLoRaLinkVar.txConfirmed) && (gTxData.dataSize > 0)) {
+  if ((gTxData.confirmed) && (gTxData.dataSize > 0)) {
     mcpsReq.Type = MCPS_CONFIRMED;
     mcpsReq.Req.Confirmed.fPort = gTxData.port;
     mcpsReq.Req.Confirmed.fBuffer = gTxData.data;
     mcpsReq.Req.Confirmed.fBufferSize = gTxData.dataSize;
+    mcpsReq.Req.Confirmed.InPlace = gTxData.inPlace;
     //    mcpsReq.Req.Confirmed.NbTrials = g_data_send_nbtrials ? g_data_send_nbtrials : gMacConfig->nbtrials.conf + 1;
     mcpsReq.Req.Confirmed.Datarate = gLoRaLinkVar.dateRate;
   } else {
@@ -491,13 +653,19 @@ static int8_t sendFrame(void) {
     mcpsReq.Req.Unconfirmed.fPort = gTxData.port;
     mcpsReq.Req.Unconfirmed.fBuffer = gTxData.data;
     mcpsReq.Req.Unconfirmed.fBufferSize = gTxData.dataSize;
+    mcpsReq.Req.Unconfirmed.InPlace = gTxData.inPlace;
     mcpsReq.Req.Unconfirmed.Datarate = gLoRaLinkVar.dateRate;
   }
 
   //
   ret_mac = LoRaMacMcpsRequest(&mcpsReq);
   if (ret_mac == LORAMAC_STATUS_OK) {
+    gTxData.encrypted = gTxData.inPlace;
     return 0;
+  } else if ((ret_mac == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED) && (mcpsReq.ReqReturn.DutyCycleWaitTime > 0)) {
+    LORACOMPON_PRINTLINE("Duty cycle restricted, wait %ums.", (unsigned)mcpsReq.ReqReturn.DutyCycleWaitTime);
+    gTxCheckInterval = mcpsReq.ReqReturn.DutyCycleWaitTime;
+    return 1;
   } else {
     LORACOMPON_PRINTLINE("LoRaMacMcpsRequest() failed, %s", getMacStatusString(ret_mac));
     return -1;
@@ -508,9 +676,16 @@ static int8_t sendFrame(void) {
 // MCPS-Confirm event function
 //==========================================================================
 static void McpsConfirm(McpsConfirm_t *mcpsConfirm) {
+#if LORAWAN_LINK_SELECT
+  if (mcpsConfirm->McpsRequest == MCPS_CONFIRMED) {
+    TakeMutex();
+    LoRaLinkSelAddAttempt(GetLinkRadio(), mcpsConfirm->AckReceived);
+    FreeMutex();
+  }
+#endif
   if (mcpsConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK) {
     LORACOMPON_PRINTLINE("McpsConfirm() OK");
-    if (!gLoRaLinkVar.txConfirmed) {
+    if (!gTxData.confirmed) {
       TakeMutex();
       gLinkStatus |= BIT_LORASTATUS_SEND_PASS;
       FreeMutex();
@@ -524,6 +699,64 @@ static void McpsConfirm(McpsConfirm_t *mcpsConfirm) {
   // LoRaComponNotify(EVENT_NOTIF_LORAMAC, NULL);
 }
 
+//==========================================================================
+// Received frame to callback, queue or ring buffer
+//==========================================================================
+static void FillRxInfo(LoRaRxInfo_t *aInfo, const McpsIndication_t *aIndication) {
+  aInfo->fport = aIndication->Port;
+  aInfo->rssi = aIndication->Rssi;
+  aInfo->datarate = aIndication->RxDatarate;
+  aInfo->snr = aIndication->Snr;
+  aInfo->rxSlot = aIndication->RxSlot;
+  aInfo->multicast = (aIndication->Multicast != 0);
+}
+
+static void FillRxFrame(LoRaRxFrame_t *aFrame, const McpsIndication_t *aIndication) {
+  FillRxInfo(&aFrame->info, aIndication);
+  aFrame->dataSize = aIndication->BufferSize;
+  memcpy1(aFrame->data, aIndication->Buffer, aFrame->dataSize);
+  FrameCopyCountRx(aFrame->dataSize);
+}
+
+// Give back the radio buffers of frames not read before a restart
+static void InitRxRing(void) {
+  for (const LoRaRxView_t *view = LoRaRxRingPeek(); view != NULL; view = LoRaRxRingPeek()) {
+    RadioRxBufferRelease(view->data);
+    LoRaRxRingRelease();
+  }
+  LoRaRxRingInit();
+}
+
+// The ring keeps a view of the payload, decrypted in place in the radio RX
+// buffer. The buffer is held until the application has read the frame.
+static void DeliverRxFrame(const McpsIndication_t *aIndication) {
+  LoRaRxCallback_t callback = gRxCallback;
+  QueueHandle_t queue = gRxQueue;
+
+  FrameCopyCountRxFrame();
+  if ((callback != NULL) || (queue != NULL)) {
+    LoRaRxFrame_t frame;
+    FillRxFrame(&frame, aIndication);
+    if (callback != NULL) {
+      callback(&frame, gRxCallbackArg);
+    } else if (xQueueSend(queue, &frame, 0) != pdTRUE) {
+      LoRaRxRingCountOverflow();
+      printf("ERROR. RX queue full, frame dropped.\n");
+    }
+  } else {
+    LoRaRxView_t *slot = LoRaRxRingGetWriteSlot();
+    if ((slot == NULL) || (!RadioRxBufferHold(aIndication->Buffer))) {
+      LoRaRxRingCountOverflow();
+      printf("ERROR. RX buffer full, frame dropped.\n");
+    } else {
+      FillRxInfo(&slot->info, aIndication);
+      slot->dataSize = aIndication->BufferSize;
+      slot->data = aIndication->Buffer;
+      LoRaRxRingCommit();
+    }
+  }
+}
+
 //==========================================================================
 // MCPS-Indication event function
 //==========================================================================
@@ -550,17 +783,19 @@ static void McpsIndication(McpsIndication_t *mcpsIndication) {
   LORACOMPON_PRINTLINE("rx frame: rssi=%d, snr=%d, dr=%d", mcpsIndication->Rssi, mcpsIndication->Snr, mcpsIndication->RxDatarate);
   gLastRxRssi = mcpsIndication->Rssi;
   gLastRxDatarate = mcpsIndication->RxDatarate;
+#if LORAWAN_LINK_SELECT
+  TakeMutex();
+  LoRaLinkSelAddDownlink(GetLinkRadio(), mcpsIndication->Rssi, mcpsIndication->Snr,
+                         GetDownlinkSf(mcpsIndication->RxDatarate));
+  FreeMutex();
+#endif
   if (mcpsIndication->RxData == true) {
     switch (mcpsIndication->Port) {
       case 224:
         break;
       default: {
-        TakeMutex();
-        gRxData.port = mcpsIndication->Port;
-        gRxData.dataSize = mcpsIndication->BufferSize;
-        memcpy1(gRxData.data, mcpsIndication->Buffer, gRxData.dataSize);
-        FreeMutex();
-        LORACOMPON_PRINTLINE("Rxed %d bytes.", gRxData.dataSize);
+        DeliverRxFrame(mcpsIndication);
+        LORACOMPON_PRINTLINE("Rxed %d bytes.", mcpsIndication->BufferSize);
         break;
       }
     }
@@ -569,7 +804,7 @@ static void McpsIndication(McpsIndication_t *mcpsIndication) {
     // ACK
     gLoRaLinkVar.ackCount++;
     LORACOMPON_PRINTLINE("AckReceived, ackCount=%u", gLoRaLinkVar.ackCount);
-    if (gLoRaLinkVar.txConfirmed) {
+    if (gTxData.confirmed) {
       TakeMutex();
       gLinkStatus |= BIT_LORASTATUS_SEND_PASS;
       FreeMutex();
@@ -679,8 +914,63 @@ static void MlmeIndication(MlmeIndication_t *mlmeIndication) {
 
 //==========================================================================
 //==========================================================================
-static void OnMacProcessNotify(void) {
-  // LoRaComponNotify(EVENT_NOTIF_LORAMAC, NULL);
+static void OnMacProcessNotify(void) { LoRaComponNotify(EVENT_NOTIF_LORAMAC); }
+
+//==========================================================================
+// MAC contexts persistence
+//==========================================================================
+static void OnNvmDataChange(uint16_t notifyFlags) { gNvmChanged = true; }
+
+static LoRaMacNvmData_t *GetNvm(void) {
+  MibRequestConfirm_t mibReq;
+
+  mibReq.Type = MIB_NVM_CTXS;
+  if (LoRaMacMibGetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK) {
+    return NULL;
+  }
+  return mibReq.Param.Contexts;
+}
+
+// Saved for the MAC context in use and tagged with its region.
+// gLoRaLinkVar.usingIsm2400 already names the next radio when
+// SwitchContext() saves the context it leaves.
+static void SaveNvm(void) {
+  gNvmChanged = false;
+  LoRaMacNvmData_t *nvm = GetNvm();
+  if (nvm != NULL) {
+    LoRaNvmSave(LoRaMacGetContext(), nvm, nvm->MacGroup2.Region);
+  }
+}
+
+// Return true if an activated session restored from flash
+static bool RestoreNvm(void) {
+  MibRequestConfirm_t mibReq;
+
+  LoRaMacNvmData_t *nvm = GetNvm();
+  if (nvm == NULL) {
+    return false;
+  }
+  memset(&gNvmRestoreBuf, 0, sizeof(gNvmRestoreBuf));
+  if (LoRaNvmRestore(LoRaMacGetContext(), &gNvmRestoreBuf, nvm->MacGroup2.Region) <= 0) {
+    return false;
+  }
+
+  // Session of another device
+  if (memcmp(gNvmRestoreBuf.SecureElement.DevEui, gLoRaSettings.devEui, LORA_EUI_LENGTH) != 0) {
+    LORACOMPON_PRINTLINE("Saved session DevEui mismatch.");
+    return false;
+  }
+
+  mibReq.Type = MIB_NVM_CTXS;
+  mibReq.Param.Contexts = &gNvmRestoreBuf;
+  if (LoRaMacMibSetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK) {
+    return false;
+  }
+  mibReq.Type = MIB_NETWORK_ACTIVATION;
+  if (LoRaMacMibGetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK) {
+    return false;
+  }
+  return (mibReq.Param.NetworkActivation != ACTIVATION_TYPE_NONE);
 }
 
 //==========================================================================
@@ -718,43 +1008,547 @@ static void InitOtaa(void) {
   mibReq.Param.Class = CLASS_A;
   LoRaMacMibSetRequestConfirm(&mibReq);
 
-  LORACOMPON_PRINTLINE("InitOtaa()");
-  LORACOMPON_HEX2STRING("DevEui:", gLoRaSettings.devEui, LORA_EUI_LENGTH);
-  LORACOMPON_HEX2STRING("JoinEui:", gLoRaSettings.joinEui, LORA_EUI_LENGTH);
-  LORACOMPON_HEX2STRING("NwkKey:", gLoRaSettings.nwkKey, LORA_KEY_LENGTH);
-  LORACOMPON_HEX2STRING("AppKey:", gLoRaSettings.appKey, LORA_KEY_LENGTH);
-}
+  LORACOMPON_PRINTLINE("InitOtaa()");
+  LORACOMPON_HEX2STRING("DevEui:", gLoRaSettings.devEui, LORA_EUI_LENGTH);
+  LORACOMPON_HEX2STRING("JoinEui:", gLoRaSettings.joinEui, LORA_EUI_LENGTH);
+  LORACOMPON_HEX2STRING("NwkKey:", gLoRaSettings.nwkKey, LORA_KEY_LENGTH);
+  LORACOMPON_HEX2STRING("AppKey:", gLoRaSettings.appKey, LORA_KEY_LENGTH);
+}
+
+//==========================================================================
+// Init for Device Provisioning
+//==========================================================================
+static void InitDevProvision(void) {
+  LORACOMPON_PRINTLINE("InitDevProvision()");
+  LORACOMPON_PRINTLINE("PID=%s", gLoRaPreservedData.provisionId);
+  LORACOMPON_HEX2STRING("Hash=", gLoRaPreservedData.provisionIdHash, sizeof(gLoRaPreservedData.provisionIdHash));
+
+  DevProvisionInit(gLoRaPreservedData.provisionId, gLoRaPreservedData.provisionIdHash);
+
+  // Setup key for MIC calculation
+  MibRequestConfirm_t mibReq;
+  uint8_t app_key[16];
+  DevProvisionGetFixedKey(app_key, sizeof(app_key));
+  mibReq.Type = MIB_NWK_KEY;
+  mibReq.Param.AppKey = app_key;
+  LoRaMacMibSetRequestConfirm(&mibReq);
+}
+
+//==========================================================================
+//==========================================================================
+static void ProcessJoinRetry(void) {
+#if (LORAWAN_SW_RADIO_COUNT != 0)
+  LORACOMPON_PRINTLINE("joinRetryTimes=%d", gLoRaLinkVar.joinRetryTimes);
+  gLoRaLinkVar.joinRetryTimes++;
+  if (gLoRaLinkVar.joinRetryTimes >= LORAWAN_SW_RADIO_COUNT) {
+    gLoRaLinkVar.usingIsm2400 = !gLoRaLinkVar.usingIsm2400;
+    gLoRaLinkVar.joinRetryTimes = 0;
+  }
+#endif
+}
+
+//==========================================================================
+// Point gTxData to the next queued frame, which is sent from its queue slot.
+// Caller holds the mutex.
+//==========================================================================
+static void LoadNextFrame(void) {
+  LoRaTxFrame_t *frame = LoRaTxQueueTakeHead();
+  if (frame == NULL) {
+    return;
+  }
+  gTxData.data = LORA_TX_FRAME_PAYLOAD(frame);
+  gTxData.inPlace = true;
+  gTxData.encrypted = false;
+  gTxData.dataSize = frame->dataSize;
+  gTxData.port = frame->port;
+  gTxData.retry = 0;
+  gLinkDecided = false;
+  switch (frame->mode) {
+    case LORA_TX_MODE_CONFIRMED:
+      gTxData.confirmed = true;
+      gTxData.autoConfirm = false;
+      break;
+    case LORA_TX_MODE_UNCONFIRMED:
+      gTxData.confirmed = false;
+      gTxData.autoConfirm = false;
+      break;
+    default:
+      gTxData.confirmed = gLoRaLinkVar.txConfirmed;
+      gTxData.autoConfirm = true;
+      break;
+  }
+  gLinkStatus &= ~(BIT_LORASTATUS_SEND_PASS | BIT_LORASTATUS_SEND_FAIL);
+}
+
+//==========================================================================
+// Release the frame of gTxData, ready for TX. Caller holds the mutex.
+//==========================================================================
+static void EndTxFrame(void) {
+  if (gTxData.inPlace) {
+    LoRaTxQueueReleaseSending();
+  }
+  gTxData.data = gTxBuf;
+  gTxData.inPlace = false;
+  gTxData.encrypted = false;
+  gTxData.dataSize = -1;
+}
+
+//==========================================================================
+// Publish the link status for the LoRaComponIs* readers. Caller holds the
+// mutex.
+//==========================================================================
+static void PublishStatus(void) {
+  LoRaStatusSnapshot_t snapshot;
+  snapshot.linkStatus = gLinkStatus;
+  snapshot.linkState = (uint8_t)gLoraLinkState;
+  snapshot.txFull = LoRaTxQueueIsFull();
+  snapshot.txLen = gTxData.dataSize;
+  snapshot.txQueued = LoRaTxQueueCount();
+  snapshot.macBusy = LoRaMacIsBusy();
+  snapshot.linkTick = gTickLoraLink;
+  snapshot.joinInterval = gLoRaLinkVar.joinInterval;
+  LoRaStatusPublish(&snapshot);
+}
+
+//==========================================================================
+// Kept over a restart of the component
+//==========================================================================
+static void InitTxOpportunity(void) {
+  gTxOpportunity.pending = false;
+  if (gTxOpportunityLock == NULL) {
+    gTxOpportunityLock = xSemaphoreCreateMutex();
+  }
+  if (gTxOpportunityDone == NULL) {
+    gTxOpportunityDone = xSemaphoreCreateBinary();
+  }
+  if ((gTxOpportunityLock == NULL) || (gTxOpportunityDone == NULL)) {
+    printf("ERROR. TX opportunity semaphore create failed.\n");
+  }
+}
+
+static void InitSleepSave(void) {
+  gSleepSavePending = false;
+  if (gSleepSaveDone == NULL) {
+    gSleepSaveDone = xSemaphoreCreateBinary();
+  }
+  if (gSleepSaveDone == NULL) {
+    printf("ERROR. Sleep save semaphore create failed.\n");
+  }
+}
+
+//==========================================================================
+// Answer LoRaComponGetTxOpportunity() with the MAC context in use
+//==========================================================================
+static void ServeTxOpportunity(void) {
+  LoRaMacTxOpportunity_t opportunity;
+
+  TakeMutex();
+  bool pending = gTxOpportunity.pending;
+  uint16_t len = gTxOpportunity.len;
+  FreeMutex();
+  if (!pending) {
+    return;
+  }
+
+  LoRaMacStatus_t status = LoRaMacQueryTxOpportunity((uint8_t)len, &opportunity);
+  TakeMutex();
+  gTxOpportunity.pending = false;
+  gTxOpportunity.result = (status == LORAMAC_STATUS_OK) ? 0 : -1;
+  memcpy(&gTxOpportunity.opportunity, &opportunity, sizeof(LoRaMacTxOpportunity_t));
+  FreeMutex();
+  xSemaphoreGive(gTxOpportunityDone);
+}
+
+//==========================================================================
+// Keep the MAC contexts and the link variables over a deep sleep, and a
+// flash copy for power loss
+//==========================================================================
+static void SaveForDeepSleep(void) {
+  LoRaMacNvmData_t *nvm = GetNvm();
+  if (nvm != NULL) {
+    gLoRaPreservedData.magicCode = VALUE_PRESERVED_DATA_MAGIC_CODE;
+    memcpy(&gLoRaPreservedData.contexts, nvm, sizeof(LoRaMacNvmData_t));
+    memcpy(&gLoRaPreservedData.linkVar, &gLoRaLinkVar, sizeof(LoRaLinkVar_t));
+    gLoRaPreservedDataCrc =
+        LoRaCrc16Ccitt(VALUE_PRESERVED_DATA_CRC_IV, (const uint8_t *)&gLoRaPreservedData, sizeof(gLoRaPreservedData));
+    LORACOMPON_PRINTLINE("Preserved Data CRC=%04X", gLoRaPreservedDataCrc);
+  }
+  if (LORAWAN_NVM_PERSIST) {
+    SaveNvm();
+  }
+}
+
+//==========================================================================
+// Save for LoRaComponPrepareForSleep()
+//==========================================================================
+static void ServeSleepSave(void) {
+  TakeMutex();
+  bool pending = gSleepSavePending;
+  gSleepSavePending = false;
+  FreeMutex();
+  if (!pending) {
+    return;
+  }
+
+  SaveForDeepSleep();
+  xSemaphoreGive(gSleepSaveDone);
+}
+
+#if LORAWAN_DUAL_CONTEXT
+//==========================================================================
+// Continue with the MAC context of the radio in use. Return false while
+// the MAC is busy.
+//==========================================================================
+static bool SwitchContext(void) {
+  uint8_t id = gLoRaLinkVar.usingIsm2400 ? LORA_CONTEXT_ISM2400 : LORA_CONTEXT_SUBGHZ;
+
+  if (LoRaMacGetContext() == id) {
+    return true;
+  }
+  // Saved in its own NVS keys, with the tag of its region
+  if ((LORAWAN_NVM_PERSIST) && (gNvmChanged)) {
+    SaveNvm();
+  }
+  int ret_mac = LoRaMacSwitchContext(id);
+  if (ret_mac != LORAMAC_STATUS_OK) {
+    LORACOMPON_PRINTLINE("LoRaMacSwitchContext() failed, %s", getMacStatusString(ret_mac));
+    return false;
+  }
+  LORACOMPON_PRINTLINE("MAC context %d.", id);
+  return true;
+}
+
+//==========================================================================
+// Return true if the context in use has a session, then the link continues
+// without a join
+//==========================================================================
+static bool ResumeSession(void) {
+  MibRequestConfirm_t mibReq;
+
+  mibReq.Type = MIB_NETWORK_ACTIVATION;
+  if ((LoRaMacMibGetRequestConfirm(&mibReq) != LORAMAC_STATUS_OK) ||
+      (mibReq.Param.NetworkActivation == ACTIVATION_TYPE_NONE)) {
+    return false;
+  }
+  LoRaMacStart();
+  LORACOMPON_PRINTLINE("LoRa session resumed.");
+
+  gLoRaLinkVar.dateRate = gLoRaLinkVar.usingIsm2400 ? LORAWAN_ISM2400_DATARATE : LORAWAN_DEFAULT_DATARATE;
+  gLoRaLinkVar.joinRetryTimes = 0;
+  TakeMutex();
+  gLinkStatus |= BIT_LORASTATUS_JOIN_PASS;
+  gLoRaLinkVar.failCount = 0;
+  FreeMutex();
+  return true;
+}
+
+//==========================================================================
+// Continue on the other radio from S_LORALINK_INIT. Caller holds the mutex.
+//==========================================================================
+static void ChangeRadio(bool aIsm2400) {
+  // Not joined until the context of the radio is resumed
+  gLinkStatus &= ~BIT_LORASTATUS_JOIN_PASS;
+  PublishStatus();
+  gLoRaLinkVar.usingIsm2400 = aIsm2400;
+  gLoRaLinkVar.joinRetryTimes = 0;
+}
+
+//==========================================================================
+// Take the radio asked by LoRaComponSelectRadio(), between two frames and
+// with the MAC idle. Return true if the radio changed.
+//==========================================================================
+static bool TakeRadioRequest(void) {
+  bool changed = false;
+
+  TakeMutex();
+  int8_t request = gRadioRequest;
+  if ((request >= 0) && (gTxData.dataSize < 0) && (!LoRaMacIsBusy())) {
+    gRadioRequest = -1;
+    if ((request != 0) != gLoRaLinkVar.usingIsm2400) {
+      ChangeRadio(request != 0);
+      changed = true;
+    }
+  }
+  FreeMutex();
+  return changed;
+}
+#endif
+
+#if LORAWAN_LINK_SELECT
+//==========================================================================
+// Costs of the radio in use, from its MAC context
+//==========================================================================
+static void UpdateLinkCost(void) {
+  LoRaMacTxOpportunity_t opportunity;
+  LoRaLinkCost_t cost;
+  MibRequestConfirm_t mibReq;
+  GetPhyParams_t getPhy;
+  LoRaMacRegion_t region = gLoRaLinkVar.usingIsm2400 ? LORAMAC_REGION_ISM2400 : SUB_GHZ_REGION;
+
+  if (LoRaMacQueryTxOpportunity(LORA_LINK_COST_LEN, &opportunity) != LORAMAC_STATUS_OK) {
+    return;
+  }
+  cost.timeOnAirByteUs = opportunity.TimeOnAir * 1000 / LORA_LINK_COST_LEN;
+  if (LoRaMacQueryTxOpportunity(0, &opportunity) != LORAMAC_STATUS_OK) {
+    return;
+  }
+  cost.timeOnAirByteUs -= opportunity.TimeOnAir * 1000 / LORA_LINK_COST_LEN;
+  cost.timeOnAirUs = opportunity.TimeOnAir * 1000;
+  cost.txDelayMs = (opportunity.TxDelay == TIMERTIME_T_MAX) ? UINT32_MAX : opportunity.TxDelay;
+  cost.airTimeLeftMs = 0;
+  cost.maxAirTimeMs = 0;
+  cost.windowLeftMs = 0;
+  for (uint8_t i = 0; i < opportunity.NbBands; i++) {
+    BandBudget_t *budget = &opportunity.Bands[i];
+    if (budget->Usable) {
+      cost.airTimeLeftMs += budget->TimeCredits / budget->DCycle;
+      cost.maxAirTimeMs += budget->MaxTimeCredits / budget->DCycle;
+      if ((cost.windowLeftMs == 0) || (budget->ObservationLeft < cost.windowLeftMs)) {
+        cost.windowLeftMs = budget->ObservationLeft;
+      }
+    }
+  }
+
+  // Radiated power of the TX power index
+  mibReq.Type = MIB_CHANNELS_TX_POWER;
+  LoRaMacMibGetRequestConfirm(&mibReq);
+  int8_t power_index = mibReq.Param.ChannelsTxPower;
+  mibReq.Type = MIB_ANTENNA_GAIN;
+  LoRaMacMibGetRequestConfirm(&mibReq);
+  getPhy.Attribute = PHY_DEF_MAX_EIRP;
+  cost.txPowerDbm =
+      RegionCommonComputeTxPower(power_index, RegionGetPhyParam(region, &getPhy).fValue, mibReq.Param.AntennaGain);
+
+  TakeMutex();
+  LoRaLinkSelSetCost(GetLinkRadio(), &cost);
+  FreeMutex();
+}
+
+//==========================================================================
+// Choose the radio of the next queued frame, once per frame. Return true
+// if the radio changed.
+//==========================================================================
+static bool SelectLinkRadio(void) {
+  bool changed = false;
+
+  TakeMutex();
+  const LoRaTxFrame_t *frame = LoRaTxQueuePeekHead();
+  bool select = (gLinkSelectOn) && (!gLinkDecided) && (frame != NULL) && (gTxData.dataSize < 0) &&
+                ((gLinkStatus & BIT_LORASTATUS_JOIN_PASS) != 0) && (gLoRaLinkVar.failCount < LORAWAN_LINK_FAIL_COUNT);
+  uint16_t len = (frame != NULL) ? frame->dataSize : 0;
+  FreeMutex();
+  if ((!select) || (LoRaMacIsBusy())) {
+    return false;
+  }
+
+  UpdateLinkCost();
+  TakeMutex();
+  uint8_t radio = LoRaLinkSelChoose(GetLinkRadio(), len);
+  gLinkDecided = true;
+  if (radio != GetLinkRadio()) {
+    LORACOMPON_PRINTLINE("Link select %s.", (radio == LORA_LINK_ISM2400) ? "ISM2400" : "sub-GHz");
+    ChangeRadio(radio == LORA_LINK_ISM2400);
+    changed = true;
+  }
+  FreeMutex();
+  return changed;
+}
+
+//==========================================================================
+// A join on a radio chosen by the link selection failed. Return true if
+// the link goes back to the other radio, which has a session.
+//==========================================================================
+static bool LinkJoinFailed(void) {
+  bool back = false;
+
+  TakeMutex();
+  uint8_t other = (GetLinkRadio() == LORA_LINK_SUBGHZ) ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ;
+  if ((gLinkSelectOn) && (LoRaLinkSelHasSession(other))) {
+    ChangeRadio(other == LORA_LINK_ISM2400);
+    back = true;
+  }
+  FreeMutex();
+  return back;
+}
+#endif
+
+#if LORAWAN_PARALLEL_JOIN
+//==========================================================================
+// Both radios send join requests while neither has a session
+//==========================================================================
+static bool IsParallelJoin(void) {
+  TakeMutex();
+  uint8_t other = (GetLinkRadio() == LORA_LINK_SUBGHZ) ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ;
+  bool parallel = (gParallelJoinOn) && (!LoRaLinkSelHasSession(other));
+  FreeMutex();
+  return parallel;
+}
+
+// Time until the next join request of aRadio, 0 before its first one
+static uint32_t GetJoinWaitTime(uint8_t aRadio) {
+  JoinRadio_t *join = &gJoinRadio[aRadio];
+
+  if (!join->ready) {
+    return 0;
+  }
+  uint32_t elapsed = LoRaTickElapsed(join->tick);
+  return (elapsed < join->interval) ? (join->interval - elapsed) : 0;
+}
+
+// Radio of the next join request, the other one when both are due
+static uint8_t GetNextJoinRadio(void) {
+  uint8_t current = GetLinkRadio();
+  uint8_t other = (current == LORA_LINK_SUBGHZ) ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ;
+  return (GetJoinWaitTime(other) <= GetJoinWaitTime(current)) ? other : current;
+}
+
+static void SetJoinWaitTime(uint32_t aInterval) {
+  JoinRadio_t *join = &gJoinRadio[GetLinkRadio()];
+
+  join->ready = true;
+  join->tick = LoRaGetTick();
+  join->interval = aInterval;
+}
+
+//==========================================================================
+// Hold the join request at aDatarate while the duty cycle of the radio in
+// use restricts it. The MAC would wait for it, busy, and the other radio
+// could not take its turn. Return true if it is held.
+//==========================================================================
+static bool HoldJoinRequest(int8_t aDatarate) {
+  LoRaMacTxOpportunity_t opportunity;
+  MibRequestConfirm_t mibReq;
+
+  // The join request sets it as well
+  mibReq.Type = MIB_CHANNELS_DATARATE;
+  mibReq.Param.ChannelsDatarate = aDatarate;
+  LoRaMacMibSetRequestConfirm(&mibReq);
+  if ((LoRaMacQueryTxOpportunity(0, &opportunity) != LORAMAC_STATUS_OK) || (opportunity.TxDelay == 0)) {
+    return false;
+  }
+  if (opportunity.TxDelay == TIMERTIME_T_MAX) {
+    SetJoinWaitTime(randr(TIME_JOIN_INTERVAL_MIN, TIME_JOIN_INTERVAL_MAX));
+  } else {
+    SetJoinWaitTime(opportunity.TxDelay);
+  }
+  LORACOMPON_PRINTLINE("Join held by the duty cycle for %u ms.", (unsigned int)gJoinRadio[GetLinkRadio()].interval);
+  return true;
+}
+#endif
+
+//==========================================================================
+// Time left of an interval started at gTickLoraLink
+//==========================================================================
+static uint32_t GetRemainingTime(uint32_t aInterval) {
+  uint32_t elapsed = LoRaTickElapsed(gTickLoraLink);
+  if (elapsed < aInterval) {
+    return aInterval - elapsed;
+  } else {
+    return 0;
+  }
+}
+
+//==========================================================================
+// Time until the state machine has something to do, in ms.
+// Events (MAC, application, sleep/resume) wake up the task earlier.
+//==========================================================================
+static uint32_t GetStateWaitTime(void) {
+  uint32_t wait_time;
+
+  switch (gLoraLinkState) {
+    case S_LORALINK_PROVISIONING_START:
+      if (gHoldProvisioning) {
+        wait_time = TIME_WAIT_FOREVER;
+      } else if (gTickLoraLink == 0) {
+        wait_time = 0;
+      } else {
+        wait_time = GetRemainingTime(gLoRaLinkVar.joinInterval);
+      }
+      break;
+
+    case S_LORALINK_PROVISIONING_HELLO:
+    case S_LORALINK_PROVISIONING_WAIT:
+      wait_time = GetRemainingTime(TIME_PROVISIONING_TIMEOUT);
+      break;
+
+    case S_LORALINK_PROVISIONING_AUTH:
+      wait_time = GetRemainingTime(TIME_PROVISIONING_AUTHWAIT);
+      break;
+
+    case S_LORALINK_JOIN_WAIT:
+#if LORAWAN_PARALLEL_JOIN
+      if (IsParallelJoin()) {
+        wait_time = GetJoinWaitTime(GetNextJoinRadio());
+        if ((wait_time == 0) && (LoRaMacIsBusy())) {
+          wait_time = TIME_MAC_BUSY_WAIT_MAX;
+        }
+        break;
+      }
+#endif
+      wait_time = GetRemainingTime(gLoRaLinkVar.joinInterval);
+      break;
+
+    case S_LORALINK_SEND_WAITING:
+      wait_time = GetRemainingTime(TIMEOUT_SEND_WAITING);
+      break;
+
+    case S_LORALINK_RETRY_WAITING:
+      wait_time = GetRemainingTime(LORAWAN_NOACK_RETRY_INTERVAL);
+      break;
+
+    case S_LORALINK_WAITING: {
+      TakeMutex();
+      uint32_t status = gLinkStatus;
+      int16_t tx_len = gTxData.dataSize;
+      uint16_t queued = LoRaTxQueueCount();
+      FreeMutex();
+      if ((status & BIT_LORASTATUS_JOIN_PASS) == 0) {
+        wait_time = TIME_WAIT_FOREVER;
+      } else if ((gTickLoraLink == 0) || ((tx_len < 0) && (queued > 0))) {
+        wait_time = 0;
+      } else if ((tx_len >= 0) || (gLoRaLinkVar.failCount >= LORAWAN_LINK_FAIL_COUNT)) {
+        wait_time = GetRemainingTime(gTxCheckInterval);
+      } else {
+        wait_time = TIME_WAIT_FOREVER;
+      }
+      break;
+    }
 
-//==========================================================================
-// Init for Device Provisioning
-//==========================================================================
-static void InitDevProvision(void) {
-  LORACOMPON_PRINTLINE("InitDevProvision()");
-  LORACOMPON_PRINTLINE("PID=%s", gLoRaPreservedData.provisionId);
-  LORACOMPON_HEX2STRING("Hash=", gLoRaPreservedData.provisionIdHash, sizeof(gLoRaPreservedData.provisionIdHash));
+    case S_LORALINK_SLEEP:
+      wait_time = TIME_WAIT_FOREVER;
+      break;
 
-  DevProvisionInit(gLoRaPreservedData.provisionId, gLoRaPreservedData.provisionIdHash);
+    case S_LORALINK_INIT:
+      // Stays only while the MAC is busy, see SwitchContext()
+      wait_time = LORAWAN_DUAL_CONTEXT ? TIME_MAC_BUSY_WAIT_MAX : 0;
+      break;
 
-  // Setup key for MIC calculation
-  MibRequestConfirm_t mibReq;
-  uint8_t app_key[16];
-  DevProvisionGetFixedKey(app_key, sizeof(app_key));
-  mibReq.Type = MIB_NWK_KEY;
-  mibReq.Param.AppKey = app_key;
-  LoRaMacMibSetRequestConfirm(&mibReq);
+    default:
+      wait_time = 0;
+      break;
+  }
+
+  if ((wait_time > TIME_MAC_BUSY_WAIT_MAX) && (LoRaMacIsBusy())) {
+    wait_time = TIME_MAC_BUSY_WAIT_MAX;
+  }
+  return wait_time;
 }
 
 //==========================================================================
+// Block until notified or the next deadline of the state machine
 //==========================================================================
-static void ProcessJoinRetry(void) {
-#if (LORAWAN_SW_RADIO_COUNT != 0)
-  LORACOMPON_PRINTLINE("joinRetryTimes=%d", gLoRaLinkVar.joinRetryTimes);
-  gLoRaLinkVar.joinRetryTimes++;
-  if (gLoRaLinkVar.joinRetryTimes >= LORAWAN_SW_RADIO_COUNT) {
-    gLoRaLinkVar.usingIsm2400 = !gLoRaLinkVar.usingIsm2400;
-    gLoRaLinkVar.joinRetryTimes = 0;
+static void WaitForEvent(uint32_t aWaitTime) {
+  TickType_t ticks;
+
+  if (aWaitTime == 0) {
+    return;
+  } else if (aWaitTime == TIME_WAIT_FOREVER) {
+    ticks = portMAX_DELAY;
+  } else {
+    // Round up, never wake up before the deadline
+    ticks = (aWaitTime + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
   }
-#endif
+  xTaskNotifyWait(0, UINT32_MAX, NULL, ticks);
 }
 
 //==========================================================================
@@ -772,6 +1566,9 @@ void loraTask(void *param) {
   gLoRaLinkVar.unconfigmedCount = 0;
   gLoRaLinkVar.usingIsm2400 = LORAWAN_USING_ISM2400;
   gLoRaLinkVar.dateRate = LORAWAN_DEFAULT_DATARATE;
+  gRadioRequest = -1;
+  gLinkDecided = false;
+  LoRaLinkSelInit(LORAWAN_MAX_NOACK_RETRY + 1);
 
   //
   // ExtPowerInit();
@@ -800,27 +1597,43 @@ void loraTask(void *param) {
 
   // start main loop of lora task.
   for (;;) {
-    //    uint32_t notif = 0;
-
     // Abort this task
     if (gLoRaTaskAbort) break;
 
-    // Process Radio IRQ
-    //    if (gLoraLinkState != S_LORALINK_SLEEP) {
-    // if (Radio.IrqProcess != NULL) {
-    //   Radio.IrqProcess();
-    // }
     // Processes the LoRaMac events
     LoRaMacProcess();
-    //    }
+    if ((LORAWAN_NVM_PERSIST) && (gNvmChanged)) {
+      SaveNvm();
+    }
+    ServeTxOpportunity();
+    ServeSleepSave();
 
     // State machine
+    LoraDevicState_t prev_state = gLoraLinkState;
     switch (gLoraLinkState) {
       case S_LORALINK_INIT: {
         int ret_mac;
         MibRequestConfirm_t mibReq;
 
         // LORACOMPON_PRINTLINE("S_LORALINK_INIT");
+#if LORAWAN_DUAL_CONTEXT
+        // Each radio keeps its session, until its link is down
+        if (!SwitchContext()) {
+          break;
+        }
+        if ((!gWakeFromSleep) && (gLoRaLinkVar.failCount < LORAWAN_LINK_FAIL_COUNT) && (ResumeSession())) {
+          gLoraLinkState = S_LORALINK_JOINED;
+          break;
+        }
+#endif
+#if LORAWAN_PARALLEL_JOIN
+        // Joins again with the MAC context as it is, its duty cycle goes on
+        if ((gJoinRadio[GetLinkRadio()].ready) && (IsParallelJoin())) {
+          LoRaMacStart();
+          gLoraLinkState = S_LORALINK_JOIN;
+          break;
+        }
+#endif
         LoRaMacDeInitialization();
 
         gLoRaMacPrimitives.MacMcpsConfirm = McpsConfirm;
@@ -829,7 +1642,7 @@ void loraTask(void *param) {
         gLoRaMacPrimitives.MacMlmeIndication = MlmeIndication;
         gLoRaMacCallbacks.GetBatteryLevel = GetBatteryLevel;
         gLoRaMacCallbacks.GetTemperatureLevel = NULL;
-        gLoRaMacCallbacks.NvmDataChange = NULL;
+        gLoRaMacCallbacks.NvmDataChange = LORAWAN_NVM_PERSIST ? OnNvmDataChange : NULL;
         gLoRaMacCallbacks.MacProcessNotify = OnMacProcessNotify;
         if (gLoRaLinkVar.usingIsm2400) {
           ret_mac = LoRaMacInitialization(&gLoRaMacPrimitives, &gLoRaMacCallbacks, LORAMAC_REGION_ISM2400);
@@ -876,6 +1689,21 @@ void loraTask(void *param) {
           }
         }
 
+        // Power on, try the session saved in flash
+        if ((LORAWAN_NVM_PERSIST) && (!device_activated)) {
+          if (RestoreNvm()) {
+            LORACOMPON_PRINTLINE("LoRa session restored from flash.");
+            device_activated = true;
+
+            // Init variables
+            TakeMutex();
+            gLinkStatus = 0;
+            gLoRaLinkVar.failCount = 0;
+            EndTxFrame();  // Ready for TX
+            FreeMutex();
+          }
+        }
+
         //
         if (!device_activated) {
           mibReq.Type = MIB_PUBLIC_NETWORK;
@@ -897,10 +1725,10 @@ void loraTask(void *param) {
 
           // Set rx time error range
           mibReq.Type = MIB_SYSTEM_MAX_RX_ERROR;
-          mibReq.Param.SystemMaxRxError = 50;  // Increase this could make the RX window open earlier.
-                                               // Warning: Since there is a limitation on the RX widnow,
-                                               //          a too large value will cause the window shifted
-                                               //          to early and missed the signal.
+          mibReq.Param.SystemMaxRxError = LORAWAN_MAX_RX_ERROR;  // Increase this could make the RX window open earlier.
+                                                                 // Warning: Since there is a limitation on the RX widnow,
+                                                                 //          a too large value will cause the window shifted
+                                                                 //          to early and missed the signal.
           LoRaMacMibSetRequestConfirm(&mibReq);
 
           if (gLoRaLinkVar.usingIsm2400) {
@@ -925,8 +1753,7 @@ void loraTask(void *param) {
           TakeMutex();
           gLinkStatus = 0;
           gLoRaLinkVar.failCount = 0;
-          gTxData.dataSize = -1;  // Ready for TX
-          gRxData.dataSize = -1;  // Ready for RX
+          EndTxFrame();  // Ready for TX
           FreeMutex();
         }
 
@@ -1028,6 +1855,12 @@ void loraTask(void *param) {
           }
         }
         mlmeReq.Req.Join.NetworkActivation = ACTIVATION_TYPE_OTAA;
+#if LORAWAN_PARALLEL_JOIN
+        if ((IsParallelJoin()) && (HoldJoinRequest(mlmeReq.Req.Join.Datarate))) {
+          gLoraLinkState = S_LORALINK_JOIN_WAIT;
+          break;
+        }
+#endif
 
         LORACOMPON_PRINTLINE("Start to Join, dr=%d", mlmeReq.Req.Join.Datarate);
         int ret_mac = LoRaMacMlmeRequest(&mlmeReq);
@@ -1038,6 +1871,9 @@ void loraTask(void *param) {
         gLoraLinkState = S_LORALINK_JOIN_WAIT;
         gLoRaLinkVar.joinInterval = randr(TIME_JOIN_INTERVAL_MIN, TIME_JOIN_INTERVAL_MAX);
         gTickLoraLink = LoRaGetTick();
+#if LORAWAN_PARALLEL_JOIN
+        SetJoinWaitTime(gLoRaLinkVar.joinInterval);
+#endif
         break;
       }
 
@@ -1048,8 +1884,34 @@ void loraTask(void *param) {
         if ((status & BIT_LORASTATUS_JOIN_PASS) != 0) {
           gLoRaLinkVar.joinRetryTimes = 0;
           gLoraLinkState = S_LORALINK_JOINED;
+#if LORAWAN_DUAL_CONTEXT
+        } else if (TakeRadioRequest()) {
+          gLoraLinkState = S_LORALINK_INIT;
+#endif
+#if LORAWAN_PARALLEL_JOIN
+        } else if (IsParallelJoin()) {
+          // The next request when the one in flight is over, on the radio due first
+          uint8_t radio = GetNextJoinRadio();
+          if ((!LoRaMacIsBusy()) && (GetJoinWaitTime(radio) == 0)) {
+            if (radio != GetLinkRadio()) {
+              // Its MAC context is taken in S_LORALINK_INIT
+              TakeMutex();
+              ChangeRadio(radio == LORA_LINK_ISM2400);
+              FreeMutex();
+              gLoraLinkState = S_LORALINK_INIT;
+            } else {
+              gLoraLinkState = gJoinRadio[radio].ready ? S_LORALINK_JOIN : S_LORALINK_INIT;
+            }
+          }
+#endif
         } else if (LoRaTickElapsed(gTickLoraLink) >= gLoRaLinkVar.joinInterval) {
+#if LORAWAN_LINK_SELECT
+          if (!LinkJoinFailed()) {
+            ProcessJoinRetry();
+          }
+#else
           ProcessJoinRetry();
+#endif
           gLoraLinkState = S_LORALINK_INIT;
         }
         break;
@@ -1059,6 +1921,15 @@ void loraTask(void *param) {
         LORACOMPON_PRINTLINE("Joined");
         gLoraLinkState = S_LORALINK_WAITING;
         gTickLoraLink = LoRaGetTick();
+#if LORAWAN_DUAL_CONTEXT
+        TakeMutex();
+        LoRaLinkSelSetSession(GetLinkRadio(), true);
+        FreeMutex();
+#endif
+#if LORAWAN_PARALLEL_JOIN
+        // The first accept wins, the other radio sends no more requests
+        memset(gJoinRadio, 0, sizeof(gJoinRadio));
+#endif
 
         if (LORAWAN_CLASS_C) {
           MibRequestConfirm_t mibReq;
@@ -1074,7 +1945,13 @@ void loraTask(void *param) {
       }
 
       case S_LORALINK_SEND: {
-        if (sendFrame() < 0) {
+        int8_t ret = sendFrame();
+        if (ret > 0) {
+          // Keep the frame, send again after the duty cycle wait time
+          gLoraLinkState = S_LORALINK_WAITING;
+          gTickLoraLink = LoRaGetTick();
+          break;
+        } else if (ret < 0) {
           LORACOMPON_PRINTLINE("sendFrame() failed.");
           TakeMutex();
           gLinkStatus |= BIT_LORASTATUS_SEND_FAIL;
@@ -1087,6 +1964,7 @@ void loraTask(void *param) {
 
       case S_LORALINK_SEND_MAC: {
         TakeMutex();
+        EndTxFrame();
         gTxData.dataSize = 0;
         FreeMutex();
         if (sendFrame() < 0) {
@@ -1138,7 +2016,8 @@ void loraTask(void *param) {
 
         } else {
           TakeMutex();
-          gTxData.dataSize = -1;  // End of TX
+          EndTxFrame();  // End of TX
+          LoRaTxQueueCountResult(false);
           FreeMutex();
           gTickLoraLink = 0;  // Instant check on S_LORALINK_WAITING
           gLoraLinkState = S_LORALINK_WAITING;
@@ -1147,20 +2026,23 @@ void loraTask(void *param) {
 
       case S_LORALINK_SEND_SUCCESS:
         TakeMutex();
-        gTxData.dataSize = -1;  // End of TX
+        EndTxFrame();  // End of TX
+        LoRaTxQueueCountResult(true);
         FreeMutex();
         gLoRaLinkVar.failCount = 0;
+        if (gTxData.autoConfirm) {
 #if (LORAWAN_UNCONFIRMED_COUNT > 0)
-        if (gLoRaLinkVar.unconfigmedCount >= LORAWAN_UNCONFIRMED_COUNT) {
-          gLoRaLinkVar.unconfigmedCount = 0;
-          gLoRaLinkVar.txConfirmed = true;
-        } else {
-          gLoRaLinkVar.unconfigmedCount++;
-          gLoRaLinkVar.txConfirmed = false;
-        }
+          if (gLoRaLinkVar.unconfigmedCount >= LORAWAN_UNCONFIRMED_COUNT) {
+            gLoRaLinkVar.unconfigmedCount = 0;
+            gLoRaLinkVar.txConfirmed = true;
+          } else {
+            gLoRaLinkVar.unconfigmedCount++;
+            gLoRaLinkVar.txConfirmed = false;
+          }
 #else
-        gLoRaLinkVar.txConfirmed = true;
+          gLoRaLinkVar.txConfirmed = true;
 #endif
+        }
         gTickLoraLink = LoRaGetTick();
         gLoraLinkState = S_LORALINK_WAITING;
         break;
@@ -1173,15 +2055,38 @@ void loraTask(void *param) {
         break;
 
       case S_LORALINK_WAITING: {
+#if LORAWAN_DUAL_CONTEXT
+        if (TakeRadioRequest()) {
+          gLoraLinkState = S_LORALINK_INIT;
+          break;
+        }
+#endif
+#if LORAWAN_LINK_SELECT
+        if (SelectLinkRadio()) {
+          gLoraLinkState = S_LORALINK_INIT;
+          break;
+        }
+#endif
         TakeMutex();
         uint32_t status = gLinkStatus;
+        if ((gTxData.dataSize < 0) && (status & BIT_LORASTATUS_JOIN_PASS) && (LoRaTxQueueCount() > 0)) {
+          // Take the next frame from the queue
+          LoadNextFrame();
+          gTickLoraLink = 0;
+        }
         int16_t tx_len = gTxData.dataSize;
         FreeMutex();
         if (status & BIT_LORASTATUS_JOIN_PASS) {
-          if ((gTickLoraLink == 0) || (LoRaTickElapsed(gTickLoraLink) >= TIME_TXCHK_INTERVAL)) {
+          if ((gTickLoraLink == 0) || (LoRaTickElapsed(gTickLoraLink) >= gTxCheckInterval)) {
             gTickLoraLink = LoRaGetTick();
+            gTxCheckInterval = TIME_TXCHK_INTERVAL;
             if (gLoRaLinkVar.failCount >= LORAWAN_LINK_FAIL_COUNT) {
               printf("ERROR. Too many link fail. Disconnect.\n");
+#if LORAWAN_DUAL_CONTEXT
+              TakeMutex();
+              LoRaLinkSelSetSession(GetLinkRadio(), false);
+              FreeMutex();
+#endif
               gLoraLinkState = S_LORALINK_INIT;
             } else if ((tx_len >= 0) && (!LoRaMacIsBusy())) {
               gLoraLinkState = S_LORALINK_SEND;
@@ -1214,26 +2119,15 @@ void loraTask(void *param) {
     }
 
     RadioHandleChipError();
-    DelayMs(10);
 
-    // if (gLoraLinkState == S_LORALINK_SLEEP) {
-    //   int ret = OS_TASK_NOTIFY_WAIT(0, OS_TASK_NOTIFY_ALL_BITS, &notif, OS_TASK_NOTIFY_FOREVER);
-    //   OS_ASSERT(ret == OS_OK);
-    // } else {
-    //   int ret = OS_TASK_NOTIFY_WAIT(0, OS_TASK_NOTIFY_ALL_BITS, &notif, OS_MS_2_TICKS(10));
-    //   OS_ASSERT(ret == OS_OK);
-    // }
-
-    // if ((notif & EVENT_NOTIF_LORA_DIO1) || (hw_gpio_get_pin_status(HW_LORA_DIO1_PORT, HW_LORA_DIO1_PIN))) {
-    //   gRadioIrqFunc(NULL);
-    // }
-
-    // if (notif & EVENT_NOTIF_LORAMAC) {
-    //   if (gp_loramac_cb != NULL) {
-    //     gp_loramac_cb();
-    //     gp_loramac_cb = NULL;
-    //   }
-    // }
+    TakeMutex();
+    PublishStatus();
+    FreeMutex();
+
+    // Run again at once on a state change, otherwise sleep until next event
+    if (gLoraLinkState == prev_state) {
+      WaitForEvent(GetStateWaitTime());
+    }
   }
   printf("INFO. LoRaTask ended.\n");
   LoRaMacDeInitialization();
@@ -1245,16 +2139,14 @@ void loraTask(void *param) {
 // Get Raw Status
 //==========================================================================
 static uint32_t GetStatus(void) {
-  TakeMutex();
-  uint32_t status = gLinkStatus;
-  int16_t tx_len = gTxData.dataSize;
-  int16_t rx_len = gRxData.dataSize;
-  FreeMutex();
+  LoRaStatusSnapshot_t snapshot;
+  LoRaStatusRead(&snapshot);
+  uint32_t status = snapshot.linkStatus;
   if (status & BIT_LORASTATUS_JOIN_PASS) {
-    if (rx_len >= 0) {
+    if (LoRaRxRingCount() > 0) {
       status |= BIT_LORASTATUS_RX_RDY;
     }
-    if (tx_len < 0) {
+    if ((snapshot.txLen < 0) && (snapshot.txQueued == 0)) {
       status |= BIT_LORASTATUS_TX_RDY;
     }
   }
@@ -1272,10 +2164,18 @@ void LoRaComponHwInit(void) { LoRaBoardInitMcu(); }
 int8_t LoRaComponStart(const char *aPid, const uint8_t *aPidHash, bool aWakeFromSleep) {
   //
   InitMutex();
+  InitTxOpportunity();
+  InitSleepSave();
+  LoRaTxQueueInit();
+  InitRxRing();
+  LoRaStatusInit();
 
   //
   LoRaDataInit();
   LoRaDataReadSettings(&gLoRaSettings);
+  if (LORAWAN_NVM_PERSIST) {
+    LoRaNvmInit();
+  }
 
   // PID
   strncpy(gLoRaPreservedData.provisionId, aPid, sizeof(gLoRaPreservedData.provisionId));
@@ -1297,10 +2197,18 @@ int8_t LoRaComponStart(const char *aPid, const uint8_t *aPidHash, bool aWakeFrom
 int8_t LoRaComponStart2(const char *aPid, const uint8_t *aPidHash, bool aWakeFromSleep, bool aHoldProvisioning) {
   //
   InitMutex();
+  InitTxOpportunity();
+  InitSleepSave();
+  LoRaTxQueueInit();
+  InitRxRing();
+  LoRaStatusInit();
 
   //
   LoRaDataInit();
   LoRaDataReadSettings(&gLoRaSettings);
+  if (LORAWAN_NVM_PERSIST) {
+    LoRaNvmInit();
+  }
 
   // PID
   strncpy(gLoRaPreservedData.provisionId, aPid, sizeof(gLoRaPreservedData.provisionId));
@@ -1322,7 +2230,10 @@ int8_t LoRaComponStart2(const char *aPid, const uint8_t *aPidHash, bool aWakeFro
 //==========================================================================
 // End of LoRa task
 //==========================================================================
-void LoRaComponStop(void) { gLoRaTaskAbort = true; }
+void LoRaComponStop(void) {
+  gLoRaTaskAbort = true;
+  LoRaComponNotify(EVENT_NOTIF_APP);
+}
 
 //==========================================================================
 // Get the sub-GHz region name
@@ -1339,27 +2250,16 @@ const char *LoRaComponRegionName(void) {
   }
 }
 
-//==========================================================================
-// Send notification bit to task
-//==========================================================================
-// void LoRaComponNotify(uint32_t aEvent, void *aCallback) {
-//   OS_TASK_NOTIFY_FROM_ISR(gLoRaTaskHandle, aEvent, eSetBits);
-//   if (aCallback) {
-//     gp_loramac_cb = aCallback;
-//   }
-// }
-
 //==========================================================================
 // Is busy
 //==========================================================================
 bool LoRaComponIsBusy(void) {
   bool ret_busy = true;
-  LoraDevicState_t state;
-  TakeMutex();
-  state = gLoraLinkState;
-  FreeMutex();
+  LoRaStatusSnapshot_t snapshot;
+  LoRaStatusRead(&snapshot);
+  LoraDevicState_t state = (LoraDevicState_t)snapshot.linkState;
 
-  if (!LoRaMacIsBusy()) {
+  if (!snapshot.macBusy) {
     if ((state == S_LORALINK_WAITING) || (state == S_LORALINK_JOIN_WAIT) || (state == S_LORALINK_PROVISIONING_START)) {
       ret_busy = false;
     }
@@ -1372,24 +2272,23 @@ bool LoRaComponIsBusy(void) {
 //==========================================================================
 uint32_t LoRaComponGetWaitingTime(void) {
   uint32_t waiting_time = 0;
-  TakeMutex();
-  LoraDevicState_t state = gLoraLinkState;
-  int16_t tx_len = gTxData.dataSize;
-  FreeMutex();
-  if (!LoRaMacIsBusy()) {
+  LoRaStatusSnapshot_t snapshot;
+  LoRaStatusRead(&snapshot);
+  LoraDevicState_t state = (LoraDevicState_t)snapshot.linkState;
+  if (!snapshot.macBusy) {
     if (state == S_LORALINK_WAITING) {
-      if ((gTickLoraLink != 0) && (tx_len < 0)) {
+      if ((snapshot.linkTick != 0) && (snapshot.txLen < 0) && (snapshot.txQueued == 0)) {
         waiting_time = UINT32_MAX;
       }
     } else if ((state == S_LORALINK_JOIN_WAIT) || (state == S_LORALINK_PROVISIONING_START)) {
-      if (gLoRaLinkVar.joinInterval > 0) {
-        uint32_t elapsed = LoRaTickElapsed(gTickLoraLink);
-        if (elapsed < gLoRaLinkVar.joinInterval) {
-          waiting_time = gLoRaLinkVar.joinInterval - elapsed;
+      if (snapshot.joinInterval > 0) {
+        uint32_t elapsed = LoRaTickElapsed(snapshot.linkTick);
+        if (elapsed < snapshot.joinInterval) {
+          waiting_time = snapshot.joinInterval - elapsed;
         }
       }
     } else if (state == S_LORALINK_RETRY_WAITING) {
-      uint32_t elapsed = LoRaTickElapsed(gTickLoraLink);
+      uint32_t elapsed = LoRaTickElapsed(snapshot.linkTick);
       if (elapsed < LORAWAN_NOACK_RETRY_INTERVAL) {
         waiting_time = LORAWAN_NOACK_RETRY_INTERVAL - elapsed;
       }
@@ -1398,39 +2297,124 @@ uint32_t LoRaComponGetWaitingTime(void) {
   return waiting_time;
 }
 
+//==========================================================================
+// Earliest time an uplink of aLen bytes could be sent, and the airtime
+// left in the bands
+//==========================================================================
+int8_t LoRaComponGetTxOpportunity(uint16_t aLen, LoRaTxOpportunity_t *aInfo) {
+  LoRaMacTxOpportunity_t opportunity;
+  uint32_t link_wait;
+  int8_t result;
+
+  memset(aInfo, 0, sizeof(LoRaTxOpportunity_t));
+  if ((gLoRaTaskHandle == NULL) || (gTxOpportunityLock == NULL) || (aLen > LORAWAN_MAX_PAYLOAD_LEN)) {
+    return -1;
+  }
+  if (xSemaphoreTake(gTxOpportunityLock, TX_OPPORTUNITY_WAIT_TIME / portTICK_PERIOD_MS) != pdTRUE) {
+    return -1;
+  }
+  // Drop the answer to a caller that gave up
+  xSemaphoreTake(gTxOpportunityDone, 0);
+  TakeMutex();
+  gTxOpportunity.len = aLen;
+  gTxOpportunity.pending = true;
+  FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
+
+  bool answered = (xSemaphoreTake(gTxOpportunityDone, TX_OPPORTUNITY_WAIT_TIME / portTICK_PERIOD_MS) == pdTRUE);
+  TakeMutex();
+  gTxOpportunity.pending = false;
+  result = answered ? gTxOpportunity.result : -1;
+  memcpy(&opportunity, &gTxOpportunity.opportunity, sizeof(LoRaMacTxOpportunity_t));
+  FreeMutex();
+  xSemaphoreGive(gTxOpportunityLock);
+  if (result != 0) {
+    return -1;
+  }
+
+  // An idle link sends as soon as the data is given
+  link_wait = LoRaComponGetWaitingTime();
+  if (link_wait == UINT32_MAX) {
+    link_wait = 0;
+  }
+
+  aInfo->datarate = opportunity.Datarate;
+  aInfo->timeOnAirMs = opportunity.TimeOnAir;
+  aInfo->dwellTimeLeftMs = opportunity.DwellTimeLeft;
+  aInfo->txDelayMs = opportunity.TxDelay;
+  if ((aInfo->txDelayMs != TIMERTIME_T_MAX) && (aInfo->txDelayMs < link_wait)) {
+    aInfo->txDelayMs = link_wait;
+  }
+  for (uint8_t i = 0; (i < opportunity.NbBands) && (i < LORA_MAX_BANDS); i++) {
+    BandBudget_t *budget = &opportunity.Bands[i];
+    LoRaBandBudget_t *band = &aInfo->band[i];
+    band->band = budget->Band;
+    band->dutyCycle = budget->DCycle;
+    band->airTimeLeftMs = budget->TimeCredits / budget->DCycle;
+    band->maxAirTimeMs = budget->MaxTimeCredits / budget->DCycle;
+    band->windowLeftMs = budget->ObservationLeft;
+    band->usable = budget->Usable;
+    aInfo->bandCount++;
+  }
+  return 0;
+}
+
 //==========================================================================
 // Call before enter of sleep
 //==========================================================================
 void LoRaComponPrepareForSleep(bool aDeepSleep) {
   TakeMutex();
   gLoraLinkState = S_LORALINK_SLEEP;
+  PublishStatus();
   FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
 
   if (aDeepSleep) {
-    if (LoRaMacQueryMacCommandsSize() > 0) {
+    // The TX queue is not kept in deep sleep, its frames are dropped. A
+    // busy MAC still uses the slot of an in place frame, then it is kept
+    // and no blank frame is sent.
+    TakeMutex();
+    uint16_t dropped = LoRaTxQueueDropQueued();
+    bool blank_frame = (!LoRaMacIsBusy()) && (LoRaMacQueryMacCommandsSize() > 0);
+    if (blank_frame) {
       // Send a blank frame if some MAC command is waiting to send
       gLinkStatus &= ~(BIT_LORASTATUS_SEND_PASS | BIT_LORASTATUS_SEND_FAIL);
+      EndTxFrame();
       gTxData.data[0] = 0;
       gTxData.dataSize = 1;
       gTxData.port = LORAWAN_FPORT_DATA;
       gTxData.retry = 0;
+      gTxData.confirmed = gLoRaLinkVar.txConfirmed;
+      gTxData.autoConfirm = true;
       gTickLoraLink = 0;
+    }
+    PublishStatus();
+    FreeMutex();
+    if (dropped > 0) {
+      LORACOMPON_PRINTLINE("%u queued frames dropped for deep sleep.", dropped);
+    }
+    if (blank_frame) {
       LORACOMPON_PRINTLINE("Send a blank frame.");
-      if (sendFrame() >= 0) {
+      if (sendFrame() == 0) {
         vTaskDelay(2000 / portTICK_PERIOD_MS);
       }
     }
 
-    // Save data to preserve area
-    MibRequestConfirm_t mibReq;
-    mibReq.Type = MIB_NVM_CTXS;
-    if (LoRaMacMibGetRequestConfirm(&mibReq) == LORAMAC_STATUS_OK) {
-      gLoRaPreservedData.magicCode = VALUE_PRESERVED_DATA_MAGIC_CODE;
-      memcpy(&gLoRaPreservedData.contexts, mibReq.Param.Contexts, sizeof(LoRaMacNvmData_t));
-      memcpy(&gLoRaPreservedData.linkVar, &gLoRaLinkVar, sizeof(LoRaLinkVar_t));
-      gLoRaPreservedDataCrc =
-          LoRaCrc16Ccitt(VALUE_PRESERVED_DATA_CRC_IV, (const uint8_t *)&gLoRaPreservedData, sizeof(gLoRaPreservedData));
-      LORACOMPON_PRINTLINE("Preserved Data CRC=%04X", gLoRaPreservedDataCrc);
+    // Save data to preserve area, on the LoRa task while it runs
+    if ((gLoRaTaskHandle != NULL) && (gSleepSaveDone != NULL)) {
+      xSemaphoreTake(gSleepSaveDone, 0);
+      TakeMutex();
+      gSleepSavePending = true;
+      FreeMutex();
+      LoRaComponNotify(EVENT_NOTIF_APP);
+      if (xSemaphoreTake(gSleepSaveDone, SLEEP_SAVE_WAIT_TIME / portTICK_PERIOD_MS) != pdTRUE) {
+        TakeMutex();
+        gSleepSavePending = false;
+        FreeMutex();
+        printf("ERROR. MAC contexts not saved for sleep.\n");
+      }
+    } else {
+      SaveForDeepSleep();
     }
   }
 
@@ -1447,19 +2431,23 @@ void LoRaComponResumeFromSleep(void) {
   LoRaBoardResumeFromSleep();
   TakeMutex();
   gLoraLinkState = S_LORALINK_WAKEUP;
+  PublishStatus();
   FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
 }
 
 //==========================================================================
-// Check ready for send data
+// Check ready for send data. True when the TX queue has space.
 //==========================================================================
 bool LoRaComponIsTxReady(void) {
-  uint32_t status = GetStatus();
-  if ((status & BIT_LORASTATUS_JOIN_PASS) == 0) {
+  LoRaStatusSnapshot_t snapshot;
+  LoRaStatusRead(&snapshot);
+  if ((snapshot.linkStatus & BIT_LORASTATUS_JOIN_PASS) == 0) {
     LORACOMPON_PRINTLINE("Not join");
     return false;
-  } else if ((status & BIT_LORASTATUS_TX_RDY) == 0) {
-    LORACOMPON_PRINTLINE("Last TX in progress");
+  }
+  if (snapshot.txFull) {
+    LORACOMPON_PRINTLINE("TX queue full");
     return false;
   } else {
     return true;
@@ -1470,30 +2458,93 @@ bool LoRaComponIsTxReady(void) {
 // Send Data
 //==========================================================================
 int8_t LoRaComponSendData(const uint8_t *aData, uint16_t aLen) {
-  // MibRequestConfirm_t mibReq;
-  // mibReq.Type = MIB_CHANNELS_MASK;
-  // LoRaMacMibGetRequestConfirm(&mibReq);
-  // LORACOMPON_PRINTLINE("  Mask: %04X %04X %04X %04X %04X %04X", mibReq.Param.ChannelsDefaultMask[0],
-  //                     mibReq.Param.ChannelsDefaultMask[1], mibReq.Param.ChannelsDefaultMask[2],
-  //                     mibReq.Param.ChannelsDefaultMask[3], mibReq.Param.ChannelsDefaultMask[4],
-  //                     mibReq.Param.ChannelsDefaultMask[5]);
-
-  if (!LoRaComponIsTxReady()) {
+  return LoRaComponEnqueueData(aData, aLen, LORAWAN_FPORT_DATA, LORA_TX_MODE_DEFAULT, LORA_TX_PRIORITY_NORMAL);
+}
+
+//==========================================================================
+// Add a frame to the TX queue, sent by loraTask when the link allows.
+// When the queue is full, the lowest priority frame is dropped if it has
+// a lower priority than the new one.
+//==========================================================================
+int8_t LoRaComponEnqueueData(const uint8_t *aData, uint16_t aLen, uint8_t aPort, LoRaTxMode_t aMode, uint8_t aPriority) {
+  if ((GetStatus() & BIT_LORASTATUS_JOIN_PASS) == 0) {
+    LORACOMPON_PRINTLINE("Not join");
     return -1;
   } else if (aLen > LORAWAN_MAX_PAYLOAD_LEN) {
     // Tx data too large
     return -1;
-  } else {
-    TakeMutex();
+  }
+
+  TakeMutex();
+  if ((gTxData.dataSize < 0) && (LoRaTxQueueCount() == 0)) {
+    // Link idle, clear the result of the last frame
     gLinkStatus &= ~(BIT_LORASTATUS_SEND_PASS | BIT_LORASTATUS_SEND_FAIL);
-    memcpy(gTxData.data, aData, aLen);
-    gTxData.dataSize = aLen;
-    gTxData.port = LORAWAN_FPORT_DATA;
-    gTxData.retry = 0;
     gTickLoraLink = 0;
-    FreeMutex();
-    return 0;
   }
+  int8_t ret = LoRaTxQueuePush(aData, aLen, aPort, (uint8_t)aMode, aPriority);
+  PublishStatus();
+  FreeMutex();
+  if (ret < 0) {
+    LORACOMPON_PRINTLINE("TX queue full, frame dropped");
+    return -1;
+  }
+  LoRaComponNotify(EVENT_NOTIF_APP);
+  return 0;
+}
+
+//==========================================================================
+// Zero-copy send. The application writes the payload to the reserved
+// buffer and commits it, the frame is built and sent in that buffer.
+// Reserving again before the commit returns the same buffer. A commit
+// with aLen 0 cancels the reservation.
+//==========================================================================
+uint8_t *LoRaComponReserveTxBuffer(void) {
+  if ((GetStatus() & BIT_LORASTATUS_JOIN_PASS) == 0) {
+    LORACOMPON_PRINTLINE("Not join");
+    return NULL;
+  }
+
+  TakeMutex();
+  uint8_t *buffer = LoRaTxQueueReserve();
+  PublishStatus();
+  FreeMutex();
+  if (buffer == NULL) {
+    LORACOMPON_PRINTLINE("TX queue full");
+  }
+  return buffer;
+}
+
+int8_t LoRaComponCommitTxBuffer(uint16_t aLen, uint8_t aPort, LoRaTxMode_t aMode, uint8_t aPriority) {
+  TakeMutex();
+  if ((gTxData.dataSize < 0) && (LoRaTxQueueCount() == 0)) {
+    // Link idle, clear the result of the last frame
+    gLinkStatus &= ~(BIT_LORASTATUS_SEND_PASS | BIT_LORASTATUS_SEND_FAIL);
+    gTickLoraLink = 0;
+  }
+  int8_t ret = LoRaTxQueueCommit(aLen, aPort, (uint8_t)aMode, aPriority);
+  PublishStatus();
+  FreeMutex();
+  if (ret < 0) {
+    return -1;
+  }
+  LoRaComponNotify(EVENT_NOTIF_APP);
+  return 0;
+}
+
+//==========================================================================
+// TX queue status
+//==========================================================================
+uint16_t LoRaComponGetTxQueueDepth(void) {
+  TakeMutex();
+  uint16_t depth = LoRaTxQueueCount();
+  FreeMutex();
+  return depth;
+}
+
+void LoRaComponGetTxQueueStats(LoRaTxQueueStats_t *aStats) {
+  TakeMutex();
+  LoRaTxQueueGetStats(aStats);
+  FreeMutex();
 }
 
 //==========================================================================
@@ -1519,25 +2570,75 @@ int32_t LoRaComponGetData(uint8_t *aData, uint16_t aDataSize, LoRaRxInfo_t *aInf
     return -1;
   } else {
     int32_t len;
-    TakeMutex();
-    if (aDataSize < gRxData.dataSize) {
+    const LoRaRxView_t *view = LoRaRxRingPeek();
+    if (view == NULL) {
+      return -1;
+    }
+    if (aDataSize < view->dataSize) {
       len = aDataSize;
     } else {
-      len = gRxData.dataSize;
+      len = view->dataSize;
     }
-    memcpy(aData, gRxData.data, len);
+    memcpy(aData, view->data, len);
+    FrameCopyCountRx(len);
     if (aInfo != NULL) {
-      aInfo->fport = gRxData.port;
-      aInfo->rssi = gLastRxRssi;
-      aInfo->datarate = gLastRxDatarate;
+      memcpy(aInfo, &view->info, sizeof(LoRaRxInfo_t));
     }
-    gRxData.dataSize = -1;
-    FreeMutex();
+    RadioRxBufferRelease(view->data);
+    LoRaRxRingRelease();
 
     return len;
   }
 }
 
+//==========================================================================
+// Get received data without a copy. The view points into the radio RX
+// buffer, which is held until LoRaComponReleaseData(). Release the frames
+// soon, only a few buffers can be held.
+// Return: 0 - OK, -1 - no data
+//==========================================================================
+int8_t LoRaComponBorrowData(LoRaRxView_t *aView) {
+  if (!LoRaComponIsRxReady()) {
+    return -1;
+  }
+  const LoRaRxView_t *view = LoRaRxRingPeek();
+  if (view == NULL) {
+    return -1;
+  }
+  memcpy(aView, view, sizeof(LoRaRxView_t));
+  LoRaRxRingRelease();
+  return 0;
+}
+
+void LoRaComponReleaseData(const LoRaRxView_t *aView) {
+  if ((aView != NULL) && (aView->data != NULL)) {
+    RadioRxBufferRelease(aView->data);
+  }
+}
+
+//==========================================================================
+// Push received frames to a callback or a queue instead of the
+// internal buffer. The queue item size must be sizeof(LoRaRxFrame_t).
+// Set NULL to go back to polling with LoRaComponGetData().
+//==========================================================================
+void LoRaComponSetRxCallback(LoRaRxCallback_t aCallback, void *aArg) {
+  TakeMutex();
+  gRxCallbackArg = aArg;
+  gRxCallback = aCallback;
+  FreeMutex();
+}
+
+void LoRaComponSetRxQueue(QueueHandle_t aQueue) {
+  TakeMutex();
+  gRxQueue = aQueue;
+  FreeMutex();
+}
+
+//==========================================================================
+// Number of received frames dropped because the buffer or queue was full
+//==========================================================================
+uint32_t LoRaComponGetRxOverflowCount(void) { return LoRaRxRingOverflowCount(); }
+
 //==========================================================================
 // Set datarate
 //==========================================================================
@@ -1585,6 +2686,61 @@ bool LoRaComponIsSendDone(void) { return ((GetStatus() & BIT_LORASTATUS_TX_RDY)
 
 bool LoRaComponIsIsm2400(void) { return gLoRaLinkVar.usingIsm2400; }
 
+//==========================================================================
+// Use the ISM2400 or the sub-GHz radio from the next frame on. With
+// LORAWAN_DUAL_CONTEXT each radio keeps its session, it joins only if it
+// has none.
+//==========================================================================
+int8_t LoRaComponSelectRadio(bool aIsm2400) {
+  if ((!LORAWAN_DUAL_CONTEXT) || (gLoRaTaskHandle == NULL)) {
+    return -1;
+  }
+  TakeMutex();
+  gRadioRequest = aIsm2400 ? 1 : 0;
+  FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
+  return 0;
+}
+
+//==========================================================================
+// Choose the radio of each frame by its link model. Needs
+// LORAWAN_LINK_SELECT, a radio given by LoRaComponSelectRadio() is kept
+// until the next frame only.
+//==========================================================================
+void LoRaComponSetLinkSelect(bool aEnable) {
+  TakeMutex();
+  gLinkSelectOn = (LORAWAN_LINK_SELECT) && (aEnable);
+  FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
+}
+
+//==========================================================================
+// Send the join requests on both radios in turn while neither has a
+// session. Needs LORAWAN_PARALLEL_JOIN.
+//==========================================================================
+void LoRaComponSetParallelJoin(bool aEnable) {
+  TakeMutex();
+  gParallelJoinOn = (LORAWAN_PARALLEL_JOIN) && (aEnable);
+  FreeMutex();
+  LoRaComponNotify(EVENT_NOTIF_APP);
+}
+
+//==========================================================================
+// Link model of both radios for a frame of aLen bytes. The costs of a
+// radio are those of its last frame.
+//==========================================================================
+int8_t LoRaComponGetLinkModel(uint16_t aLen, LoRaLinkModel_t *aModel) {
+  memset(aModel, 0, sizeof(LoRaLinkModel_t));
+  if ((!LORAWAN_LINK_SELECT) || (gLoRaTaskHandle == NULL) || (aLen > LORAWAN_MAX_PAYLOAD_LEN)) {
+    return -1;
+  }
+  TakeMutex();
+  LoRaLinkSelGetModel(gLoRaLinkVar.usingIsm2400 ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ, aLen, aModel);
+  aModel->enabled = gLinkSelectOn;
+  FreeMutex();
+  return 0;
+}
+
 //==========================================================================
 // Settings
 //==========================================================================
@@ -1607,6 +2763,9 @@ void LoRaComponResetSettings(void) {
   }
   LoRaDataResetToDefault();
   LoRaDataReadSettings(&gLoRaSettings);
+  if (LORAWAN_NVM_PERSIST) {
+    LoRaNvmErase();
+  }
 }
 
 //==========================================================================
@@ -1627,4 +2786,5 @@ void LoRaComponProceedProvisioning(void) {
     gHoldProvisioning = false;
     FreeMutex();
   }
+  LoRaComponNotify(EVENT_NOTIF_APP);
 }
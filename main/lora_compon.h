@@ -7,6 +7,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "sdkconfig.h"
 
 //==========================================================================
@@ -28,8 +30,105 @@ typedef struct {
     uint8_t fport;
     int16_t rssi;
     int16_t datarate;
+    int8_t snr;
+    uint8_t rxSlot;     // LoRaMacRxSlot_t
+    bool multicast;
 }LoRaRxInfo_t;
 
+typedef struct {
+    LoRaRxInfo_t info;
+    uint16_t dataSize;
+    uint8_t data[LORAWAN_MAX_PAYLOAD_LEN];
+}LoRaRxFrame_t;
+
+// Received frame lent by LoRaComponBorrowData(). data points into the
+// radio RX buffer and is valid until LoRaComponReleaseData().
+typedef struct {
+    LoRaRxInfo_t info;
+    uint16_t dataSize;
+    const uint8_t *data;
+}LoRaRxView_t;
+
+// Called from the LoRa task for each received frame
+typedef void (*LoRaRxCallback_t)(const LoRaRxFrame_t *aFrame, void *aArg);
+
+// Uplink frame type
+typedef enum {
+    LORA_TX_MODE_DEFAULT = 0,   // Follow LORAWAN_UNCONFIRMED_COUNT
+    LORA_TX_MODE_CONFIRMED,
+    LORA_TX_MODE_UNCONFIRMED,
+}LoRaTxMode_t;
+
+// Uplink priority, higher value is sent first
+#define LORA_TX_PRIORITY_LOW 0
+#define LORA_TX_PRIORITY_NORMAL 128
+#define LORA_TX_PRIORITY_HIGH 255
+
+typedef struct {
+    uint16_t depth;
+    uint16_t capacity;
+    uint16_t maxDepth;
+    uint32_t enqueued;
+    uint32_t dropped;
+    uint32_t sent;
+    uint32_t failed;
+}LoRaTxQueueStats_t;
+
+// Airtime budget of a band over the duty cycle observation window [ms]
+#define LORA_MAX_BANDS 6
+
+typedef struct {
+    uint8_t band;
+    uint16_t dutyCycle;         // 1/dutyCycle of the time may be used
+    uint32_t airTimeLeftMs;     // Airtime left until windowLeftMs
+    uint32_t maxAirTimeMs;      // Airtime of a whole window
+    uint32_t windowLeftMs;      // Time until the airtime is refilled
+    bool usable;                // A channel of the band takes the current datarate
+}LoRaBandBudget_t;
+
+// Next transmit opportunity of an uplink, UINT32_MAX when never
+typedef struct {
+    int8_t datarate;
+    uint32_t timeOnAirMs;
+    uint32_t txDelayMs;
+    uint32_t dwellTimeLeftMs;
+    uint8_t bandCount;
+    LoRaBandBudget_t band[LORA_MAX_BANDS];
+}LoRaTxOpportunity_t;
+
+// Link model of each radio, see LoRaComponGetLinkModel()
+#define LORA_LINK_SUBGHZ 0
+#define LORA_LINK_ISM2400 1
+#define LORA_LINK_RADIOS 2
+
+typedef struct {
+    bool known;                 // Costs learned while the radio was in use
+    bool session;               // Joined, sends without a new join
+    int16_t rssi;               // Smoothed downlink RSSI [dBm]
+    int8_t snr;                 // Smoothed downlink SNR [dB]
+    int8_t snrMargin;           // SNR above the demodulation floor of the downlink SF [dB]
+    uint32_t downlinks;
+    uint32_t attempts;          // Confirmed uplinks sent, retries included
+    uint32_t acks;
+    uint16_t ackRatio;          // Smoothed ACKs per attempt, per mille
+    uint16_t delivery;          // Expected ACKs per attempt, per mille
+    uint16_t frameDelivery;     // Expected frames ACKed within their retries, per mille
+    int8_t txPowerDbm;
+    uint32_t timeOnAirMs;       // Frame of the asked length at the datarate of the radio
+    uint32_t energyUj;          // Time on air x TX power per delivered frame, UINT32_MAX when unknown
+    uint32_t energyPerByteNj;
+    uint32_t txDelayMs;         // Duty cycle wait before the radio may send
+    uint32_t airTimeLeftMs;     // Airtime left in the bands the datarate can use
+}LoRaLinkRadio_t;
+
+typedef struct {
+    bool enabled;               // LoRaComponSetLinkSelect()
+    uint8_t selected;           // LORA_LINK_*, the radio in use
+    uint32_t switches;          // Changes of radio by the selection
+    uint32_t probes;            // Frames sent on the other radio to refresh its model
+    LoRaLinkRadio_t radio[LORA_LINK_RADIOS];
+}LoRaLinkModel_t;
+
 //==========================================================================
 //==========================================================================
 void LoRaComponHwInit(void);
@@ -38,7 +137,6 @@ int8_t LoRaComponStart(const char *aPid, const uint8_t *aPidHash, bool aWakeFrom
 int8_t LoRaComponStart2(const char *aPid, const uint8_t *aPidHash, bool aWakeFromSleep, bool aHoldProvisioning);
 void LoRaComponStop(void);
 const char *LoRaComponRegionName(void);
-//void LoRaComponNotify(uint32_t aEvent, void *aCallback);
 
 bool LoRaComponIsBusy(void);
 uint32_t LoRaComponGetWaitingTime(void);
@@ -47,9 +145,21 @@ void LoRaComponResumeFromSleep(void);
 
 bool LoRaComponIsTxReady(void);
 int8_t LoRaComponSendData(const uint8_t *aData, uint16_t aLen);
+int8_t LoRaComponEnqueueData(const uint8_t *aData, uint16_t aLen, uint8_t aPort, LoRaTxMode_t aMode, uint8_t aPriority);
+// Zero-copy send: fill the reserved buffer, up to LORAWAN_MAX_PAYLOAD_LEN bytes, then commit it
+uint8_t *LoRaComponReserveTxBuffer(void);
+int8_t LoRaComponCommitTxBuffer(uint16_t aLen, uint8_t aPort, LoRaTxMode_t aMode, uint8_t aPriority);
+uint16_t LoRaComponGetTxQueueDepth(void);
+void LoRaComponGetTxQueueStats(LoRaTxQueueStats_t *aStats);
+int8_t LoRaComponGetTxOpportunity(uint16_t aLen, LoRaTxOpportunity_t *aInfo);
 
 bool LoRaComponIsRxReady(void);
 int32_t LoRaComponGetData(uint8_t *aData, uint16_t aDataSize, LoRaRxInfo_t *aInfo);
+int8_t LoRaComponBorrowData(LoRaRxView_t *aView);
+void LoRaComponReleaseData(const LoRaRxView_t *aView);
+void LoRaComponSetRxCallback(LoRaRxCallback_t aCallback, void *aArg);
+void LoRaComponSetRxQueue(QueueHandle_t aQueue);
+uint32_t LoRaComponGetRxOverflowCount(void);
 
 void LoRaComponSetDatarate(int8_t aValue);
 
@@ -61,6 +171,10 @@ bool LoRaComponIsJoined(void);
 bool LoRaComponIsSendDone(void);
 bool LoRaComponIsSendSuccess(void);
 bool LoRaComponIsIsm2400(void);
+int8_t LoRaComponSelectRadio(bool aIsm2400);
+void LoRaComponSetLinkSelect(bool aEnable);
+void LoRaComponSetParallelJoin(bool aEnable);
+int8_t LoRaComponGetLinkModel(uint16_t aLen, LoRaLinkModel_t *aModel);
 
 int8_t LoRaComponGetSettings(LoRaSettings_t *aSettings);
 void LoRaComponResetSettings(void);
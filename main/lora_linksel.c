@@ -0,0 +1,328 @@
+//==========================================================================
+// Radio selection by link quality
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "lora_linksel.h"
+
+#include <string.h>
+
+#include "timer.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+// Smoothing of the ACK ratio and the downlink quality, 1/n of a new sample
+#define LINK_SMOOTHING 4
+// The ACK ratio counts as this many samples at most, against the SNR
+#define LINK_ACK_WEIGHT_MAX 8
+// A downlink counts as this many samples, one less per unanswered attempt
+#define LINK_SNR_WEIGHT 4
+
+#define LINK_DELIVERY_PRIOR 500
+#define LINK_DELIVERY_MIN 10
+#define LINK_DELIVERY_MAX 980
+// Per mille of delivery per dB of SNR margin, 500 at no margin
+#define LINK_DELIVERY_PER_DB 90
+
+// Per mille of frames that must get an ACK within their attempts, a radio
+// below is only used if the other one is below as well
+#define LINK_FRAME_DELIVERY_MIN 900
+
+// The other radio must save 1/n of the energy to switch
+#define LINK_HYSTERESIS 8
+// A probe without ACK doubles the interval, up to this factor
+#define LINK_PROBE_BACKOFF_MAX 8
+
+// Q4 fixed point of the smoothed RSSI and SNR
+#define Q4(x) ((x) * 16)
+
+//==========================================================================
+// Variables
+//==========================================================================
+typedef struct {
+  bool known;
+  bool session;
+  LoRaLinkCost_t cost;
+  uint32_t costTick;
+  int32_t rssiQ4;
+  int32_t snrQ4;
+  int32_t marginQ4;
+  uint8_t snrWeight;
+  uint32_t downlinks;
+  uint32_t attempts;
+  uint32_t acks;
+  uint16_t ackRatio;
+  uint32_t lastUse;  // gLinkFrames when last chosen
+  uint32_t probeInterval;
+} LinkRadio_t;
+
+static LinkRadio_t gLinkRadio[LORA_LINK_RADIOS];
+static uint32_t gLinkFrames;
+static uint32_t gLinkSwitches;
+static uint32_t gLinkProbes;
+static uint8_t gLinkFrameAttempts;
+
+// uW of 0 to 9 dBm
+static const uint16_t kDbmMicroWatt[10] = {1000, 1259, 1585, 1995, 2512, 3162, 3981, 5012, 6310, 7943};
+
+//==========================================================================
+//==========================================================================
+static uint32_t DbmToMicroWatt(int8_t aDbm) {
+  int16_t dbm = aDbm;
+  uint32_t uw;
+  int8_t decades = 0;
+
+  while (dbm < 0) {
+    dbm += 10;
+    decades--;
+  }
+  decades += dbm / 10;
+  uw = kDbmMicroWatt[dbm % 10];
+  for (; decades > 0; decades--) {
+    uw *= 10;
+  }
+  for (; decades < 0; decades++) {
+    uw /= 10;
+  }
+  return uw;
+}
+
+static void Smooth(int32_t *aValue, int32_t aSample) { *aValue += (aSample - *aValue) / LINK_SMOOTHING; }
+
+static uint32_t GetTimeOnAirUs(const LinkRadio_t *aRadio, uint16_t aLen) {
+  return aRadio->cost.timeOnAirUs + aRadio->cost.timeOnAirByteUs * aLen;
+}
+
+//==========================================================================
+// Expected ACKs per attempt, per mille
+//==========================================================================
+static uint16_t GetDelivery(const LinkRadio_t *aRadio) {
+  uint32_t ack_weight = (aRadio->attempts < LINK_ACK_WEIGHT_MAX) ? aRadio->attempts : LINK_ACK_WEIGHT_MAX;
+  int32_t snr_delivery = LINK_DELIVERY_PRIOR + (aRadio->marginQ4 * LINK_DELIVERY_PER_DB) / Q4(1);
+
+  if (snr_delivery < LINK_DELIVERY_MIN) {
+    snr_delivery = LINK_DELIVERY_MIN;
+  } else if (snr_delivery > LINK_DELIVERY_MAX) {
+    snr_delivery = LINK_DELIVERY_MAX;
+  }
+  if (ack_weight + aRadio->snrWeight == 0) {
+    return LINK_DELIVERY_PRIOR;
+  }
+  uint32_t delivery =
+      (ack_weight * aRadio->ackRatio + aRadio->snrWeight * snr_delivery) / (ack_weight + aRadio->snrWeight);
+  return (delivery < LINK_DELIVERY_MIN) ? LINK_DELIVERY_MIN : delivery;
+}
+
+//==========================================================================
+// Per mille of frames ACKed within gLinkFrameAttempts attempts
+//==========================================================================
+static uint16_t GetFrameDelivery(const LinkRadio_t *aRadio) {
+  uint32_t lost = 1000;
+
+  for (uint8_t i = 0; i < gLinkFrameAttempts; i++) {
+    lost = lost * (1000 - GetDelivery(aRadio)) / 1000;
+  }
+  return 1000 - lost;
+}
+
+//==========================================================================
+// TX energy per delivered frame [uJ], UINT32_MAX when unknown
+//==========================================================================
+static uint32_t GetEnergy(const LinkRadio_t *aRadio, uint16_t aLen) {
+  if (!aRadio->known) {
+    return UINT32_MAX;
+  }
+  uint64_t attempt_pj = (uint64_t)GetTimeOnAirUs(aRadio, aLen) * DbmToMicroWatt(aRadio->cost.txPowerDbm);
+  uint64_t energy = attempt_pj / GetDelivery(aRadio) / 1000;
+  return (energy < UINT32_MAX) ? (uint32_t)energy : UINT32_MAX - 1;
+}
+
+//==========================================================================
+// Duty cycle wait and airtime left of the cost snapshot, aged to now
+//==========================================================================
+static uint32_t GetTxDelay(const LinkRadio_t *aRadio, uint16_t aLen, uint32_t *aAirTimeLeft) {
+  uint32_t elapsed = LoRaTickElapsed(aRadio->costTick);
+  uint32_t delay = aRadio->cost.txDelayMs;
+  uint32_t air_left = aRadio->cost.airTimeLeftMs;
+  uint32_t window_left = aRadio->cost.windowLeftMs;
+
+  if (!aRadio->known) {
+    *aAirTimeLeft = 0;
+    return 0;
+  }
+  if (delay == UINT32_MAX) {
+    *aAirTimeLeft = air_left;
+    return delay;
+  }
+  delay = (delay > elapsed) ? delay - elapsed : 0;
+  if ((window_left != 0) && (elapsed >= window_left)) {
+    // A new window has started since
+    air_left = aRadio->cost.maxAirTimeMs;
+    window_left = 0;
+  } else if (window_left != 0) {
+    window_left -= elapsed;
+  }
+  // Not enough airtime left, wait for the next window
+  if ((air_left * 1000 < GetTimeOnAirUs(aRadio, aLen)) && (delay < window_left)) {
+    delay = window_left;
+  }
+  *aAirTimeLeft = air_left;
+  return delay;
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaLinkSelInit(uint8_t aFrameAttempts) {
+  memset(gLinkRadio, 0, sizeof(gLinkRadio));
+  for (uint8_t i = 0; i < LORA_LINK_RADIOS; i++) {
+    gLinkRadio[i].ackRatio = LINK_DELIVERY_PRIOR;
+    // A radio not used yet is probed at the first frame
+    gLinkRadio[i].probeInterval = 1;
+  }
+  gLinkFrames = 0;
+  gLinkSwitches = 0;
+  gLinkProbes = 0;
+  gLinkFrameAttempts = aFrameAttempts;
+}
+
+void LoRaLinkSelSetCost(uint8_t aRadio, const LoRaLinkCost_t *aCost) {
+  LinkRadio_t *radio = &gLinkRadio[aRadio];
+
+  radio->cost = *aCost;
+  radio->costTick = LoRaGetTick();
+  radio->known = true;
+}
+
+void LoRaLinkSelSetSession(uint8_t aRadio, bool aSession) {
+  if ((aSession) && (!gLinkRadio[aRadio].session)) {
+    gLinkRadio[aRadio].probeInterval = LORA_LINK_PROBE_INTERVAL;
+  }
+  gLinkRadio[aRadio].session = aSession;
+}
+
+bool LoRaLinkSelHasSession(uint8_t aRadio) { return gLinkRadio[aRadio].session; }
+
+//==========================================================================
+// The margin is taken against the demodulation floor of the LoRa SF,
+// -7.5 dB at SF7 and 2.5 dB lower per SF
+//==========================================================================
+void LoRaLinkSelAddDownlink(uint8_t aRadio, int16_t aRssi, int8_t aSnr, uint8_t aSf) {
+  LinkRadio_t *radio = &gLinkRadio[aRadio];
+  int32_t margin_q4 = Q4(aSnr) + ((aSf != 0) ? Q4(5 * aSf - 20) / 2 : 0);
+
+  if (radio->downlinks == 0) {
+    radio->rssiQ4 = Q4(aRssi);
+    radio->snrQ4 = Q4(aSnr);
+    radio->marginQ4 = margin_q4;
+  } else {
+    Smooth(&radio->rssiQ4, Q4(aRssi));
+    Smooth(&radio->snrQ4, Q4(aSnr));
+    Smooth(&radio->marginQ4, margin_q4);
+  }
+  radio->downlinks++;
+  radio->snrWeight = LINK_SNR_WEIGHT;
+}
+
+void LoRaLinkSelAddAttempt(uint8_t aRadio, bool aAcked) {
+  LinkRadio_t *radio = &gLinkRadio[aRadio];
+  int32_t ratio = radio->ackRatio;
+
+  radio->attempts++;
+  if (aAcked) {
+    radio->acks++;
+    radio->probeInterval = LORA_LINK_PROBE_INTERVAL;
+  } else if (radio->snrWeight > 0) {
+    // The last downlink tells less about a link that stopped answering
+    radio->snrWeight--;
+  }
+  Smooth(&ratio, aAcked ? 1000 : 0);
+  radio->ackRatio = (uint16_t)ratio;
+}
+
+//==========================================================================
+//==========================================================================
+uint8_t LoRaLinkSelChoose(uint8_t aCurrent, uint16_t aLen) {
+  uint8_t other = (aCurrent == LORA_LINK_SUBGHZ) ? LORA_LINK_ISM2400 : LORA_LINK_SUBGHZ;
+  LinkRadio_t *current = &gLinkRadio[aCurrent];
+  LinkRadio_t *alternative = &gLinkRadio[other];
+  uint32_t air_left;
+  uint8_t choice = aCurrent;
+
+  gLinkFrames++;
+  uint32_t current_delay = GetTxDelay(current, aLen, &air_left);
+  uint32_t other_delay = GetTxDelay(alternative, aLen, &air_left);
+
+  if ((gLinkFrames - alternative->lastUse >= alternative->probeInterval) && (other_delay <= LORA_LINK_MAX_TX_DELAY)) {
+    // Unused for long, or never used
+    if (alternative->probeInterval < LORA_LINK_PROBE_INTERVAL * LINK_PROBE_BACKOFF_MAX) {
+      alternative->probeInterval *= 2;
+    }
+    gLinkProbes++;
+    choice = other;
+  } else if (alternative->known) {
+    uint32_t current_energy = GetEnergy(current, aLen);
+    uint32_t other_energy = GetEnergy(alternative, aLen);
+    bool current_delivers = (GetFrameDelivery(current) >= LINK_FRAME_DELIVERY_MIN);
+    bool other_delivers = (GetFrameDelivery(alternative) >= LINK_FRAME_DELIVERY_MIN);
+    if (current_delay > LORA_LINK_MAX_TX_DELAY) {
+      if (other_delay < current_delay) {
+        choice = other;
+      }
+    } else if (other_delay <= LORA_LINK_MAX_TX_DELAY) {
+      if ((other_delivers) && (!current_delivers)) {
+        choice = other;
+      } else if ((other_delivers == current_delivers) &&
+                 ((uint64_t)other_energy * LINK_HYSTERESIS < (uint64_t)current_energy * (LINK_HYSTERESIS - 1))) {
+        choice = other;
+      }
+    }
+  }
+
+  if (choice != aCurrent) {
+    gLinkSwitches++;
+  }
+  gLinkRadio[choice].lastUse = gLinkFrames;
+  return choice;
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaLinkSelGetModel(uint8_t aCurrent, uint16_t aLen, LoRaLinkModel_t *aModel) {
+  aModel->selected = aCurrent;
+  aModel->switches = gLinkSwitches;
+  aModel->probes = gLinkProbes;
+  for (uint8_t i = 0; i < LORA_LINK_RADIOS; i++) {
+    const LinkRadio_t *radio = &gLinkRadio[i];
+    LoRaLinkRadio_t *model = &aModel->radio[i];
+    model->known = radio->known;
+    model->session = radio->session;
+    model->rssi = radio->rssiQ4 / Q4(1);
+    model->snr = radio->snrQ4 / Q4(1);
+    model->snrMargin = radio->marginQ4 / Q4(1);
+    model->downlinks = radio->downlinks;
+    model->attempts = radio->attempts;
+    model->acks = radio->acks;
+    model->ackRatio = radio->ackRatio;
+    model->delivery = GetDelivery(radio);
+    model->frameDelivery = GetFrameDelivery(radio);
+    model->txPowerDbm = radio->cost.txPowerDbm;
+    model->timeOnAirMs = (GetTimeOnAirUs(radio, aLen) + 500) / 1000;
+    model->energyUj = GetEnergy(radio, aLen);
+    model->energyPerByteNj = UINT32_MAX;
+    if ((model->energyUj != UINT32_MAX) && (aLen > 0)) {
+      model->energyPerByteNj = (uint32_t)((uint64_t)model->energyUj * 1000 / aLen);
+    }
+    model->txDelayMs = GetTxDelay(radio, aLen, &model->airTimeLeftMs);
+  }
+}
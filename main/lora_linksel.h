@@ -0,0 +1,63 @@
+//==========================================================================
+//==========================================================================
+#ifndef INC_LORA_LINKSEL_H
+#define INC_LORA_LINKSEL_H
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lora_compon.h"
+
+//==========================================================================
+//==========================================================================
+#if defined(CONFIG_LORAWAN_LINK_PROBE_INTERVAL)
+#define LORA_LINK_PROBE_INTERVAL CONFIG_LORAWAN_LINK_PROBE_INTERVAL
+#else
+#define LORA_LINK_PROBE_INTERVAL 16
+#endif
+
+// A radio waiting longer for its duty cycle is skipped if the other one
+// can send sooner
+#define LORA_LINK_MAX_TX_DELAY 30000
+
+// Costs of a radio, taken from its MAC context while it is in use
+typedef struct {
+  uint32_t timeOnAirUs;      // Frame without application payload
+  uint32_t timeOnAirByteUs;  // Per byte of application payload
+  int8_t txPowerDbm;
+  uint32_t txDelayMs;
+  uint32_t airTimeLeftMs;  // In the bands the datarate can use
+  uint32_t windowLeftMs;   // Until the airtime is refilled
+  uint32_t maxAirTimeMs;   // Airtime of a whole window
+} LoRaLinkCost_t;
+
+//==========================================================================
+// Radio selection by the expected TX energy per delivered frame: time on
+// air x TX power, divided by the chance an attempt is ACKed. The chance
+// is the smoothed ACK ratio of the confirmed uplinks, blended with the SNR
+// margin of the last downlinks while they are recent. A radio that would
+// lose more than 1 in 10 frames after all their attempts is left for the
+// other one. The other radio is probed now and then, its model goes stale
+// while it is not used.
+// Not thread safe, the caller holds the component mutex.
+//==========================================================================
+// aFrameAttempts is the number of attempts of a frame, retries included
+void LoRaLinkSelInit(uint8_t aFrameAttempts);
+
+void LoRaLinkSelSetCost(uint8_t aRadio, const LoRaLinkCost_t *aCost);
+void LoRaLinkSelSetSession(uint8_t aRadio, bool aSession);
+bool LoRaLinkSelHasSession(uint8_t aRadio);
+// aSf is the spreading factor of the downlink, 0 for FSK
+void LoRaLinkSelAddDownlink(uint8_t aRadio, int16_t aRssi, int8_t aSnr, uint8_t aSf);
+// Each attempt of a confirmed uplink, retries included
+void LoRaLinkSelAddAttempt(uint8_t aRadio, bool aAcked);
+
+// Radio for the next frame of aLen bytes, aCurrent is the one in use
+uint8_t LoRaLinkSelChoose(uint8_t aCurrent, uint16_t aLen);
+
+void LoRaLinkSelGetModel(uint8_t aCurrent, uint16_t aLen, LoRaLinkModel_t *aModel);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LORA_LINKSEL_H
@@ -0,0 +1,282 @@
+//==========================================================================
+// LoRaMac context persistence
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "lora_nvm.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "LoRaCompon_debug.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "utilities.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+// Key list, max 15 character with the context prefix
+#define KEY_NVM_HEADER "hdr"
+#define KEY_MAX_LENGTH 16
+
+// Magic code
+#define MAGIC_LORA_NVM 0x5e9c31a7
+
+#define NVM_GROUP_COUNT 7
+
+typedef struct {
+  const char *key;
+  uint16_t offset;
+  uint16_t size;
+} LoRaNvmGroup_t;
+
+// Header, CRC of each group as in flash
+typedef struct {
+  uint32_t magicCode;
+  uint32_t tag;
+  uint32_t groupCrc[NVM_GROUP_COUNT];
+} LoRaNvmHeader_t;
+
+//==========================================================================
+// Constants
+//==========================================================================
+static const char *kStorageNamespace = "LoRaMacNvm";
+
+// Each group ends with its Crc32, maintained by LoRaMacHandleNvm()
+static const LoRaNvmGroup_t kNvmGroups[NVM_GROUP_COUNT] = {
+    {"crypto", offsetof(LoRaMacNvmData_t, Crypto), sizeof(LoRaMacCryptoNvmData_t)},
+    {"mac1", offsetof(LoRaMacNvmData_t, MacGroup1), sizeof(LoRaMacNvmDataGroup1_t)},
+    {"mac2", offsetof(LoRaMacNvmData_t, MacGroup2), sizeof(LoRaMacNvmDataGroup2_t)},
+    {"se", offsetof(LoRaMacNvmData_t, SecureElement), sizeof(SecureElementNvmData_t)},
+    {"region1", offsetof(LoRaMacNvmData_t, RegionGroup1), sizeof(RegionNvmDataGroup1_t)},
+    {"region2", offsetof(LoRaMacNvmData_t, RegionGroup2), sizeof(RegionNvmDataGroup2_t)},
+    {"classb", offsetof(LoRaMacNvmData_t, ClassB), sizeof(LoRaMacClassBNvmData_t)},
+};
+
+//==========================================================================
+// Variables
+//==========================================================================
+static bool gNvmReady;
+static LoRaNvmHeader_t gNvmHeader[LORAMAC_NB_CONTEXTS];
+static LoRaNvmStats_t gNvmStats;
+
+//==========================================================================
+// CRC stored at the end of a group
+//==========================================================================
+static uint32_t GetGroupCrc(const uint8_t *aGroup, uint16_t aSize) {
+  uint32_t crc;
+  memcpy(&crc, aGroup + aSize - sizeof(uint32_t), sizeof(uint32_t));
+  return crc;
+}
+
+static bool IsGroupValid(const uint8_t *aGroup, uint16_t aSize) {
+  uint32_t crc = LoRaCrc32((uint8_t *)aGroup, aSize - sizeof(uint32_t));
+  return (crc == GetGroupCrc(aGroup, aSize));
+}
+
+//==========================================================================
+// NVS key of a MAC context. Context 0 keeps the keys of a single context
+// build, so its saved session stays valid.
+//==========================================================================
+static const char *GetKey(uint8_t aContext, const char *aName, char *aKey) {
+  if (aContext == 0) {
+    return aName;
+  }
+  snprintf(aKey, KEY_MAX_LENGTH, "%u%s", aContext, aName);
+  return aKey;
+}
+
+//==========================================================================
+// Init
+//   nvs_flash_init() must called before this.
+//==========================================================================
+int8_t LoRaNvmInit(void) {
+  esp_err_t esp_ret;
+  nvs_handle h_nvm;
+  char key[KEY_MAX_LENGTH];
+
+  gNvmReady = false;
+  memset(gNvmHeader, 0, sizeof(gNvmHeader));
+  memset(&gNvmStats, 0, sizeof(gNvmStats));
+
+  esp_ret = nvs_open(kStorageNamespace, NVS_READWRITE, &h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmInit nvs_open() failed. %s.\n", esp_err_to_name(esp_ret));
+    return -1;
+  }
+
+  for (uint8_t ctx = 0; ctx < LORAMAC_NB_CONTEXTS; ctx++) {
+    LoRaNvmHeader_t *header = &gNvmHeader[ctx];
+    size_t len = sizeof(LoRaNvmHeader_t);
+    esp_ret = nvs_get_blob(h_nvm, GetKey(ctx, KEY_NVM_HEADER, key), header, &len);
+    if ((esp_ret != ESP_OK) || (len != sizeof(LoRaNvmHeader_t)) || (header->magicCode != MAGIC_LORA_NVM)) {
+      // Nothing saved yet
+      memset(header, 0, sizeof(LoRaNvmHeader_t));
+    }
+  }
+  nvs_close(h_nvm);
+
+  gNvmReady = true;
+  return 0;
+}
+
+//==========================================================================
+// Write the groups changed since the last save
+// Return: number of groups written, -1 on error
+//==========================================================================
+int8_t LoRaNvmSave(uint8_t aContext, const LoRaMacNvmData_t *aNvm, uint32_t aTag) {
+  esp_err_t esp_ret;
+  nvs_handle h_nvm;
+  int8_t written = 0;
+  char key[KEY_MAX_LENGTH];
+
+  if ((!gNvmReady) || (aContext >= LORAMAC_NB_CONTEXTS)) {
+    return -1;
+  }
+  LoRaNvmHeader_t *header = &gNvmHeader[aContext];
+
+  // Nothing to do when all groups are unchanged
+  bool changed = (header->magicCode != MAGIC_LORA_NVM) || (header->tag != aTag);
+  for (uint8_t i = 0; (i < NVM_GROUP_COUNT) && (!changed); i++) {
+    const uint8_t *group = (const uint8_t *)aNvm + kNvmGroups[i].offset;
+    if (GetGroupCrc(group, kNvmGroups[i].size) != header->groupCrc[i]) {
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return 0;
+  }
+
+  esp_ret = nvs_open(kStorageNamespace, NVS_READWRITE, &h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmSave nvs_open() failed. %s.\n", esp_err_to_name(esp_ret));
+    return -1;
+  }
+
+  if ((header->magicCode != MAGIC_LORA_NVM) || (header->tag != aTag)) {
+    // New owner, rewrite all groups
+    memset(header, 0, sizeof(LoRaNvmHeader_t));
+    header->magicCode = MAGIC_LORA_NVM;
+    header->tag = aTag;
+  }
+
+  // Groups first, a group is valid by its own CRC even if the header
+  // write is lost.
+  for (uint8_t i = 0; i < NVM_GROUP_COUNT; i++) {
+    const uint8_t *group = (const uint8_t *)aNvm + kNvmGroups[i].offset;
+    uint32_t crc = GetGroupCrc(group, kNvmGroups[i].size);
+    if ((crc == header->groupCrc[i]) || (!IsGroupValid(group, kNvmGroups[i].size))) {
+      continue;
+    }
+    esp_ret = nvs_set_blob(h_nvm, GetKey(aContext, kNvmGroups[i].key, key), group, kNvmGroups[i].size);
+    if (esp_ret != ESP_OK) {
+      printf("ERROR. LoRaNvmSave set %s failed. %s.\n", kNvmGroups[i].key, esp_err_to_name(esp_ret));
+      continue;
+    }
+    header->groupCrc[i] = crc;
+    gNvmStats.groupWrites++;
+    gNvmStats.bytesWritten += kNvmGroups[i].size;
+    written++;
+  }
+
+  esp_ret = nvs_set_blob(h_nvm, GetKey(aContext, KEY_NVM_HEADER, key), header, sizeof(LoRaNvmHeader_t));
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmSave set %s failed. %s.\n", KEY_NVM_HEADER, esp_err_to_name(esp_ret));
+  }
+  esp_ret = nvs_commit(h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmSave nvs commit failed. %s.\n", esp_err_to_name(esp_ret));
+    written = -1;
+  }
+  nvs_close(h_nvm);
+
+  if (written > 0) {
+    gNvmStats.saveCount++;
+    LORACOMPON_PRINTLINE("LoRaNvmSave %d groups of context %u.", written, aContext);
+  }
+  return written;
+}
+
+//==========================================================================
+// Read the saved groups. Groups not found or with a bad CRC are left
+// untouched, the MAC rejects them by CRC as well.
+// Return: number of valid groups, -1 on error or other tag
+//==========================================================================
+int8_t LoRaNvmRestore(uint8_t aContext, LoRaMacNvmData_t *aNvm, uint32_t aTag) {
+  esp_err_t esp_ret;
+  nvs_handle h_nvm;
+  int8_t restored = 0;
+  char key[KEY_MAX_LENGTH];
+
+  if ((!gNvmReady) || (aContext >= LORAMAC_NB_CONTEXTS)) {
+    return -1;
+  }
+  LoRaNvmHeader_t *header = &gNvmHeader[aContext];
+  if ((header->magicCode != MAGIC_LORA_NVM) || (header->tag != aTag)) {
+    return -1;
+  }
+
+  int64_t start = esp_timer_get_time();
+  esp_ret = nvs_open(kStorageNamespace, NVS_READONLY, &h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmRestore nvs_open() failed. %s.\n", esp_err_to_name(esp_ret));
+    return -1;
+  }
+
+  for (uint8_t i = 0; i < NVM_GROUP_COUNT; i++) {
+    uint8_t *group = (uint8_t *)aNvm + kNvmGroups[i].offset;
+    size_t len = kNvmGroups[i].size;
+    esp_ret = nvs_get_blob(h_nvm, GetKey(aContext, kNvmGroups[i].key, key), group, &len);
+    if ((esp_ret != ESP_OK) || (len != kNvmGroups[i].size) || (!IsGroupValid(group, kNvmGroups[i].size))) {
+      LORACOMPON_PRINTLINE("LoRaNvmRestore %s not valid.", kNvmGroups[i].key);
+      continue;
+    }
+    header->groupCrc[i] = GetGroupCrc(group, kNvmGroups[i].size);
+    restored++;
+  }
+  nvs_close(h_nvm);
+
+  gNvmStats.restoreTimeUs = (uint32_t)(esp_timer_get_time() - start);
+  LORACOMPON_PRINTLINE("LoRaNvmRestore %d groups in %uus.", restored, gNvmStats.restoreTimeUs);
+  return restored;
+}
+
+//==========================================================================
+// Drop the saved sessions of all contexts
+//==========================================================================
+int8_t LoRaNvmErase(void) {
+  esp_err_t esp_ret;
+  nvs_handle h_nvm;
+
+  memset(gNvmHeader, 0, sizeof(gNvmHeader));
+  esp_ret = nvs_open(kStorageNamespace, NVS_READWRITE, &h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmErase nvs_open() failed. %s.\n", esp_err_to_name(esp_ret));
+    return -1;
+  }
+  esp_ret = nvs_erase_all(h_nvm);
+  if (esp_ret != ESP_OK) {
+    printf("ERROR. LoRaNvmErase nvs_erase_all() failed. %s.\n", esp_err_to_name(esp_ret));
+    nvs_close(h_nvm);
+    return -1;
+  }
+  esp_ret = nvs_commit(h_nvm);
+  nvs_close(h_nvm);
+  return (esp_ret == ESP_OK) ? 0 : -1;
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaNvmGetStats(LoRaNvmStats_t *aStats) { memcpy(aStats, &gNvmStats, sizeof(LoRaNvmStats_t)); }
@@ -0,0 +1,36 @@
+//==========================================================================
+//==========================================================================
+#ifndef INC_LORA_NVM_H
+#define INC_LORA_NVM_H
+
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "LoRaMac.h"
+
+//==========================================================================
+//==========================================================================
+typedef struct {
+  uint32_t saveCount;     // LoRaNvmSave() calls that wrote something
+  uint32_t groupWrites;   // Groups written
+  uint32_t bytesWritten;
+  uint32_t restoreTimeUs; // Duration of the last LoRaNvmRestore()
+} LoRaNvmStats_t;
+
+//==========================================================================
+// MAC NVM groups in flash. Only the groups whose Crc32 changed are written.
+// Each MAC context (LoRaMacGetContext()) has its own keys and header.
+// aTag identifies the session owner (e.g. the region), restore needs the
+// same tag.
+//==========================================================================
+int8_t LoRaNvmInit(void);
+int8_t LoRaNvmSave(uint8_t aContext, const LoRaMacNvmData_t *aNvm, uint32_t aTag);
+int8_t LoRaNvmRestore(uint8_t aContext, LoRaMacNvmData_t *aNvm, uint32_t aTag);
+int8_t LoRaNvmErase(void);
+void LoRaNvmGetStats(LoRaNvmStats_t *aStats);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LORA_NVM_H
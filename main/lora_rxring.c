@@ -0,0 +1,87 @@
+//==========================================================================
+// Downlink frame ring buffer
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "lora_rxring.h"
+
+//==========================================================================
+// Index are free running, wrapped by mask.
+// The producer only writes gRxRingHead, the consumer only writes gRxRingTail.
+//==========================================================================
+#define RX_RING_MASK (LORA_RX_RING_SIZE - 1)
+
+static LoRaRxView_t gRxRing[LORA_RX_RING_SIZE];
+static uint32_t gRxRingHead;
+static uint32_t gRxRingTail;
+static uint32_t gRxRingOverflow;
+
+//==========================================================================
+//==========================================================================
+void LoRaRxRingInit(void) { LoRaRxRingInitAt(0); }
+
+// Empty ring with both index at aIndex. A test can start close to
+// 2^32 to cover the wrap-around of the index.
+void LoRaRxRingInitAt(uint32_t aIndex) {
+  __atomic_store_n(&gRxRingHead, aIndex, __ATOMIC_RELAXED);
+  __atomic_store_n(&gRxRingTail, aIndex, __ATOMIC_RELAXED);
+  __atomic_store_n(&gRxRingOverflow, 0, __ATOMIC_RELAXED);
+}
+
+//==========================================================================
+// Free slot to fill, NULL when full
+//==========================================================================
+LoRaRxView_t *LoRaRxRingGetWriteSlot(void) {
+  uint32_t head = __atomic_load_n(&gRxRingHead, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&gRxRingTail, __ATOMIC_ACQUIRE);
+  if ((head - tail) >= LORA_RX_RING_SIZE) {
+    return NULL;
+  }
+  return &gRxRing[head & RX_RING_MASK];
+}
+
+// Publish the slot returned by LoRaRxRingGetWriteSlot()
+void LoRaRxRingCommit(void) {
+  uint32_t head = __atomic_load_n(&gRxRingHead, __ATOMIC_RELAXED);
+  __atomic_store_n(&gRxRingHead, head + 1, __ATOMIC_RELEASE);
+}
+
+void LoRaRxRingCountOverflow(void) { __atomic_fetch_add(&gRxRingOverflow, 1, __ATOMIC_RELAXED); }
+
+//==========================================================================
+// Oldest frame, NULL when empty
+//==========================================================================
+const LoRaRxView_t *LoRaRxRingPeek(void) {
+  uint32_t tail = __atomic_load_n(&gRxRingTail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&gRxRingHead, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return NULL;
+  }
+  return &gRxRing[tail & RX_RING_MASK];
+}
+
+// Give the slot returned by LoRaRxRingPeek() back to the producer
+void LoRaRxRingRelease(void) {
+  uint32_t tail = __atomic_load_n(&gRxRingTail, __ATOMIC_RELAXED);
+  __atomic_store_n(&gRxRingTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+//==========================================================================
+//==========================================================================
+uint16_t LoRaRxRingCount(void) {
+  uint32_t head = __atomic_load_n(&gRxRingHead, __ATOMIC_ACQUIRE);
+  uint32_t tail = __atomic_load_n(&gRxRingTail, __ATOMIC_ACQUIRE);
+  return (uint16_t)(head - tail);
+}
+
+uint32_t LoRaRxRingOverflowCount(void) { return __atomic_load_n(&gRxRingOverflow, __ATOMIC_RELAXED); }
@@ -0,0 +1,44 @@
+//==========================================================================
+//==========================================================================
+#ifndef INC_LORA_RXRING_H
+#define INC_LORA_RXRING_H
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lora_compon.h"
+
+//==========================================================================
+//==========================================================================
+#if defined(CONFIG_LORAWAN_RX_RING_SIZE)
+#define LORA_RX_RING_SIZE CONFIG_LORAWAN_RX_RING_SIZE
+#else
+#define LORA_RX_RING_SIZE 4
+#endif
+
+#if (LORA_RX_RING_SIZE & (LORA_RX_RING_SIZE - 1)) != 0
+#error "LORA_RX_RING_SIZE must be a power of 2"
+#endif
+
+//==========================================================================
+// Single producer (loraTask), single consumer (application). No lock.
+//==========================================================================
+void LoRaRxRingInit(void);
+void LoRaRxRingInitAt(uint32_t aIndex);
+
+// Producer
+LoRaRxView_t *LoRaRxRingGetWriteSlot(void);
+void LoRaRxRingCommit(void);
+void LoRaRxRingCountOverflow(void);
+
+// Consumer
+const LoRaRxView_t *LoRaRxRingPeek(void);
+void LoRaRxRingRelease(void);
+
+uint16_t LoRaRxRingCount(void);
+uint32_t LoRaRxRingOverflowCount(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LORA_RXRING_H
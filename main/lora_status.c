@@ -0,0 +1,106 @@
+//==========================================================================
+// Link status snapshot
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "lora_status.h"
+
+#include "freertos/FreeRTOS.h"
+
+//==========================================================================
+// The snapshot is packed into words that are loaded and stored atomically.
+// gStatusSeq is odd while a publish is in progress.
+//==========================================================================
+#define STATUS_WORD_LINK 0
+#define STATUS_WORD_STATE 1
+#define STATUS_WORD_TX 2
+#define STATUS_WORD_TICK 3
+#define STATUS_WORD_JOIN 4
+#define STATUS_WORDS 5
+
+#define STATE_TX_FULL 0x100
+#define STATE_MAC_BUSY 0x200
+
+static uint32_t gStatusSeq;
+static uint32_t gStatusWord[STATUS_WORDS];
+static uint32_t gStatusRetries;
+
+// Keeps the publish from being preempted, a reader on the same core would
+// spin on the odd sequence until the writer runs again.
+static portMUX_TYPE gStatusLock = portMUX_INITIALIZER_UNLOCKED;
+
+//==========================================================================
+//==========================================================================
+void LoRaStatusInit(void) {
+  LoRaStatusSnapshot_t snapshot = {.linkStatus = 0,
+                                   .linkState = 0,
+                                   .txFull = false,
+                                   .txLen = -1,
+                                   .txQueued = 0,
+                                   .macBusy = false,
+                                   .linkTick = 0,
+                                   .joinInterval = 0};
+  LoRaStatusPublish(&snapshot);
+  __atomic_store_n(&gStatusRetries, 0, __ATOMIC_RELAXED);
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaStatusPublish(const LoRaStatusSnapshot_t *aSnapshot) {
+  uint32_t state =
+      aSnapshot->linkState | (aSnapshot->txFull ? STATE_TX_FULL : 0) | (aSnapshot->macBusy ? STATE_MAC_BUSY : 0);
+  uint32_t tx = (uint16_t)aSnapshot->txLen | ((uint32_t)aSnapshot->txQueued << 16);
+
+  portENTER_CRITICAL(&gStatusLock);
+  uint32_t seq = __atomic_load_n(&gStatusSeq, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusSeq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&gStatusWord[STATUS_WORD_LINK], aSnapshot->linkStatus, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusWord[STATUS_WORD_STATE], state, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusWord[STATUS_WORD_TX], tx, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusWord[STATUS_WORD_TICK], aSnapshot->linkTick, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusWord[STATUS_WORD_JOIN], aSnapshot->joinInterval, __ATOMIC_RELAXED);
+  __atomic_store_n(&gStatusSeq, seq + 2, __ATOMIC_RELEASE);
+  portEXIT_CRITICAL(&gStatusLock);
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaStatusRead(LoRaStatusSnapshot_t *aSnapshot) {
+  uint32_t word[STATUS_WORDS];
+
+  for (;;) {
+    uint32_t seq = __atomic_load_n(&gStatusSeq, __ATOMIC_ACQUIRE);
+    if ((seq & 1) == 0) {
+      for (uint8_t i = 0; i < STATUS_WORDS; i++) {
+        word[i] = __atomic_load_n(&gStatusWord[i], __ATOMIC_RELAXED);
+      }
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&gStatusSeq, __ATOMIC_RELAXED) == seq) {
+        break;
+      }
+    }
+    __atomic_fetch_add(&gStatusRetries, 1, __ATOMIC_RELAXED);
+  }
+
+  aSnapshot->linkStatus = word[STATUS_WORD_LINK];
+  aSnapshot->linkState = (uint8_t)word[STATUS_WORD_STATE];
+  aSnapshot->txFull = ((word[STATUS_WORD_STATE] & STATE_TX_FULL) != 0);
+  aSnapshot->txLen = (int16_t)(uint16_t)word[STATUS_WORD_TX];
+  aSnapshot->txQueued = (uint16_t)(word[STATUS_WORD_TX] >> 16);
+  aSnapshot->macBusy = ((word[STATUS_WORD_STATE] & STATE_MAC_BUSY) != 0);
+  aSnapshot->linkTick = word[STATUS_WORD_TICK];
+  aSnapshot->joinInterval = word[STATUS_WORD_JOIN];
+}
+
+uint32_t LoRaStatusRetryCount(void) { return __atomic_load_n(&gStatusRetries, __ATOMIC_RELAXED); }
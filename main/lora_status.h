@@ -0,0 +1,43 @@
+//==========================================================================
+//==========================================================================
+#ifndef INC_LORA_STATUS_H
+#define INC_LORA_STATUS_H
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+//==========================================================================
+// Link status published by loraTask for the LoRaComponIs* polling API
+//==========================================================================
+typedef struct {
+  uint32_t linkStatus;  // BIT_LORASTATUS_* of lora_compon.c
+  uint8_t linkState;    // LoraDevicState_t
+  bool txFull;          // TX queue has no free slot
+  int16_t txLen;        // Size of the frame in TX, -1 when none
+  uint16_t txQueued;    // Frames in the TX queue
+  bool macBusy;         // LoRaMacIsBusy()
+  uint32_t linkTick;    // Start of the link state timing, 0 when none
+  uint32_t joinInterval;
+} LoRaStatusSnapshot_t;
+
+//==========================================================================
+// Sequence counter protected snapshot. The writer runs in a short critical
+// section, readers take no lock and only retry while a publish is in
+// progress, so they never block on the component mutex.
+//==========================================================================
+void LoRaStatusInit(void);
+
+// The caller keeps the sources of the snapshot stable, i.e. holds the
+// component mutex, so a stale snapshot never overwrites a newer one.
+void LoRaStatusPublish(const LoRaStatusSnapshot_t *aSnapshot);
+
+// Any task or core
+void LoRaStatusRead(LoRaStatusSnapshot_t *aSnapshot);
+
+// Reads repeated because of a concurrent publish
+uint32_t LoRaStatusRetryCount(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LORA_STATUS_H
@@ -0,0 +1,246 @@
+//==========================================================================
+// Uplink frame queue
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "lora_txqueue.h"
+
+#include <string.h>
+
+#include "utilities.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+// One more slot than the queue size, for the frame being sent
+#define TX_QUEUE_SLOTS (LORA_TX_QUEUE_SIZE + 1)
+
+typedef enum {
+  TX_SLOT_FREE = 0,
+  TX_SLOT_RESERVED,  // Filled by the application
+  TX_SLOT_QUEUED,
+  TX_SLOT_SENDING,  // In use by the MAC
+} TxSlotState_t;
+
+//==========================================================================
+// Variables
+//==========================================================================
+static LoRaTxFrame_t gTxQueue[TX_QUEUE_SLOTS];
+static uint8_t gTxQueueState[TX_QUEUE_SLOTS];
+static uint16_t gTxQueueCount;
+static uint16_t gTxQueueReserved;
+static uint32_t gTxQueueSeq;
+static LoRaTxQueueStats_t gTxQueueStats;
+
+//==========================================================================
+// Slot of the next frame to send. Highest priority, oldest first.
+//==========================================================================
+static int16_t FindHead(void) {
+  int16_t head = -1;
+  for (int16_t i = 0; i < TX_QUEUE_SLOTS; i++) {
+    if (gTxQueueState[i] != TX_SLOT_QUEUED) continue;
+    if ((head < 0) || (gTxQueue[i].priority > gTxQueue[head].priority) ||
+        ((gTxQueue[i].priority == gTxQueue[head].priority) && ((int32_t)(gTxQueue[i].seq - gTxQueue[head].seq) < 0))) {
+      head = i;
+    }
+  }
+  return head;
+}
+
+//==========================================================================
+// Slot to drop when full. Lowest priority, newest first.
+//==========================================================================
+static int16_t FindTail(void) {
+  int16_t tail = -1;
+  for (int16_t i = 0; i < TX_QUEUE_SLOTS; i++) {
+    if (gTxQueueState[i] != TX_SLOT_QUEUED) continue;
+    if ((tail < 0) || (gTxQueue[i].priority < gTxQueue[tail].priority) ||
+        ((gTxQueue[i].priority == gTxQueue[tail].priority) && ((int32_t)(gTxQueue[i].seq - gTxQueue[tail].seq) > 0))) {
+      tail = i;
+    }
+  }
+  return tail;
+}
+
+static int16_t FindState(uint8_t aState) {
+  for (int16_t i = 0; i < TX_QUEUE_SLOTS; i++) {
+    if (gTxQueueState[i] == aState) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void QueueSlot(int16_t aSlot, uint16_t aLen, uint8_t aPort, uint8_t aMode, uint8_t aPriority) {
+  LoRaTxFrame_t *frame = &gTxQueue[aSlot];
+  frame->dataSize = aLen;
+  frame->port = aPort;
+  frame->mode = aMode;
+  frame->priority = aPriority;
+  frame->seq = gTxQueueSeq++;
+  gTxQueueState[aSlot] = TX_SLOT_QUEUED;
+  gTxQueueCount++;
+
+  gTxQueueStats.enqueued++;
+  if (gTxQueueCount > gTxQueueStats.maxDepth) {
+    gTxQueueStats.maxDepth = gTxQueueCount;
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaTxQueueInit(void) {
+  LoRaTxQueueClear();
+  memset(&gTxQueueStats, 0, sizeof(gTxQueueStats));
+  gTxQueueStats.capacity = LORA_TX_QUEUE_SIZE;
+}
+
+void LoRaTxQueueClear(void) {
+  for (int16_t i = 0; i < TX_QUEUE_SLOTS; i++) {
+    gTxQueueState[i] = TX_SLOT_FREE;
+  }
+  gTxQueueCount = 0;
+  gTxQueueReserved = 0;
+}
+
+//==========================================================================
+// Add a frame. When full, a lower priority frame is dropped to make room.
+// Return: 0 - queued, -1 - dropped
+//==========================================================================
+int8_t LoRaTxQueuePush(const uint8_t *aData, uint16_t aLen, uint8_t aPort, uint8_t aMode, uint8_t aPriority) {
+  if (aLen > LORAWAN_MAX_PAYLOAD_LEN) {
+    return -1;
+  }
+
+  int16_t slot = -1;
+  if (LoRaTxQueueIsFull()) {
+    int16_t tail = FindTail();
+    if ((tail < 0) || (gTxQueue[tail].priority >= aPriority)) {
+      gTxQueueStats.dropped++;
+      return -1;
+    }
+    // Replace the lowest priority frame
+    gTxQueueStats.dropped++;
+    gTxQueueState[tail] = TX_SLOT_FREE;
+    gTxQueueCount--;
+    slot = tail;
+  } else {
+    slot = FindState(TX_SLOT_FREE);
+  }
+
+  memcpy(LORA_TX_FRAME_PAYLOAD(&gTxQueue[slot]), aData, aLen);
+  FrameCopyCountTx(aLen);
+  QueueSlot(slot, aLen, aPort, aMode, aPriority);
+  return 0;
+}
+
+//==========================================================================
+// Payload buffer of a free slot, for the application to fill and commit.
+// Reserving again returns the same buffer. NULL when full.
+//==========================================================================
+uint8_t *LoRaTxQueueReserve(void) {
+  int16_t slot = FindState(TX_SLOT_RESERVED);
+  if (slot < 0) {
+    if (LoRaTxQueueIsFull()) {
+      return NULL;
+    }
+    slot = FindState(TX_SLOT_FREE);
+    gTxQueueState[slot] = TX_SLOT_RESERVED;
+    gTxQueueReserved++;
+  }
+  return LORA_TX_FRAME_PAYLOAD(&gTxQueue[slot]);
+}
+
+//==========================================================================
+// Queue the reserved slot. A length of 0 cancels the reservation.
+// Return: 0 - queued, -1 - no reserved slot or cancelled
+//==========================================================================
+int8_t LoRaTxQueueCommit(uint16_t aLen, uint8_t aPort, uint8_t aMode, uint8_t aPriority) {
+  int16_t slot = FindState(TX_SLOT_RESERVED);
+  if (slot < 0) {
+    return -1;
+  }
+  gTxQueueReserved--;
+  if ((aLen == 0) || (aLen > LORAWAN_MAX_PAYLOAD_LEN)) {
+    gTxQueueState[slot] = TX_SLOT_FREE;
+    return -1;
+  }
+
+  QueueSlot(slot, aLen, aPort, aMode, aPriority);
+  return 0;
+}
+
+//==========================================================================
+// Next frame to send, NULL when empty. The slot stays in use by the MAC
+// until LoRaTxQueueReleaseSending().
+//==========================================================================
+LoRaTxFrame_t *LoRaTxQueueTakeHead(void) {
+  int16_t head = FindHead();
+  if (head < 0) {
+    return NULL;
+  }
+  gTxQueueState[head] = TX_SLOT_SENDING;
+  gTxQueueCount--;
+  return &gTxQueue[head];
+}
+
+// Next frame to send, left in the queue. NULL when empty.
+const LoRaTxFrame_t *LoRaTxQueuePeekHead(void) {
+  int16_t head = FindHead();
+  return (head < 0) ? NULL : &gTxQueue[head];
+}
+
+void LoRaTxQueueReleaseSending(void) {
+  int16_t slot = FindState(TX_SLOT_SENDING);
+  if (slot >= 0) {
+    gTxQueueState[slot] = TX_SLOT_FREE;
+  }
+}
+
+//==========================================================================
+// Drop the queued frames, counted as dropped. The frame being sent and a
+// reserved slot are kept.
+// Return: number of frames dropped
+//==========================================================================
+uint16_t LoRaTxQueueDropQueued(void) {
+  uint16_t dropped = 0;
+  for (int16_t i = 0; i < TX_QUEUE_SLOTS; i++) {
+    if (gTxQueueState[i] == TX_SLOT_QUEUED) {
+      gTxQueueState[i] = TX_SLOT_FREE;
+      dropped++;
+    }
+  }
+  gTxQueueCount = 0;
+  gTxQueueStats.dropped += dropped;
+  return dropped;
+}
+
+uint16_t LoRaTxQueueCount(void) { return gTxQueueCount; }
+
+bool LoRaTxQueueIsFull(void) { return ((gTxQueueCount + gTxQueueReserved) >= LORA_TX_QUEUE_SIZE); }
+
+//==========================================================================
+// Statistics
+//==========================================================================
+void LoRaTxQueueCountResult(bool aSuccess) {
+  if (aSuccess) {
+    gTxQueueStats.sent++;
+  } else {
+    gTxQueueStats.failed++;
+  }
+}
+
+void LoRaTxQueueGetStats(LoRaTxQueueStats_t *aStats) {
+  memcpy(aStats, &gTxQueueStats, sizeof(LoRaTxQueueStats_t));
+  aStats->depth = gTxQueueCount;
+}
@@ -0,0 +1,54 @@
+//==========================================================================
+//==========================================================================
+#ifndef INC_LORA_TXQUEUE_H
+#define INC_LORA_TXQUEUE_H
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "LoRaMac.h"
+#include "lora_compon.h"
+
+//==========================================================================
+//==========================================================================
+#if defined(CONFIG_LORAWAN_TX_QUEUE_SIZE)
+#define LORA_TX_QUEUE_SIZE CONFIG_LORAWAN_TX_QUEUE_SIZE
+#else
+#define LORA_TX_QUEUE_SIZE 4
+#endif
+
+// The payload has room for the LoRaWAN headers and MIC around it, so the
+// MAC builds and encrypts the frame in the slot without copying it.
+typedef struct {
+  uint8_t buffer[LORAMAC_FRAME_HEADROOM + LORAWAN_MAX_PAYLOAD_LEN + LORAMAC_FRAME_TAILROOM];
+  uint8_t dataSize;
+  uint8_t port;
+  uint8_t mode;  // LoRaTxMode_t
+  uint8_t priority;
+  uint32_t seq;  // FIFO order within the same priority
+} LoRaTxFrame_t;
+
+#define LORA_TX_FRAME_PAYLOAD(frame) (&(frame)->buffer[LORAMAC_FRAME_HEADROOM])
+
+//==========================================================================
+// Not thread safe, the caller holds the component mutex.
+//==========================================================================
+void LoRaTxQueueInit(void);
+void LoRaTxQueueClear(void);
+int8_t LoRaTxQueuePush(const uint8_t *aData, uint16_t aLen, uint8_t aPort, uint8_t aMode, uint8_t aPriority);
+uint8_t *LoRaTxQueueReserve(void);
+int8_t LoRaTxQueueCommit(uint16_t aLen, uint8_t aPort, uint8_t aMode, uint8_t aPriority);
+LoRaTxFrame_t *LoRaTxQueueTakeHead(void);
+const LoRaTxFrame_t *LoRaTxQueuePeekHead(void);
+void LoRaTxQueueReleaseSending(void);
+uint16_t LoRaTxQueueDropQueued(void);
+uint16_t LoRaTxQueueCount(void);
+bool LoRaTxQueueIsFull(void);
+
+void LoRaTxQueueCountResult(bool aSuccess);
+void LoRaTxQueueGetStats(LoRaTxQueueStats_t *aStats);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_LORA_TXQUEUE_H
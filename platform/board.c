@@ -20,6 +20,7 @@
 
 #include "LoRaPlatform_debug.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -27,6 +28,7 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "radio.h"
+#include "radio_dio.h"
 #include "sx-gpio.h"
 #include "timer.h"
 
@@ -59,75 +61,81 @@ DioIrqHandler* gSx1280DioIrqHandler = NULL;
 // Timer interrupt
 //==========================================================================
 static esp_timer_handle_t gBoardTimer = NULL;
-static xQueueHandle gLoRaDioEventQueue = NULL;
+static TaskHandle_t gLoRaDioTask = NULL;
 
-static void PeriodicTimerFunc(void* arg) { TimerIrqHandler(); }
+static void BoardTimerFunc(void* arg) { TimerIrqHandler(); }
 
 //==========================================================================
-// DIO interrupts for LoRa chips
+// DIO interrupts for LoRa chips. The ISR notifies the task with one bit
+// per chip, the task processes the IRQ of that chip in the same wakeup.
 //==========================================================================
-void LoRaDioIsrHandler(void* arg) {
-  uint32_t gpio_num = (uint32_t)arg;
-  xQueueSendFromISR(gLoRaDioEventQueue, &gpio_num, NULL);
+static void IRAM_ATTR LoRaDioIsrHandler(void* arg) {
+  RadioChip_t chip = (RadioChip_t)(uint32_t)arg;
+  BaseType_t woken = pdFALSE;
+
+  RadioDioEdgeFromIsr(chip);
+  if (gLoRaDioTask != NULL) {
+    xTaskNotifyFromISR(gLoRaDioTask, 1 << chip, eSetBits, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+static uint32_t GetDioLevel(RadioChip_t aChip) {
+  return (aChip == RADIO_CHIP_SX126X) ? SX126xGetDio1PinState() : SX1280HalGetDioStatus();
+}
+
+static void LoRaDioDispatch(RadioChip_t aChip) {
+  const struct Radio_s* radio = (aChip == RADIO_CHIP_SX126X) ? &RadioSx126x : &RadioSx1280;
+  DioIrqHandler* handler = (aChip == RADIO_CHIP_SX126X) ? gSx126xDioIrqHandler : gSx1280DioIrqHandler;
+  bool stuck = true;
+
+  RadioDioDispatchBegin(aChip);
+  // While the DIO stays high, a new IRQ came during the processing
+  for (uint8_t i = 0; i < RADIO_DIO_MAX_PASSES; i++) {
+    if (GetDioLevel(aChip) == 0) {
+      stuck = false;
+      break;
+    }
+    RadioDioDispatchPass(aChip);
+    if (handler != NULL) {
+      LORAPLATFORM_PRINTLINE("call DIO IRQ handler, chip %d", aChip);
+      handler(NULL);
+    }
+
+    // It is not current radio, an unexpected DIO IRQ
+    if (Radio.IrqProcess != radio->IrqProcess) {
+      printf("ERROR. Unexpected DIO irq, %s.\n", (aChip == RADIO_CHIP_SX126X) ? "SX1261" : "SX1280");
+      if (aChip == RADIO_CHIP_SX126X) {
+        SX126xClearIrqStatus(0xFFFF);
+      } else {
+        SX1280ClearIrqStatus(0xFFFF);
+      }
+      radio->Standby();
+      stuck = false;
+      break;
+    }
+    Radio.IrqProcess();
+  }
+  if (stuck) {
+    printf("ERROR. DIO still high, chip %d.\n", aChip);
+  }
+  RadioDioDispatchEnd(aChip, stuck);
 }
 
 static void LoRaDioIrqTask(void* arg) {
-  uint32_t io_num;
+  uint32_t bits;
   for (;;) {
-    if (xQueueReceive(gLoRaDioEventQueue, &io_num, portMAX_DELAY)) {
-      // If DIO level keep high, keep running up to 50ms.
-      for (uint8_t i = 0; i < 10; i++) {
-        // Process SX1261
-        if (SX126xGetDio1PinState() != 0) {
-          if (gSx126xDioIrqHandler != NULL) {
-            LORAPLATFORM_PRINTLINE("call gSx126xDioIrqHandler()");
-            gSx126xDioIrqHandler(NULL);
-          }
-          // It is not current radio, an unexpected DIO IRQ
-          if (Radio.IrqProcess != RadioSx126x.IrqProcess) {
-            printf("ERROR. Unexpected DIO irq, SX1261.\n");
-            SX126xClearIrqStatus(0xFFFF);
-            RadioSx126x.Standby();
-          }
-        }
-
-        // Process SX1280
-        if (SX1280HalGetDioStatus() != 0) {
-          if (gSx1280DioIrqHandler != NULL) {
-            LORAPLATFORM_PRINTLINE("call gSx1280DioIrqHandler()");
-            gSx1280DioIrqHandler(NULL);
-          }
-
-          // It is not current radio, an unexpected DIO IRQ
-          if (Radio.IrqProcess != RadioSx1280.IrqProcess) {
-            printf("ERROR. Unexpected DIO irq, SX1280.\n");
-            SX1280ClearIrqStatus(0xFFFF);
-            RadioSx1280.Standby();
-          }
-        }
-
-        // Call radio IRQ
-        if (Radio.IrqProcess == NULL) break;
-        Radio.IrqProcess();
-        vTaskDelay(5 / portTICK_PERIOD_MS);
-
-        // DIO back to low, exit
-        if ((SX126xGetDio1PinState() == 0) && (SX1280HalGetDioStatus() == 0)) break;
-
-        // DIO keep high, wait a while and process again
-        LORAPLATFORM_PRINTLINE("DIO still high.");
-        vTaskDelay(5 / portTICK_PERIOD_MS);
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY) == pdTRUE) {
+      if (bits & (1 << RADIO_CHIP_SX126X)) {
+        LoRaDioDispatch(RADIO_CHIP_SX126X);
+      }
+      if (bits & (1 << RADIO_CHIP_SX1280)) {
+        LoRaDioDispatch(RADIO_CHIP_SX1280);
       }
     }
   }
   vTaskDelete(NULL);
 }
-//==========================================================================
-// Critical section
-//==========================================================================
-void LoRaBoardCriticalSectionBegin(void) { vTaskSuspendAll(); }
-
-void LoRaBoardCriticalSectionEnd(void) { xTaskResumeAll(); }
 
 //==========================================================================
 //==========================================================================
@@ -149,35 +157,54 @@ void LoRaBoardGetUniqueId(uint8_t* id) {
 }
 
 //==========================================================================
-// ESP timer
+// ESP timer, one-shot alarm for the earliest timer deadline
 //==========================================================================
 static void CreateBoardTimer(void) {
   if (gBoardTimer == NULL) {
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &PeriodicTimerFunc,
+    const esp_timer_create_args_t timer_args = {
+        .callback = &BoardTimerFunc,
         .dispatch_method = ESP_TIMER_TASK,
-        .name = "periodic",
+        .name = "lora_timer",
     };
-    if (esp_timer_create(&periodic_timer_args, &gBoardTimer) != ESP_OK) {
-      printf("ERROR. Failed to create periodic timer.\n");
+    if (esp_timer_create(&timer_args, &gBoardTimer) != ESP_OK) {
+      printf("ERROR. Failed to create board timer.\n");
       gBoardTimer = NULL;
+    } else {
+      LORAPLATFORM_PRINTLINE("Board timer created.");
     }
   }
-  if (gBoardTimer != NULL) {
-    // Kick start a 1ms periodic timer
-    esp_timer_start_periodic(gBoardTimer, 1000);
-    LORAPLATFORM_PRINTLINE("Periodic timer started.");
-  }
 }
 
 static void RemoveBoardTimer(void) {
   if (gBoardTimer != NULL) {
     esp_timer_stop(gBoardTimer);
-    LORAPLATFORM_PRINTLINE("Periodic timer stopped.");
+    esp_timer_delete(gBoardTimer);
+    LORAPLATFORM_PRINTLINE("Board timer removed.");
     gBoardTimer = NULL;
   }
 }
 
+//==========================================================================
+// Arm the alarm, TimerIrqHandler() will be called after aTimeoutUs.
+// Called within critical section by the timer module, so no printf() here.
+// Return false when the alarm could not be started.
+//==========================================================================
+bool LoRaBoardStartTimerAlarm(uint64_t aTimeoutUs) {
+  if (gBoardTimer != NULL) {
+    esp_timer_stop(gBoardTimer);
+    if (esp_timer_start_once(gBoardTimer, aTimeoutUs) != ESP_OK) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LoRaBoardStopTimerAlarm(void) {
+  if (gBoardTimer != NULL) {
+    esp_timer_stop(gBoardTimer);
+  }
+}
+
 //==========================================================================
 //==========================================================================
 void LoRaBoardInitMcu(void) {
@@ -187,6 +214,11 @@ void LoRaBoardInitMcu(void) {
   //
   CreateBoardTimer();
 
+  // Before the radios, which add their BUSY interrupts
+  if (gpio_install_isr_service(0) != ESP_OK) {
+    printf("ERROR. Failed to install GPIO IRQ service.\n");
+  }
+
   // LoRa Radio
   SX126xIoInit();
   SX126xIoIrqInit(NULL);
@@ -194,26 +226,22 @@ void LoRaBoardInitMcu(void) {
   SX1280HalInit();
   SX1280HalIoIrqInit(NULL);
 
-  //
-  if (gpio_install_isr_service(0) != ESP_OK) {
-    printf("ERROR. Failed to install GPIO IRQ service.\n");
-  }
-
   // Task to handle LoRa chip DIO IRQ
-  gLoRaDioEventQueue = xQueueCreate(200, sizeof(uint32_t));
-  if (xTaskCreate(LoRaDioIrqTask, "LoRaDioIrqTask", 2048, NULL, TASK_PRIO_IRQ, NULL) != pdPASS) {
-    printf("ERROR. Failed to create LoRa DIO IRQ task.\n");
+  if (gLoRaDioTask == NULL) {
+    if (xTaskCreate(LoRaDioIrqTask, "LoRaDioIrqTask", 2048, NULL, TASK_PRIO_IRQ, &gLoRaDioTask) != pdPASS) {
+      printf("ERROR. Failed to create LoRa DIO IRQ task.\n");
+    }
   }
 
   //
   gpio_set_intr_type(SX1261_DIO1, GPIO_INTR_POSEDGE);
-  if (gpio_isr_handler_add(SX1261_DIO1, LoRaDioIsrHandler, (void*)SX1261_DIO1) != ESP_OK) {
+  if (gpio_isr_handler_add(SX1261_DIO1, LoRaDioIsrHandler, (void*)RADIO_CHIP_SX126X) != ESP_OK) {
     printf("ERROR. Failed to add SX1261 DIO1 IRQ handler.");
   }
 
   // // Setup LoRa chip DIO interrupt
   gpio_set_intr_type(SX1280_DIO1, GPIO_INTR_POSEDGE);
-  if (gpio_isr_handler_add(SX1280_DIO1, LoRaDioIsrHandler, (void*)SX1280_DIO1) != ESP_OK) {
+  if (gpio_isr_handler_add(SX1280_DIO1, LoRaDioIsrHandler, (void*)RADIO_CHIP_SX1280) != ESP_OK) {
     printf("ERROR. Failed to add SX1280 DIO1 IRQ handler.");
   }
 }
@@ -232,6 +260,10 @@ void LoRaBoardPrepareForSleep(void) {
 void LoRaBoardResumeFromSleep(void) {
   //
   CreateBoardTimer();
+  // Process timers pending during sleep
+  if (!LoRaBoardStartTimerAlarm(0)) {
+    printf("ERROR. Failed to start board timer.\n");
+  }
 
   //
   SX126xIoInit();
@@ -9,14 +9,16 @@ extern "C" {
 
 //==========================================================================
 //==========================================================================
+#include <stdbool.h>
 #include <stdint.h>
 
 //==========================================================================
 //==========================================================================
 void LoRaBoardInitMcu(void);
 void LoRaBoardGetUniqueId(uint8_t *id);
-void LoRaBoardCriticalSectionBegin(void);
-void LoRaBoardCriticalSectionEnd(void);
+
+bool LoRaBoardStartTimerAlarm(uint64_t aTimeoutUs);
+void LoRaBoardStopTimerAlarm(void);
 
 void LoRaBoardPrepareForSleep(void);
 void LoRaBoardResumeFromSleep(void);
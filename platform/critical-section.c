@@ -0,0 +1,112 @@
+//==========================================================================
+// Critical sections per subsystem
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "critical-section.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+//==========================================================================
+//==========================================================================
+typedef struct {
+  portMUX_TYPE mux;
+  uint8_t depth;  // Only changed by the owner
+  uint64_t enterUs;
+  LoRaCriticalStats_t stats;
+} CriticalLock_t;
+
+static const char *const kLockName[LORA_CRITICAL_COUNT] = {"timer", "radio", "mac"};
+
+static CriticalLock_t gCriticalLocks[LORA_CRITICAL_COUNT] = {
+    [LORA_CRITICAL_TIMER] = {.mux = portMUX_INITIALIZER_UNLOCKED},
+    [LORA_CRITICAL_RADIO] = {.mux = portMUX_INITIALIZER_UNLOCKED},
+    [LORA_CRITICAL_MAC] = {.mux = portMUX_INITIALIZER_UNLOCKED},
+};
+
+//==========================================================================
+//==========================================================================
+static uint8_t BucketOf(uint32_t aUs) {
+  uint8_t bucket = (aUs == 0) ? 0 : (32 - __builtin_clz(aUs));
+  return (bucket < LORA_CRITICAL_HIST_BUCKETS) ? bucket : (LORA_CRITICAL_HIST_BUCKETS - 1);
+}
+
+//==========================================================================
+// The spinlock itself may be taken again by the owner core
+//==========================================================================
+void IRAM_ATTR LoRaCriticalEnter(LoRaCriticalId_t aId) {
+  CriticalLock_t *lock = &gCriticalLocks[aId];
+
+  portENTER_CRITICAL(&lock->mux);
+  if (lock->depth++ == 0) {
+    if (LORA_CRITICAL_STATS) {
+      lock->enterUs = (uint64_t)esp_timer_get_time();
+    }
+    lock->stats.enters++;
+  } else {
+    lock->stats.nested++;
+  }
+}
+
+void IRAM_ATTR LoRaCriticalExit(LoRaCriticalId_t aId) {
+  CriticalLock_t *lock = &gCriticalLocks[aId];
+
+  if ((--lock->depth == 0) && (LORA_CRITICAL_STATS)) {
+    uint64_t elapsed = (uint64_t)esp_timer_get_time() - lock->enterUs;
+    uint32_t us = (elapsed < UINT32_MAX) ? (uint32_t)elapsed : UINT32_MAX;
+    lock->stats.bucket[BucketOf(us)]++;
+    lock->stats.totalUs += us;
+    if (us > lock->stats.maxUs) {
+      lock->stats.maxUs = us;
+    }
+  }
+  portEXIT_CRITICAL(&lock->mux);
+}
+
+//==========================================================================
+//==========================================================================
+void LoRaCriticalGetStats(LoRaCriticalId_t aId, LoRaCriticalStats_t *aStats) {
+  CriticalLock_t *lock = &gCriticalLocks[aId];
+
+  portENTER_CRITICAL(&lock->mux);
+  *aStats = lock->stats;
+  portEXIT_CRITICAL(&lock->mux);
+}
+
+void LoRaCriticalResetStats(void) {
+  for (uint8_t i = 0; i < LORA_CRITICAL_COUNT; i++) {
+    CriticalLock_t *lock = &gCriticalLocks[i];
+    portENTER_CRITICAL(&lock->mux);
+    memset(&lock->stats, 0, sizeof(LoRaCriticalStats_t));
+    portEXIT_CRITICAL(&lock->mux);
+  }
+}
+
+void LoRaCriticalPrintStats(void) {
+  LoRaCriticalStats_t stats;
+
+  for (uint8_t i = 0; i < LORA_CRITICAL_COUNT; i++) {
+    LoRaCriticalGetStats((LoRaCriticalId_t)i, &stats);
+    printf("Critical %s: enters=%u nested=%u max=%uus total=%lluus |", kLockName[i], stats.enters, stats.nested,
+           stats.maxUs, (unsigned long long)stats.totalUs);
+    for (uint8_t b = 0; b < LORA_CRITICAL_HIST_BUCKETS; b++) {
+      printf(" %u", stats.bucket[b]);
+    }
+    printf("\n");
+  }
+}
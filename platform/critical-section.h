@@ -0,0 +1,74 @@
+//==========================================================================
+// Critical sections per subsystem
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Each subsystem has its own spinlock, so a timer update on one core does
+// not stall the radio or MAC flags on the other, and both cores and the
+// interrupts are excluded, unlike vTaskSuspendAll(). A section may be
+// entered again by its owner. The time from the outermost enter to the
+// exit is kept in a histogram per lock.
+//
+// Keep the sections short and never block in them: the interrupts of the
+// core are disabled.
+//==========================================================================
+#ifndef LORA_INC_CRITICAL_SECTION_H
+#define LORA_INC_CRITICAL_SECTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//==========================================================================
+//==========================================================================
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#if defined(CONFIG_LORAWAN_CRITICAL_STATS)
+#define LORA_CRITICAL_STATS 1
+#else
+#define LORA_CRITICAL_STATS 0
+#endif
+
+// Bucket 0 is below 1 us, bucket n is [2^(n-1), 2^n) us, the last bucket
+// is everything above.
+#define LORA_CRITICAL_HIST_BUCKETS 12
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef enum {
+  LORA_CRITICAL_TIMER,  // Timer heap and the board alarm
+  LORA_CRITICAL_RADIO,  // Radio IRQ and event flags
+  LORA_CRITICAL_MAC,    // MAC and Class B event flags
+  LORA_CRITICAL_COUNT,
+} LoRaCriticalId_t;
+
+typedef struct {
+  uint32_t enters;   // Outermost enters
+  uint32_t nested;   // Enters by the owner
+  uint32_t maxUs;    // Longest hold
+  uint64_t totalUs;  // Sum of the holds
+  uint32_t bucket[LORA_CRITICAL_HIST_BUCKETS];
+} LoRaCriticalStats_t;
+
+//==========================================================================
+//==========================================================================
+void LoRaCriticalEnter(LoRaCriticalId_t aId);
+void LoRaCriticalExit(LoRaCriticalId_t aId);
+
+void LoRaCriticalGetStats(LoRaCriticalId_t aId, LoRaCriticalStats_t *aStats);
+void LoRaCriticalResetStats(void);
+void LoRaCriticalPrintStats(void);
+
+//==========================================================================
+//==========================================================================
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LORA_INC_CRITICAL_SECTION_H
@@ -15,6 +15,7 @@
 //==========================================================================
 #include "timer.h"
 
+#include <stdio.h>
 #include <sys/time.h>
 #include <time.h>
 
@@ -26,76 +27,159 @@
 #include "LoRaPlatform_debug.h"
 
 //==========================================================================
+// Started timers are kept in a binary min-heap ordered by deadline (us).
+// A single one-shot board alarm is armed for the heap top.
 //==========================================================================
 #define MAX_NUM_OF_TIMER 16
-static TimerEvent_t *gTimerList[MAX_NUM_OF_TIMER];
+#define TIMER_MIN_VALUE_US 100
+static TimerEvent_t *gTimerHeap[MAX_NUM_OF_TIMER];
+static uint8_t gTimerCount;
 
 //==========================================================================
 // Tick
 //==========================================================================
 uint32_t LoRaGetTick(void) { return (uint32_t)(esp_timer_get_time() / 1000); }
 
-uint32_t LoRaTickElapsed(uint32_t aTick) {
-  uint32_t curr_tick;
+uint64_t LoRaGetTickUs(void) { return (uint64_t)esp_timer_get_time(); }
 
-  curr_tick = LoRaGetTick();
-  if (curr_tick >= aTick) {
-    return (curr_tick - aTick);
-  } else {
-    return (0xffffffff - aTick + curr_tick);
-  }
+uint32_t LoRaTickElapsed(uint32_t aTick) {
+  // Modulo 2^32 arithmetic, correct across the tick wrap-around
+  return LoRaGetTick() - aTick;
 }
 
 //==========================================================================
+// Heap helpers. Must be called within critical section.
 //==========================================================================
-static void TimerInsertTimer(TimerEvent_t *obj) {
-  // Find a blank slot
-  for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
-    if (gTimerList[i] == NULL) {
-      gTimerList[i] = obj;
-      return;
+static bool TimerIsEarlier(const TimerEvent_t *a, const TimerEvent_t *b) { return a->Deadline < b->Deadline; }
+
+static bool TimerIsQueued(const TimerEvent_t *obj) {
+  return (obj->HeapIndex >= 0) && (obj->HeapIndex < gTimerCount) && (gTimerHeap[obj->HeapIndex] == obj);
+}
+
+static void TimerHeapSet(uint8_t aIndex, TimerEvent_t *obj) {
+  gTimerHeap[aIndex] = obj;
+  obj->HeapIndex = aIndex;
+}
+
+static void TimerHeapSiftUp(uint8_t aIndex) {
+  TimerEvent_t *obj = gTimerHeap[aIndex];
+  while (aIndex > 0) {
+    uint8_t parent = (aIndex - 1) / 2;
+    if (!TimerIsEarlier(obj, gTimerHeap[parent])) break;
+    TimerHeapSet(aIndex, gTimerHeap[parent]);
+    aIndex = parent;
+  }
+  TimerHeapSet(aIndex, obj);
+}
+
+static void TimerHeapSiftDown(uint8_t aIndex) {
+  TimerEvent_t *obj = gTimerHeap[aIndex];
+  for (;;) {
+    uint8_t child = aIndex * 2 + 1;
+    if (child >= gTimerCount) break;
+    if ((child + 1 < gTimerCount) && TimerIsEarlier(gTimerHeap[child + 1], gTimerHeap[child])) {
+      child++;
     }
+    if (!TimerIsEarlier(gTimerHeap[child], obj)) break;
+    TimerHeapSet(aIndex, gTimerHeap[child]);
+    aIndex = child;
   }
+  TimerHeapSet(aIndex, obj);
+}
 
-  // No free slot
-  printf("ERROR. TimerInsertTimer no free slot.");
+// Return false when there is no free slot
+static bool TimerInsertTimer(TimerEvent_t *obj) {
+  if (gTimerCount >= MAX_NUM_OF_TIMER) {
+    obj->HeapIndex = -1;
+    return false;
+  }
+  TimerHeapSet(gTimerCount, obj);
+  gTimerCount++;
+  TimerHeapSiftUp(obj->HeapIndex);
+  return true;
+}
+
+static void TimerRemoveTimer(TimerEvent_t *obj) {
+  uint8_t index = obj->HeapIndex;
+  gTimerCount--;
+  obj->HeapIndex = -1;
+  if (index < gTimerCount) {
+    // Move the last one into the hole, then restore the heap order
+    TimerEvent_t *last = gTimerHeap[gTimerCount];
+    TimerHeapSet(index, last);
+    TimerHeapSiftDown(index);
+    TimerHeapSiftUp(last->HeapIndex);
+  }
+  gTimerHeap[gTimerCount] = NULL;
 }
 
 //==========================================================================
+// Arm the board alarm for the earliest deadline. Return false when the
+// alarm could not be started, the caller reports it after the critical
+// section.
 //==========================================================================
-bool TimerExists(TimerEvent_t *obj) {
-  TimerEvent_t *cur = NULL;
-  for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
-    cur = gTimerList[i];
-    if (cur == obj) {
-      break;
-    }
-  }
-  if (cur == obj) {
+static bool TimerArmNext(void) {
+  if (gTimerCount == 0) {
+    LoRaBoardStopTimerAlarm();
     return true;
-  } else {
-    return false;
   }
+  uint64_t now = LoRaGetTickUs();
+  uint64_t deadline = gTimerHeap[0]->Deadline;
+  return LoRaBoardStartTimerAlarm((deadline > now) ? (deadline - now) : 0);
+}
+
+static void TimerReportArmError(void) { printf("ERROR. Failed to start board timer.\n"); }
+
+//==========================================================================
+//==========================================================================
+bool TimerExists(TimerEvent_t *obj) {
+  bool ret;
+  CRITICAL_SECTION_BEGIN(LORA_CRITICAL_TIMER);
+  ret = TimerIsQueued(obj);
+  CRITICAL_SECTION_END(LORA_CRITICAL_TIMER);
+  return ret;
 }
 
 //==========================================================================
 //==========================================================================
 void TimerPowerUpInit(void) {
   for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
-    gTimerList[i] = NULL;
+    gTimerHeap[i] = NULL;
   }
+  gTimerCount = 0;
 }
 
 //==========================================================================
 //==========================================================================
 void TimerInit(TimerEvent_t *obj, void (*callback)(void *context)) {
+  bool armed = true;
+
+  // A timer still in the heap is removed first, it must not be left there
+  // with HeapIndex -1
+  CRITICAL_SECTION_BEGIN(LORA_CRITICAL_TIMER);
+  if (TimerIsQueued(obj)) {
+    bool was_first = (obj->HeapIndex == 0);
+    TimerRemoveTimer(obj);
+    if (was_first) {
+      armed = TimerArmNext();
+    }
+  }
+  CRITICAL_SECTION_END(LORA_CRITICAL_TIMER);
+
   obj->Timestamp = 0;
   obj->ReloadValue = 0;
+  obj->ReloadValueUs = 0;
+  obj->Deadline = 0;
   obj->IsStarted = false;
   obj->IsNext2Expire = false;
   obj->Callback = callback;
   obj->Context = NULL;
   obj->Next = NULL;
+  obj->HeapIndex = -1;
+
+  if (!armed) {
+    TimerReportArmError();
+  }
 }
 
 void TimerSetContext(TimerEvent_t *obj, void *context) { obj->Context = context; }
@@ -103,27 +187,39 @@ void TimerSetContext(TimerEvent_t *obj, void *context) { obj->Context = context;
 //==========================================================================
 //==========================================================================
 void TimerStart(TimerEvent_t *obj) {
-  CRITICAL_SECTION_BEGIN();
+  bool inserted = true;
+  bool armed = true;
+
+  CRITICAL_SECTION_BEGIN(LORA_CRITICAL_TIMER);
 
   if (obj != NULL) {
+    bool was_first = false;
+    if (TimerIsQueued(obj)) {
+      was_first = (obj->HeapIndex == 0);
+      TimerRemoveTimer(obj);
+    }
+
     obj->Timestamp = LoRaGetTick();
+    obj->Deadline = LoRaGetTickUs() + obj->ReloadValueUs;
     obj->IsStarted = true;
     obj->IsNext2Expire = false;
+    inserted = TimerInsertTimer(obj);
 
-    // Find obj from timer list
-    TimerEvent_t *cur = NULL;
-    for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
-      cur = gTimerList[i];
-      if (cur == obj) {
-        break;
-      }
-    }
-    if (cur != obj) {
-      TimerInsertTimer(obj);
+    // Re-arm only when the earliest deadline changed
+    if ((was_first) || (obj->HeapIndex == 0)) {
+      armed = TimerArmNext();
     }
   }
 
-  CRITICAL_SECTION_END();
+  CRITICAL_SECTION_END(LORA_CRITICAL_TIMER);
+
+  // No printf() within the critical section
+  if (!inserted) {
+    printf("ERROR. TimerInsertTimer no free slot.");
+  }
+  if (!armed) {
+    TimerReportArmError();
+  }
 }
 
 //==========================================================================
@@ -133,51 +229,65 @@ bool TimerIsStarted(TimerEvent_t *obj) { return obj->IsStarted; }
 //==========================================================================
 //==========================================================================
 void TimerIrqHandler(void) {
-  for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
+  for (;;) {
     void (*callback)(void *) = NULL;
     void *callback_context = NULL;
+    bool done = false;
+    bool missing = false;
+    bool armed = true;
 
-    CRITICAL_SECTION_BEGIN();
-    if (gTimerList[i] != NULL) {
-      if (gTimerList[i]->IsStarted) {
-        if (LoRaTickElapsed(gTimerList[i]->Timestamp) >= gTimerList[i]->ReloadValue) {
-          gTimerList[i]->IsStarted = false;
-          if (gTimerList[i]->Callback == NULL) {
-            printf("WARN. TimerIrqHandler missing callback on slot %d.", i);
-          } else {
-            callback = gTimerList[i]->Callback;
-            callback_context = gTimerList[i]->Context;
-          }
-        }
+    CRITICAL_SECTION_BEGIN(LORA_CRITICAL_TIMER);
+    TimerEvent_t *first = (gTimerCount > 0) ? gTimerHeap[0] : NULL;
+    if ((first != NULL) && (LoRaGetTickUs() >= first->Deadline)) {
+      TimerRemoveTimer(first);
+      first->IsStarted = false;
+      if (first->Callback == NULL) {
+        missing = true;
+      } else {
+        callback = first->Callback;
+        callback_context = first->Context;
       }
+    } else {
+      armed = TimerArmNext();
+      done = true;
     }
-    CRITICAL_SECTION_END();
+    CRITICAL_SECTION_END(LORA_CRITICAL_TIMER);
 
     //
+    if (missing) {
+      printf("WARN. TimerIrqHandler missing callback.");
+    }
+    if (!armed) {
+      TimerReportArmError();
+    }
     if (callback != NULL) {
-      // LORAPLATFORM_PRINTLINE("Timer triggered. %u, %u", gTimerList[i]->Timestamp, LoRaGetTick());
       callback(callback_context);
     }
+    if (done) break;
   }
 }
 
 //==========================================================================
 //==========================================================================
 void TimerStop(TimerEvent_t *obj) {
-  CRITICAL_SECTION_BEGIN();
+  bool armed = true;
 
-  // Find obj from timer list
-  TimerEvent_t *cur = NULL;
-  for (int i = 0; i < MAX_NUM_OF_TIMER; i++) {
-    cur = gTimerList[i];
-    if (cur == obj) {
-      break;
+  CRITICAL_SECTION_BEGIN(LORA_CRITICAL_TIMER);
+
+  obj->IsStarted = false;
+  if (TimerIsQueued(obj)) {
+    bool was_first = (obj->HeapIndex == 0);
+    TimerRemoveTimer(obj);
+    if (was_first) {
+      armed = TimerArmNext();
     }
   }
-  if (cur == obj) {
-    cur->IsStarted = false;
+
+  CRITICAL_SECTION_END(LORA_CRITICAL_TIMER);
+
+  if (!armed) {
+    TimerReportArmError();
   }
-  CRITICAL_SECTION_END();
 }
 
 //==========================================================================
@@ -190,16 +300,28 @@ void TimerReset(TimerEvent_t *obj) {
 //==========================================================================
 //==========================================================================
 void TimerSetValue(TimerEvent_t *obj, uint32_t value) {
-  uint32_t minValue = 0;
   TimerStop(obj);
 
-  minValue = 10;
-  if (value < minValue) {
-    value = minValue;
+  // No polling latency to cover any more, 1 ms is enough
+  if (value < 1) {
+    value = 1;
   }
 
   obj->Timestamp = LoRaGetTick();
   obj->ReloadValue = value;
+  obj->ReloadValueUs = (uint64_t)value * 1000;
+}
+
+void TimerSetValueUs(TimerEvent_t *obj, uint32_t value) {
+  TimerStop(obj);
+
+  if (value < TIMER_MIN_VALUE_US) {
+    value = TIMER_MIN_VALUE_US;
+  }
+
+  obj->Timestamp = LoRaGetTick();
+  obj->ReloadValue = (value + 999) / 1000;
+  obj->ReloadValueUs = value;
 }
 
 //==========================================================================
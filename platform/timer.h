@@ -38,11 +38,14 @@ extern "C"
 typedef struct TimerEvent_s {
     uint32_t Timestamp;                  //! Current timer value
     uint32_t ReloadValue;                //! Timer delay value
+    uint64_t ReloadValueUs;              //! Timer delay value in us
+    uint64_t Deadline;                   //! Expiry time in us, see LoRaGetTickUs
     bool IsStarted;                      //! Is the timer currently running
     bool IsNext2Expire;                  //! Is the next timer to expire
     void ( *Callback )( void *context ); //! Timer IRQ callback function
     void *Context;                       //! User defined data object pointer to pass back
     struct TimerEvent_s *Next;           //! Pointer to the next Timer object.
+    int8_t HeapIndex;                    //! Position in the timer heap, -1 when not queued
 } TimerEvent_t;
 
 /*!
@@ -73,7 +76,10 @@ void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) );
 void TimerSetContext( TimerEvent_t *obj, void *context );
 
 /*!
- * Timer IRQ event handler
+ * \brief Timer IRQ event handler
+ *
+ * \remark Runs the callbacks of all expired timers, then arms the board
+ *         alarm for the next deadline.
  */
 void TimerIrqHandler( void );
 
@@ -116,6 +122,14 @@ void TimerReset( TimerEvent_t *obj );
  */
 void TimerSetValue( TimerEvent_t *obj, uint32_t value );
 
+/*!
+ * \brief Set timer new timeout value in microseconds
+ *
+ * \param [IN] obj   Structure containing the timer object parameters
+ * \param [IN] value New timer timeout value in us
+ */
+void TimerSetValueUs( TimerEvent_t *obj, uint32_t value );
+
 /*!
  * \brief Read the current time
  *
@@ -157,6 +171,11 @@ void TimerPowerUpInit(void);
 uint32_t LoRaGetTick(void);
 uint32_t LoRaTickElapsed(uint32_t aTick);
 
+//==========================================================================
+// 1us Tick, 64 bits, does not wrap
+//==========================================================================
+uint64_t LoRaGetTickUs(void);
+
 //==========================================================================
 //==========================================================================
 bool TimerExists(TimerEvent_t *obj);
@@ -22,6 +22,7 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include "utilities.h"
 
 /*!
@@ -84,26 +85,62 @@ int8_t Nibble2HexChar( uint8_t a )
     }
 }
 
-uint32_t LoRaCrc32( uint8_t *buffer, uint16_t length )
+/*!
+ * Slice-by-4 CRC tables, built on first use. Table 0 is the classic byte
+ * table, table n advances the CRC of table n-1 by one more zero byte.
+ */
+static uint32_t Crc32Table[4][256];
+static bool Crc32TableReady = false;
+
+static void Crc32BuildTable( void )
 {
     // The CRC calculation follows CCITT - 0x04C11DB7
     const uint32_t reversedPolynom = 0xEDB88320;
 
-    // CRC initial value
-    uint32_t crc = 0xFFFFFFFF;
+    for ( uint16_t n = 0; n < 256; n++ ) {
+        uint32_t crc = n;
+        for ( uint8_t i = 0; i < 8; i++ ) {
+            crc = ( crc >> 1 ) ^ ( reversedPolynom & ~( ( crc & 0x01 ) - 1 ) );
+        }
+        Crc32Table[0][n] = crc;
+    }
+    for ( uint16_t n = 0; n < 256; n++ ) {
+        for ( uint8_t t = 1; t < 4; t++ ) {
+            uint32_t crc = Crc32Table[t - 1][n];
+            Crc32Table[t][n] = ( crc >> 8 ) ^ Crc32Table[0][crc & 0xFF];
+        }
+    }
+    Crc32TableReady = true;
+}
 
-    if ( buffer == NULL ) {
-        return 0;
+static uint32_t Crc32Process( uint32_t crc, const uint8_t *buffer, uint16_t length )
+{
+    if ( !Crc32TableReady ) {
+        Crc32BuildTable( );
     }
 
-    for ( uint16_t i = 0; i < length; ++i ) {
-        crc ^= ( uint32_t )buffer[i];
-        for ( uint16_t i = 0; i < 8; i++ ) {
-            crc = ( crc >> 1 ) ^ ( reversedPolynom & ~( ( crc & 0x01 ) - 1 ) );
-        }
+    while ( length >= 4 ) {
+        crc ^= ( uint32_t )buffer[0] | ( ( uint32_t )buffer[1] << 8 ) | ( ( uint32_t )buffer[2] << 16 ) |
+               ( ( uint32_t )buffer[3] << 24 );
+        crc = Crc32Table[3][crc & 0xFF] ^ Crc32Table[2][( crc >> 8 ) & 0xFF] ^
+              Crc32Table[1][( crc >> 16 ) & 0xFF] ^ Crc32Table[0][crc >> 24];
+        buffer += 4;
+        length -= 4;
     }
+    while ( length-- > 0 ) {
+        crc = ( crc >> 8 ) ^ Crc32Table[0][( crc ^ *buffer++ ) & 0xFF];
+    }
+    return crc;
+}
 
-    return ~crc;
+uint32_t LoRaCrc32( uint8_t *buffer, uint16_t length )
+{
+    if ( buffer == NULL ) {
+        return 0;
+    }
+
+    // CRC initial value
+    return ~Crc32Process( 0xFFFFFFFF, buffer, length );
 }
 
 uint32_t LoRaCrc32Init( void )
@@ -113,26 +150,48 @@ uint32_t LoRaCrc32Init( void )
 
 uint32_t LoRaCrc32Update( uint32_t crcInit, uint8_t *buffer, uint16_t length )
 {
-    // The CRC calculation follows CCITT - 0x04C11DB7
-    const uint32_t reversedPolynom = 0xEDB88320;
-
-    // CRC initial value
-    uint32_t crc = crcInit;
-
     if ( buffer == NULL ) {
         return 0;
     }
 
-    for ( uint16_t i = 0; i < length; ++i ) {
-        crc ^= ( uint32_t )buffer[i];
-        for ( uint16_t i = 0; i < 8; i++ ) {
-            crc = ( crc >> 1 ) ^ ( reversedPolynom & ~( ( crc & 0x01 ) - 1 ) );
-        }
-    }
-    return crc;
+    return Crc32Process( crcInit, buffer, length );
 }
 
 uint32_t LoRaCrc32Finalize( uint32_t crc )
 {
     return ~crc;
 }
+
+static FrameCopyStats_t CopyStats;
+
+void FrameCopyCountTx( uint16_t size )
+{
+    CopyStats.TxCopies++;
+    CopyStats.TxBytes += size;
+}
+
+void FrameCopyCountTxFrame( void )
+{
+    CopyStats.TxFrames++;
+}
+
+void FrameCopyCountRx( uint16_t size )
+{
+    CopyStats.RxCopies++;
+    CopyStats.RxBytes += size;
+}
+
+void FrameCopyCountRxFrame( void )
+{
+    CopyStats.RxFrames++;
+}
+
+void FrameCopyGetStats( FrameCopyStats_t *stats )
+{
+    *stats = CopyStats;
+}
+
+void FrameCopyResetStats( void )
+{
+    memset1( ( uint8_t * )&CopyStats, 0, sizeof( CopyStats ) );
+}
@@ -30,6 +30,7 @@ extern "C"
 
 #include <stdint.h>
 #include "board.h"
+#include "critical-section.h"
 
 /*!
  * LMN (LoRaMac-node) status
@@ -176,14 +177,86 @@ uint32_t LoRaCrc32Update( uint32_t crcInit, uint8_t *buffer, uint16_t length );
 uint32_t LoRaCrc32Finalize( uint32_t crc );
 
 /*!
- * Begins critical section
+ * Payload copy counters of the uplink and downlink paths, between the
+ * application and the radio
  */
-#define CRITICAL_SECTION_BEGIN( ) LoRaBoardCriticalSectionBegin() 
+typedef struct sFrameCopyStats
+{
+    /*!
+     * Frames handed to the radio
+     */
+    uint32_t TxFrames;
+    /*!
+     * Payload copies made on the way
+     */
+    uint32_t TxCopies;
+    /*!
+     * Payload bytes copied
+     */
+    uint32_t TxBytes;
+    /*!
+     * Downlinks delivered to the application
+     */
+    uint32_t RxFrames;
+    /*!
+     * Payload copies made from the radio to the application
+     */
+    uint32_t RxCopies;
+    /*!
+     * Payload bytes copied
+     */
+    uint32_t RxBytes;
+}FrameCopyStats_t;
+
+/*!
+ * \brief Counts a copy of an uplink payload
+ *
+ * \param [IN] size Number of bytes copied
+ */
+void FrameCopyCountTx( uint16_t size );
+
+/*!
+ * \brief Counts an uplink frame handed to the radio
+ */
+void FrameCopyCountTxFrame( void );
 
 /*!
- * Ends critical section
+ * \brief Counts a copy of a downlink payload
+ *
+ * \param [IN] size Number of bytes copied
+ */
+void FrameCopyCountRx( uint16_t size );
+
+/*!
+ * \brief Counts a downlink delivered to the application
+ */
+void FrameCopyCountRxFrame( void );
+
+/*!
+ * \brief Gets the payload copy counters
+ *
+ * \param [OUT] stats Counters
+ */
+void FrameCopyGetStats( FrameCopyStats_t *stats );
+
+/*!
+ * \brief Clears the payload copy counters
+ */
+void FrameCopyResetStats( void );
+
+/*!
+ * Begins critical section of a subsystem
+ *
+ * \param [IN] id LoRaCriticalId_t of the subsystem
+ */
+#define CRITICAL_SECTION_BEGIN( id ) LoRaCriticalEnter( id )
+
+/*!
+ * Ends critical section of a subsystem
+ *
+ * \param [IN] id LoRaCriticalId_t of the subsystem
  */
-#define CRITICAL_SECTION_END( ) LoRaBoardCriticalSectionEnd()
+#define CRITICAL_SECTION_END( id ) LoRaCriticalExit( id )
 
 
 #ifdef __cplusplus
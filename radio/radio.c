@@ -15,6 +15,7 @@
 //==========================================================================
 #include "radio.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "LoRaRadio_debug.h"
@@ -72,4 +73,68 @@ void RadioHandleChipError(void) {
     LORARADIO_PRINTLINE("SX126x chip error. Try init again.");
     SX126xIoInit();
   }
-}
\ No newline at end of file
+}
+//==========================================================================
+// RX buffers
+//==========================================================================
+// One buffer per RX ring slot, and two that are never held: the one the
+// MAC is processing and the one for the next reception.
+#define RX_BUFFER_MIN_FREE 2
+#if defined(CONFIG_LORAWAN_RX_RING_SIZE)
+#define RADIO_RX_BUFFER_COUNT (CONFIG_LORAWAN_RX_RING_SIZE + RX_BUFFER_MIN_FREE)
+#else
+#define RADIO_RX_BUFFER_COUNT (4 + RX_BUFFER_MIN_FREE)
+#endif
+
+static uint8_t gRxBuffer[RADIO_RX_BUFFER_COUNT][RADIO_RX_BUFFER_SIZE] __attribute__((aligned(4)));
+static uint8_t gRxBufferHeld[RADIO_RX_BUFFER_COUNT];
+static uint8_t gRxBufferHeldCount;
+static uint8_t gRxBufferNext;
+
+static int16_t RxBufferIndex(const uint8_t *aData) {
+  if ((aData < &gRxBuffer[0][0]) || (aData >= &gRxBuffer[0][0] + sizeof(gRxBuffer))) {
+    return -1;
+  }
+  return (int16_t)((aData - &gRxBuffer[0][0]) / RADIO_RX_BUFFER_SIZE);
+}
+
+//==========================================================================
+// Buffer for the next reception, called by the chip drivers. Round robin,
+// so the buffer of the previous reception is not overwritten first.
+//==========================================================================
+uint8_t *RadioRxBufferAcquire(void) {
+  for (uint8_t i = 0; i < RADIO_RX_BUFFER_COUNT; i++) {
+    uint8_t idx = gRxBufferNext;
+    gRxBufferNext = (gRxBufferNext + 1) % RADIO_RX_BUFFER_COUNT;
+    if (__atomic_load_n(&gRxBufferHeld[idx], __ATOMIC_ACQUIRE) == 0) {
+      return gRxBuffer[idx];
+    }
+  }
+  // Not reached, RadioRxBufferHold() keeps buffers free
+  printf("ERROR. All radio RX buffers held.\n");
+  return gRxBuffer[0];
+}
+
+//==========================================================================
+// Keep the buffer containing aData from being reused.
+// Return false when too few buffers would be left for reception.
+//==========================================================================
+bool RadioRxBufferHold(const uint8_t *aData) {
+  int16_t idx = RxBufferIndex(aData);
+  if ((idx < 0) || (__atomic_load_n(&gRxBufferHeld[idx], __ATOMIC_RELAXED) != 0)) {
+    return false;
+  }
+  if (__atomic_add_fetch(&gRxBufferHeldCount, 1, __ATOMIC_RELAXED) > (RADIO_RX_BUFFER_COUNT - RX_BUFFER_MIN_FREE)) {
+    __atomic_sub_fetch(&gRxBufferHeldCount, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  __atomic_store_n(&gRxBufferHeld[idx], 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void RadioRxBufferRelease(const uint8_t *aData) {
+  int16_t idx = RxBufferIndex(aData);
+  if ((idx >= 0) && (__atomic_exchange_n(&gRxBufferHeld[idx], 0, __ATOMIC_RELEASE) != 0)) {
+    __atomic_sub_fetch(&gRxBufferHeldCount, 1, __ATOMIC_RELAXED);
+  }
+}
@@ -427,6 +427,15 @@ typedef enum RadioChip_e {
 void RadioSelectChip (RadioChip_t aRadioType);
 void RadioHandleChipError(void);
 
+// RX buffers, shared by the radio chips. Each reception is read into the
+// next free buffer, which is reused by a later reception unless it is held,
+// e.g. while a downlink is lent to the application.
+#define RADIO_RX_BUFFER_SIZE 255
+
+uint8_t *RadioRxBufferAcquire(void);
+bool RadioRxBufferHold(const uint8_t *aData);
+void RadioRxBufferRelease(const uint8_t *aData);
+
 #ifdef __cplusplus
 }
 #endif
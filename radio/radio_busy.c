@@ -0,0 +1,180 @@
+//==========================================================================
+// Radio BUSY line wait
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_busy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/task.h"
+
+//==========================================================================
+// Histogram
+//==========================================================================
+static uint8_t BucketOf(uint32_t aUs) {
+  uint8_t bucket = (aUs == 0) ? 0 : (32 - __builtin_clz(aUs));
+  return (bucket < RADIO_BUSY_HIST_BUCKETS) ? bucket : (RADIO_BUSY_HIST_BUCKETS - 1);
+}
+
+static void Record(RadioBusy_t *aBusy, uint8_t aCmd, uint32_t aUs) {
+  RadioBusyHist_t *hist = NULL;
+
+  portENTER_CRITICAL(&aBusy->lock);
+  for (uint8_t i = 0; i < aBusy->histCount; i++) {
+    if (aBusy->hist[i].cmd == aCmd) {
+      hist = &aBusy->hist[i];
+      break;
+    }
+  }
+  if ((hist == NULL) && (aBusy->histCount < RADIO_BUSY_HIST_CMDS)) {
+    hist = &aBusy->hist[aBusy->histCount++];
+    hist->cmd = aCmd;
+  }
+  if (hist != NULL) {
+    hist->count++;
+    hist->bucket[BucketOf(aUs)]++;
+    if (aUs > hist->maxUs) {
+      hist->maxUs = aUs;
+    }
+  } else {
+    aBusy->histDropped++;
+  }
+  portEXIT_CRITICAL(&aBusy->lock);
+}
+
+//==========================================================================
+// Block until the falling edge, or poll once per tick without interrupt
+//==========================================================================
+static int8_t WaitEdge(RadioBusy_t *aBusy, uint64_t aStartUs) {
+  const RadioBusyOps_t *ops = aBusy->ops;
+  uint64_t deadline = aStartUs + (uint64_t)RADIO_BUSY_TIMEOUT_MS * 1000;
+  int8_t ret = 0;
+
+  xSemaphoreTake(aBusy->edge, 0);
+  bool irq = (ops->enableIrq(aBusy) == 0);
+
+  // Check the level after enabling, the edge may have come before
+  while (ops->getLevel(aBusy) != 0) {
+    uint64_t now = ops->getTimeUs(aBusy);
+    if (now >= deadline) {
+      ret = -1;
+      break;
+    }
+    if (irq) {
+      TickType_t ticks = (deadline - now) / 1000 / portTICK_PERIOD_MS + 1;
+      xSemaphoreTake(aBusy->edge, ticks);
+    } else {
+      vTaskDelay(1);
+    }
+  }
+
+  if (irq) {
+    ops->disableIrq(aBusy);
+  }
+  return ret;
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioBusyInit(RadioBusy_t *aBusy, const RadioBusyOps_t *aOps, void *aCtx, const char *aName) {
+  memset(aBusy, 0, sizeof(RadioBusy_t));
+  aBusy->ops = aOps;
+  aBusy->ctx = aCtx;
+  aBusy->name = aName;
+  aBusy->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+  aBusy->edge = xSemaphoreCreateBinary();
+  if (aBusy->edge == NULL) {
+    printf("ERROR. RadioBusy %s create semaphore failed.\n", aName);
+    return -1;
+  }
+  return 0;
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioBusyWait(RadioBusy_t *aBusy, uint8_t aCmd) {
+  const RadioBusyOps_t *ops = aBusy->ops;
+  uint64_t start = ops->getTimeUs(aBusy);
+  uint64_t elapsed = 0;
+  int8_t ret = 0;
+  bool spin = true;
+
+  // Spin phase
+  while (ops->getLevel(aBusy) != 0) {
+    elapsed = ops->getTimeUs(aBusy) - start;
+    if (elapsed >= RADIO_BUSY_SPIN_US) {
+      spin = false;
+      ret = WaitEdge(aBusy, start);
+      elapsed = ops->getTimeUs(aBusy) - start;
+      break;
+    }
+  }
+
+  if (ret != 0) {
+    __atomic_add_fetch(&aBusy->timeouts, 1, __ATOMIC_RELAXED);
+  } else if (spin) {
+    __atomic_add_fetch(&aBusy->spinWaits, 1, __ATOMIC_RELAXED);
+  } else {
+    __atomic_add_fetch(&aBusy->irqWaits, 1, __ATOMIC_RELAXED);
+  }
+  Record(aBusy, aCmd, (elapsed < UINT32_MAX) ? (uint32_t)elapsed : UINT32_MAX);
+  return ret;
+}
+
+//==========================================================================
+//==========================================================================
+void RadioBusyIsr(RadioBusy_t *aBusy) {
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(aBusy->edge, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+//==========================================================================
+//==========================================================================
+const RadioBusyHist_t *RadioBusyGetHist(const RadioBusy_t *aBusy, uint8_t aCmd) {
+  for (uint8_t i = 0; i < aBusy->histCount; i++) {
+    if (aBusy->hist[i].cmd == aCmd) {
+      return &aBusy->hist[i];
+    }
+  }
+  return NULL;
+}
+
+//==========================================================================
+//==========================================================================
+void RadioBusyPrintStats(const RadioBusy_t *aBusy) {
+  printf("%s BUSY: spin=%u irq=%u timeout=%u\n", aBusy->name, aBusy->spinWaits, aBusy->irqWaits, aBusy->timeouts);
+  for (uint8_t i = 0; i < aBusy->histCount; i++) {
+    const RadioBusyHist_t *hist = &aBusy->hist[i];
+    printf("  cmd 0x%02X: n=%u max=%uus |", hist->cmd, hist->count, hist->maxUs);
+    for (uint8_t b = 0; b < RADIO_BUSY_HIST_BUCKETS; b++) {
+      printf(" %u", hist->bucket[b]);
+    }
+    printf("\n");
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void RadioBusyResetStats(RadioBusy_t *aBusy) {
+  portENTER_CRITICAL(&aBusy->lock);
+  aBusy->spinWaits = 0;
+  aBusy->irqWaits = 0;
+  aBusy->timeouts = 0;
+  aBusy->histDropped = 0;
+  aBusy->histCount = 0;
+  memset(aBusy->hist, 0, sizeof(aBusy->hist));
+  portEXIT_CRITICAL(&aBusy->lock);
+}
@@ -0,0 +1,90 @@
+//==========================================================================
+// Radio BUSY line wait
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Waits for the BUSY line of a radio chip to go low. Most commands finish
+// within a few us, so the wait spins first; a longer wait blocks on the
+// falling edge interrupt instead of polling once per tick. The BUSY time
+// after each command is kept in a histogram per opcode.
+//
+// The pin is an ops table, implemented on ESP-IDF by radio_busy_esp.c and
+// by a simulated pin in the host port.
+//==========================================================================
+#ifndef INC_RADIO_BUSY_H
+#define INC_RADIO_BUSY_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define RADIO_BUSY_SPIN_US 50
+#define RADIO_BUSY_TIMEOUT_MS 1000
+
+// Bucket 0 is below 1 us, bucket n is [2^(n-1), 2^n) us, the last bucket
+// is everything above.
+#define RADIO_BUSY_HIST_BUCKETS 16
+// Opcodes with a histogram, per chip
+#define RADIO_BUSY_HIST_CMDS 24
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint8_t cmd;
+  uint32_t count;
+  uint32_t maxUs;
+  uint32_t bucket[RADIO_BUSY_HIST_BUCKETS];
+} RadioBusyHist_t;
+
+typedef struct RadioBusy_s RadioBusy_t;
+
+typedef struct {
+  int (*getLevel)(RadioBusy_t *aBusy);
+  uint64_t (*getTimeUs)(RadioBusy_t *aBusy);
+  // Enable the falling edge interrupt, which calls RadioBusyIsr().
+  // Returns -1 if there is none, the wait then polls once per tick.
+  int8_t (*enableIrq)(RadioBusy_t *aBusy);
+  void (*disableIrq)(RadioBusy_t *aBusy);
+} RadioBusyOps_t;
+
+struct RadioBusy_s {
+  const RadioBusyOps_t *ops;
+  void *ctx;  // Pin implementation data
+  const char *name;
+  SemaphoreHandle_t edge;
+  portMUX_TYPE lock;
+
+  uint32_t spinWaits;   // Done in the spin phase
+  uint32_t irqWaits;    // Blocked until the falling edge
+  uint32_t timeouts;
+  uint32_t histDropped;  // Waits of opcodes beyond RADIO_BUSY_HIST_CMDS
+  uint8_t histCount;
+  RadioBusyHist_t hist[RADIO_BUSY_HIST_CMDS];
+};
+
+//==========================================================================
+//==========================================================================
+int8_t RadioBusyInit(RadioBusy_t *aBusy, const RadioBusyOps_t *aOps, void *aCtx, const char *aName);
+
+// Wait for BUSY low after the command aCmd. Returns -1 after
+// RADIO_BUSY_TIMEOUT_MS.
+int8_t RadioBusyWait(RadioBusy_t *aBusy, uint8_t aCmd);
+
+// Called by the falling edge interrupt
+void RadioBusyIsr(RadioBusy_t *aBusy);
+
+const RadioBusyHist_t *RadioBusyGetHist(const RadioBusy_t *aBusy, uint8_t aCmd);
+void RadioBusyPrintStats(const RadioBusy_t *aBusy);
+void RadioBusyResetStats(RadioBusy_t *aBusy);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_BUSY_H
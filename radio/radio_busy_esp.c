@@ -0,0 +1,74 @@
+//==========================================================================
+// Radio BUSY line on an ESP-IDF GPIO
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_busy_esp.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+//==========================================================================
+// Pin ops
+//==========================================================================
+static int EspGetLevel(RadioBusy_t *aBusy) {
+  RadioBusyEsp_t *esp = aBusy->ctx;
+  return gpio_get_level(esp->pin);
+}
+
+static uint64_t EspGetTimeUs(RadioBusy_t *aBusy) { return esp_timer_get_time(); }
+
+static int8_t EspEnableIrq(RadioBusy_t *aBusy) {
+  RadioBusyEsp_t *esp = aBusy->ctx;
+
+  if (!esp->irqAdded) {
+    return -1;
+  }
+  gpio_intr_enable(esp->pin);
+  return 0;
+}
+
+static void EspDisableIrq(RadioBusy_t *aBusy) {
+  RadioBusyEsp_t *esp = aBusy->ctx;
+  gpio_intr_disable(esp->pin);
+}
+
+static const RadioBusyOps_t kEspBusyOps = {
+    .getLevel = EspGetLevel,
+    .getTimeUs = EspGetTimeUs,
+    .enableIrq = EspEnableIrq,
+    .disableIrq = EspDisableIrq,
+};
+
+static void EspBusyIsrHandler(void *aArg) { RadioBusyIsr(aArg); }
+
+//==========================================================================
+//==========================================================================
+int8_t RadioBusyEspInit(RadioBusy_t *aBusy, RadioBusyEsp_t *aEsp, gpio_num_t aPin, const char *aName) {
+  memset(aEsp, 0, sizeof(RadioBusyEsp_t));
+  aEsp->pin = aPin;
+  if (RadioBusyInit(aBusy, &kEspBusyOps, aEsp, aName) != 0) {
+    return -1;
+  }
+
+  gpio_set_intr_type(aPin, GPIO_INTR_NEGEDGE);
+  if (gpio_isr_handler_add(aPin, EspBusyIsrHandler, aBusy) != ESP_OK) {
+    printf("ERROR. Failed to add %s BUSY IRQ handler.\n", aName);
+  } else {
+    aEsp->irqAdded = true;
+  }
+  gpio_intr_disable(aPin);
+  return 0;
+}
@@ -0,0 +1,31 @@
+//==========================================================================
+// Radio BUSY line on an ESP-IDF GPIO
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// The falling edge interrupt is added to the GPIO ISR service, which must
+// be installed before. Without it the wait polls once per tick.
+//==========================================================================
+#ifndef INC_RADIO_BUSY_ESP_H
+#define INC_RADIO_BUSY_ESP_H
+
+//==========================================================================
+//==========================================================================
+#include "driver/gpio.h"
+#include "radio_busy.h"
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  gpio_num_t pin;
+  bool irqAdded;
+} RadioBusyEsp_t;
+
+//==========================================================================
+//==========================================================================
+int8_t RadioBusyEspInit(RadioBusy_t *aBusy, RadioBusyEsp_t *aEsp, gpio_num_t aPin, const char *aName);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_BUSY_ESP_H
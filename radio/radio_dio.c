@@ -0,0 +1,129 @@
+//==========================================================================
+// Radio DIO interrupt timing
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_dio.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+//==========================================================================
+//==========================================================================
+typedef struct {
+  uint64_t edgeUs;  // First edge not dispatched yet
+  bool pending;
+  RadioDioStats_t stats;
+} DioChip_t;
+
+static const char *const kChipName[RADIO_DIO_CHIPS] = {"SX126x", "SX1280"};
+
+static DioChip_t gDioChip[RADIO_DIO_CHIPS];
+static portMUX_TYPE gDioLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Only the DIO task dispatches
+static bool gInDispatch = false;
+static uint64_t gDispatchEdgeUs;
+
+//==========================================================================
+//==========================================================================
+static uint8_t BucketOf(uint32_t aUs) {
+  uint8_t bucket = (aUs == 0) ? 0 : (32 - __builtin_clz(aUs));
+  return (bucket < RADIO_DIO_HIST_BUCKETS) ? bucket : (RADIO_DIO_HIST_BUCKETS - 1);
+}
+
+//==========================================================================
+// The first edge is kept until dispatched, it is the earliest event
+//==========================================================================
+void IRAM_ATTR RadioDioEdgeFromIsr(RadioChip_t aChip) {
+  DioChip_t *chip = &gDioChip[aChip];
+  uint64_t now = (uint64_t)esp_timer_get_time();
+
+  portENTER_CRITICAL_ISR(&gDioLock);
+  if (!chip->pending) {
+    chip->edgeUs = now;
+    chip->pending = true;
+  }
+  chip->stats.edges++;
+  portEXIT_CRITICAL_ISR(&gDioLock);
+}
+
+//==========================================================================
+//==========================================================================
+void RadioDioDispatchBegin(RadioChip_t aChip) {
+  DioChip_t *chip = &gDioChip[aChip];
+  uint64_t edge = (uint64_t)esp_timer_get_time();
+
+  portENTER_CRITICAL(&gDioLock);
+  if (chip->pending) {
+    edge = chip->edgeUs;
+    chip->pending = false;
+  }
+  portEXIT_CRITICAL(&gDioLock);
+
+  chip->stats.dispatches++;
+  gDispatchEdgeUs = edge;
+  gInDispatch = true;
+}
+
+void RadioDioDispatchPass(RadioChip_t aChip) { gDioChip[aChip].stats.passes++; }
+
+void RadioDioDispatchEnd(RadioChip_t aChip, bool aStuck) {
+  RadioDioStats_t *stats = &gDioChip[aChip].stats;
+  uint64_t elapsed = (uint64_t)esp_timer_get_time() - gDispatchEdgeUs;
+  uint32_t us = (elapsed < UINT32_MAX) ? (uint32_t)elapsed : UINT32_MAX;
+
+  gInDispatch = false;
+  if (aStuck) {
+    stats->stuck++;
+  }
+  stats->bucket[BucketOf(us)]++;
+  if (us > stats->maxUs) {
+    stats->maxUs = us;
+  }
+}
+
+//==========================================================================
+//==========================================================================
+uint64_t RadioDioGetEdgeUs(void) {
+  if (gInDispatch) {
+    return gDispatchEdgeUs;
+  }
+  return (uint64_t)esp_timer_get_time();
+}
+
+//==========================================================================
+//==========================================================================
+void RadioDioGetStats(RadioChip_t aChip, RadioDioStats_t *aStats) {
+  portENTER_CRITICAL(&gDioLock);
+  *aStats = gDioChip[aChip].stats;
+  portEXIT_CRITICAL(&gDioLock);
+}
+
+void RadioDioPrintStats(void) {
+  RadioDioStats_t stats;
+
+  for (uint8_t i = 0; i < RADIO_DIO_CHIPS; i++) {
+    RadioDioGetStats((RadioChip_t)i, &stats);
+    printf("%s DIO: edges=%u dispatches=%u passes=%u stuck=%u max=%uus |", kChipName[i], stats.edges,
+           stats.dispatches, stats.passes, stats.stuck, stats.maxUs);
+    for (uint8_t b = 0; b < RADIO_DIO_HIST_BUCKETS; b++) {
+      printf(" %u", stats.bucket[b]);
+    }
+    printf("\n");
+  }
+}
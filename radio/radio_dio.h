@@ -0,0 +1,66 @@
+//==========================================================================
+// Radio DIO interrupt timing
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// The DIO interrupt of a radio chip records the time of the edge and
+// notifies the board DIO task, which processes the IRQ of that chip at
+// once. The radio events run within that dispatch and take the edge time
+// from RadioDioGetEdgeUs(), e.g. the MAC for TxDone, so the RX windows do
+// not move with the dispatch latency. The time from the edge to the end
+// of the dispatch is kept in a histogram per chip.
+//==========================================================================
+#ifndef INC_RADIO_DIO_H
+#define INC_RADIO_DIO_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "radio.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define RADIO_DIO_CHIPS 2
+
+// Bucket 0 is below 1 us, bucket n is [2^(n-1), 2^n) us, the last bucket
+// is everything above.
+#define RADIO_DIO_HIST_BUCKETS 16
+
+// IRQ processing passes per dispatch while the DIO line stays high
+#define RADIO_DIO_MAX_PASSES 10
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint32_t edges;       // Interrupts
+  uint32_t dispatches;  // Edges seen by the task, several edges may make one
+  uint32_t passes;      // IRQ processing calls
+  uint32_t stuck;       // DIO still high after RADIO_DIO_MAX_PASSES
+  uint32_t maxUs;       // Edge to end of dispatch
+  uint32_t bucket[RADIO_DIO_HIST_BUCKETS];
+} RadioDioStats_t;
+
+//==========================================================================
+//==========================================================================
+// Called by the DIO interrupt
+void RadioDioEdgeFromIsr(RadioChip_t aChip);
+
+// Around the IRQ processing of aChip in the DIO task
+void RadioDioDispatchBegin(RadioChip_t aChip);
+void RadioDioDispatchPass(RadioChip_t aChip);
+void RadioDioDispatchEnd(RadioChip_t aChip, bool aStuck);
+
+// The DIO edge time of the IRQ in dispatch, or the current time outside a
+// dispatch [us, esp_timer_get_time()]
+uint64_t RadioDioGetEdgeUs(void);
+
+void RadioDioGetStats(RadioChip_t aChip, RadioDioStats_t *aStats);
+void RadioDioPrintStats(void);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_DIO_H
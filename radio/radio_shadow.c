@@ -0,0 +1,169 @@
+//==========================================================================
+// Radio configuration shadow
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_shadow.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//==========================================================================
+// Defines
+//==========================================================================
+// Opcode and address, or opcode and offset, on the wire
+#define REGISTER_HEADER_SIZE 3
+#define BUFFER_HEADER_SIZE 2
+
+//==========================================================================
+//==========================================================================
+static void CountSkipped(RadioShadow_t *aShadow, uint16_t aBytes) {
+  aShadow->stats.skippedCommands++;
+  aShadow->stats.skippedBytes += aBytes;
+}
+
+static RadioShadowReg_t *FindRegister(const RadioShadow_t *aShadow, uint16_t aAddress) {
+  for (uint8_t i = 0; i < aShadow->regCount; i++) {
+    if (aShadow->reg[i].address == aAddress) {
+      return (RadioShadowReg_t *)&aShadow->reg[i];
+    }
+  }
+  return NULL;
+}
+
+//==========================================================================
+//==========================================================================
+void RadioShadowInvalidate(RadioShadow_t *aShadow, uint8_t aParts) {
+  if (aParts & RADIO_SHADOW_COMMANDS) {
+    aShadow->cmdCount = 0;
+  }
+  if (aParts & RADIO_SHADOW_REGISTERS) {
+    aShadow->regCount = 0;
+  }
+  if (aParts & RADIO_SHADOW_PAYLOAD) {
+    aShadow->payloadValid = false;
+  }
+}
+
+//==========================================================================
+//==========================================================================
+bool RadioShadowCommand(RadioShadow_t *aShadow, uint8_t aOpcode, const uint8_t *aData, uint16_t aSize) {
+  RadioShadowCmd_t *cmd = NULL;
+
+  if (aSize > RADIO_SHADOW_CMD_SIZE) {
+    return true;
+  }
+  for (uint8_t i = 0; i < aShadow->cmdCount; i++) {
+    if (aShadow->cmd[i].opcode == aOpcode) {
+      cmd = &aShadow->cmd[i];
+      break;
+    }
+  }
+  if (cmd == NULL) {
+    if (aShadow->cmdCount >= RADIO_SHADOW_CMDS) {
+      return true;
+    }
+    cmd = &aShadow->cmd[aShadow->cmdCount++];
+    cmd->opcode = aOpcode;
+  } else if ((cmd->size == aSize) && (memcmp(cmd->data, aData, aSize) == 0)) {
+    CountSkipped(aShadow, 1 + aSize);
+    return false;
+  }
+  cmd->size = (uint8_t)aSize;
+  memcpy(cmd->data, aData, aSize);
+  return true;
+}
+
+//==========================================================================
+//==========================================================================
+bool RadioShadowWriteRegister(RadioShadow_t *aShadow, uint16_t aAddress, uint8_t aValue) {
+  RadioShadowReg_t *reg = FindRegister(aShadow, aAddress);
+
+  if ((reg != NULL) && (reg->value == aValue)) {
+    CountSkipped(aShadow, REGISTER_HEADER_SIZE + 1);
+    return false;
+  }
+  RadioShadowStoreRegister(aShadow, aAddress, aValue);
+  return true;
+}
+
+bool RadioShadowReadRegister(const RadioShadow_t *aShadow, uint16_t aAddress, uint8_t *aValue) {
+  const RadioShadowReg_t *reg = FindRegister(aShadow, aAddress);
+
+  if (reg == NULL) {
+    return false;
+  }
+  *aValue = reg->value;
+  return true;
+}
+
+void RadioShadowStoreRegister(RadioShadow_t *aShadow, uint16_t aAddress, uint8_t aValue) {
+  RadioShadowReg_t *reg = FindRegister(aShadow, aAddress);
+
+  if (reg == NULL) {
+    if (aShadow->regCount >= RADIO_SHADOW_REGS) {
+      return;
+    }
+    reg = &aShadow->reg[aShadow->regCount++];
+    reg->address = aAddress;
+  }
+  reg->value = aValue;
+}
+
+//==========================================================================
+//==========================================================================
+bool RadioShadowHasPayload(const RadioShadow_t *aShadow, uint8_t aOffset, const uint8_t *aData, uint8_t aSize) {
+  return aShadow->payloadValid && (aShadow->payloadOffset == aOffset) && (aShadow->payloadSize == aSize) &&
+         (memcmp(aShadow->payload, aData, aSize) == 0);
+}
+
+bool RadioShadowWritePayload(RadioShadow_t *aShadow, uint8_t aOffset, const uint8_t *aData, uint8_t aSize) {
+  if (RadioShadowHasPayload(aShadow, aOffset, aData, aSize)) {
+    CountSkipped(aShadow, BUFFER_HEADER_SIZE + aSize);
+    aShadow->stats.payloadReuses++;
+    return false;
+  }
+  aShadow->payloadValid = true;
+  aShadow->payloadOffset = aOffset;
+  aShadow->payloadSize = aSize;
+  memcpy(aShadow->payload, aData, aSize);
+  return true;
+}
+
+//==========================================================================
+//==========================================================================
+void RadioShadowCountSpi(RadioShadow_t *aShadow, uint16_t aBytes) {
+  aShadow->stats.commands++;
+  aShadow->stats.bytes += aBytes;
+}
+
+void RadioShadowUplink(RadioShadow_t *aShadow) {
+  aShadow->stats.uplinks++;
+  aShadow->stats.uplinkCommands = aShadow->stats.commands - aShadow->uplinkStartCommands;
+  aShadow->stats.uplinkBytes = aShadow->stats.bytes - aShadow->uplinkStartBytes;
+  aShadow->uplinkStartCommands = aShadow->stats.commands;
+  aShadow->uplinkStartBytes = aShadow->stats.bytes;
+}
+
+//==========================================================================
+//==========================================================================
+void RadioShadowGetStats(const RadioShadow_t *aShadow, RadioShadowStats_t *aStats) { *aStats = aShadow->stats; }
+
+void RadioShadowPrintStats(const RadioShadow_t *aShadow) {
+  const RadioShadowStats_t *stats = &aShadow->stats;
+
+  printf("%s SPI: %u commands %u bytes, skipped %u commands %u bytes, payload reused %u\n", aShadow->name,
+         stats->commands, stats->bytes, stats->skippedCommands, stats->skippedBytes, stats->payloadReuses);
+  printf("%s SPI last uplink: %u commands %u bytes (%u uplinks)\n", aShadow->name, stats->uplinkCommands,
+         stats->uplinkBytes, stats->uplinks);
+}
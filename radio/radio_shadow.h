@@ -0,0 +1,112 @@
+//==========================================================================
+// Radio configuration shadow
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Keeps the configuration last applied to a radio chip, so the chip
+// drivers send only what changed. A configuration command is skipped when
+// its parameters equal the last ones sent with the same opcode, a register
+// write when the register already holds the value, and the TX payload when
+// the same payload is still in the chip buffer, e.g. for a retransmission.
+//
+// The chip driver invalidates the shadow when the chip loses its state:
+// reset, sleep, a packet type change, or a reception into the buffer.
+//
+// The HAL counts the SPI commands and bytes sent, per uplink and in total.
+//==========================================================================
+#ifndef INC_RADIO_SHADOW_H
+#define INC_RADIO_SHADOW_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define RADIO_SHADOW_CMDS 12
+#define RADIO_SHADOW_CMD_SIZE 9  // SX126x GFSK packet parameters
+#define RADIO_SHADOW_REGS 12
+#define RADIO_SHADOW_PAYLOAD_SIZE 255
+
+// Parts for RadioShadowInvalidate()
+#define RADIO_SHADOW_COMMANDS 0x01
+#define RADIO_SHADOW_REGISTERS 0x02
+#define RADIO_SHADOW_PAYLOAD 0x04
+#define RADIO_SHADOW_ALL (RADIO_SHADOW_COMMANDS | RADIO_SHADOW_REGISTERS | RADIO_SHADOW_PAYLOAD)
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  uint32_t commands;  // Sent
+  uint32_t bytes;
+  uint32_t skippedCommands;
+  uint32_t skippedBytes;
+  uint32_t payloadReuses;
+
+  uint32_t uplinks;
+  uint32_t uplinkCommands;  // Since the previous uplink, up to SetTx
+  uint32_t uplinkBytes;
+} RadioShadowStats_t;
+
+typedef struct {
+  uint8_t opcode;
+  uint8_t size;
+  uint8_t data[RADIO_SHADOW_CMD_SIZE];
+} RadioShadowCmd_t;
+
+typedef struct {
+  uint16_t address;
+  uint8_t value;
+} RadioShadowReg_t;
+
+typedef struct {
+  const char *name;
+
+  uint8_t cmdCount;
+  RadioShadowCmd_t cmd[RADIO_SHADOW_CMDS];
+  uint8_t regCount;
+  RadioShadowReg_t reg[RADIO_SHADOW_REGS];
+
+  bool payloadValid;
+  uint8_t payloadOffset;
+  uint8_t payloadSize;
+  uint8_t payload[RADIO_SHADOW_PAYLOAD_SIZE];
+
+  RadioShadowStats_t stats;
+  uint32_t uplinkStartCommands;
+  uint32_t uplinkStartBytes;
+} RadioShadow_t;
+
+//==========================================================================
+//==========================================================================
+void RadioShadowInvalidate(RadioShadow_t *aShadow, uint8_t aParts);
+
+// Return true if the command must be sent. Commands beyond
+// RADIO_SHADOW_CMDS opcodes or RADIO_SHADOW_CMD_SIZE bytes are always sent.
+bool RadioShadowCommand(RadioShadow_t *aShadow, uint8_t aOpcode, const uint8_t *aData, uint16_t aSize);
+
+// Return true if the register must be written
+bool RadioShadowWriteRegister(RadioShadow_t *aShadow, uint16_t aAddress, uint8_t aValue);
+// Return false if the register is not known, it must then be read
+bool RadioShadowReadRegister(const RadioShadow_t *aShadow, uint16_t aAddress, uint8_t *aValue);
+void RadioShadowStoreRegister(RadioShadow_t *aShadow, uint16_t aAddress, uint8_t aValue);
+
+// True if the payload is in the chip buffer at aOffset
+bool RadioShadowHasPayload(const RadioShadow_t *aShadow, uint8_t aOffset, const uint8_t *aData, uint8_t aSize);
+// Return true if the payload must be written
+bool RadioShadowWritePayload(RadioShadow_t *aShadow, uint8_t aOffset, const uint8_t *aData, uint8_t aSize);
+
+// Called by the HAL for each SPI command sent
+void RadioShadowCountSpi(RadioShadow_t *aShadow, uint16_t aBytes);
+// Called by the chip driver before SetTx
+void RadioShadowUplink(RadioShadow_t *aShadow);
+
+void RadioShadowGetStats(const RadioShadow_t *aShadow, RadioShadowStats_t *aStats);
+void RadioShadowPrintStats(const RadioShadow_t *aShadow);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_SHADOW_H
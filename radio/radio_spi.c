@@ -0,0 +1,164 @@
+//==========================================================================
+// Radio SPI transactions
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_spi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//==========================================================================
+// Wait for the oldest transfer in flight
+//==========================================================================
+static void WaitOldest(RadioSpiBus_t *aBus) {
+  if (aBus->ops->waitDone(aBus) != 0) {
+    printf("ERROR. RadioSpi %s transfer failed.\n", aBus->name);
+    aBus->error = -1;
+  }
+  aBus->head = (aBus->head + 1) % RADIO_SPI_QUEUE_DEPTH;
+  aBus->pending--;
+}
+
+static void WaitAll(RadioSpiBus_t *aBus) {
+  while (aBus->pending > 0) {
+    WaitOldest(aBus);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiInit(RadioSpiBus_t *aBus, const RadioSpiBusOps_t *aOps, void *aCtx, const char *aName) {
+  memset(aBus, 0, sizeof(RadioSpiBus_t));
+  aBus->ops = aOps;
+  aBus->ctx = aCtx;
+  aBus->name = aName;
+  aBus->lock = xSemaphoreCreateMutex();
+  if (aBus->lock == NULL) {
+    printf("ERROR. RadioSpi %s create mutex failed.\n", aName);
+    return -1;
+  }
+  return 0;
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiBegin(RadioSpiBus_t *aBus) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+  if ((aBus->depth > 0) && (aBus->owner == self)) {
+    aBus->depth++;
+    return 0;
+  }
+
+  xSemaphoreTake(aBus->lock, portMAX_DELAY);
+  if (aBus->ops->acquire(aBus) != 0) {
+    printf("ERROR. RadioSpi %s acquire bus failed.\n", aBus->name);
+    xSemaphoreGive(aBus->lock);
+    return -1;
+  }
+  aBus->owner = self;
+  aBus->depth = 1;
+  aBus->error = 0;
+  aBus->sent = false;
+  aBus->notReady = false;
+  return 0;
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiEnd(RadioSpiBus_t *aBus) {
+  int8_t ret;
+
+  if (aBus->depth > 1) {
+    aBus->depth--;
+    return aBus->error;
+  }
+
+  WaitAll(aBus);
+  ret = aBus->error;
+  aBus->ops->release(aBus);
+  aBus->owner = NULL;
+  aBus->depth = 0;
+  xSemaphoreGive(aBus->lock);
+  return ret;
+}
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiTransfer(RadioSpiBus_t *aBus, const RadioSpiXfer_t *aXfer) {
+  uint8_t index;
+  RadioSpiXfer_t *slot;
+  int8_t ret = 0;
+
+  if (RadioSpiBegin(aBus) != 0) {
+    return -1;
+  }
+
+  // A chained command is taken once the chip has finished the one before.
+  // Wait for it here, not in the SPI interrupt, and drop the transfer if
+  // the chip stays busy.
+  if (aXfer->waitReady && aBus->sent && (aBus->ops->waitReady != NULL)) {
+    WaitAll(aBus);
+    if (aBus->notReady || (aBus->ops->waitReady(aBus, aBus->lastCmd) != 0)) {
+      if (!aBus->notReady) {
+        printf("ERROR. RadioSpi %s chip not ready.\n", aBus->name);
+      }
+      aBus->notReady = true;
+      aBus->error = -1;
+      RadioSpiEnd(aBus);
+      return -1;
+    }
+    aBus->sent = false;
+  }
+
+  // Make room in the queue
+  if (aBus->pending >= RADIO_SPI_QUEUE_DEPTH) {
+    WaitOldest(aBus);
+  }
+
+  index = (aBus->head + aBus->pending) % RADIO_SPI_QUEUE_DEPTH;
+  slot = &aBus->slot[index];
+  *slot = *aXfer;
+  if ((aXfer->txData != NULL) && (aXfer->length <= RADIO_SPI_INLINE_SIZE)) {
+    memcpy(aBus->inlineTx[index], aXfer->txData, aXfer->length);
+    slot->txData = aBus->inlineTx[index];
+  }
+
+  if (aBus->ops->submit(aBus, index) != 0) {
+    printf("ERROR. RadioSpi %s submit failed.\n", aBus->name);
+    aBus->error = -1;
+    ret = -1;
+  } else {
+    aBus->pending++;
+    aBus->sent = true;
+    aBus->lastCmd = aXfer->cmd;
+  }
+
+  // A read, or a transfer outside of a chain, returns when it is done
+  if ((aXfer->rxData != NULL) || (aBus->depth == 1)) {
+    WaitAll(aBus);
+    if (aBus->error != 0) {
+      ret = -1;
+    }
+  }
+
+  RadioSpiEnd(aBus);
+  return ret;
+}
+
+//==========================================================================
+//==========================================================================
+bool RadioSpiInChain(const RadioSpiBus_t *aBus) {
+  return (aBus->depth > 0) && (aBus->owner == xTaskGetCurrentTaskHandle());
+}
@@ -0,0 +1,108 @@
+//==========================================================================
+// Radio SPI transactions
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Queues the command transfers of a radio chip to an SPI bus and lets the
+// caller block until they are done, so the CPU is free while the DMA runs.
+// Several commands can be chained under one bus acquisition with
+// RadioSpiBegin() and RadioSpiEnd(); inside a chain a write returns once it
+// is queued. The caller waits for the BUSY line before the chain, and a
+// transfer after the first one waits for it here, in the calling task.
+//
+// The bus is an ops table, implemented on ESP-IDF by radio_spi_esp.c and
+// by a mock SPI in the host port.
+//==========================================================================
+#ifndef INC_RADIO_SPI_H
+#define INC_RADIO_SPI_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+// Transfers in flight per chip
+#define RADIO_SPI_QUEUE_DEPTH 4
+
+// Write data up to this size is copied into the transfer slot, so the caller
+// buffer can be reused once RadioSpiTransfer() returns. Longer write data is
+// sent from the caller buffer, which must stay valid until RadioSpiEnd().
+#define RADIO_SPI_INLINE_SIZE 16
+
+//==========================================================================
+// Types
+//==========================================================================
+// One command transfer: opcode, optional address phase, then data
+typedef struct {
+  uint8_t cmd;
+  uint8_t addrBits;       // 0, 8, 16 or 24
+  uint32_t addr;
+  const uint8_t *txData;  // NULL to send zeros
+  uint8_t *rxData;        // NULL when nothing is read
+  uint16_t length;        // Data phase [bytes]
+  bool waitReady;         // Wait for the chip BUSY line before the transfer
+} RadioSpiXfer_t;
+
+typedef struct RadioSpiBus_s RadioSpiBus_t;
+
+// Bus implementation. The transfers of one bus complete in submit order.
+typedef struct {
+  int8_t (*acquire)(RadioSpiBus_t *aBus);
+  void (*release)(RadioSpiBus_t *aBus);
+  // Start a transfer and return. The transfer is in aBus->slot[aSlot] until done.
+  int8_t (*submit)(RadioSpiBus_t *aBus, uint8_t aSlot);
+  // Block until the oldest submitted transfer is done
+  int8_t (*waitDone)(RadioSpiBus_t *aBus);
+  // Block until the chip takes a command again after aCmd. Called with no
+  // transfer in flight. NULL if the chip has no BUSY line.
+  int8_t (*waitReady)(RadioSpiBus_t *aBus, uint8_t aCmd);
+} RadioSpiBusOps_t;
+
+struct RadioSpiBus_s {
+  const RadioSpiBusOps_t *ops;
+  void *ctx;  // Bus implementation data
+  const char *name;
+
+  SemaphoreHandle_t lock;
+  TaskHandle_t owner;
+  uint8_t depth;    // Nesting of RadioSpiBegin()
+  uint8_t head;     // Oldest transfer in flight
+  uint8_t pending;  // Transfers in flight
+  int8_t error;     // Set by a failed transfer, returned by RadioSpiEnd()
+  bool sent;        // A transfer was queued since the chip was last ready
+  bool notReady;    // The chip stayed busy, the rest of the chain is dropped
+  uint8_t lastCmd;  // Opcode of the last queued transfer
+
+  RadioSpiXfer_t slot[RADIO_SPI_QUEUE_DEPTH];
+  uint8_t inlineTx[RADIO_SPI_QUEUE_DEPTH][RADIO_SPI_INLINE_SIZE] __attribute__((aligned(4)));
+};
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiInit(RadioSpiBus_t *aBus, const RadioSpiBusOps_t *aOps, void *aCtx, const char *aName);
+
+// Chain the following transfers under one bus acquisition. Nested calls by
+// the same task are allowed.
+int8_t RadioSpiBegin(RadioSpiBus_t *aBus);
+// Wait for the chained transfers and release the bus. Returns -1 if any of
+// them failed.
+int8_t RadioSpiEnd(RadioSpiBus_t *aBus);
+
+// Outside of a chain, and for reads, returns when the transfer is done, with
+// -1 if it or a transfer chained before it failed. Inside a chain, a write
+// returns when it is queued.
+int8_t RadioSpiTransfer(RadioSpiBus_t *aBus, const RadioSpiXfer_t *aXfer);
+
+// True if the calling task is inside RadioSpiBegin() / RadioSpiEnd()
+bool RadioSpiInChain(const RadioSpiBus_t *aBus);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_SPI_H
@@ -0,0 +1,105 @@
+//==========================================================================
+// Radio SPI transactions on the ESP-IDF SPI master driver
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_spi_esp.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//==========================================================================
+// Variables
+//==========================================================================
+// Sent when a transfer has no write data, e.g. the NOPs of a read
+static uint8_t gZeros[256] __attribute__((aligned(4)));
+
+//==========================================================================
+// Bus ops
+//==========================================================================
+static int8_t EspAcquire(RadioSpiBus_t *aBus) {
+  RadioSpiEsp_t *esp = aBus->ctx;
+
+  if (spi_device_acquire_bus(esp->dev, portMAX_DELAY) != ESP_OK) {
+    return -1;
+  }
+  return 0;
+}
+
+static void EspRelease(RadioSpiBus_t *aBus) {
+  RadioSpiEsp_t *esp = aBus->ctx;
+  spi_device_release_bus(esp->dev);
+}
+
+static int8_t EspSubmit(RadioSpiBus_t *aBus, uint8_t aSlot) {
+  RadioSpiEsp_t *esp = aBus->ctx;
+  const RadioSpiXfer_t *xfer = &aBus->slot[aSlot];
+  spi_transaction_ext_t *trans = &esp->trans[aSlot];
+
+  if ((xfer->txData == NULL) && (xfer->length > sizeof(gZeros))) {
+    return -1;
+  }
+
+  // The opcode and address go in the command and address phases, the data
+  // phase uses the caller buffers.
+  memset(trans, 0, sizeof(spi_transaction_ext_t));
+  trans->base.flags = SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR;
+  trans->base.cmd = xfer->cmd;
+  trans->base.addr = xfer->addr;
+  trans->command_bits = 8;
+  trans->address_bits = xfer->addrBits;
+  trans->base.length = xfer->length * 8;
+  trans->base.tx_buffer = (xfer->txData != NULL) ? xfer->txData : gZeros;
+  if (xfer->rxData != NULL) {
+    trans->base.rxlength = xfer->length * 8;
+    trans->base.rx_buffer = xfer->rxData;
+  }
+
+  if (spi_device_queue_trans(esp->dev, &trans->base, portMAX_DELAY) != ESP_OK) {
+    return -1;
+  }
+  return 0;
+}
+
+static int8_t EspWaitDone(RadioSpiBus_t *aBus) {
+  RadioSpiEsp_t *esp = aBus->ctx;
+  spi_transaction_t *trans;
+
+  if (spi_device_get_trans_result(esp->dev, &trans, portMAX_DELAY) != ESP_OK) {
+    return -1;
+  }
+  return 0;
+}
+
+static int8_t EspWaitReady(RadioSpiBus_t *aBus, uint8_t aCmd) {
+  RadioSpiEsp_t *esp = aBus->ctx;
+  return RadioBusyWait(esp->busy, aCmd);
+}
+
+static const RadioSpiBusOps_t kEspBusOps = {
+    .acquire = EspAcquire,
+    .release = EspRelease,
+    .submit = EspSubmit,
+    .waitDone = EspWaitDone,
+    .waitReady = EspWaitReady,
+};
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiEspInit(RadioSpiBus_t *aBus, RadioSpiEsp_t *aEsp, spi_device_handle_t aDev, RadioBusy_t *aBusy,
+                       const char *aName) {
+  memset(aEsp, 0, sizeof(RadioSpiEsp_t));
+  aEsp->dev = aDev;
+  aEsp->busy = aBusy;
+  return RadioSpiInit(aBus, &kEspBusOps, aEsp, aName);
+}
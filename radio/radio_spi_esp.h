@@ -0,0 +1,36 @@
+//==========================================================================
+// Radio SPI transactions on the ESP-IDF SPI master driver
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Transfers are queued to the device with spi_device_queue_trans(), and
+// the caller sleeps in spi_device_get_trans_result() while the DMA runs.
+// Before a chained transfer the calling task waits for the BUSY line of
+// the chip with RadioBusyWait(), the SPI interrupt does not wait.
+//==========================================================================
+#ifndef INC_RADIO_SPI_ESP_H
+#define INC_RADIO_SPI_ESP_H
+
+//==========================================================================
+//==========================================================================
+#include "driver/spi_master.h"
+#include "radio_busy.h"
+#include "radio_spi.h"
+
+//==========================================================================
+// Types
+//==========================================================================
+typedef struct {
+  spi_device_handle_t dev;
+  RadioBusy_t *busy;
+  spi_transaction_ext_t trans[RADIO_SPI_QUEUE_DEPTH];
+} RadioSpiEsp_t;
+
+//==========================================================================
+//==========================================================================
+int8_t RadioSpiEspInit(RadioSpiBus_t *aBus, RadioSpiEsp_t *aEsp, spi_device_handle_t aDev, RadioBusy_t *aBusy,
+                       const char *aName);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_SPI_ESP_H
@@ -434,7 +434,6 @@ bool RxContinuous = false;
 
 
 PacketStatus_t RadioPktStatus;
-uint8_t RadioRxPayload[255];
 
 bool IrqFired = false;
 
@@ -574,14 +573,14 @@ void RadioSetModem( RadioModems_t modem )
         if( RadioPublicNetwork.Current == true )
         {
             // Change LoRa modem SyncWord
-            SX126xWriteRegister( REG_LR_SYNCWORD, ( LORA_MAC_PUBLIC_SYNCWORD >> 8 ) & 0xFF );
-            SX126xWriteRegister( REG_LR_SYNCWORD + 1, LORA_MAC_PUBLIC_SYNCWORD & 0xFF );
+            SX126xSetConfigRegister( REG_LR_SYNCWORD, ( LORA_MAC_PUBLIC_SYNCWORD >> 8 ) & 0xFF );
+            SX126xSetConfigRegister( REG_LR_SYNCWORD + 1, LORA_MAC_PUBLIC_SYNCWORD & 0xFF );
         }
         else
         {
             // Change LoRa modem SyncWord
-            SX126xWriteRegister( REG_LR_SYNCWORD, ( LORA_MAC_PRIVATE_SYNCWORD >> 8 ) & 0xFF );
-            SX126xWriteRegister( REG_LR_SYNCWORD + 1, LORA_MAC_PRIVATE_SYNCWORD & 0xFF );
+            SX126xSetConfigRegister( REG_LR_SYNCWORD, ( LORA_MAC_PRIVATE_SYNCWORD >> 8 ) & 0xFF );
+            SX126xSetConfigRegister( REG_LR_SYNCWORD + 1, LORA_MAC_PRIVATE_SYNCWORD & 0xFF );
         }
         break;
     }
@@ -755,11 +754,11 @@ void RadioSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
             // WORKAROUND - Optimizing the Inverted IQ Operation, see DS_SX1261-2_V1.2 datasheet chapter 15.4
             if( SX126x.PacketParams.Params.LoRa.InvertIQ == LORA_IQ_INVERTED )
             {
-                SX126xWriteRegister( REG_IQ_POLARITY, SX126xReadRegister( REG_IQ_POLARITY ) & ~( 1 << 2 ) );
+                SX126xSetConfigRegister( REG_IQ_POLARITY, SX126xGetConfigRegister( REG_IQ_POLARITY ) & ~( 1 << 2 ) );
             }
             else
             {
-                SX126xWriteRegister( REG_IQ_POLARITY, SX126xReadRegister( REG_IQ_POLARITY ) | ( 1 << 2 ) );
+                SX126xSetConfigRegister( REG_IQ_POLARITY, SX126xGetConfigRegister( REG_IQ_POLARITY ) | ( 1 << 2 ) );
             }
             // WORKAROUND END
 
@@ -864,11 +863,11 @@ void RadioSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
     // WORKAROUND - Modulation Quality with 500 kHz LoRa Bandwidth, see DS_SX1261-2_V1.2 datasheet chapter 15.1
     if( ( modem == MODEM_LORA ) && ( SX126x.ModulationParams.Params.LoRa.Bandwidth == LORA_BW_500 ) )
     {
-        SX126xWriteRegister( REG_TX_MODULATION, SX126xReadRegister( REG_TX_MODULATION ) & ~( 1 << 2 ) );
+        SX126xSetConfigRegister( REG_TX_MODULATION, SX126xGetConfigRegister( REG_TX_MODULATION ) & ~( 1 << 2 ) );
     }
     else
     {
-        SX126xWriteRegister( REG_TX_MODULATION, SX126xReadRegister( REG_TX_MODULATION ) | ( 1 << 2 ) );
+        SX126xSetConfigRegister( REG_TX_MODULATION, SX126xGetConfigRegister( REG_TX_MODULATION ) | ( 1 << 2 ) );
     }
     // WORKAROUND END
 
@@ -1037,6 +1036,8 @@ uint32_t RadioTimeOnAir( RadioModems_t modem, uint32_t bandwidth,
 
 void RadioSend( uint8_t *buffer, uint8_t size )
 {
+    // Queue the TX setup, payload and SetTx under one SPI bus acquisition
+    SX126xChainBegin( );
     SX126xSetDioIrqParams( IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT,
                            IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT,
                            IRQ_RADIO_NONE,
@@ -1053,6 +1054,7 @@ void RadioSend( uint8_t *buffer, uint8_t size )
     SX126xSetPacketParams( &SX126x.PacketParams );
 
     SX126xSendPayload( buffer, size, 0 );
+    SX126xChainEnd( );
     TimerSetValue( &TxTimeoutTimer, TxTimeout );
     TimerStart( &TxTimeoutTimer );
 }
@@ -1074,7 +1076,9 @@ void RadioStandby( void )
 
 void RadioRx( uint32_t timeout )
 {
-    SX126xSetDioIrqParams( IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT,
+    // The sync word and header IRQs are latched only, they tell
+    // SX126xSetPayload that a reception overwrote the data buffer
+    SX126xSetDioIrqParams( IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT | IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID,
                            IRQ_RX_DONE | IRQ_RX_TX_TIMEOUT,
                            IRQ_RADIO_NONE,
                            IRQ_RADIO_NONE );
@@ -1179,6 +1183,8 @@ int16_t RadioRssi( RadioModems_t modem )
 
 void RadioWrite( uint32_t addr, uint8_t data )
 {
+    // Written around the shadow
+    RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_REGISTERS );
     SX126xWriteRegister( addr, data );
 }
 
@@ -1189,6 +1195,7 @@ uint8_t RadioRead( uint32_t addr )
 
 void RadioWriteBuffer( uint32_t addr, uint8_t *buffer, uint8_t size )
 {
+    RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_REGISTERS );
     SX126xWriteRegisters( addr, buffer, size );
 }
 
@@ -1262,11 +1269,11 @@ void RadioOnDioIrq( void* context )
 
 void RadioIrqProcess( void )
 {
-    CRITICAL_SECTION_BEGIN( );
+    CRITICAL_SECTION_BEGIN( LORA_CRITICAL_RADIO );
     // Clear IRQ flag
     const bool isIrqFired = IrqFired;
     IrqFired = false;
-    CRITICAL_SECTION_END( );
+    CRITICAL_SECTION_END( LORA_CRITICAL_RADIO );
 
     if( isIrqFired == true )
     {
@@ -1275,12 +1282,12 @@ void RadioIrqProcess( void )
         // LORARADIO_PRINTLINE("irqRegs=%04X", irqRegs);
 
         // Check if DIO1 pin is High. If it is the case revert IrqFired to true
-        CRITICAL_SECTION_BEGIN( );
+        CRITICAL_SECTION_BEGIN( LORA_CRITICAL_RADIO );
         if( SX126xGetDio1PinState( ) == 1 )
         {
             IrqFired = true;
         }
-        CRITICAL_SECTION_END( );
+        CRITICAL_SECTION_END( LORA_CRITICAL_RADIO );
 
         if( ( irqRegs & IRQ_TX_DONE ) == IRQ_TX_DONE )
         {
@@ -1323,11 +1330,13 @@ void RadioIrqProcess( void )
                     SX126xWriteRegister( REG_EVT_CLR, SX126xReadRegister( REG_EVT_CLR ) | ( 1 << 1 ) );
                     // WORKAROUND END
                 }
-                SX126xGetPayload( RadioRxPayload, &size , 255 );
+                // The MAC parses and decrypts the frame in this buffer
+                uint8_t *rxPayload = RadioRxBufferAcquire( );
+                SX126xGetPayload( rxPayload, &size , RADIO_RX_BUFFER_SIZE );
                 SX126xGetPacketStatus( &RadioPktStatus );
                 if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
                 {
-                    RadioEvents->RxDone( RadioRxPayload, size, RadioPktStatus.Params.LoRa.RssiPkt, RadioPktStatus.Params.LoRa.SnrPkt );
+                    RadioEvents->RxDone( rxPayload, size, RadioPktStatus.Params.LoRa.RssiPkt, RadioPktStatus.Params.LoRa.SnrPkt );
                 }
             }
         }
@@ -1,6 +1,5 @@
 //==========================================================================
 //==========================================================================
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -8,6 +7,7 @@
 #include "board.h"
 #include "delay.h"
 #include "radio.h"
+#include "radio_toa.h"
 #include "sx1280-hal.h"
 #include "sx1280.h"
 #include "timer.h"
@@ -18,13 +18,6 @@
 #define LORA_MAC_PRIVATE_SYNCWORD 0x1424
 #define LORA_MAC_PUBLIC_SYNCWORD 0x3444
 
-#define max(a, b)           \
-  ({                        \
-    __typeof__(a) _a = (a); \
-    __typeof__(b) _b = (b); \
-    _a > _b ? _a : _b;      \
-  })
-
 //==========================================================================
 //==========================================================================
 /*!
@@ -369,7 +362,6 @@ static uint32_t RxTimeout = 0;
 static bool RxContinuous = false;
 
 static PacketStatus_t RadioPktStatus;
-static uint8_t RadioRxPayload[255];
 
 static bool IrqFired = false;
 
@@ -492,11 +484,11 @@ static void RadioSetModem(RadioModems_t modem) {
       SX1280SetPacketType(PACKET_TYPE_LORA);
 
       if (RadioPublicNetwork.Current == true) {
-        SX1280HalWriteRegister(0x944, (LORA_MAC_PUBLIC_SYNCWORD >> 8) & 0xFF);
-        SX1280HalWriteRegister(0x944 + 1, LORA_MAC_PUBLIC_SYNCWORD & 0xFF);
+        SX1280SetConfigRegister(0x944, (LORA_MAC_PUBLIC_SYNCWORD >> 8) & 0xFF);
+        SX1280SetConfigRegister(0x944 + 1, LORA_MAC_PUBLIC_SYNCWORD & 0xFF);
       } else {
-        SX1280HalWriteRegister(0x944, (LORA_MAC_PRIVATE_SYNCWORD >> 8) & 0xFF);
-        SX1280HalWriteRegister(0x944 + 1, LORA_MAC_PRIVATE_SYNCWORD & 0xFF);
+        SX1280SetConfigRegister(0x944, (LORA_MAC_PRIVATE_SYNCWORD >> 8) & 0xFF);
+        SX1280SetConfigRegister(0x944 + 1, LORA_MAC_PRIVATE_SYNCWORD & 0xFF);
       }
       break;
   }
@@ -819,71 +811,58 @@ static uint32_t RadioGetLoRaBandwidthInHz(RadioLoRaBandwidths_t bw) {
 //==========================================================================
 static uint32_t RadioGetGfskTimeOnAirNumerator(uint32_t bandwidth, uint32_t datarate, uint8_t coderate, uint16_t preambleLen,
                                                bool fixLen, uint8_t payloadLen, bool crcOn) {
-  uint16_t BitCount = 0;
-  double tPayload = 0.0;
-  int8_t sync_word_len = 3;
-
-  BitCount = 4 + (preambleLen >> 4) * 4;               // preamble
-  BitCount = BitCount + 8 + (sync_word_len >> 1) * 8;  // sync word
-  BitCount = BitCount + ((fixLen) ? 0 : 80);
-  BitCount = BitCount + payloadLen * 8;
-  BitCount = BitCount + ((crcOn) ? 8 : 0);
+  uint16_t bitsPerMs = 0;
 
   switch (GetFskBitrateBandwidth(bandwidth, datarate)) {
     case GFSK_BLE_BR_2_000_BW_2_4:
-      tPayload = (double)BitCount / 2000.0;
+      bitsPerMs = 2000;
       break;
 
     case GFSK_BLE_BR_1_600_BW_2_4:
-      tPayload = (double)BitCount / 1600.0;
+      bitsPerMs = 1600;
       break;
 
     case GFSK_BLE_BR_1_000_BW_2_4:
     case GFSK_BLE_BR_1_000_BW_1_2:
-      tPayload = (double)BitCount / 1000.0;
+      bitsPerMs = 1000;
       break;
 
     case GFSK_BLE_BR_0_800_BW_2_4:
     case GFSK_BLE_BR_0_800_BW_1_2:
-      tPayload = (double)BitCount / 800.0;
+      bitsPerMs = 800;
       break;
 
     case GFSK_BLE_BR_0_500_BW_1_2:
     case GFSK_BLE_BR_0_500_BW_0_6:
-      tPayload = (double)BitCount / 500.0;
+      bitsPerMs = 500;
       break;
 
     case GFSK_BLE_BR_0_400_BW_1_2:
     case GFSK_BLE_BR_0_400_BW_0_6:
-      tPayload = (double)BitCount / 400.0;
+      bitsPerMs = 400;
       break;
 
     case GFSK_BLE_BR_0_250_BW_0_6:
     case GFSK_BLE_BR_0_250_BW_0_3:
-      tPayload = (double)BitCount / 250.0;
+      bitsPerMs = 250;
       break;
 
     case GFSK_BLE_BR_0_125_BW_0_3:
-      tPayload = (double)BitCount / 125.0;
+      bitsPerMs = 125;
       break;
 
     default:
       break;
   }
-  return ceil(tPayload);
+  return RadioToaSx1280Gfsk(bitsPerMs, preambleLen, fixLen, payloadLen, crcOn);
 }
 
 //==========================================================================
+// datarate is the spreading factor, 5 to 12
 //==========================================================================
 static uint32_t RadioGetLoRaTimeOnAirNumerator(uint32_t bandwidth, uint32_t datarate, uint8_t coderate, uint16_t preambleLen,
                                                bool fixLen, uint8_t payloadLen, bool crcOn) {
-  uint16_t bw = 0.0;
-  double nPayload = 0.0;
-  double ts = 0.0;
-  double tPayload = 0.0;
-  uint8_t SF = kSfTable[datarate] >> 4;
-  uint8_t crc = (crcOn) ? 16 : 0;
-  uint8_t header = (fixLen) ? 0 : 20;
+  uint16_t bw = 0;
 
   switch (Bandwidths[bandwidth]) {
     case LORA_BW_0200:
@@ -905,30 +884,7 @@ static uint32_t RadioGetLoRaTimeOnAirNumerator(uint32_t bandwidth, uint32_t data
     default:
       break;
   }
-
-  if (SF < 7) {
-    nPayload = max(((double)(payloadLen + crc - (4 * SF) + header)), 0.0);
-    nPayload = nPayload / (double)(4 * SF);
-    nPayload = ceil(nPayload);
-    nPayload = nPayload * (coderate + 4);
-    nPayload = nPayload + preambleLen + 6.25 + 8;
-  } else if (SF > 10) {
-    nPayload = max(((double)(payloadLen + crc - (4 * SF) + 8 + header)), 0.0);
-    nPayload = nPayload / (double)(4 * (SF - 2));
-    nPayload = ceil(nPayload);
-    nPayload = nPayload * (coderate + 4);
-    nPayload = nPayload + preambleLen + 4.25 + 8;
-  } else {
-    nPayload = max(((double)(payloadLen + crc - (4 * SF) + 8 + header)), 0.0);
-    nPayload = nPayload / (double)(4 * SF);
-    nPayload = ceil(nPayload);
-    nPayload = nPayload * (coderate + 4);
-    nPayload = nPayload + preambleLen + 4.25 + 8;
-  }
-  ts = (double)(1 << SF) / (double)(bw);
-  tPayload = nPayload * ts;
-
-  return ceil(tPayload);
+  return RadioToaSx1280LoRa(bw, (uint8_t)datarate, coderate, preambleLen, fixLen, payloadLen, crcOn);
 }
 
 //==========================================================================
@@ -949,6 +905,8 @@ static uint32_t RadioTimeOnAir(RadioModems_t modem, uint32_t bandwidth, uint32_t
 //==========================================================================
 //==========================================================================
 static void RadioSend(uint8_t* buffer, uint8_t size) {
+  // Queue the TX setup, payload and SetTx under one SPI bus acquisition
+  SX1280HalChainBegin();
   SX1280SetDioIrqParams(IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT, IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT, IRQ_RADIO_NONE, IRQ_RADIO_NONE);
 
   if (SX1280GetPacketType() == PACKET_TYPE_LORA) {
@@ -959,6 +917,7 @@ static void RadioSend(uint8_t* buffer, uint8_t size) {
   SX1280SetPacketParams(&SX1280.PacketParams);
   SX1280SetRfFrequency(Frequency);
   SX1280SendPayload(buffer, size, RX_TX_SINGLE);
+  SX1280HalChainEnd();
   TimerSetValue(&TxTimeoutTimer, TxTimeout);
   TimerStart(&TxTimeoutTimer);
 }
@@ -1042,7 +1001,11 @@ static int16_t RadioRssi(RadioModems_t modem) { return SX1280GetRssiInst(); }
 
 //==========================================================================
 //==========================================================================
-static void RadioWrite(uint32_t addr, uint8_t data) { SX1280HalWriteRegister(addr, data); }
+// Written around the shadow
+static void RadioWrite(uint32_t addr, uint8_t data) {
+  RadioShadowInvalidate(&SX1280Shadow, RADIO_SHADOW_REGISTERS);
+  SX1280HalWriteRegister(addr, data);
+}
 
 //==========================================================================
 //==========================================================================
@@ -1050,7 +1013,10 @@ static uint8_t RadioRead(uint32_t addr) { return SX1280HalReadRegister(addr); }
 
 //==========================================================================
 //==========================================================================
-static void RadioWriteBuffer(uint32_t addr, uint8_t* buffer, uint8_t size) { SX1280HalWriteRegisters(addr, buffer, size); }
+static void RadioWriteBuffer(uint32_t addr, uint8_t* buffer, uint8_t size) {
+  RadioShadowInvalidate(&SX1280Shadow, RADIO_SHADOW_REGISTERS);
+  SX1280HalWriteRegisters(addr, buffer, size);
+}
 
 //==========================================================================
 //==========================================================================
@@ -1114,11 +1080,11 @@ static void RadioOnDioIrq(void* context) { IrqFired = true; }
 //==========================================================================
 //==========================================================================
 static void RadioIrqProcess(void) {
-  CRITICAL_SECTION_BEGIN();
+  CRITICAL_SECTION_BEGIN(LORA_CRITICAL_RADIO);
   // Clear IRQ flag
   const bool isIrqFired = IrqFired;
   IrqFired = false;
-  CRITICAL_SECTION_END();
+  CRITICAL_SECTION_END(LORA_CRITICAL_RADIO);
 
   if (isIrqFired == true) {
     uint16_t irqRegs = SX1280GetIrqStatus();
@@ -1126,11 +1092,11 @@ static void RadioIrqProcess(void) {
     // LORARADIO_PRINTLINE("irqRegs=%02X, %u", irqRegs, TimerGetCurrentTime());
 
     // Check if DIO1 pin is High. If it is the case revert IrqFired to true
-    CRITICAL_SECTION_BEGIN();
+    CRITICAL_SECTION_BEGIN(LORA_CRITICAL_RADIO);
     if (SX1280HalGetDioStatus() == 1) {
       IrqFired = true;
     }
-    CRITICAL_SECTION_END();
+    CRITICAL_SECTION_END(LORA_CRITICAL_RADIO);
 
     if ((irqRegs & IRQ_TX_DONE) == IRQ_TX_DONE) {
       TimerStop(&TxTimeoutTimer);
@@ -1159,10 +1125,12 @@ static void RadioIrqProcess(void) {
           //!< Update operating mode state to a value lower than \ref MODE_STDBY_XOSC
           SX1280SetStandby(STDBY_RC);
         }
-        SX1280GetPayload(RadioRxPayload, &size, 255);
+        // The MAC parses and decrypts the frame in this buffer
+        uint8_t *rx_payload = RadioRxBufferAcquire();
+        SX1280GetPayload(rx_payload, &size, RADIO_RX_BUFFER_SIZE);
         SX1280GetPacketStatus(&RadioPktStatus);
         if ((RadioEvents != NULL) && (RadioEvents->RxDone != NULL)) {
-          RadioEvents->RxDone(RadioRxPayload, size, RadioPktStatus.Params.LoRa.RssiPkt, RadioPktStatus.Params.LoRa.SnrPkt);
+          RadioEvents->RxDone(rx_payload, size, RadioPktStatus.Params.LoRa.RssiPkt, RadioPktStatus.Params.LoRa.SnrPkt);
         }
       }
     }
@@ -0,0 +1,71 @@
+//==========================================================================
+// Radio time on air
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Naming conventions
+// ~~~~~~~~~~~~~~~~~~
+//                Class : Leading C
+//               Struct : Leading T
+//       typedef Struct : tailing _t
+//             Constant : Leading k
+//      Global Variable : Leading g
+//    Function argument : Leading a
+//       Local Variable : All lower case
+//==========================================================================
+#include "radio_toa.h"
+
+//==========================================================================
+// Defines
+//==========================================================================
+#define SX1280_GFSK_SYNC_WORD_LEN 3
+
+//==========================================================================
+//==========================================================================
+static uint32_t DivCeil(uint64_t aNum, uint64_t aDen) { return (uint32_t)((aNum + aDen - 1) / aDen); }
+
+//==========================================================================
+// Symbols = preamble + 4.25 (6.25 below SF7) + 8 + payload symbols, kept
+// in quarter symbols so the symbol time 2^SF / BW is applied once.
+//==========================================================================
+uint32_t RadioToaSx1280LoRa(uint16_t aBwKhz, uint8_t aSf, uint8_t aCoderate, uint16_t aPreambleLen, bool aFixLen,
+                            uint8_t aPayloadLen, bool aCrcOn) {
+  int32_t bits = aPayloadLen + (aCrcOn ? 16 : 0) - 4 * aSf + (aFixLen ? 0 : 20);
+  uint32_t bitsPerSymbol = 4 * aSf;
+  uint32_t fixedQuarters = 4 * (4 + 8) + 1;
+  uint64_t quarters;
+
+  if ((aBwKhz == 0) || (aSf < 5) || (aSf > 12)) {
+    return 0;
+  }
+  if (aSf < 7) {
+    fixedQuarters += 4 * 2;
+  } else {
+    bits += 8;
+    if (aSf > 10) {
+      bitsPerSymbol = 4 * (aSf - 2);
+    }
+  }
+  if (bits < 0) {
+    bits = 0;
+  }
+
+  quarters = 4 * ((uint64_t)DivCeil((uint32_t)bits, bitsPerSymbol) * (aCoderate + 4) + aPreambleLen) + fixedQuarters;
+  return DivCeil(quarters << aSf, 4 * (uint64_t)aBwKhz);
+}
+
+//==========================================================================
+//==========================================================================
+uint32_t RadioToaSx1280Gfsk(uint16_t aBitsPerMs, uint16_t aPreambleLen, bool aFixLen, uint8_t aPayloadLen,
+                            bool aCrcOn) {
+  uint32_t bits = 4 + (aPreambleLen >> 4) * 4;
+
+  if (aBitsPerMs == 0) {
+    return 0;
+  }
+  bits += 8 + (SX1280_GFSK_SYNC_WORD_LEN >> 1) * 8;
+  bits += aFixLen ? 0 : 80;
+  bits += aPayloadLen * 8;
+  bits += aCrcOn ? 8 : 0;
+  return DivCeil(bits, aBitsPerMs);
+}
@@ -0,0 +1,32 @@
+//==========================================================================
+// Radio time on air
+//==========================================================================
+//  Copyright (c) MatchX GmbH.  All rights reserved.
+//==========================================================================
+// Integer time on air of the SX1280 packets, the same values as the
+// formulas of the chip datasheet evaluated in floating point, without the
+// FPU or the soft float library. The fractional symbols of the LoRa
+// preamble are counted in quarter symbols, and every division rounds up
+// like ceil() did.
+//==========================================================================
+#ifndef INC_RADIO_TOA_H
+#define INC_RADIO_TOA_H
+
+//==========================================================================
+//==========================================================================
+#include <stdbool.h>
+#include <stdint.h>
+
+//==========================================================================
+//==========================================================================
+// LoRa packet, aBwKhz 203, 406, 812 or 1625, aSf 5 to 12 [ms]
+uint32_t RadioToaSx1280LoRa(uint16_t aBwKhz, uint8_t aSf, uint8_t aCoderate, uint16_t aPreambleLen, bool aFixLen,
+                            uint8_t aPayloadLen, bool aCrcOn);
+
+// GFSK packet, aBitsPerMs is the bitrate in kbps [ms]
+uint32_t RadioToaSx1280Gfsk(uint16_t aBitsPerMs, uint16_t aPreambleLen, bool aFixLen, uint8_t aPayloadLen,
+                            bool aCrcOn);
+
+//==========================================================================
+//==========================================================================
+#endif  // INC_RADIO_TOA_H
@@ -14,13 +14,13 @@
 #include "freertos/portmacro.h"
 #include "freertos/task.h"
 #include "radio.h"
+#include "radio_busy_esp.h"
+#include "radio_spi_esp.h"
 #include "sx-gpio.h"
 
 //==========================================================================
 // Defines
 //==========================================================================
-#define MAX_HAL_BUFFER_SIZE 255
-
 #define DelayMs(x) vTaskDelay(x / portTICK_PERIOD_MS)
 
 //==========================================================================
@@ -29,9 +29,13 @@
 static bool gChipError = false;
 static spi_device_handle_t gDevSx126x = NULL;
 
+static RadioSpiEsp_t gSpiSx126x;
+static RadioSpiBus_t gBusSx126x;
+static RadioBusyEsp_t gBusyPinSx126x;
+static RadioBusy_t gBusySx126x;
+static uint8_t gLastCommand;  // BUSY time is recorded for it
+
 static RadioOperatingModes_t gOperatingMode;
-static uint8_t halTxBuffer[MAX_HAL_BUFFER_SIZE] = {0x00};
-static uint8_t halRxBuffer[MAX_HAL_BUFFER_SIZE] = {0x00};
 
 extern DioIrqHandler *gSx126xDioIrqHandler;
 
@@ -50,6 +54,9 @@ void SX126xIoInit(void) {
     gpio_reset_pin(SX1261_BUSY);
     gpio_set_direction(SX1261_BUSY, GPIO_MODE_INPUT);
     gpio_set_pull_mode(SX1261_BUSY, GPIO_FLOATING);
+    if (gBusySx126x.ops == NULL) {
+      RadioBusyEspInit(&gBusySx126x, &gBusyPinSx126x, SX1261_BUSY, "SX126x");
+    }
     gpio_reset_pin(SX1261_DIO1);
     gpio_set_direction(SX1261_DIO1, GPIO_MODE_INPUT);
     gpio_set_pull_mode(SX1261_DIO1, GPIO_FLOATING);
@@ -64,11 +71,14 @@ void SX126xIoInit(void) {
     sx1261_cfg.clock_speed_hz = SPI_MASTER_FREQ_8M;
     sx1261_cfg.spics_io_num = SX1261_SS;
     sx1261_cfg.flags = 0;
-    sx1261_cfg.queue_size = 20;
+    sx1261_cfg.queue_size = RADIO_SPI_QUEUE_DEPTH;
 
     esp_err_t ret = spi_bus_add_device(SPIHOST, &sx1261_cfg, &gDevSx126x);
     if (ret != ESP_OK) {
       printf("ERROR. SPI add SX1261 device failed.\n");
+    } else if (RadioSpiEspInit(&gBusSx126x, &gSpiSx126x, gDevSx126x, &gBusySx126x, "SX126x") != 0) {
+      spi_bus_remove_device(gDevSx126x);
+      gDevSx126x = NULL;
     } else {
       LORARADIO_PRINTLINE("Registered SX1261 to SPI drvice.");
     }
@@ -126,53 +136,82 @@ void SX126xReset(void) {
   DelayMs(50);
   gpio_set_level(SX1261_nRES, 1);
   DelayMs(20);
+  RadioShadowInvalidate(&SX126xShadow, RADIO_SHADOW_ALL);
 }
 
 //==========================================================================
 //==========================================================================
 int8_t SX126xWaitOnBusy(void) {
   // Timeout at about 1s
-  for (uint32_t timeout = 1000; timeout > 0; timeout--) {
-    if (gpio_get_level(SX1261_BUSY) == 0) {
-      return 0;
-    }
-    DelayMs(1);
+  if (RadioBusyWait(&gBusySx126x, gLastCommand) != 0) {
+    gChipError = true;
+    printf("ERROR. SX126xWaitOnBusy Timeout.\n");
+    return -1;
   }
-  gChipError = true;
-  printf("ERROR. SX126xWaitOnBusy Timeout.\n");
-  return -1;
+  return 0;
 }
 
 //==========================================================================
+// Every SPI command goes through here and is counted
 //==========================================================================
-void SX126xWakeup(void) {
-  spi_transaction_t xfer;
+static int8_t Transfer(const RadioSpiXfer_t *aXfer) {
+  RadioShadowCountSpi(&SX126xShadow, 1 + aXfer->addrBits / 8 + aXfer->length);
+  return RadioSpiTransfer(&gBusSx126x, aXfer);
+}
+
+//==========================================================================
+// A command outside of a chain waits for the chip before and after it. In
+// a chain, RadioSpiTransfer() waits for BUSY before each queued command.
+//==========================================================================
+static void BeginCommand(uint8_t aCommand) {
+  if (!RadioSpiInChain(&gBusSx126x)) {
+    SX126xCheckDeviceReady();
+  }
+  gLastCommand = aCommand;
+}
 
+static void EndCommand(void) {
+  if (!RadioSpiInChain(&gBusSx126x)) {
+    SX126xWaitOnBusy();
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void SX126xChainBegin(void) {
   if (gDevSx126x == NULL) {
-    printf("ERROR. SX126xWakeup device not registered.\n");
+    printf("ERROR. SX126xChainBegin device not registered.\n");
     return;
   }
+  if (!RadioSpiInChain(&gBusSx126x)) {
+    SX126xCheckDeviceReady();
+  }
+  RadioSpiBegin(&gBusSx126x);
+}
 
-  // Don't wait for BUSY here
+//==========================================================================
+//==========================================================================
+void SX126xChainEnd(void) {
+  if (gDevSx126x == NULL) {
+    return;
+  }
+  if (RadioSpiEnd(&gBusSx126x) != 0) {
+    gChipError = true;
+  }
+}
 
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_GET_STATUS;
-  xfer.length = 2 * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xWakeup accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xWakeup SPI transmit failed.\n");
-  } else {
-    // All ok
+//==========================================================================
+//==========================================================================
+void SX126xWakeup(void) {
+  if (gDevSx126x == NULL) {
+    printf("ERROR. SX126xWakeup device not registered.\n");
+    return;
   }
-  spi_device_release_bus(gDevSx126x);
+
+  // Don't wait for BUSY here
+  RadioSpiXfer_t xfer = {.cmd = RADIO_GET_STATUS, .addrBits = 8};
+  Transfer(&xfer);
+  gLastCommand = RADIO_GET_STATUS;
 
   // Wait for chip to be ready.
   SX126xWaitOnBusy();
@@ -184,50 +223,28 @@ void SX126xWakeup(void) {
 //==========================================================================
 //==========================================================================
 void SX126xWriteCommand(RadioCommands_t command, uint8_t *buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx126x == NULL) {
     printf("ERROR. SX126xWriteCommand device not registered.\n");
     return;
   }
 
-  // Check Device Ready
-  SX126xCheckDeviceReady();
+  BeginCommand(command);
 
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = (uint8_t)command;
-  if (size > (MAX_HAL_BUFFER_SIZE - 1)) {
-    printf("ERROR. SX126xWriteCommand data size (%u) too larget.\n", size);
-    return;
+  RadioSpiXfer_t xfer = {.cmd = command, .txData = buffer, .length = size, .waitReady = true};
+  if (buffer == NULL) {
+    xfer.length = 0;
   }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[1], buffer, size);
-  }
-  xfer.length = (1 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xWriteCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xWriteCommand SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx126x);
+  Transfer(&xfer);
 
   if (command != RADIO_SET_SLEEP) {
-    SX126xWaitOnBusy();
+    EndCommand();
   }
 }
 
 //==========================================================================
 //==========================================================================
 uint8_t SX126xReadCommand(RadioCommands_t command, uint8_t *buffer, uint16_t size) {
-  spi_transaction_t xfer;
+  uint8_t data[1 + RADIO_SPI_INLINE_SIZE];
   uint8_t status = 0;
 
   if (gDevSx126x == NULL) {
@@ -235,37 +252,21 @@ uint8_t SX126xReadCommand(RadioCommands_t command, uint8_t *buffer, uint16_t siz
     return 0;
   }
   memset(buffer, 0xff, size);
-
-  // Check Device Ready
-  SX126xCheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = (uint8_t)command;
-  halTxBuffer[1] = 0;
-  if (size > (MAX_HAL_BUFFER_SIZE - 2)) {
+  if (size > RADIO_SPI_INLINE_SIZE) {
     printf("ERROR. SX126xReadCommand data size (%u) too larget.\n", size);
     return 0;
   }
-  xfer.length = (2 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xReadCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xReadCommand SPI transmit failed.\n");
-  } else {
-    // All ok
-    status = halRxBuffer[1];
-    memcpy(buffer, &halRxBuffer[2], size);
+
+  BeginCommand(command);
+
+  // The status comes in the NOP byte after the opcode
+  RadioSpiXfer_t xfer = {.cmd = command, .rxData = data, .length = 1 + size, .waitReady = true};
+  if (Transfer(&xfer) == 0) {
+    status = data[0];
+    memcpy(buffer, &data[1], size);
   }
-  spi_device_release_bus(gDevSx126x);
 
-  SX126xWaitOnBusy();
+  EndCommand();
 
   return status;
 }
@@ -273,44 +274,22 @@ uint8_t SX126xReadCommand(RadioCommands_t command, uint8_t *buffer, uint16_t siz
 //==========================================================================
 //==========================================================================
 void SX126xWriteRegisters(uint16_t address, uint8_t *buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx126x == NULL) {
     printf("ERROR. SX126xWriteRegisters device not registered.\n");
     return;
   }
 
-  // Wait end of busy
-  SX126xCheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_WRITE_REGISTER;
-  halTxBuffer[1] = (uint8_t)(address >> 8);
-  halTxBuffer[2] = (uint8_t)(address >> 0);
-  if (size > (MAX_HAL_BUFFER_SIZE - 3)) {
-    printf("ERROR. SX126xWriteRegisters data size (%u) too larget.\n", size);
-    return;
-  }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[3], buffer, size);
-  }
-  xfer.length = (3 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xWriteRegisters accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xWriteRegisters SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx126x);
+  BeginCommand(RADIO_WRITE_REGISTER);
 
-  SX126xWaitOnBusy();
+  RadioSpiXfer_t xfer = {.cmd = RADIO_WRITE_REGISTER,
+                         .addrBits = 16,
+                         .addr = address,
+                         .txData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
@@ -320,45 +299,24 @@ void SX126xWriteRegister(uint16_t address, uint8_t value) { SX126xWriteRegisters
 //==========================================================================
 //==========================================================================
 void SX126xReadRegisters(uint16_t address, uint8_t *buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx126x == NULL) {
     printf("ERROR. SX126xReadRegisters device not registered.\n");
     return;
   }
   memset(buffer, 0xff, size);
 
-  // Wait end of busy
-  SX126xCheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_READ_REGISTER;
-  halTxBuffer[1] = (uint8_t)(address >> 8);
-  halTxBuffer[2] = (uint8_t)(address >> 0);
-  halTxBuffer[3] = 0;
-  if (size > (MAX_HAL_BUFFER_SIZE - 4)) {
-    printf("ERROR. SX126xReadRegisters data size (%u) too larget.\n", size);
-    return;
-  }
-  xfer.length = (4 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xReadRegisters accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xReadRegisters SPI transmit failed.\n");
-  } else {
-    // All ok
-    memcpy(buffer, &halRxBuffer[4], size);
-  }
-  spi_device_release_bus(gDevSx126x);
+  BeginCommand(RADIO_READ_REGISTER);
 
-  SX126xWaitOnBusy();
+  // The address and the status byte go in the address phase
+  RadioSpiXfer_t xfer = {.cmd = RADIO_READ_REGISTER,
+                         .addrBits = 24,
+                         .addr = (uint32_t)address << 8,
+                         .rxData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
@@ -372,86 +330,47 @@ uint8_t SX126xReadRegister(uint16_t address) {
 //==========================================================================
 //==========================================================================
 void SX126xWriteBuffer(uint8_t offset, uint8_t *buffer, uint8_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx126x == NULL) {
     printf("ERROR. SX126xWriteBuffer device not registered.\n");
     return;
   }
 
-  // Wait end of busy
-  SX126xCheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_WRITE_BUFFER;
-  halTxBuffer[1] = offset;
-  if (size > (MAX_HAL_BUFFER_SIZE - 2)) {
-    printf("ERROR. SX126xWriteBuffer data size (%u) too larget.\n", size);
-    return;
-  }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[2], buffer, size);
-  }
-  xfer.length = (2 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xWriteBuffer accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xWriteBuffer SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx126x);
+  BeginCommand(RADIO_WRITE_BUFFER);
 
-  SX126xWaitOnBusy();
+  // The data is sent from the caller buffer without a copy
+  RadioSpiXfer_t xfer = {.cmd = RADIO_WRITE_BUFFER,
+                         .addrBits = 8,
+                         .addr = offset,
+                         .txData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
 //==========================================================================
 void SX126xReadBuffer(uint8_t offset, uint8_t *buffer, uint8_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx126x == NULL) {
     printf("ERROR. SX126xReadBuffer device not registered.\n");
     return;
   }
   memset(buffer, 0xff, size);
 
-  // Wait end of busy
-  SX126xCheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_READ_BUFFER;
-  halTxBuffer[1] = offset;
-  halTxBuffer[2] = 0;
-  if (size > (MAX_HAL_BUFFER_SIZE - 3)) {
-    printf("ERROR. SX126xReadBuffer data size (%u) too larget.\n", size);
-    return;
-  }
-  xfer.length = (3 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx126x, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX126xReadBuffer accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx126x, &xfer) != ESP_OK) {
-    printf("ERROR. SX126xReadBuffer SPI transmit failed.\n");
-  } else {
-    // All ok
-    memcpy(buffer, &halRxBuffer[3], size);
-  }
-  spi_device_release_bus(gDevSx126x);
+  BeginCommand(RADIO_READ_BUFFER);
 
-  SX126xWaitOnBusy();
+  // The offset and the status byte go in the address phase, the data is
+  // read into the caller buffer.
+  RadioSpiXfer_t xfer = {.cmd = RADIO_READ_BUFFER,
+                         .addrBits = 16,
+                         .addr = (uint32_t)offset << 8,
+                         .rxData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
@@ -488,3 +407,15 @@ uint32_t SX126xGetDio1PinState(void) {
 //==========================================================================
 //==========================================================================
 bool SX126xIsError(void) { return gChipError; };
+
+//==========================================================================
+//==========================================================================
+void SX126xPrintBusyStats(void) {
+  if (gBusySx126x.ops != NULL) {
+    RadioBusyPrintStats(&gBusySx126x);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void SX126xPrintSpiStats(void) { RadioShadowPrintStats(&SX126xShadow); }
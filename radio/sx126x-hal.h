@@ -81,6 +81,19 @@ int8_t SX126xWaitOnBusy( void );
  */
 void SX126xWakeup( void );
 
+/*!
+ * \brief Chains the following commands under one SPI bus acquisition
+ *
+ * \remark Inside a chain the write commands return once they are queued.
+ *         The buffer of SX126xWriteBuffer must stay valid until SX126xChainEnd.
+ */
+void SX126xChainBegin( void );
+
+/*!
+ * \brief Waits for the chained commands and releases the SPI bus
+ */
+void SX126xChainEnd( void );
+
 /*!
  * \brief Send a command that write data to the radio
  *
@@ -191,6 +204,12 @@ void SX126xSetOperatingMode( RadioOperatingModes_t mode );
 //
 bool SX126xIsError(void);
 
+// Print the BUSY time histograms per command
+void SX126xPrintBusyStats(void);
+
+// Print the SPI commands and bytes sent and skipped
+void SX126xPrintSpiStats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,12 @@
  */
 #define SX126X_MAX_LORA_SYMB_NUM_TIMEOUT            248
 
+/*!
+ * \brief IRQs raised by a reception that writes to the data buffer
+ */
+#define SX126X_RX_BUFFER_IRQS                       ( IRQ_RX_DONE | IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID | \
+                                                      IRQ_HEADER_ERROR | IRQ_CRC_ERROR )
+
 /*!
  * \brief Radio registers definition
  */
@@ -79,6 +85,16 @@ volatile uint32_t FrequencyError = 0;
  */
 static bool ImageCalibrated = false;
 
+/*!
+ * \brief Stores the IRQs enabled by the last SX126xSetDioIrqParams
+ */
+static uint16_t IrqMask = IRQ_RADIO_NONE;
+
+/*!
+ * \brief Configuration last applied to the radio, and the SPI counters
+ */
+RadioShadow_t SX126xShadow = { .name = "SX126x" };
+
 /*!
  * \brief Get the number of PLL steps for a given frequency in Hertz
  *
@@ -112,6 +128,46 @@ void SX126xSetInterruptMode( void );
  */
 void SX126xProcessIrqs( void );
 
+/*!
+ * \brief Sends a configuration command unless the radio already has it
+ */
+static void SX126xWriteConfigCommand( RadioCommands_t opcode, uint8_t *buffer, uint16_t size )
+{
+    if( RadioShadowCommand( &SX126xShadow, opcode, buffer, size ) == true )
+    {
+        SX126xWriteCommand( opcode, buffer, size );
+    }
+}
+
+/*!
+ * \brief Invalidates the resident payload if a reception wrote to the data
+ *        buffer since the IRQ status was last read
+ */
+static void SX126xCheckRxBuffer( void )
+{
+    // SX126xGetIrqStatus invalidates the payload
+    uint16_t irqRegs = SX126xGetIrqStatus( ) & ( IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID );
+
+    // Not handled by the IRQ processing, clear them for the next check
+    if( irqRegs != 0 )
+    {
+        SX126xClearIrqStatus( irqRegs );
+    }
+}
+
+/*!
+ * \brief Without a latched sync word or header IRQ, a reception could write to
+ *        the data buffer unnoticed
+ */
+static void SX126xOnRxStart( void )
+{
+    if( ( ( IrqMask & ( IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID ) ) != ( IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID ) ) ||
+        ( ( PacketType == PACKET_TYPE_LORA ) && ( LoRaHeaderType == LORA_PACKET_FIXED_LENGTH ) ) )
+    {
+        RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_PAYLOAD );
+    }
+}
+
 void SX126xInit( DioIrqHandler dioIrq )
 {
     SX126xReset( );
@@ -129,6 +185,7 @@ void SX126xInit( DioIrqHandler dioIrq )
 
     // Force image calibration
     ImageCalibrated = false;
+    IrqMask = IRQ_RADIO_NONE;
 
     SX126xSetOperatingMode( MODE_STDBY_RC );
 }
@@ -146,7 +203,15 @@ void SX126xCheckDeviceReady( void )
 
 void SX126xSetPayload( uint8_t *payload, uint8_t size )
 {
-    SX126xWriteBuffer( 0x00, payload, size );
+    // A retransmission finds its payload still in the data buffer
+    if( RadioShadowHasPayload( &SX126xShadow, 0x00, payload, size ) == true )
+    {
+        SX126xCheckRxBuffer( );
+    }
+    if( RadioShadowWritePayload( &SX126xShadow, 0x00, payload, size ) == true )
+    {
+        SX126xWriteBuffer( 0x00, payload, size );
+    }
 }
 
 uint8_t SX126xGetPayload( uint8_t *buffer, uint8_t *size,  uint8_t maxSize )
@@ -217,10 +282,10 @@ void SX126xSetWhiteningSeed( uint16_t seed )
     switch( SX126xGetPacketType( ) )
     {
         case PACKET_TYPE_GFSK:
-            regValue = SX126xReadRegister( REG_LR_WHITSEEDBASEADDR_MSB ) & 0xFE;
+            regValue = SX126xGetConfigRegister( REG_LR_WHITSEEDBASEADDR_MSB ) & 0xFE;
             regValue = ( ( seed >> 8 ) & 0x01 ) | regValue;
-            SX126xWriteRegister( REG_LR_WHITSEEDBASEADDR_MSB, regValue ); // only 1 bit.
-            SX126xWriteRegister( REG_LR_WHITSEEDBASEADDR_LSB, ( uint8_t )seed );
+            SX126xSetConfigRegister( REG_LR_WHITSEEDBASEADDR_MSB, regValue ); // only 1 bit.
+            SX126xSetConfigRegister( REG_LR_WHITSEEDBASEADDR_LSB, ( uint8_t )seed );
             break;
 
         default:
@@ -265,6 +330,12 @@ void SX126xSetSleep( SleepParams_t sleepConfig )
     {
         // Force image calibration
         ImageCalibrated = false;
+        RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_ALL );
+    }
+    else
+    {
+        // The data buffer and most registers are lost, the configuration is kept
+        RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_REGISTERS | RADIO_SHADOW_PAYLOAD );
     }
     SX126xWriteCommand( RADIO_SET_SLEEP, &value, 1 );
     SX126xSetOperatingMode( MODE_SLEEP );
@@ -293,6 +364,7 @@ void SX126xSetTx( uint32_t timeout )
 {
     uint8_t buf[3];
 
+    RadioShadowUplink( &SX126xShadow );
     SX126xSetOperatingMode( MODE_TX );
 
     buf[0] = ( uint8_t )( ( timeout >> 16 ) & 0xFF );
@@ -306,8 +378,9 @@ void SX126xSetRx( uint32_t timeout )
     uint8_t buf[3];
 
     SX126xSetOperatingMode( MODE_RX );
+    SX126xOnRxStart( );
 
-    SX126xWriteRegister( REG_RX_GAIN, 0x94 ); // default gain
+    SX126xSetConfigRegister( REG_RX_GAIN, 0x94 ); // default gain
 
     buf[0] = ( uint8_t )( ( timeout >> 16 ) & 0xFF );
     buf[1] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
@@ -320,8 +393,9 @@ void SX126xSetRxBoosted( uint32_t timeout )
     uint8_t buf[3];
 
     SX126xSetOperatingMode( MODE_RX );
+    SX126xOnRxStart( );
 
-    SX126xWriteRegister( REG_RX_GAIN, 0x96 ); // max LNA gain, increase current by ~2mA for around ~3dB in sensitivity
+    SX126xSetConfigRegister( REG_RX_GAIN, 0x96 ); // max LNA gain, increase current by ~2mA for around ~3dB in sensitivity
 
     buf[0] = ( uint8_t )( ( timeout >> 16 ) & 0xFF );
     buf[1] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
@@ -339,6 +413,8 @@ void SX126xSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime )
     buf[3] = ( uint8_t )( ( sleepTime >> 16 ) & 0xFF );
     buf[4] = ( uint8_t )( ( sleepTime >> 8 ) & 0xFF );
     buf[5] = ( uint8_t )( sleepTime & 0xFF );
+    // The data buffer is lost in the sleep periods
+    RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_PAYLOAD );
     SX126xWriteCommand( RADIO_SET_RXDUTYCYCLE, buf, 6 );
     SX126xSetOperatingMode( MODE_RX_DC );
 }
@@ -363,7 +439,7 @@ void SX126xSetTxInfinitePreamble( void )
 
 void SX126xSetStopRxTimerOnPreambleDetect( bool enable )
 {
-    SX126xWriteCommand( RADIO_SET_STOPRXTIMERONPREAMBLE, ( uint8_t* )&enable, 1 );
+    SX126xWriteConfigCommand( RADIO_SET_STOPRXTIMERONPREAMBLE, ( uint8_t* )&enable, 1 );
 }
 
 void SX126xSetLoRaSymbNumTimeout( uint8_t symbNum )
@@ -381,18 +457,18 @@ void SX126xSetLoRaSymbNumTimeout( uint8_t symbNum )
     }
 
     reg = mant << ( 2 * exp + 1 );
-    SX126xWriteCommand( RADIO_SET_LORASYMBTIMEOUT, &reg, 1 );
+    SX126xWriteConfigCommand( RADIO_SET_LORASYMBTIMEOUT, &reg, 1 );
 
     if( symbNum != 0 )
     {
         reg = exp + ( mant << 3 );
-        SX126xWriteRegister( REG_LR_SYNCH_TIMEOUT, reg );
+        SX126xSetConfigRegister( REG_LR_SYNCH_TIMEOUT, reg );
     }
 }
 
 void SX126xSetRegulatorMode( RadioRegulatorMode_t mode )
 {
-    SX126xWriteCommand( RADIO_SET_REGULATORMODE, ( uint8_t* )&mode, 1 );
+    SX126xWriteConfigCommand( RADIO_SET_REGULATORMODE, ( uint8_t* )&mode, 1 );
 }
 
 void SX126xCalibrate( CalibrationParams_t calibParam )
@@ -448,12 +524,12 @@ void SX126xSetPaConfig( uint8_t paDutyCycle, uint8_t hpMax, uint8_t deviceSel, u
     buf[1] = hpMax;
     buf[2] = deviceSel;
     buf[3] = paLut;
-    SX126xWriteCommand( RADIO_SET_PACONFIG, buf, 4 );
+    SX126xWriteConfigCommand( RADIO_SET_PACONFIG, buf, 4 );
 }
 
 void SX126xSetRxTxFallbackMode( uint8_t fallbackMode )
 {
-    SX126xWriteCommand( RADIO_SET_TXFALLBACKMODE, &fallbackMode, 1 );
+    SX126xWriteConfigCommand( RADIO_SET_TXFALLBACKMODE, &fallbackMode, 1 );
 }
 
 void SX126xSetDioIrqParams( uint16_t irqMask, uint16_t dio1Mask, uint16_t dio2Mask, uint16_t dio3Mask )
@@ -468,7 +544,8 @@ void SX126xSetDioIrqParams( uint16_t irqMask, uint16_t dio1Mask, uint16_t dio2Ma
     buf[5] = ( uint8_t )( dio2Mask & 0x00FF );
     buf[6] = ( uint8_t )( ( dio3Mask >> 8 ) & 0x00FF );
     buf[7] = ( uint8_t )( dio3Mask & 0x00FF );
-    SX126xWriteCommand( RADIO_CFG_DIOIRQ, buf, 8 );
+    IrqMask = irqMask;
+    SX126xWriteConfigCommand( RADIO_CFG_DIOIRQ, buf, 8 );
 }
 
 uint16_t SX126xGetIrqStatus( void )
@@ -476,12 +553,17 @@ uint16_t SX126xGetIrqStatus( void )
     uint8_t irqStatus[2];
 
     SX126xReadCommand( RADIO_GET_IRQSTATUS, irqStatus, 2 );
-    return ( irqStatus[0] << 8 ) | irqStatus[1];
+    uint16_t irq = ( irqStatus[0] << 8 ) | irqStatus[1];
+    if( ( irq & SX126X_RX_BUFFER_IRQS ) != 0 )
+    {
+        RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_PAYLOAD );
+    }
+    return irq;
 }
 
 void SX126xSetDio2AsRfSwitchCtrl( uint8_t enable )
 {
-    SX126xWriteCommand( RADIO_SET_RFSWITCHMODE, &enable, 1 );
+    SX126xWriteConfigCommand( RADIO_SET_RFSWITCHMODE, &enable, 1 );
 }
 
 void SX126xSetDio3AsTcxoCtrl( RadioTcxoCtrlVoltage_t tcxoVoltage, uint32_t timeout )
@@ -493,7 +575,7 @@ void SX126xSetDio3AsTcxoCtrl( RadioTcxoCtrlVoltage_t tcxoVoltage, uint32_t timeo
     buf[2] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
     buf[3] = ( uint8_t )( timeout & 0xFF );
 
-    SX126xWriteCommand( RADIO_SET_TCXOMODE, buf, 4 );
+    SX126xWriteConfigCommand( RADIO_SET_TCXOMODE, buf, 4 );
 }
 
 void SX126xSetRfFrequency( uint32_t frequency )
@@ -512,14 +594,20 @@ void SX126xSetRfFrequency( uint32_t frequency )
     buf[1] = ( uint8_t )( ( freqInPllSteps >> 16 ) & 0xFF );
     buf[2] = ( uint8_t )( ( freqInPllSteps >> 8 ) & 0xFF );
     buf[3] = ( uint8_t )( freqInPllSteps & 0xFF );
-    SX126xWriteCommand( RADIO_SET_RFFREQUENCY, buf, 4 );
+    SX126xWriteConfigCommand( RADIO_SET_RFFREQUENCY, buf, 4 );
 }
 
 void SX126xSetPacketType( RadioPacketTypes_t packetType )
 {
     // Save packet type internally to avoid questioning the radio
     PacketType = packetType;
-    SX126xWriteCommand( RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+    if( RadioShadowCommand( &SX126xShadow, RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 ) == true )
+    {
+        // The modem parameters and the LoRa sync word are reset with the packet type
+        RadioShadowInvalidate( &SX126xShadow, RADIO_SHADOW_COMMANDS | RADIO_SHADOW_REGISTERS );
+        RadioShadowCommand( &SX126xShadow, RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+        SX126xWriteCommand( RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+    }
 }
 
 RadioPacketTypes_t SX126xGetPacketType( void )
@@ -553,7 +641,7 @@ void SX126xSetTxParams( int8_t power, RadioRampTimes_t rampTime )
     else // sx1262
     {
         // WORKAROUND - Better Resistance of the SX1262 Tx to Antenna Mismatch, see DS_SX1261-2_V1.2 datasheet chapter 15.2
-        SX126xWriteRegister( REG_TX_CLAMP_CFG, SX126xReadRegister( REG_TX_CLAMP_CFG ) | ( 0x0F << 1 ) );
+        SX126xSetConfigRegister( REG_TX_CLAMP_CFG, SX126xGetConfigRegister( REG_TX_CLAMP_CFG ) | ( 0x0F << 1 ) );
         // WORKAROUND END
 
         SX126xSetPaConfig( 0x04, 0x07, 0x00, 0x01 );
@@ -568,7 +656,7 @@ void SX126xSetTxParams( int8_t power, RadioRampTimes_t rampTime )
     }
     buf[0] = power;
     buf[1] = ( uint8_t )rampTime;
-    SX126xWriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
+    SX126xWriteConfigCommand( RADIO_SET_TXPARAMS, buf, 2 );
 }
 
 void SX126xSetModulationParams( ModulationParams_t *modulationParams )
@@ -598,7 +686,7 @@ void SX126xSetModulationParams( ModulationParams_t *modulationParams )
         buf[5] = ( tempVal >> 16 ) & 0xFF;
         buf[6] = ( tempVal >> 8 ) & 0xFF;
         buf[7] = ( tempVal& 0xFF );
-        SX126xWriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        SX126xWriteConfigCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
         break;
     case PACKET_TYPE_LORA:
         n = 4;
@@ -607,7 +695,7 @@ void SX126xSetModulationParams( ModulationParams_t *modulationParams )
         buf[2] = modulationParams->Params.LoRa.CodingRate;
         buf[3] = modulationParams->Params.LoRa.LowDatarateOptimize;
 
-        SX126xWriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        SX126xWriteConfigCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
 
         break;
     default:
@@ -672,7 +760,7 @@ void SX126xSetPacketParams( PacketParams_t *packetParams )
     case PACKET_TYPE_NONE:
         return;
     }
-    SX126xWriteCommand( RADIO_SET_PACKETPARAMS, buf, n );
+    SX126xWriteConfigCommand( RADIO_SET_PACKETPARAMS, buf, n );
 }
 
 void SX126xSetCadParams( RadioLoRaCadSymbols_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin, RadioCadExitModes_t cadExitMode, uint32_t cadTimeout )
@@ -696,7 +784,7 @@ void SX126xSetBufferBaseAddress( uint8_t txBaseAddress, uint8_t rxBaseAddress )
 
     buf[0] = txBaseAddress;
     buf[1] = rxBaseAddress;
-    SX126xWriteCommand( RADIO_SET_BUFFERBASEADDRESS, buf, 2 );
+    SX126xWriteConfigCommand( RADIO_SET_BUFFERBASEADDRESS, buf, 2 );
 }
 
 RadioStatus_t SX126xGetStatus( void )
@@ -805,6 +893,26 @@ void SX126xClearIrqStatus( uint16_t irq )
     SX126xWriteCommand( RADIO_CLR_IRQSTATUS, buf, 2 );
 }
 
+void SX126xSetConfigRegister( uint16_t address, uint8_t value )
+{
+    if( RadioShadowWriteRegister( &SX126xShadow, address, value ) == true )
+    {
+        SX126xWriteRegister( address, value );
+    }
+}
+
+uint8_t SX126xGetConfigRegister( uint16_t address )
+{
+    uint8_t value;
+
+    if( RadioShadowReadRegister( &SX126xShadow, address, &value ) == false )
+    {
+        value = SX126xReadRegister( address );
+        RadioShadowStoreRegister( &SX126xShadow, address, value );
+    }
+    return value;
+}
+
 static uint32_t SX126xConvertFreqInHzToPllStep( uint32_t freqInHz )
 {
     uint32_t stepsInt;
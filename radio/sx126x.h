@@ -32,6 +32,7 @@ extern "C"
 #include <stdbool.h>
 #include <math.h>
 #include "radio.h"
+#include "radio_shadow.h"
 
 #define SX1261                                      1
 #define SX1262                                      2
@@ -1149,6 +1150,27 @@ void SX126xClearDeviceErrors( void );
  */
 void SX126xClearIrqStatus( uint16_t irq );
 
+/*!
+ * \brief Writes a configuration register unless it already holds the value
+ *
+ * \param [in]  address       Register address
+ * \param [in]  value         New register value
+ */
+void SX126xSetConfigRegister( uint16_t address, uint8_t value );
+
+/*!
+ * \brief Reads a configuration register, from the shadow once it is known
+ *
+ * \param [in]  address       Register address
+ * \retval      value         Register value
+ */
+uint8_t SX126xGetConfigRegister( uint16_t address );
+
+/*!
+ * \brief Configuration last applied to the radio, and the SPI counters
+ */
+extern RadioShadow_t SX126xShadow;
+
 #ifdef __cplusplus
 }
 #endif
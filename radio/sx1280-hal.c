@@ -14,6 +14,8 @@
 #include "freertos/portmacro.h"
 #include "freertos/task.h"
 #include "radio.h"
+#include "radio_busy_esp.h"
+#include "radio_spi_esp.h"
 #include "sx-gpio.h"
 
 //==========================================================================
@@ -23,10 +25,13 @@ static spi_device_handle_t gDevSx1280 = NULL;
 
 #define DelayMs(x) vTaskDelay(x / portTICK_PERIOD_MS)
 
-#define MAX_HAL_BUFFER_SIZE 256
+#define IRAM_CLEAR_BLOCK 128
 static RadioOperatingModes_t gOperatingMode;
-static uint8_t halTxBuffer[MAX_HAL_BUFFER_SIZE] = {0x00};
-static uint8_t halRxBuffer[MAX_HAL_BUFFER_SIZE] = {0x00};
+static RadioSpiEsp_t gSpiSx1280;
+static RadioSpiBus_t gBusSx1280;
+static RadioBusyEsp_t gBusyPinSx1280;
+static RadioBusy_t gBusySx1280;
+static uint8_t gLastCommand;  // BUSY time is recorded for it
 
 //
 extern DioIrqHandler* gSx1280DioIrqHandler;
@@ -35,14 +40,10 @@ extern DioIrqHandler* gSx1280DioIrqHandler;
 //==========================================================================
 void SX1280HalWaitOnBusy(void) {
   // Timeout at about 1s
-  for (uint32_t timeout = 1000; timeout > 0; timeout--) {
-    if (gpio_get_level(SX1280_BUSY) == 0) {
-      return;
-    }
-    DelayMs(1);
+  if (RadioBusyWait(&gBusySx1280, gLastCommand) != 0) {
+    gChipError = true;
+    printf("ERROR. SX1280HalWaitOnBusy Timeout.\n");
   }
-  gChipError = true;
-  printf("ERROR. SX1280HalWaitOnBusy Timeout.\n");
 }
 
 //==========================================================================
@@ -60,6 +61,9 @@ void SX1280HalInit(void) {
     gpio_reset_pin(SX1280_BUSY);
     gpio_set_direction(SX1280_BUSY, GPIO_MODE_INPUT);
     gpio_set_pull_mode(SX1280_BUSY, GPIO_FLOATING);
+    if (gBusySx1280.ops == NULL) {
+      RadioBusyEspInit(&gBusySx1280, &gBusyPinSx1280, SX1280_BUSY, "SX1280");
+    }
     gpio_reset_pin(SX1280_DIO1);
     gpio_set_direction(SX1280_DIO1, GPIO_MODE_INPUT);
     gpio_set_pull_mode(SX1280_DIO1, GPIO_FLOATING);
@@ -74,11 +78,14 @@ void SX1280HalInit(void) {
     sx1280_cfg.clock_speed_hz = SPI_MASTER_FREQ_8M;
     sx1280_cfg.spics_io_num = SX1280_SS;
     sx1280_cfg.flags = 0;
-    sx1280_cfg.queue_size = 20;
+    sx1280_cfg.queue_size = RADIO_SPI_QUEUE_DEPTH;
 
     esp_err_t ret = spi_bus_add_device(SPIHOST, &sx1280_cfg, &gDevSx1280);
     if (ret != ESP_OK) {
       printf("ERROR. SPI add SX1280 device failed.\n");
+    } else if (RadioSpiEspInit(&gBusSx1280, &gSpiSx1280, gDevSx1280, &gBusySx1280, "SX1280") != 0) {
+      spi_bus_remove_device(gDevSx1280);
+      gDevSx1280 = NULL;
     } else {
       LORARADIO_PRINTLINE("Registered SX1280 to SPI drvice.");
     }
@@ -117,73 +124,90 @@ void SX1280HalReset(void) {
   DelayMs(50);
   gpio_set_level(SX1280_nRES, 1);
   DelayMs(20);
+  RadioShadowInvalidate(&SX1280Shadow, RADIO_SHADOW_ALL);
 }
 
 //==========================================================================
+// Every SPI command goes through here and is counted
 //==========================================================================
-void SX1280HalClearInstructionRam(void) {
-  spi_transaction_t xfer;
-  uint16_t size = MAX_HAL_BUFFER_SIZE / 2;
+static int8_t Transfer(const RadioSpiXfer_t *aXfer) {
+  RadioShadowCountSpi(&SX1280Shadow, 1 + aXfer->addrBits / 8 + aXfer->length);
+  return RadioSpiTransfer(&gBusSx1280, aXfer);
+}
+
+//==========================================================================
+// A command outside of a chain waits for the chip before and after it. In
+// a chain, RadioSpiTransfer() waits for BUSY before each queued command.
+//==========================================================================
+static void BeginCommand(uint8_t aCommand) {
+  if (!RadioSpiInChain(&gBusSx1280)) {
+    SX1280CheckDeviceReady();
+  }
+  gLastCommand = aCommand;
+}
+
+static void EndCommand(void) {
+  if (!RadioSpiInChain(&gBusSx1280)) {
+    SX1280HalWaitOnBusy();
+  }
+}
 
+//==========================================================================
+//==========================================================================
+void SX1280HalChainBegin(void) {
+  if (gDevSx1280 == NULL) {
+    printf("ERROR. SX1280HalChainBegin device not registered.\n");
+    return;
+  }
+  if (!RadioSpiInChain(&gBusSx1280)) {
+    SX1280CheckDeviceReady();
+  }
+  RadioSpiBegin(&gBusSx1280);
+}
+
+//==========================================================================
+//==========================================================================
+void SX1280HalChainEnd(void) {
+  if (gDevSx1280 == NULL) {
+    return;
+  }
+  if (RadioSpiEnd(&gBusSx1280) != 0) {
+    gChipError = true;
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void SX1280HalClearInstructionRam(void) {
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalClearInstructionRam device not registered.\n");
     return;
   }
 
   // Clearing the instruction RAM is writing 0x00s on every bytes of the
-  // instruction RAM
-  for (uint16_t addr = 0; addr < IRAM_SIZE; addr += size) {
-    // Set up transfer info
-    memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-    memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-    memset(&xfer, 0, sizeof(xfer));
-    halTxBuffer[0] = RADIO_WRITE_REGISTER;
-    halTxBuffer[1] = (uint8_t)((addr >> 8) & 0x00FF);
-    halTxBuffer[2] = (uint8_t)(addr & 0x00FF);
-    xfer.length = (size + 3) * 8;
-    xfer.tx_buffer = halTxBuffer;
-
-    // start
-    if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-      printf("ERROR. SX1280HalClearInstructionRam accuire SPI bus failed.\n");
-    } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-      printf("ERROR. SX1280HalClearInstructionRam SPI transmit failed.\n");
-    } else {
-      // All ok
-    }
-    spi_device_release_bus(gDevSx1280);
+  // instruction RAM, in one chain
+  RadioSpiBegin(&gBusSx1280);
+  for (uint16_t addr = 0; addr < IRAM_SIZE; addr += IRAM_CLEAR_BLOCK) {
+    RadioSpiXfer_t xfer = {.cmd = RADIO_WRITE_REGISTER, .addrBits = 16, .addr = addr, .length = IRAM_CLEAR_BLOCK};
+    Transfer(&xfer);
   }
+  RadioSpiEnd(&gBusSx1280);
+  gLastCommand = RADIO_WRITE_REGISTER;
   SX1280HalWaitOnBusy();
 }
 
 //==========================================================================
 //==========================================================================
 void SX1280HalWakeup(void) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalWakeup device not registered.\n");
     return;
   }
 
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_GET_STATUS;
-  xfer.length = 2 * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalWakeup accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalWakeup SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx1280);
+  // Don't wait for BUSY here
+  RadioSpiXfer_t xfer = {.cmd = RADIO_GET_STATUS, .addrBits = 8};
+  Transfer(&xfer);
+  gLastCommand = RADIO_GET_STATUS;
 
   // Wait for chip to be ready.
   SX1280HalWaitOnBusy();
@@ -195,149 +219,72 @@ void SX1280HalWakeup(void) {
 //==========================================================================
 //==========================================================================
 void SX1280HalWriteCommand(RadioCommands_t command, uint8_t* buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalWriteCommand device not registered.\n");
     return;
   }
 
-  // Check Device Ready
+  // Check Device Ready. SET_STANDBY is also sent after the reset, to disable
+  // the UART, and doesn't wait for BUSY.
   if (command != RADIO_SET_STANDBY) {
-    SX1280CheckDeviceReady();
-  }
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = (uint8_t)command;
-  if (size > (MAX_HAL_BUFFER_SIZE - 1)) {
-    printf("ERROR. SX1280HalWriteCommand data size (%u) too larget.\n", size);
-    return;
-  }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[1], buffer, size);
+    BeginCommand(command);
+  } else {
+    gLastCommand = command;
   }
-  xfer.length = (1 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-
-  // LORARADIO_HEX2STRING("WR CMD:", halTxBuffer, (1 + size));
 
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteCommand SPI transmit failed.\n");
-  } else {
-    // All ok
+  RadioSpiXfer_t xfer = {
+      .cmd = command, .txData = buffer, .length = size, .waitReady = (command != RADIO_SET_STANDBY)};
+  if (buffer == NULL) {
+    xfer.length = 0;
   }
-  spi_device_release_bus(gDevSx1280);
+  Transfer(&xfer);
 
   if (command != RADIO_SET_SLEEP) {
-    SX1280HalWaitOnBusy();
+    EndCommand();
   }
 }
 
 //==========================================================================
 //==========================================================================
 void SX1280HalReadCommand(RadioCommands_t command, uint8_t* buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalReadCommand device not registered.\n");
     return;
   }
   memset(buffer, 0xff, size);
 
-  // Check Device Ready
-  SX1280CheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = (uint8_t)command;
-  halTxBuffer[1] = 0;
+  BeginCommand(command);
 
-  if (command == RADIO_GET_STATUS) {
-    if (size > (MAX_HAL_BUFFER_SIZE - 1)) {
-      printf("ERROR. SX1280HalReadCommand data size (%u) too larget.\n", size);
-      return;
-    }
-    xfer.length = (1 + size) * 8;
-  } else {
-    if (size > (MAX_HAL_BUFFER_SIZE - 2)) {
-      printf("ERROR. SX1280HalReadCommand data size (%u) too larget.\n", size);
-      return;
-    }
-    xfer.length = (2 + size) * 8;
+  // The status is the first data byte of GET_STATUS. The other commands
+  // have a NOP byte before the data, sent in the address phase.
+  RadioSpiXfer_t xfer = {.cmd = command, .rxData = buffer, .length = size, .waitReady = true};
+  if (command != RADIO_GET_STATUS) {
+    xfer.addrBits = 8;
   }
+  Transfer(&xfer);
 
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand SPI transmit failed.\n");
-  } else {
-    // All ok
-    if (command == RADIO_GET_STATUS) {
-      memcpy(buffer, &halRxBuffer[1], size);
-    } else {
-      memcpy(buffer, &halRxBuffer[2], size);
-    }
-  }
-  spi_device_release_bus(gDevSx1280);
-
-  SX1280HalWaitOnBusy();
+  EndCommand();
 }
 
 //==========================================================================
 //==========================================================================
 void SX1280HalWriteRegisters(uint16_t address, uint8_t* buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalWriteRegisters device not registered.\n");
     return;
   }
 
-  // Check Device Ready
-  SX1280CheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_WRITE_REGISTER;
-  halTxBuffer[1] = (uint8_t)(address >> 8);
-  halTxBuffer[2] = (uint8_t)(address >> 0);
-  if (size > (MAX_HAL_BUFFER_SIZE - 3)) {
-    printf("ERROR. SX1280HalWriteRegisters data size (%u) too larget.\n", size);
-    return;
-  }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[3], buffer, size);
-  }
-  xfer.length = (3 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-
-  // LORARADIO_HEX2STRING("WR REG:", halTxBuffer, (3 + size));
+  BeginCommand(RADIO_WRITE_REGISTER);
 
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteRegisters accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteRegisters SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx1280);
+  RadioSpiXfer_t xfer = {.cmd = RADIO_WRITE_REGISTER,
+                         .addrBits = 16,
+                         .addr = address,
+                         .txData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
 
-  SX1280HalWaitOnBusy();
+  EndCommand();
 }
 
 //==========================================================================
@@ -347,45 +294,24 @@ void SX1280HalWriteRegister(uint16_t address, uint8_t value) { SX1280HalWriteReg
 //==========================================================================
 //==========================================================================
 void SX1280HalReadRegisters(uint16_t address, uint8_t* buffer, uint16_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
-    printf("ERROR. SX1280HalReadCommand device not registered.\n");
+    printf("ERROR. SX1280HalReadRegisters device not registered.\n");
     return;
   }
   memset(buffer, 0xff, size);
 
-  // Check Device Ready
-  SX1280CheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_READ_REGISTER;
-  halTxBuffer[1] = (uint8_t)(address >> 8);
-  halTxBuffer[2] = (uint8_t)(address >> 0);
-  halTxBuffer[3] = 0;
-  if (size > (MAX_HAL_BUFFER_SIZE - 4)) {
-    printf("ERROR. SX1280HalReadCommand data size (%u) too larget.\n", size);
-    return;
-  }
-  xfer.length = (4 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand SPI transmit failed.\n");
-  } else {
-    // All ok
-    memcpy(buffer, &halRxBuffer[4], size);
-  }
-  spi_device_release_bus(gDevSx1280);
+  BeginCommand(RADIO_READ_REGISTER);
 
-  SX1280HalWaitOnBusy();
+  // The address and the status byte go in the address phase
+  RadioSpiXfer_t xfer = {.cmd = RADIO_READ_REGISTER,
+                         .addrBits = 24,
+                         .addr = (uint32_t)address << 8,
+                         .rxData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
@@ -401,88 +327,47 @@ uint8_t SX1280HalReadRegister(uint16_t address) {
 //==========================================================================
 //==========================================================================
 void SX1280HalWriteBuffer(uint8_t offset, uint8_t* buffer, uint8_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
     printf("ERROR. SX1280HalWriteBuffer device not registered.\n");
     return;
   }
 
-  // Check Device Ready
-  SX1280CheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_WRITE_BUFFER;
-  halTxBuffer[1] = offset;
-  if (size > (MAX_HAL_BUFFER_SIZE - 2)) {
-    printf("ERROR. SX1280HalWriteBuffer data size (%u) too larget.\n", size);
-    return;
-  }
-  if ((buffer != NULL) && (size > 0)) {
-    memcpy(&halTxBuffer[2], buffer, size);
-  }
-  xfer.length = (2 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
+  BeginCommand(RADIO_WRITE_BUFFER);
 
-  // LORARADIO_HEX2STRING("WR BUF:", halTxBuffer, (2 + size));
+  // The data is sent from the caller buffer without a copy
+  RadioSpiXfer_t xfer = {.cmd = RADIO_WRITE_BUFFER,
+                         .addrBits = 8,
+                         .addr = offset,
+                         .txData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
 
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteBuffer accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalWriteBuffer SPI transmit failed.\n");
-  } else {
-    // All ok
-  }
-  spi_device_release_bus(gDevSx1280);
-
-  SX1280HalWaitOnBusy();
+  EndCommand();
 }
 
 //==========================================================================
 //==========================================================================
 void SX1280HalReadBuffer(uint8_t offset, uint8_t* buffer, uint8_t size) {
-  spi_transaction_t xfer;
-
   if (gDevSx1280 == NULL) {
-    printf("ERROR. SX1280HalReadCommand device not registered.\n");
+    printf("ERROR. SX1280HalReadBuffer device not registered.\n");
     return;
   }
   memset(buffer, 0xff, size);
 
-  // Check Device Ready
-  SX1280CheckDeviceReady();
-
-  // Set up transfer info
-  memset(&halTxBuffer, 0, sizeof(halTxBuffer));
-  memset(&halRxBuffer, 0, sizeof(halRxBuffer));
-  memset(&xfer, 0, sizeof(xfer));
-  halTxBuffer[0] = RADIO_READ_BUFFER;
-  halTxBuffer[1] = offset;
-  halTxBuffer[2] = 0;
-  if (size > (MAX_HAL_BUFFER_SIZE - 3)) {
-    printf("ERROR. SX1280HalReadCommand data size (%u) too larget.\n", size);
-    return;
-  }
-  xfer.length = (3 + size) * 8;
-  xfer.tx_buffer = halTxBuffer;
-  xfer.rx_buffer = halRxBuffer;
-
-  // start
-  if (spi_device_acquire_bus(gDevSx1280, portMAX_DELAY) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand accuire SPI bus failed.\n");
-  } else if (spi_device_polling_transmit(gDevSx1280, &xfer) != ESP_OK) {
-    printf("ERROR. SX1280HalReadCommand SPI transmit failed.\n");
-  } else {
-    // All ok
-    memcpy(buffer, &halRxBuffer[3], size);
-  }
-  spi_device_release_bus(gDevSx1280);
+  BeginCommand(RADIO_READ_BUFFER);
 
-  SX1280HalWaitOnBusy();
+  // The offset and the status byte go in the address phase, the data is
+  // read into the caller buffer.
+  RadioSpiXfer_t xfer = {.cmd = RADIO_READ_BUFFER,
+                         .addrBits = 16,
+                         .addr = (uint32_t)offset << 8,
+                         .rxData = buffer,
+                         .length = size,
+                         .waitReady = true};
+  Transfer(&xfer);
+
+  EndCommand();
 }
 
 //==========================================================================
@@ -506,3 +391,15 @@ void SX1280SetOperatingMode(RadioOperatingModes_t mode) { gOperatingMode = mode;
 //==========================================================================
 //==========================================================================
 bool SX1280IsError(void) { return gChipError; };
+
+//==========================================================================
+//==========================================================================
+void SX1280HalPrintBusyStats(void) {
+  if (gBusySx1280.ops != NULL) {
+    RadioBusyPrintStats(&gBusySx1280);
+  }
+}
+
+//==========================================================================
+//==========================================================================
+void SX1280HalPrintSpiStats(void) { RadioShadowPrintStats(&SX1280Shadow); }
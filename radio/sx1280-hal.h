@@ -49,6 +49,19 @@ void SX1280HalClearInstructionRam( void );
  */
 void SX1280HalWakeup( void );
 
+/*!
+ * \brief Chains the following commands under one SPI bus acquisition
+ *
+ * \remark Inside a chain the write commands return once they are queued.
+ *         The buffer of SX1280HalWriteBuffer must stay valid until SX1280HalChainEnd.
+ */
+void SX1280HalChainBegin( void );
+
+/*!
+ * \brief Waits for the chained commands and releases the SPI bus
+ */
+void SX1280HalChainEnd( void );
+
 /*!
  * \brief Send a command that write data to the radio
  *
@@ -151,4 +164,10 @@ void SX1280SetOperatingMode( RadioOperatingModes_t mode );
 // Return chip error
 bool SX1280IsError(void);
 
+// Print the BUSY time histograms per command
+void SX1280HalPrintBusyStats(void);
+
+// Print the SPI commands and bytes sent and skipped
+void SX1280HalPrintSpiStats(void);
+
 #endif // __SX1280_HAL_H__
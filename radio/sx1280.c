@@ -51,6 +51,50 @@ static RadioPacketTypes_t PacketType;
  */
 static RadioLoRaBandwidths_t LoRaBandwidth;
 
+/*!
+ * \brief Stores the current LoRa header type set in the radio
+ */
+static RadioLoRaPacketLengthsModes_t LoRaHeaderType;
+
+/*!
+ * \brief Stores the IRQs enabled by the last SX1280SetDioIrqParams
+ */
+static uint16_t IrqMask = IRQ_RADIO_NONE;
+
+/*!
+ * \brief IRQs raised by a reception that writes to the data buffer
+ */
+#define SX1280_RX_BUFFER_IRQS   ( IRQ_RX_DONE | IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID | IRQ_HEADER_ERROR | IRQ_CRC_ERROR )
+
+/*!
+ * \brief Configuration last applied to the radio, and the SPI counters
+ */
+RadioShadow_t SX1280Shadow = { .name = "SX1280" };
+
+/*!
+ * \brief Sends a configuration command unless the radio already has it
+ */
+static void SX1280WriteConfigCommand( RadioCommands_t opcode, uint8_t *buffer, uint16_t size )
+{
+    if( RadioShadowCommand( &SX1280Shadow, opcode, buffer, size ) == true )
+    {
+        SX1280HalWriteCommand( opcode, buffer, size );
+    }
+}
+
+/*!
+ * \brief Without a latched sync word or header IRQ, a reception could write to
+ *        the data buffer unnoticed
+ */
+static void SX1280OnRxStart( void )
+{
+    if( ( ( IrqMask & ( IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID ) ) != ( IRQ_SYNCWORD_VALID | IRQ_HEADER_VALID ) ) ||
+        ( ( PacketType == PACKET_TYPE_LORA ) && ( LoRaHeaderType == LORA_PACKET_IMPLICIT ) ) )
+    {
+        RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_PAYLOAD );
+    }
+}
+
 int32_t SX1280complement2( const uint32_t num, const uint8_t bitCnt )
 {
     int32_t retVal = ( int32_t )num;
@@ -65,6 +109,7 @@ void SX1280Init( DioIrqHandler irqHandlers )
 {
     SX1280HalInit();
     SX1280HalIoIrqInit(irqHandlers);
+    IrqMask = IRQ_RADIO_NONE;
     SX1280SetOperatingMode( MODE_STDBY_RC );
 }
 
@@ -106,6 +151,17 @@ void SX1280SetSleep( SleepParams_t sleepConfig )
                     ( sleepConfig.DataBufferRetention << 1 ) |
                     ( sleepConfig.DataRamRetention );
 
+    // The configuration is kept with data RAM retention, the payload with
+    // data buffer retention
+    if( sleepConfig.DataRamRetention == 0 )
+    {
+        RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_COMMANDS | RADIO_SHADOW_REGISTERS );
+    }
+    if( sleepConfig.DataBufferRetention == 0 )
+    {
+        RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_PAYLOAD );
+    }
+
     SX1280SetOperatingMode(MODE_SLEEP);
     SX1280HalWriteCommand( RADIO_SET_SLEEP, &sleep, 1 );
     SX1280SetOperatingMode( MODE_SLEEP );
@@ -145,6 +201,7 @@ void SX1280SetTx( TickTime_t timeout )
     {
         SX1280SetRangingRole( RADIO_RANGING_ROLE_MASTER );
     }
+    RadioShadowUplink( &SX1280Shadow );
     SX1280HalWriteCommand( RADIO_SET_TX, buf, 3 );
     SX1280SetOperatingMode(MODE_TX);
 }
@@ -164,6 +221,7 @@ void SX1280SetRx( TickTime_t timeout )
     {
         SX1280SetRangingRole( RADIO_RANGING_ROLE_SLAVE );
     }
+    SX1280OnRxStart( );
     SX1280HalWriteCommand( RADIO_SET_RX, buf, 3 );
     SX1280SetOperatingMode(MODE_RX);
 }
@@ -177,6 +235,8 @@ void SX1280SetRxDutyCycle( RadioTickSizes_t Step, uint16_t NbStepRx, uint16_t Rx
     buf[2] = ( uint8_t )( NbStepRx & 0x00FF );
     buf[3] = ( uint8_t )( ( RxNbStepSleep >> 8 ) & 0x00FF );
     buf[4] = ( uint8_t )( RxNbStepSleep & 0x00FF );
+    // The data buffer is lost in the sleep periods
+    RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_PAYLOAD );
     SX1280HalWriteCommand( RADIO_SET_RXDUTYCYCLE, buf, 5 );
     SX1280SetOperatingMode(MODE_RX);
 }
@@ -202,7 +262,13 @@ void SX1280SetPacketType( RadioPacketTypes_t packetType )
     // Save packet type internally to avoid questioning the radio
     PacketType = packetType;
 
-    SX1280HalWriteCommand( RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+    if( RadioShadowCommand( &SX1280Shadow, RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 ) == true )
+    {
+        // The modem parameters and the sync word are reset with the packet type
+        RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_COMMANDS | RADIO_SHADOW_REGISTERS );
+        RadioShadowCommand( &SX1280Shadow, RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+        SX1280HalWriteCommand( RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+    }
 }
 
 RadioPacketTypes_t SX1280GetPacketType( void )
@@ -219,7 +285,7 @@ void SX1280SetRfFrequency( uint32_t frequency )
     buf[0] = ( uint8_t )( ( freq >> 16 ) & 0xFF );
     buf[1] = ( uint8_t )( ( freq >> 8 ) & 0xFF );
     buf[2] = ( uint8_t )( freq & 0xFF );
-    SX1280HalWriteCommand( RADIO_SET_RFFREQUENCY, buf, 3 );
+    SX1280WriteConfigCommand( RADIO_SET_RFFREQUENCY, buf, 3 );
 }
 
 void SX1280SetTxParams( int8_t power, RadioRampTimes_t rampTime )
@@ -230,7 +296,7 @@ void SX1280SetTxParams( int8_t power, RadioRampTimes_t rampTime )
     // physical output power is in the range [-18..13]dBm
     buf[0] = power + 18;
     buf[1] = ( uint8_t )rampTime;
-    SX1280HalWriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
+    SX1280WriteConfigCommand( RADIO_SET_TXPARAMS, buf, 2 );
 }
 
 void SX1280SetCadParams( RadioLoRaCadSymbols_t cadSymbolNum )
@@ -245,7 +311,7 @@ void SX1280SetBufferBaseAddresses( uint8_t txBaseAddress, uint8_t rxBaseAddress
 
     buf[0] = txBaseAddress;
     buf[1] = rxBaseAddress;
-    SX1280HalWriteCommand( RADIO_SET_BUFFERBASEADDRESS, buf, 2 );
+    SX1280WriteConfigCommand( RADIO_SET_BUFFERBASEADDRESS, buf, 2 );
 }
 
 void SX1280SetModulationParams( ModulationParams_t *modulationParams )
@@ -293,7 +359,7 @@ void SX1280SetModulationParams( ModulationParams_t *modulationParams )
             buf[2] = 0;
             break;
     }
-    SX1280HalWriteCommand( RADIO_SET_MODULATIONPARAMS, buf, 3 );
+    SX1280WriteConfigCommand( RADIO_SET_MODULATIONPARAMS, buf, 3 );
 }
 
 void SX1280SetPacketParams( PacketParams_t *packetParams )
@@ -328,6 +394,7 @@ void SX1280SetPacketParams( PacketParams_t *packetParams )
             buf[4] = packetParams->Params.LoRa.InvertIQ;
             buf[5] = 0;
             buf[6] = 0;
+            LoRaHeaderType = packetParams->Params.LoRa.HeaderType;
             break;
 
         case PACKET_TYPE_FLRC:
@@ -360,7 +427,7 @@ void SX1280SetPacketParams( PacketParams_t *packetParams )
             buf[6] = 0;
             break;
     }
-    SX1280HalWriteCommand( RADIO_SET_PACKETPARAMS, buf, 7 );
+    SX1280WriteConfigCommand( RADIO_SET_PACKETPARAMS, buf, 7 );
 }
 
 void SX1280GetRxBufferStatus( uint8_t *payloadLength, uint8_t *rxStartBufferPointer )
@@ -502,7 +569,8 @@ void SX1280SetDioIrqParams( uint16_t irqMask, uint16_t dio1Mask, uint16_t dio2Ma
     buf[5] = ( uint8_t )( dio2Mask & 0x00FF );
     buf[6] = ( uint8_t )( ( dio3Mask >> 8 ) & 0x00FF );
     buf[7] = ( uint8_t )( dio3Mask & 0x00FF );
-    SX1280HalWriteCommand( RADIO_SET_DIOIRQPARAMS, buf, 8 );
+    IrqMask = irqMask;
+    SX1280WriteConfigCommand( RADIO_SET_DIOIRQPARAMS, buf, 8 );
 }
 
 uint16_t SX1280GetIrqStatus( void )
@@ -511,7 +579,12 @@ uint16_t SX1280GetIrqStatus( void )
 
     SX1280HalReadCommand( RADIO_GET_IRQSTATUS, irqStatus, 2 );
 
-    return ( irqStatus[0] << 8 ) | irqStatus[1];
+    uint16_t irq = ( irqStatus[0] << 8 ) | irqStatus[1];
+    if( ( irq & SX1280_RX_BUFFER_IRQS ) != 0 )
+    {
+        RadioShadowInvalidate( &SX1280Shadow, RADIO_SHADOW_PAYLOAD );
+    }
+    return irq;
 }
 
 void SX1280ClearIrqStatus( uint16_t irq )
@@ -537,7 +610,7 @@ void SX1280Calibrate( CalibrationParams_t calibParam )
 
 void SX1280SetRegulatorMode( RadioRegulatorModes_t mode )
 {
-    SX1280HalWriteCommand( RADIO_SET_REGULATORMODE, ( uint8_t* )&mode, 1 );
+    SX1280WriteConfigCommand( RADIO_SET_REGULATORMODE, ( uint8_t* )&mode, 1 );
 }
 
 void SX1280SetSaveContext( void )
@@ -563,17 +636,26 @@ void SX1280StopAutoTx( void )
 
 void SX1280SetAutoFS( uint8_t enable )
 {
-    SX1280HalWriteCommand( RADIO_SET_AUTOFS, &enable, 1 );
+    SX1280WriteConfigCommand( RADIO_SET_AUTOFS, &enable, 1 );
 }
 
 void SX1280SetLongPreamble( uint8_t enable )
 {
-    SX1280HalWriteCommand( RADIO_SET_LONGPREAMBLE, &enable, 1 );
+    SX1280WriteConfigCommand( RADIO_SET_LONGPREAMBLE, &enable, 1 );
 }
 
 void SX1280SetPayload( uint8_t *buffer, uint8_t size )
 {
-    SX1280HalWriteBuffer( 0x00, buffer, size );
+    // A retransmission finds its payload still in the data buffer, unless
+    // SX1280GetIrqStatus reports a reception since the last IRQ clear
+    if( RadioShadowHasPayload( &SX1280Shadow, 0x00, buffer, size ) == true )
+    {
+        SX1280GetIrqStatus( );
+    }
+    if( RadioShadowWritePayload( &SX1280Shadow, 0x00, buffer, size ) == true )
+    {
+        SX1280HalWriteBuffer( 0x00, buffer, size );
+    }
 }
 
 uint8_t SX1280GetPayload( uint8_t *buffer, uint8_t *size , uint8_t maxSize )
@@ -1153,4 +1235,24 @@ double SX1280ComputeRangingCorrectionPolynome(const RadioLoRaSpreadingFactors_t
         correctedValue += correctionCoeff;
     }
     return correctedValue;
-}
\ No newline at end of file
+}
+
+void SX1280SetConfigRegister( uint16_t address, uint8_t value )
+{
+    if( RadioShadowWriteRegister( &SX1280Shadow, address, value ) == true )
+    {
+        SX1280HalWriteRegister( address, value );
+    }
+}
+
+uint8_t SX1280GetConfigRegister( uint16_t address )
+{
+    uint8_t value;
+
+    if( RadioShadowReadRegister( &SX1280Shadow, address, &value ) == false )
+    {
+        value = SX1280HalReadRegister( address );
+        RadioShadowStoreRegister( &SX1280Shadow, address, value );
+    }
+    return value;
+}
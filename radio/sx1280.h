@@ -21,6 +21,7 @@ Maintainer: Miguel Luis, Gregory Cristian and Matthieu Verdy
 #include <math.h>
 
 #include "radio.h"
+#include "radio_shadow.h"
 
 /*!
  * \brief Enables/disables driver debug features
@@ -1606,4 +1607,25 @@ int8_t SX1280ParseHexFileLine( char* line );
  */
 int8_t SX1280GetHexFileLineFields( char* line, uint8_t *bytes, uint16_t *addr, uint16_t *num, uint8_t *code );
 
+/*!
+ * \brief Writes a configuration register unless it already holds the value
+ *
+ * \param [in]  address       Register address
+ * \param [in]  value         New register value
+ */
+void SX1280SetConfigRegister( uint16_t address, uint8_t value );
+
+/*!
+ * \brief Reads a configuration register, from the shadow once it is known
+ *
+ * \param [in]  address       Register address
+ * \retval      value         Register value
+ */
+uint8_t SX1280GetConfigRegister( uint16_t address );
+
+/*!
+ * \brief Configuration last applied to the radio, and the SPI counters
+ */
+extern RadioShadow_t SX1280Shadow;
+
 #endif // __SX1280_H__
@@ -64,6 +64,19 @@
 
 #include "aes.h"
 
+/*  The byte rounds are used by every encryption but the table one, and
+    by the byte version kept next to it with AES_ENC_REFERENCE. Their
+    round key helpers are used by every decryption as well.
+*/
+#if !defined( AES_ENC_TTABLE ) || defined( AES_ENC_REFERENCE ) || \
+    defined( AES_ENC_128_OTFK ) || defined( AES_ENC_256_OTFK )
+#  define AES_ENC_BYTE_ROUNDS
+#endif
+#if defined( AES_ENC_BYTE_ROUNDS ) || defined( AES_DEC_PREKEYED ) || \
+    defined( AES_DEC_128_OTFK ) || defined( AES_DEC_256_OTFK )
+#  define AES_BYTE_ROUNDS
+#endif
+
 //#if defined( HAVE_UINT_32T )
 //  typedef unsigned long uint32_t;
 //#endif
@@ -197,8 +210,10 @@ static const uint8_t sbox[256]  =  sb_data(f1);
 static const uint8_t isbox[256] = isb_data(f1);
 #endif
 
+#if defined( AES_ENC_BYTE_ROUNDS )
 static const uint8_t gfm2_sbox[256] = sb_data(f2);
 static const uint8_t gfm3_sbox[256] = sb_data(f3);
+#endif
 
 #if defined( AES_DEC_PREKEYED )
 static const uint8_t gfmul_9[256] = mm_data(f9);
@@ -207,6 +222,14 @@ static const uint8_t gfmul_d[256] = mm_data(fd);
 static const uint8_t gfmul_e[256] = mm_data(fe);
 #endif
 
+#if defined( AES_ENC_TTABLE )
+/*  32-bit encryption table, little endian column word (2s, s, s, 3s).
+    The other three tables of the usual T-table scheme are rotations of it.
+*/
+#define t_enc(x) ( ( uint32_t )f2(x) | ( ( uint32_t )(x) << 8 ) | ( ( uint32_t )(x) << 16 ) | ( ( uint32_t )f3(x) << 24 ) )
+static const uint32_t t_enc_tab[256] = sb_data(t_enc);
+#endif
+
 #define s_box(x)     sbox[(x)]
 #if defined( AES_DEC_PREKEYED )
 #define is_box(x)    isbox[(x)]
@@ -375,6 +398,8 @@ static void xor_block( void *d, const void *s )
 #endif
 }
 
+#if defined( AES_BYTE_ROUNDS )
+
 static void copy_and_key( void *d, const void *s, const void *k )
 {
 #if defined( HAVE_UINT_32T )
@@ -410,6 +435,10 @@ static void add_round_key( uint8_t d[N_BLOCK], const uint8_t k[N_BLOCK] )
     xor_block(d, k);
 }
 
+#endif
+
+#if defined( AES_ENC_BYTE_ROUNDS )
+
 static void shift_sub_rows( uint8_t st[N_BLOCK] )
 {
     uint8_t tt;
@@ -427,6 +456,8 @@ static void shift_sub_rows( uint8_t st[N_BLOCK] )
     st[ 7] = s_box(st[ 3]); st[ 3] = s_box( tt );
 }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
@@ -448,6 +479,8 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
 
 #endif
 
+#if defined( AES_ENC_BYTE_ROUNDS )
+
 #if defined( VERSION_1 )
 static void mix_sub_columns( uint8_t dt[N_BLOCK] )
 {
@@ -478,6 +511,8 @@ static void mix_sub_columns( uint8_t dt[N_BLOCK], uint8_t st[N_BLOCK] )
     dt[15] = gfm3_sb(st[12]) ^ s_box(st[1]) ^ s_box(st[6]) ^ gfm2_sb(st[11]);
 }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 #if defined( VERSION_1 )
@@ -565,9 +600,86 @@ return_type lora_aes_set_key( const uint8_t key[], length_type keylen, aes_conte
 
 #if defined( AES_ENC_PREKEYED )
 
-/*  Encrypt a single block of 16 bytes */
+#if defined( AES_ENC_TTABLE )
+
+#if !defined( USE_TABLES )
+#  error "AES_ENC_TTABLE needs USE_TABLES"
+#endif
+
+#define rotl32(x, n)    ( ( ( x ) << ( n ) ) | ( ( x ) >> ( 32 - ( n ) ) ) )
+#define load_le32(p)    ( ( uint32_t )( p )[0] | ( ( uint32_t )( p )[1] << 8 ) | \
+                          ( ( uint32_t )( p )[2] << 16 ) | ( ( uint32_t )( p )[3] << 24 ) )
+#define b0(x)           ( ( x ) & 0xff )
+#define b1(x)           ( ( ( x ) >> 8 ) & 0xff )
+#define b2(x)           ( ( ( x ) >> 16 ) & 0xff )
+#define b3(x)           ( ( x ) >> 24 )
+
+/*  One round of SubBytes, ShiftRows and MixColumns on column words */
+#define t_round(a, b, c, d) ( t_enc_tab[b0(a)] ^ rotl32( t_enc_tab[b1(b)], 8 ) ^ \
+                              rotl32( t_enc_tab[b2(c)], 16 ) ^ rotl32( t_enc_tab[b3(d)], 24 ) )
+
+/*  Last round, SubBytes and ShiftRows only */
+#define t_last(a, b, c, d)  ( ( uint32_t )s_box(b0(a)) | ( ( uint32_t )s_box(b1(b)) << 8 ) | \
+                              ( ( uint32_t )s_box(b2(c)) << 16 ) | ( ( uint32_t )s_box(b3(d)) << 24 ) )
+
+static void store_le32( uint8_t *p, uint32_t v )
+{
+    p[0] = ( uint8_t )v;
+    p[1] = ( uint8_t )( v >> 8 );
+    p[2] = ( uint8_t )( v >> 16 );
+    p[3] = ( uint8_t )( v >> 24 );
+}
+
+/*  Encrypt a single block of 16 bytes, 32-bit table version */
 
 return_type laes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const aes_context ctx[1] )
+{
+    const uint8_t *rk = ctx->ksch;
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t r;
+
+    if ( ctx->rnd == 0 ) {
+        return ( uint8_t ) -1;
+    }
+
+    s0 = load_le32( in + 0 ) ^ load_le32( rk + 0 );
+    s1 = load_le32( in + 4 ) ^ load_le32( rk + 4 );
+    s2 = load_le32( in + 8 ) ^ load_le32( rk + 8 );
+    s3 = load_le32( in + 12 ) ^ load_le32( rk + 12 );
+
+    for ( r = 1 ; r < ctx->rnd ; ++r ) {
+        rk += N_BLOCK;
+        t0 = t_round( s0, s1, s2, s3 ) ^ load_le32( rk + 0 );
+        t1 = t_round( s1, s2, s3, s0 ) ^ load_le32( rk + 4 );
+        t2 = t_round( s2, s3, s0, s1 ) ^ load_le32( rk + 8 );
+        t3 = t_round( s3, s0, s1, s2 ) ^ load_le32( rk + 12 );
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    rk += N_BLOCK;
+    store_le32( out + 0, t_last( s0, s1, s2, s3 ) ^ load_le32( rk + 0 ) );
+    store_le32( out + 4, t_last( s1, s2, s3, s0 ) ^ load_le32( rk + 4 ) );
+    store_le32( out + 8, t_last( s2, s3, s0, s1 ) ^ load_le32( rk + 8 ) );
+    store_le32( out + 12, t_last( s3, s0, s1, s2 ) ^ load_le32( rk + 12 ) );
+    return 0;
+}
+
+#endif
+
+#if !defined( AES_ENC_TTABLE ) || defined( AES_ENC_REFERENCE )
+
+#if defined( AES_ENC_TTABLE )
+#  define laes_encrypt_bytes laes_encrypt_ref
+#else
+#  define laes_encrypt_bytes laes_encrypt
+#endif
+
+/*  Encrypt a single block of 16 bytes */
+
+return_type laes_encrypt_bytes( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const aes_context ctx[1] )
 {
     if ( ctx->rnd ) {
         uint8_t s1[N_BLOCK], r;
@@ -594,6 +706,8 @@ return_type laes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], cons
     return 0;
 }
 
+#endif
+
 /* CBC encrypt a number of blocks (input and return an IV) */
 
 return_type lora_aes_cbc_encrypt( const uint8_t *in, uint8_t *out,
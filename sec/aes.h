@@ -43,6 +43,15 @@ extern "C" {
 #if 0
 #  define AES_DEC_PREKEYED  /* AES decryption with a precomputed key schedule  */
 #endif
+
+/*  AES_ENC_TTABLE: 32-bit table encryption for the pre-keyed version.
+    Uses one 1 KB table, a few times faster than the byte version on
+    32-bit cores. Not constant time, same as the byte version.
+    Set from the build (CONFIG_LORAWAN_AES_TTABLE).
+
+    AES_ENC_REFERENCE: with AES_ENC_TTABLE, build the byte version as
+    well, as laes_encrypt_ref(), to compare the two.
+*/
 #if 0
 #  define AES_ENC_128_OTFK  /* AES encryption with 'on the fly' 128 bit keying */
 #endif
@@ -95,6 +104,13 @@ return_type laes_encrypt( const uint8_t in[N_BLOCK],
                           uint8_t out[N_BLOCK],
                           const aes_context ctx[1] );
 
+#if defined( AES_ENC_TTABLE ) && defined( AES_ENC_REFERENCE )
+/*  The byte version, built next to the table one to compare the two */
+return_type laes_encrypt_ref( const uint8_t in[N_BLOCK],
+                              uint8_t out[N_BLOCK],
+                              const aes_context ctx[1] );
+#endif
+
 return_type lora_aes_cbc_encrypt( const uint8_t *in,
                              uint8_t *out,
                              int32_t n_block,
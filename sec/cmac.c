@@ -61,11 +61,18 @@ void AES_CMAC_Init( AES_CMAC_CTX *ctx )
     memset1( ctx->X, 0, sizeof ctx->X );
     ctx->M_n = 0;
     memset1( ctx->rijndael.ksch, '\0', 240 );
+    ctx->ksch = &ctx->rijndael;
 }
 
 void AES_CMAC_SetKey( AES_CMAC_CTX *ctx, const uint8_t key[AES_CMAC_KEY_LENGTH] )
 {
     lora_aes_set_key( key, AES_CMAC_KEY_LENGTH, &ctx->rijndael );
+    ctx->ksch = &ctx->rijndael;
+}
+
+void AES_CMAC_SetKeySchedule( AES_CMAC_CTX *ctx, const aes_context *ksch )
+{
+    ctx->ksch = ksch;
 }
 
 void AES_CMAC_Update( AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len )
@@ -83,7 +90,7 @@ void AES_CMAC_Update( AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len )
         XOR( ctx->M_last, ctx->X );
 
         memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        laes_encrypt( in, in, &ctx->rijndael );
+        laes_encrypt( in, in, ctx->ksch );
         memcpy1( &ctx->X[0], in, 16 );
 
         data += mlen;
@@ -95,7 +102,7 @@ void AES_CMAC_Update( AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len )
         XOR( data, ctx->X );
 
         memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        laes_encrypt( in, in, &ctx->rijndael );
+        laes_encrypt( in, in, ctx->ksch );
         memcpy1( &ctx->X[0], in, 16 );
 
         data += 16;
@@ -113,7 +120,7 @@ void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX *ctx )
     /* generate subkey K1 */
     memset1( K, '\0', 16 );
 
-    laes_encrypt( K, K, &ctx->rijndael );
+    laes_encrypt( K, K, ctx->ksch );
 
     if ( K[0] & 0x80 ) {
         LSHIFT( K, K );
@@ -145,6 +152,6 @@ void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX *ctx )
     XOR( ctx->M_last, ctx->X );
 
     memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-    laes_encrypt( in, digest, &ctx->rijndael );
+    laes_encrypt( in, digest, ctx->ksch );
     memset1( K, 0, sizeof K );
 }
@@ -0,0 +1,138 @@
+/*!
+ * \file      se-crypto-esp.c
+ *
+ * \brief     ESP AES accelerator crypto provider of the secure element
+ */
+#include "se-crypto.h"
+
+#if defined( SE_CRYPTO_ESP_AES )
+
+#include <string.h>
+
+#include "utilities.h"
+
+/*
+ * CMAC subkey doubling in GF(2^128)
+ */
+static void CmacDouble( const uint8_t *in, uint8_t *out )
+{
+    uint8_t msb = in[0] & 0x80;
+
+    for ( uint8_t i = 0; i < SE_CRYPTO_BLOCK_SIZE - 1; i++ ) {
+        out[i] = ( in[i] << 1 ) | ( in[i + 1] >> 7 );
+    }
+    out[SE_CRYPTO_BLOCK_SIZE - 1] = in[SE_CRYPTO_BLOCK_SIZE - 1] << 1;
+    if ( msb != 0 ) {
+        out[SE_CRYPTO_BLOCK_SIZE - 1] ^= 0x87;
+    }
+}
+
+static bool EspSetKey( SeCryptoKey_t *keyCtx, const uint8_t *key )
+{
+    uint8_t l[SE_CRYPTO_BLOCK_SIZE] = { 0 };
+
+    esp_aes_init( &keyCtx->Esp.Aes );
+    if ( esp_aes_setkey( &keyCtx->Esp.Aes, key, 128 ) != 0 ) {
+        return false;
+    }
+    esp_aes_crypt_ecb( &keyCtx->Esp.Aes, ESP_AES_ENCRYPT, l, l );
+    CmacDouble( l, keyCtx->Esp.K1 );
+    CmacDouble( keyCtx->Esp.K1, keyCtx->Esp.K2 );
+    memset1( l, 0, sizeof( l ) );
+    return true;
+}
+
+static void EspClearKey( SeCryptoKey_t *keyCtx )
+{
+    esp_aes_free( &keyCtx->Esp.Aes );
+    memset1( ( uint8_t * )&keyCtx->Esp, 0, sizeof( keyCtx->Esp ) );
+}
+
+static void EspEcbEncrypt( const SeCryptoKey_t *keyCtx, const uint8_t *in, uint8_t *out, uint16_t size )
+{
+    esp_aes_context *aes = ( esp_aes_context * )&keyCtx->Esp.Aes;
+
+    while ( size >= SE_CRYPTO_BLOCK_SIZE ) {
+        esp_aes_crypt_ecb( aes, ESP_AES_ENCRYPT, in, out );
+        in += SE_CRYPTO_BLOCK_SIZE;
+        out += SE_CRYPTO_BLOCK_SIZE;
+        size -= SE_CRYPTO_BLOCK_SIZE;
+    }
+}
+
+static void EspCtrCrypt( const SeCryptoKey_t *keyCtx, uint8_t *counter, uint8_t *buffer, uint16_t size )
+{
+    esp_aes_context *aes = ( esp_aes_context * )&keyCtx->Esp.Aes;
+    uint8_t          streamBlock[SE_CRYPTO_BLOCK_SIZE];
+    size_t           offset = 0;
+
+    esp_aes_crypt_ctr( aes, size, &offset, counter, streamBlock, buffer, buffer );
+    memset1( streamBlock, 0, sizeof( streamBlock ) );
+}
+
+static void EspCmac( const SeCryptoKey_t *keyCtx, const uint8_t *prefix, const uint8_t *buffer, uint16_t size,
+                     uint8_t *cmac )
+{
+    esp_aes_context *aes = ( esp_aes_context * )&keyCtx->Esp.Aes;
+    uint8_t          iv[SE_CRYPTO_BLOCK_SIZE] = { 0 };
+    uint8_t          last[SE_CRYPTO_BLOCK_SIZE];
+    uint8_t          scratch[4 * SE_CRYPTO_BLOCK_SIZE];
+    const uint8_t   *lastData;
+    uint8_t          lastLen;
+
+    if ( ( prefix != NULL ) && ( size == 0 ) ) {
+        // The prefix is the only block
+        lastData = prefix;
+        lastLen  = SE_CRYPTO_BLOCK_SIZE;
+    } else {
+        if ( prefix != NULL ) {
+            esp_aes_crypt_cbc( aes, ESP_AES_ENCRYPT, SE_CRYPTO_BLOCK_SIZE, iv, prefix, scratch );
+        }
+
+        // All complete blocks except the last one are chained in hardware
+        lastLen       = ( size == 0 ) ? 0 : ( ( size - 1 ) % SE_CRYPTO_BLOCK_SIZE ) + 1;
+        uint16_t bulk = size - lastLen;
+        while ( bulk > 0 ) {
+            uint16_t len = ( bulk > sizeof( scratch ) ) ? sizeof( scratch ) : bulk;
+            esp_aes_crypt_cbc( aes, ESP_AES_ENCRYPT, len, iv, buffer, scratch );
+            buffer += len;
+            bulk -= len;
+        }
+        lastData = buffer;
+    }
+
+    if ( lastLen == SE_CRYPTO_BLOCK_SIZE ) {
+        for ( uint8_t i = 0; i < SE_CRYPTO_BLOCK_SIZE; i++ ) {
+            last[i] = lastData[i] ^ keyCtx->Esp.K1[i];
+        }
+    } else {
+        memset1( last, 0, sizeof( last ) );
+        memcpy1( last, lastData, lastLen );
+        last[lastLen] = 0x80;
+        for ( uint8_t i = 0; i < SE_CRYPTO_BLOCK_SIZE; i++ ) {
+            last[i] ^= keyCtx->Esp.K2[i];
+        }
+    }
+    for ( uint8_t i = 0; i < SE_CRYPTO_BLOCK_SIZE; i++ ) {
+        last[i] ^= iv[i];
+    }
+    esp_aes_crypt_ecb( aes, ESP_AES_ENCRYPT, last, cmac );
+
+    memset1( scratch, 0, sizeof( scratch ) );
+}
+
+const SeCryptoProvider_t SeCryptoEspAes = {
+    .Name       = "esp-aes",
+    .SetKey     = EspSetKey,
+    .ClearKey   = EspClearKey,
+    .EcbEncrypt = EspEcbEncrypt,
+    .CtrCrypt   = EspCtrCrypt,
+    .Cmac       = EspCmac,
+};
+
+const SeCryptoProvider_t *SeCryptoGetProvider( void )
+{
+    return &SeCryptoEspAes;
+}
+
+#endif  // SE_CRYPTO_ESP_AES
@@ -0,0 +1,89 @@
+/*!
+ * \file      se-crypto-soft.c
+ *
+ * \brief     Software crypto provider of the secure element
+ */
+#include <string.h>
+
+#include "utilities.h"
+#include "aes.h"
+#include "cmac.h"
+
+#include "se-crypto.h"
+
+static bool SoftSetKey( SeCryptoKey_t *keyCtx, const uint8_t *key )
+{
+    aes_context *ctx = &keyCtx->Soft;
+
+    // Clear the whole context, through ksch GCC takes it for 240 bytes
+    // and warns that lora_aes_set_key() writes 241
+    memset1( ( uint8_t * )ctx, 0, sizeof( aes_context ) );
+    return ( lora_aes_set_key( key, 16, ctx ) == 0 );
+}
+
+static void SoftClearKey( SeCryptoKey_t *keyCtx )
+{
+    memset1( ( uint8_t * )&keyCtx->Soft, 0, sizeof( keyCtx->Soft ) );
+}
+
+static void SoftEcbEncrypt( const SeCryptoKey_t *keyCtx, const uint8_t *in, uint8_t *out, uint16_t size )
+{
+    while ( size >= SE_CRYPTO_BLOCK_SIZE ) {
+        laes_encrypt( in, out, &keyCtx->Soft );
+        in += SE_CRYPTO_BLOCK_SIZE;
+        out += SE_CRYPTO_BLOCK_SIZE;
+        size -= SE_CRYPTO_BLOCK_SIZE;
+    }
+}
+
+static void SoftCtrCrypt( const SeCryptoKey_t *keyCtx, uint8_t *counter, uint8_t *buffer, uint16_t size )
+{
+    uint8_t sBlock[SE_CRYPTO_BLOCK_SIZE];
+
+    while ( size > 0 ) {
+        uint8_t len = ( size > SE_CRYPTO_BLOCK_SIZE ) ? SE_CRYPTO_BLOCK_SIZE : size;
+
+        laes_encrypt( counter, sBlock, &keyCtx->Soft );
+        for ( uint8_t i = 0; i < len; i++ ) {
+            buffer[i] ^= sBlock[i];
+        }
+        for ( int8_t i = SE_CRYPTO_BLOCK_SIZE - 1; i >= 0; i-- ) {
+            if ( ++counter[i] != 0 ) {
+                break;
+            }
+        }
+        buffer += len;
+        size -= len;
+    }
+    memset1( sBlock, 0, sizeof( sBlock ) );
+}
+
+static void SoftCmac( const SeCryptoKey_t *keyCtx, const uint8_t *prefix, const uint8_t *buffer, uint16_t size,
+                      uint8_t *cmac )
+{
+    AES_CMAC_CTX aesCmacCtx[1];
+
+    AES_CMAC_Init( aesCmacCtx );
+    AES_CMAC_SetKeySchedule( aesCmacCtx, &keyCtx->Soft );
+    if ( prefix != NULL ) {
+        AES_CMAC_Update( aesCmacCtx, prefix, SE_CRYPTO_BLOCK_SIZE );
+    }
+    AES_CMAC_Update( aesCmacCtx, buffer, size );
+    AES_CMAC_Final( cmac, aesCmacCtx );
+}
+
+const SeCryptoProvider_t SeCryptoSoft = {
+    .Name       = "software",
+    .SetKey     = SoftSetKey,
+    .ClearKey   = SoftClearKey,
+    .EcbEncrypt = SoftEcbEncrypt,
+    .CtrCrypt   = SoftCtrCrypt,
+    .Cmac       = SoftCmac,
+};
+
+#if !defined( SE_CRYPTO_ESP_AES )
+const SeCryptoProvider_t *SeCryptoGetProvider( void )
+{
+    return &SeCryptoSoft;
+}
+#endif
@@ -0,0 +1,108 @@
+/*!
+ * \file      se-crypto.h
+ *
+ * \brief     Crypto provider interface of the software secure element
+ *
+ * \remark    soft-se.c keeps the keys and dispatches all AES operations to
+ *            the provider selected at build time:
+ *              - Software, sec/aes.c and sec/cmac.c (default, any target)
+ *              - ESP AES accelerator, when SE_CRYPTO_ESP_AES is defined
+ */
+#ifndef __SE_CRYPTO_H__
+#define __SE_CRYPTO_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "aes.h"
+
+#if defined( SE_CRYPTO_ESP_AES )
+#include "aes/esp_aes.h"
+#endif
+
+#define SE_CRYPTO_BLOCK_SIZE 16
+
+/*!
+ * Prepared key of the ESP AES accelerator provider
+ */
+#if defined( SE_CRYPTO_ESP_AES )
+typedef struct sSeCryptoEspKey {
+    esp_aes_context Aes;
+    /*!
+     * CMAC subkeys
+     */
+    uint8_t K1[SE_CRYPTO_BLOCK_SIZE];
+    uint8_t K2[SE_CRYPTO_BLOCK_SIZE];
+} SeCryptoEspKey_t;
+#endif
+
+/*!
+ * Prepared key, the provider decides which member is used
+ */
+typedef union uSeCryptoKey {
+    aes_context Soft;
+#if defined( SE_CRYPTO_ESP_AES )
+    SeCryptoEspKey_t Esp;
+#endif
+} SeCryptoKey_t;
+
+/*!
+ * Crypto provider. All functions use an AES-128 key prepared by SetKey.
+ */
+typedef struct sSeCryptoProvider {
+    /*!
+     * Provider name
+     */
+    const char *Name;
+    /*!
+     * Prepares a 16 bytes key
+     *
+     * \retval true on success
+     */
+    bool ( *SetKey )( SeCryptoKey_t *keyCtx, const uint8_t *key );
+    /*!
+     * Releases a prepared key
+     */
+    void ( *ClearKey )( SeCryptoKey_t *keyCtx );
+    /*!
+     * AES-ECB encryption, size is a multiple of 16
+     */
+    void ( *EcbEncrypt )( const SeCryptoKey_t *keyCtx, const uint8_t *in, uint8_t *out, uint16_t size );
+    /*!
+     * AES-CTR in place, any size. The counter block is incremented as a
+     * 128 bits big endian number and holds the next counter on return.
+     */
+    void ( *CtrCrypt )( const SeCryptoKey_t *keyCtx, uint8_t *counter, uint8_t *buffer, uint16_t size );
+    /*!
+     * AES-CMAC of prefix (16 bytes, may be NULL) followed by buffer
+     */
+    void ( *Cmac )( const SeCryptoKey_t *keyCtx, const uint8_t *prefix, const uint8_t *buffer, uint16_t size,
+                    uint8_t *cmac );
+} SeCryptoProvider_t;
+
+/*!
+ * Software provider, always available
+ */
+extern const SeCryptoProvider_t SeCryptoSoft;
+
+#if defined( SE_CRYPTO_ESP_AES )
+/*!
+ * ESP AES accelerator provider
+ */
+extern const SeCryptoProvider_t SeCryptoEspAes;
+#endif
+
+/*!
+ * Provider selected at build time
+ */
+const SeCryptoProvider_t *SeCryptoGetProvider( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __SE_CRYPTO_H__
@@ -25,10 +25,10 @@
  */
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "utilities.h"
-#include "aes.h"
-#include "cmac.h"
+#include "se-crypto.h"
 
 #include "LoRaMacHeaderTypes.h"
 
@@ -39,6 +39,49 @@
 
 static SecureElementNvmData_t *SeNvm;
 
+/*!
+ * Set when SeNvm is written
+ */
+static bool SeNvmChanged;
+
+/*!
+ * Crypto provider doing the AES operations
+ */
+static const SeCryptoProvider_t *Crypto;
+
+/*!
+ * Number of prepared AES keys kept in RAM
+ */
+#ifndef SOFT_SE_KEY_CACHE_SIZE
+#define SOFT_SE_KEY_CACHE_SIZE 6
+#endif
+
+/*!
+ * Prepared key of a key in the key list
+ */
+typedef struct sKeyScheduleCache {
+    /*!
+     * Key identifier, NUM_OF_KEYS when unused
+     */
+    KeyIdentifier_t KeyID;
+    /*!
+     * Key value the key was prepared from
+     */
+    uint8_t KeyValue[SE_KEY_SIZE];
+    /*!
+     * Key prepared by the crypto provider
+     */
+    SeCryptoKey_t KeyCtx;
+} KeyScheduleCache_t;
+
+static KeyScheduleCache_t KeyCache[SOFT_SE_KEY_CACHE_SIZE];
+static uint8_t KeyCacheNext;
+
+/*!
+ * Keys prepared since SecureElementInit
+ */
+static uint32_t KeyCacheMisses;
+
 /*
  * Local functions
  */
@@ -61,6 +104,70 @@ static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t **keyItem
     return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
 
+/*
+ * Releases a cache entry
+ *
+ * \param[IN]  entry          - Cache entry
+ */
+static void ClearKeySchedule( KeyScheduleCache_t *entry )
+{
+    if ( entry->KeyID != ( KeyIdentifier_t ) NUM_OF_KEYS ) {
+        Crypto->ClearKey( &entry->KeyCtx );
+        entry->KeyID = ( KeyIdentifier_t ) NUM_OF_KEYS;
+    }
+}
+
+/*
+ * Drops the cached key schedule of a key
+ *
+ * \param[IN]  keyID          - Key identifier
+ */
+static void InvalidateKeySchedule( KeyIdentifier_t keyID )
+{
+    for ( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ ) {
+        if ( KeyCache[i].KeyID == keyID ) {
+            ClearKeySchedule( &KeyCache[i] );
+        }
+    }
+}
+
+/*
+ * Gets the prepared AES key of a key. The key value is compared as
+ * well, so a key list restored from NVM never uses a stale schedule.
+ *
+ * \param[IN]  keyItem        - Key item
+ * \retval                    - Prepared key, NULL on error
+ */
+static const SeCryptoKey_t *GetKeySchedule( const Key_t *keyItem )
+{
+    KeyScheduleCache_t *entry = NULL;
+
+    for ( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ ) {
+        if ( KeyCache[i].KeyID == keyItem->KeyID ) {
+            if ( memcmp( KeyCache[i].KeyValue, keyItem->KeyValue, SE_KEY_SIZE ) == 0 ) {
+                return &KeyCache[i].KeyCtx;
+            }
+            entry = &KeyCache[i];
+            break;
+        }
+    }
+
+    if ( entry == NULL ) {
+        entry        = &KeyCache[KeyCacheNext];
+        KeyCacheNext = ( KeyCacheNext + 1 ) % SOFT_SE_KEY_CACHE_SIZE;
+    }
+
+    ClearKeySchedule( entry );
+    KeyCacheMisses++;
+    if ( !Crypto->SetKey( &entry->KeyCtx, keyItem->KeyValue ) ) {
+        Crypto->ClearKey( &entry->KeyCtx );
+        return NULL;
+    }
+    memcpy1( entry->KeyValue, keyItem->KeyValue, SE_KEY_SIZE );
+    entry->KeyID = keyItem->KeyID;
+    return &entry->KeyCtx;
+}
+
 /*
  * Computes a CMAC of a message using provided initial Bx block
  *
@@ -81,23 +188,17 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
     }
 
     uint8_t Cmac[16];
-    AES_CMAC_CTX aesCmacCtx[1];
-
-    AES_CMAC_Init( aesCmacCtx );
 
     Key_t                *keyItem;
     SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
 
     if ( retval == SECURE_ELEMENT_SUCCESS ) {
-        AES_CMAC_SetKey( aesCmacCtx, keyItem->KeyValue );
-
-        if ( micBxBuffer != NULL ) {
-            AES_CMAC_Update( aesCmacCtx, micBxBuffer, 16 );
+        const SeCryptoKey_t *keyCtx = GetKeySchedule( keyItem );
+        if ( keyCtx == NULL ) {
+            return SECURE_ELEMENT_ERROR;
         }
 
-        AES_CMAC_Update( aesCmacCtx, buffer, size );
-
-        AES_CMAC_Final( Cmac, aesCmacCtx );
+        Crypto->Cmac( keyCtx, micBxBuffer, buffer, size, Cmac );
 
         // Bring into the required format
         *cmac = ( uint32_t )( ( uint32_t ) Cmac[3] << 24 | ( uint32_t ) Cmac[2] << 16 | ( uint32_t ) Cmac[1] << 8 |
@@ -143,8 +244,22 @@ SecureElementStatus_t SecureElementInit( SecureElementNvmData_t *nvm )
     // Initialize nvm pointer
     SeNvm = nvm;
 
+    // Drop all prepared keys
+    if ( Crypto != NULL ) {
+        for ( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ ) {
+            ClearKeySchedule( &KeyCache[i] );
+        }
+    } else {
+        for ( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ ) {
+            KeyCache[i].KeyID = ( KeyIdentifier_t ) NUM_OF_KEYS;
+        }
+    }
+    Crypto         = SeCryptoGetProvider( );
+    KeyCacheMisses = 0;
+
     // Initialize data
     memcpy1( ( uint8_t * )SeNvm, ( uint8_t * )&seNvmInit, sizeof( seNvmInit ) );
+    SeNvmChanged = true;
 
 #if !defined( SECURE_ELEMENT_PRE_PROVISIONED )
 #if( STATIC_DEVICE_EUI == 0 )
@@ -163,6 +278,8 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
 
     for ( uint8_t i = 0; i < NUM_OF_KEYS; i++ ) {
         if ( SeNvm->KeyList[i].KeyID == keyID ) {
+            InvalidateKeySchedule( keyID );
+            SeNvmChanged = true;
             if ( ( keyID == MC_KEY_0 ) || ( keyID == MC_KEY_1 ) || ( keyID == MC_KEY_2 ) || ( keyID == MC_KEY_3 ) ) {
                 // Decrypt the key if its a Mckey
                 SecureElementStatus_t retval           = SECURE_ELEMENT_ERROR;
@@ -226,22 +343,37 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint16_t size, K
         return SECURE_ELEMENT_ERROR_BUF_SIZE;
     }
 
-    aes_context aesContext;
-    memset1( aesContext.ksch, '\0', 240 );
-
     Key_t                *pItem;
     SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
 
     if ( retval == SECURE_ELEMENT_SUCCESS ) {
-        lora_aes_set_key( pItem->KeyValue, 16, &aesContext );
+        const SeCryptoKey_t *keyCtx = GetKeySchedule( pItem );
+        if ( keyCtx == NULL ) {
+            return SECURE_ELEMENT_ERROR;
+        }
 
-        uint8_t block = 0;
+        Crypto->EcbEncrypt( keyCtx, buffer, encBuffer, size );
+    }
+    return retval;
+}
+
+SecureElementStatus_t SecureElementAesCtrCrypt( uint8_t *aBlock, uint8_t *buffer, uint16_t size,
+        KeyIdentifier_t keyID )
+{
+    if ( ( aBlock == NULL ) || ( buffer == NULL ) ) {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    Key_t                *pItem;
+    SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
 
-        while ( size != 0 ) {
-            laes_encrypt( &buffer[block], &encBuffer[block], &aesContext );
-            block = block + 16;
-            size  = size - 16;
+    if ( retval == SECURE_ELEMENT_SUCCESS ) {
+        const SeCryptoKey_t *keyCtx = GetKeySchedule( pItem );
+        if ( keyCtx == NULL ) {
+            return SECURE_ELEMENT_ERROR;
         }
+
+        Crypto->CtrCrypt( keyCtx, aBlock, buffer, size );
     }
     return retval;
 }
@@ -373,6 +505,7 @@ SecureElementStatus_t SecureElementSetDevEui( uint8_t *devEui )
         return SECURE_ELEMENT_ERROR_NPE;
     }
     memcpy1( SeNvm->DevEui, devEui, SE_EUI_SIZE );
+    SeNvmChanged = true;
     return SECURE_ELEMENT_SUCCESS;
 }
 
@@ -387,6 +520,7 @@ SecureElementStatus_t SecureElementSetJoinEui( uint8_t *joinEui )
         return SECURE_ELEMENT_ERROR_NPE;
     }
     memcpy1( SeNvm->JoinEui, joinEui, SE_EUI_SIZE );
+    SeNvmChanged = true;
     return SECURE_ELEMENT_SUCCESS;
 }
 
@@ -402,6 +536,7 @@ SecureElementStatus_t SecureElementSetPin( uint8_t *pin )
     }
 
     memcpy1( SeNvm->Pin, pin, SE_PIN_SIZE );
+    SeNvmChanged = true;
     return SECURE_ELEMENT_SUCCESS;
 }
 
@@ -418,3 +553,15 @@ SecureElementStatus_t SecureElementRandomNumber( uint32_t *randomNum )
     *randomNum = SoftSeHalGetRandomNumber( );
     return SECURE_ELEMENT_SUCCESS;
 }
+
+uint32_t SecureElementGetKeyCacheMisses( void )
+{
+    return KeyCacheMisses;
+}
+
+bool SecureElementIsNvmChanged( void )
+{
+    bool changed = SeNvmChanged;
+    SeNvmChanged = false;
+    return changed;
+}